@@ -0,0 +1,784 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <cdogs/ai_coop.h>
+#include <cdogs/ammo.h>
+#include <cdogs/blit.h>
+#include <cdogs/blit_kernels.h>
+#include <cdogs/character_class.h>
+#include <cdogs/collision.h>
+#include <cdogs/files.h>
+#include <cdogs/font_utils.h>
+#include <cdogs/gamedata.h>
+#include <cdogs/grafx.h>
+#include <cdogs/handle_game_events.h>
+#include <cdogs/log.h>
+#include <cdogs/map_object.h>
+#include <cdogs/mission.h>
+#include <cdogs/net_client.h>
+#include <cdogs/net_server.h>
+#include <cdogs/particle.h>
+#include <cdogs/path_cache.h>
+#include <cdogs/pic_manager.h>
+#include <cdogs/pickup.h>
+#include <cdogs/player.h>
+#include <cdogs/player_template.h>
+#include <cdogs/tick_profile.h>
+
+#include "game.h"
+#include "XGetopt.h"
+
+// Headless simulation benchmark.
+// Runs a mission with AI-controlled players only, with no video, sound or
+// input, as fast as possible, then reports the tick rate and how long each
+// subsystem of the game update took.
+// With --render, every tick is also drawn into an offscreen buffer, with
+// forced split screen, to measure the cost of drawing.
+// --frame-hash prints a hash of all the drawn frames, so that renderers can
+// be checked against each other; see tests/render_threads_test.cmake.
+
+#define DEFAULT_CAMPAIGN "missions/ogre.cdogscpn"
+#define DEFAULT_TICKS 2000
+
+
+static void PrintHelp(void)
+{
+	printf("%s\n",
+		"Usage: cdogs-sdl-benchmark [options] [campaign]\n"
+		"    campaign         Campaign file relative to the data dir\n"
+		"                       (default " DEFAULT_CAMPAIGN ")\n"
+		"    --ticks=n        Number of game ticks to run (default "
+		TOSTRING(DEFAULT_TICKS) ")\n"
+		"    --players=n      Number of AI players, 1-4 (default 1)\n"
+		"    --mission=n      Mission index, starting from 0 (default 0)\n"
+		"    --seed=n         Random seed (default 0)\n"
+		"    --log=L          Enable logging for all modules at level L\n"
+		"    --micro=name     Run a micro-benchmark for --ticks iterations\n"
+		"                       instead of a mission; one of: config, blit,\n"
+		"                       assets, startup, atlas\n"
+		"    --render=WxH     Also draw every tick at this resolution, with\n"
+		"                       split screen for each player\n"
+		"    --render-threads Draw the split screen views on worker threads\n"
+		"    --frame-hash     Print a hash of every frame drawn\n"
+	);
+}
+
+// Config values looked up every frame or tick by the game, to compare
+// dot-separated name lookups against pre-resolved handles
+static const char *configFrameNames[] =
+{
+	"Graphics.Brightness",
+	"Game.SightRange",
+	"StartServer",
+	"Interface.Splitscreen",
+	"Interface.Splitscreen",
+	"Interface.ShowHUDMap",
+	"Interface.ShowFPS",
+	"Interface.ShowTime",
+	"Game.Ammo",
+	"Game.Fog",
+	"Game.Shadows",
+	"Game.SwitchMoveStyle",
+	"Game.FireMoveStyle",
+	"Sound.Footsteps"
+};
+#define CONFIG_FRAME_NAMES_COUNT \
+	(sizeof configFrameNames / sizeof configFrameNames[0])
+static void BenchmarkConfig(const int frames)
+{
+	ConfigHandle handles[CONFIG_FRAME_NAMES_COUNT];
+	for (int i = 0; i < (int)CONFIG_FRAME_NAMES_COUNT; i++)
+	{
+		const ConfigHandle h = CONFIG_HANDLE(configFrameNames[i]);
+		handles[i] = h;
+	}
+	// Accumulate the values so the lookups can't be optimised away
+	volatile int sink = 0;
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < (int)CONFIG_FRAME_NAMES_COUNT; i++)
+		{
+			sink += ConfigGet(&gConfig, configFrameNames[i])->u.Int.Value;
+		}
+	}
+	const Uint64 byName = SDL_GetPerformanceCounter() - start;
+
+	start = SDL_GetPerformanceCounter();
+	for (int f = 0; f < frames; f++)
+	{
+		for (int i = 0; i < (int)CONFIG_FRAME_NAMES_COUNT; i++)
+		{
+			sink += ConfigHandleGet(&handles[i])->u.Int.Value;
+		}
+	}
+	const Uint64 byHandle = SDL_GetPerformanceCounter() - start;
+	UNUSED(sink);
+
+	const double freq = (double)SDL_GetPerformanceFrequency();
+	printf("Config lookups: %d frames x %d values\n",
+		frames, (int)CONFIG_FRAME_NAMES_COUNT);
+	printf("%-12s %12s %14s\n", "Method", "total ms", "ns/frame");
+	printf("%-12s %12.3f %14.1f\n", "By name",
+		byName * 1000.0 / freq, byName * 1e9 / freq / frames);
+	printf("%-12s %12.3f %14.1f\n", "By handle",
+		byHandle * 1000.0 / freq, byHandle * 1e9 / freq / frames);
+}
+
+// Blit operations that go through the row kernels
+typedef enum
+{
+	BLIT_OP_BLIT,
+	BLIT_OP_MASKED,
+	BLIT_OP_BLEND,
+	BLIT_OP_BRIGHTNESS,
+	BLIT_OP_COUNT
+} BlitOp;
+static const char *blitOpNames[] =
+{
+	"Blit", "BlitMasked", "BlitBlend", "Brightness"
+};
+// Cover the screen with the pic, like a busy frame, using one blit op
+static int BlitFrame(GraphicsDevice *g, const Pic *pic, const BlitOp op)
+{
+	const Vec2i res = g->cachedConfig.Res;
+	const color_t blend = { 0x80, 0xC0, 0xFF, 0x80 };
+	int blits = 0;
+	if (op == BLIT_OP_BRIGHTNESS)
+	{
+		BlitBrightness b;
+		BlitBrightnessInit(&b, 3);
+		gBlitKernels->Brightness(g->buf, res.x * res.y, &b);
+		return 1;
+	}
+	// Offset the pics so that they straddle the screen edges and get clipped
+	for (int y = -pic->size.y / 2; y < res.y; y += pic->size.y)
+	{
+		for (int x = -pic->size.x / 2; x < res.x; x += pic->size.x)
+		{
+			const Vec2i pos = Vec2iNew(x - pic->offset.x, y - pic->offset.y);
+			switch (op)
+			{
+			case BLIT_OP_BLIT:
+				Blit(g, pic, pos);
+				break;
+			case BLIT_OP_MASKED:
+				BlitMasked(g, pic, pos, colorRed, true);
+				break;
+			case BLIT_OP_BLEND:
+				BlitBlend(g, pic, pos, blend);
+				break;
+			default:
+				CASSERT(false, "unknown blit op");
+				break;
+			}
+			blits++;
+		}
+	}
+	return blits;
+}
+static void BenchmarkBlit(const int frames)
+{
+	GraphicsDevice *g = &gGraphicsDevice;
+	const Pic *pic = PicManagerGetPic(&gPicManager, "barrel");
+	const BlitKernels *defaultKernels = gBlitKernels;
+	const Vec2i res = g->cachedConfig.Res;
+	const double freq = (double)SDL_GetPerformanceFrequency();
+	printf("Blits: %d frames at %dx%d, %dx%d pic\n",
+		frames, res.x, res.y, pic->size.x, pic->size.y);
+	printf("%-12s %-8s %12s %14s %12s\n",
+		"Op", "Kernels", "ms/frame", "ns/blit", "ns/Kpixel");
+	for (BlitOp op = 0; op < BLIT_OP_COUNT; op++)
+	{
+		for (int t = 0; t < BLIT_KERNELS_COUNT; t++)
+		{
+			gBlitKernels = BlitKernelsGet((BlitKernelsType)t);
+			if (gBlitKernels == NULL)
+			{
+				continue;
+			}
+			memset(g->buf, 0x40, GraphicsGetMemSize(&g->cachedConfig));
+			int blits = 0;
+			const Uint64 start = SDL_GetPerformanceCounter();
+			for (int f = 0; f < frames; f++)
+			{
+				blits += BlitFrame(g, pic, op);
+			}
+			const double ns =
+				(SDL_GetPerformanceCounter() - start) * 1e9 / freq;
+			printf("%-12s %-8s %12.4f %14.1f %12.1f\n",
+				blitOpNames[op], gBlitKernels->Name,
+				ns / 1e6 / frames, ns / blits,
+				ns * 1000.0 / ((double)res.x * res.y * frames));
+		}
+	}
+	gBlitKernels = defaultKernels;
+}
+
+// The lookups made for every shot: the gun of a fire event, then the bullet
+// class of each bullet it adds
+// Linear scans are how names were resolved before they were interned
+static const GunDescription *ScanGun(const char *name)
+{
+	CA_FOREACH(const GunDescription, g, gGunDescriptions.CustomGuns)
+		if (g->name != NULL && strcmp(name, g->name) == 0) return g;
+	CA_FOREACH_END()
+	CA_FOREACH(const GunDescription, g, gGunDescriptions.Guns)
+		if (g->name != NULL && strcmp(name, g->name) == 0) return g;
+	CA_FOREACH_END()
+	return NULL;
+}
+static const BulletClass *ScanBullet(const char *name)
+{
+	CA_FOREACH(const BulletClass, b, gBulletClasses.CustomClasses)
+		if (strcmp(name, b->Name) == 0) return b;
+	CA_FOREACH_END()
+	CA_FOREACH(const BulletClass, b, gBulletClasses.Classes)
+		if (strcmp(name, b->Name) == 0) return b;
+	CA_FOREACH_END()
+	return NULL;
+}
+static void BenchmarkAssets(const int frames)
+{
+	CArray guns;	// of const GunDescription *
+	CArrayInit(&guns, sizeof(const GunDescription *));
+	CA_FOREACH(const GunDescription, g, gGunDescriptions.Guns)
+		if (g->IsRealGun && g->Bullet != NULL)
+		{
+			CArrayPushBack(&guns, &g);
+		}
+	CA_FOREACH_END()
+	const int shots = frames * (int)guns.size;
+	volatile intptr_t sink = 0;
+	const double freq = (double)SDL_GetPerformanceFrequency();
+	printf("Asset lookups: %d shots over %d guns\n", shots, (int)guns.size);
+	printf("%-12s %12s %14s\n", "Method", "total ms", "ns/shot");
+	for (int method = 0; method < 3; method++)
+	{
+		const Uint64 start = SDL_GetPerformanceCounter();
+		for (int f = 0; f < frames; f++)
+		{
+			CA_FOREACH(const GunDescription *, gp, guns)
+				const GunDescription *g = *gp;
+				switch (method)
+				{
+				case 0:
+					g = ScanGun(g->name);
+					sink += (intptr_t)ScanBullet(g->Bullet->Name);
+					break;
+				case 1:
+					g = StrGunDescription(g->name);
+					sink += (intptr_t)StrBulletClass(g->Bullet->Name);
+					break;
+				default:
+					g = IdGunDescription(GunDescriptionId(g));
+					sink += (intptr_t)IdBulletClass(BulletClassId(g->Bullet));
+					break;
+				}
+			CA_FOREACH_END()
+		}
+		const double ns = (SDL_GetPerformanceCounter() - start) * 1e9 / freq;
+		static const char *methodNames[] = { "Scan", "By name", "By ID" };
+		printf("%-12s %12.3f %14.1f\n",
+			methodNames[method], ns / 1e6, shots > 0 ? ns / shots : 0);
+	}
+	UNUSED(sink);
+	CArrayTerminate(&guns);
+}
+
+// Load the graphics dir without a cache, with an empty cache that is then
+// written (cold start), and from that cache (warm start)
+#define BENCHMARK_CACHE "benchmark_graphics.cache"
+static double LoadGraphicsMs(const char *cachePath);
+static void BenchmarkStartup(const int iterations)
+{
+	printf("Graphics load: %d iterations\n", iterations);
+	printf("%-12s %12s %14s\n", "Method", "total ms", "ms/load");
+	for (int method = 0; method < 3; method++)
+	{
+		double ms = 0;
+		for (int i = 0; i < iterations; i++)
+		{
+			switch (method)
+			{
+			case 0:
+				ms += LoadGraphicsMs(NULL);
+				break;
+			case 1:
+				remove(BENCHMARK_CACHE);
+				ms += LoadGraphicsMs(BENCHMARK_CACHE);
+				break;
+			default:
+				ms += LoadGraphicsMs(BENCHMARK_CACHE);
+				break;
+			}
+		}
+		static const char *methodNames[] = { "No cache", "Cold", "Warm" };
+		printf("%-12s %12.3f %14.3f\n",
+			methodNames[method], ms, iterations > 0 ? ms / iterations : 0);
+	}
+	remove(BENCHMARK_CACHE);
+}
+static double LoadGraphicsMs(const char *cachePath)
+{
+	// Load into a separate manager, as game data points to the global one
+	PicManager pm;
+	if (!PicManagerTryInit(&pm, "graphics/cdogs.px", "graphics/cdogs2.px"))
+	{
+		return 0;
+	}
+	const Uint64 start = SDL_GetPerformanceCounter();
+	PicManagerLoadDir(&pm, "graphics", cachePath);
+	const Uint64 end = SDL_GetPerformanceCounter();
+	PicManagerTerminate(&pm);
+	return (end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Draw every loaded pic once a frame, from separately allocated copies
+// like pics were before they were packed, then from the atlas
+static int AddNamedPicToList(any_t data, any_t item);
+static int AddNamedSpritesToList(any_t data, any_t item);
+static int ComparePicData(const void *v1, const void *v2);
+static size_t HeapChunkSize(void *p);
+static int BlitPics(GraphicsDevice *g, const CArray *pics);
+static void BenchmarkAtlas(const int frames)
+{
+	GraphicsDevice *g = &gGraphicsDevice;
+	CArray packed;	// of Pic
+	CArrayInit(&packed, sizeof(Pic));
+	for (int i = 0; i < PIC_MAX; i++)
+	{
+		const Pic *pic = &gPicManager.picsFromOld[i];
+		if (pic->Data != NULL) CArrayPushBack(&packed, pic);
+	}
+	hashmap_iterate(gPicManager.oldSprites, AddNamedSpritesToList, &packed);
+	hashmap_iterate(gPicManager.pics, AddNamedPicToList, &packed);
+	hashmap_iterate(gPicManager.sprites, AddNamedSpritesToList, &packed);
+	// Draw in atlas order, as pics packed together are likely drawn together
+	qsort(packed.data, packed.size, packed.elemSize, ComparePicData);
+
+	CArray copies;	// of Pic
+	CArrayInit(&copies, sizeof(Pic));
+	CArrayReserve(&copies, packed.size);
+	size_t pixelBytes = 0;
+	size_t copiesBytes = 0;
+	CA_FOREACH(const Pic, pic, packed)
+		const Pic p = PicCopy(pic);
+		CArrayPushBack(&copies, &p);
+		pixelBytes += pic->size.x * pic->size.y * sizeof *pic->Data;
+		copiesBytes += HeapChunkSize(p.Data);
+	CA_FOREACH_END()
+	size_t atlasUsed;
+	const size_t atlasBytes = PicAtlasSize(&gPicManager.atlas, &atlasUsed);
+
+	printf("Pics: %d, %d KB of pixels\n",
+		(int)packed.size, (int)(pixelBytes / 1024));
+	if (copiesBytes > 0)
+	{
+		printf("Separate allocations: %d KB of heap\n",
+			(int)(copiesBytes / 1024));
+	}
+	printf("Atlas: %d pics in %d pages, %d KB (%d KB used)\n",
+		gPicManager.atlas.NumPics, (int)gPicManager.atlas.pages.size,
+		(int)(atlasBytes / 1024), (int)(atlasUsed / 1024));
+
+	const double freq = (double)SDL_GetPerformanceFrequency();
+	printf("Blits: %d frames of %d pics\n", frames, (int)packed.size);
+	printf("%-12s %12s %14s\n", "Pics", "ms/frame", "ns/blit");
+	for (int method = 0; method < 2; method++)
+	{
+		const CArray *pics = method == 0 ? &copies : &packed;
+		int blits = 0;
+		const Uint64 start = SDL_GetPerformanceCounter();
+		for (int f = 0; f < frames; f++)
+		{
+			blits += BlitPics(g, pics);
+		}
+		const double ns = (SDL_GetPerformanceCounter() - start) * 1e9 / freq;
+		static const char *methodNames[] = { "Separate", "Atlas" };
+		printf("%-12s %12.4f %14.1f\n",
+			methodNames[method], ns / 1e6 / frames,
+			blits > 0 ? ns / blits : 0);
+	}
+
+	CA_FOREACH(Pic, pic, copies)
+		PicFree(pic);
+	CA_FOREACH_END()
+	CArrayTerminate(&copies);
+	CArrayTerminate(&packed);
+}
+static int AddNamedPicToList(any_t data, any_t item)
+{
+	const NamedPic *n = item;
+	CArrayPushBack(data, &n->pic);
+	return MAP_OK;
+}
+static int AddNamedSpritesToList(any_t data, any_t item)
+{
+	const NamedSprites *n = item;
+	CA_FOREACH(const Pic, pic, n->pics)
+		CArrayPushBack(data, pic);
+	CA_FOREACH_END()
+	return MAP_OK;
+}
+static int ComparePicData(const void *v1, const void *v2)
+{
+	const Pic *p1 = v1;
+	const Pic *p2 = v2;
+	return p1->Data < p2->Data ? -1 : p1->Data > p2->Data;
+}
+// Heap bytes taken by an allocation, including its header, or 0 if unknown
+static size_t HeapChunkSize(void *p)
+{
+#ifdef __GLIBC__
+	return malloc_usable_size(p) + sizeof(size_t);
+#else
+	UNUSED(p);
+	return 0;
+#endif
+}
+static int BlitPics(GraphicsDevice *g, const CArray *pics)
+{
+	// Lay the pics out in rows across the screen, wrapping around
+	const Vec2i res = g->cachedConfig.Res;
+	Vec2i pos = Vec2iZero();
+	int rowHeight = 0;
+	CA_FOREACH(const Pic, pic, *pics)
+		if (pos.x + pic->size.x > res.x)
+		{
+			pos.x = 0;
+			pos.y += rowHeight;
+			rowHeight = 0;
+		}
+		if (pos.y + pic->size.y > res.y)
+		{
+			pos.y = 0;
+		}
+		Blit(g, pic, pos);
+		pos.x += pic->size.x;
+		rowHeight = MAX(rowHeight, pic->size.y);
+	CA_FOREACH_END()
+	return (int)pics->size;
+}
+
+static void AddAIPlayers(const int numPlayers);
+int main(int argc, char *argv[])
+{
+	int err = EXIT_SUCCESS;
+	const char *campaignPath = DEFAULT_CAMPAIGN;
+	int ticks = DEFAULT_TICKS;
+	int numPlayers = 1;
+	int missionIndex = 0;
+	unsigned int seed = 0;
+	const char *micro = NULL;
+	Vec2i renderRes = Vec2iZero();
+	bool renderThreads = false;
+	bool frameHash = false;
+
+	LogInit();
+	for (int i = 0; i < (int)LM_COUNT; i++)
+	{
+		LogModuleSetLevel((LogModule)i, LL_WARN);
+	}
+	{
+		struct option longopts[] =
+		{
+			{"ticks",	required_argument,	NULL,	't'},
+			{"players",	required_argument,	NULL,	'p'},
+			{"mission",	required_argument,	NULL,	'm'},
+			{"seed",	required_argument,	NULL,	's'},
+			{"log",		required_argument,	NULL,	1000},
+			{"micro",	required_argument,	NULL,	1001},
+			{"render",	required_argument,	NULL,	1002},
+			{"render-threads",	no_argument,	NULL,	1003},
+			{"frame-hash",	no_argument,		NULL,	1004},
+			{"help",	no_argument,		NULL,	'h'},
+			{0,			0,					NULL,	0}
+		};
+		int opt = 0;
+		int idx = 0;
+		while ((opt = getopt_long(argc, argv, "t:p:m:s:\0h", longopts, &idx)) != -1)
+		{
+			switch (opt)
+			{
+			case 't':
+				ticks = MAX(atoi(optarg), 1);
+				break;
+			case 'p':
+				numPlayers = CLAMP(atoi(optarg), 1, MAX_LOCAL_PLAYERS);
+				break;
+			case 'm':
+				missionIndex = MAX(atoi(optarg), 0);
+				break;
+			case 's':
+				seed = (unsigned int)strtoul(optarg, NULL, 10);
+				break;
+			case 1000:
+				{
+					const LogLevel ll = StrLogLevel(optarg);
+					for (int i = 0; i < (int)LM_COUNT; i++)
+					{
+						LogModuleSetLevel((LogModule)i, ll);
+					}
+				}
+				break;
+			case 1001:
+				micro = optarg;
+				break;
+			case 1002:
+				if (sscanf(optarg, "%dx%d", &renderRes.x, &renderRes.y) != 2 ||
+					renderRes.x < 320 || renderRes.y < 240)
+				{
+					printf("Invalid resolution %s\n", optarg);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 1003:
+				renderThreads = true;
+				break;
+			case 1004:
+				frameHash = true;
+				break;
+			case 'h':
+				PrintHelp();
+				return EXIT_SUCCESS;
+			default:
+				PrintHelp();
+				return EXIT_FAILURE;
+			}
+		}
+		if (optind < argc)
+		{
+			campaignPath = argv[optind];
+		}
+	}
+
+	// Use the default config so that runs are reproducible
+	gConfig = ConfigDefault();
+	ConfigGet(&gConfig, "Game.RandomSeed")->u.Int.Value = (int)seed;
+	ConfigGet(&gConfig, "Sound.SoundVolume")->u.Int.Value = 0;
+	ConfigGet(&gConfig, "Sound.MusicVolume")->u.Int.Value = 0;
+	const bool render = !Vec2iIsZero(renderRes);
+	if (render)
+	{
+		ConfigGet(&gConfig, "Graphics.ResolutionWidth")->u.Int.Value =
+			renderRes.x;
+		ConfigGet(&gConfig, "Graphics.ResolutionHeight")->u.Int.Value =
+			renderRes.y;
+		ConfigGet(&gConfig, "Interface.Splitscreen")->u.Enum.Value =
+			SPLITSCREEN_ALWAYS;
+		ConfigGet(&gConfig, "Graphics.ThreadedRender")->u.Bool.Value =
+			renderThreads;
+	}
+
+	// Only the timer; no video, audio or input
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Could not initialise SDL: %s", SDL_GetError());
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	if (enet_initialize() != 0)
+	{
+		LOG(LM_MAIN, LL_ERROR, "An error occurred while initializing ENet.");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	NetClientInit(&gNetClient);
+	NetServerInit(&gNetServer);
+
+	GraphicsInit(&gGraphicsDevice, &gConfig);
+	GraphicsInitializeHeadless(&gGraphicsDevice);
+	if (!PicManagerTryInit(
+		&gPicManager, "graphics/cdogs.px", "graphics/cdogs2.px"))
+	{
+		LOG(LM_MAIN, LL_ERROR, "Failed to initialize graphics");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	PicManagerLoadDir(&gPicManager, "graphics", NULL);
+	FontLoadFromJSON(&gFont, "graphics/font.png", "graphics/font.json");
+
+	ParticleClassesInit(&gParticleClasses, "data/particles.json");
+	AmmoInitialize(&gAmmo, "data/ammo.json");
+	BulletAndWeaponInitialize(
+		&gBulletClasses, &gGunDescriptions,
+		"data/bullets.json", "data/guns.json");
+	CharacterClassesInitialize(&gCharacterClasses, "data/character_classes.json");
+	PickupClassesInit(
+		&gPickupClasses, "data/pickups.json", &gAmmo, &gGunDescriptions);
+	MapObjectsInit(
+		&gMapObjects, "data/map_objects.json", &gAmmo, &gGunDescriptions);
+	CollisionSystemInit(&gCollisionSystem);
+	CampaignInit(&gCampaign);
+	PlayerDataInit(&gPlayerDatas);
+	CArrayInit(&gPlayerTemplates, sizeof(PlayerTemplate));
+	TickProfileInit(&gTickProfile);
+
+	if (micro != NULL)
+	{
+		if (strcmp(micro, "config") == 0)
+		{
+			BenchmarkConfig(ticks);
+		}
+		else if (strcmp(micro, "blit") == 0)
+		{
+			BenchmarkBlit(ticks);
+		}
+		else if (strcmp(micro, "assets") == 0)
+		{
+			BenchmarkAssets(ticks);
+		}
+		else if (strcmp(micro, "startup") == 0)
+		{
+			BenchmarkStartup(ticks);
+		}
+		else if (strcmp(micro, "atlas") == 0)
+		{
+			BenchmarkAtlas(ticks);
+		}
+		else
+		{
+			LOG(LM_MAIN, LL_ERROR, "Unknown micro-benchmark %s", micro);
+			err = EXIT_FAILURE;
+		}
+		goto bail;
+	}
+
+	char buf[CDOGS_PATH_MAX];
+	GetDataFilePath(buf, campaignPath);
+	CampaignEntry entry;
+	if (!CampaignEntryTryLoad(&entry, buf, GAME_MODE_NORMAL) ||
+		!CampaignLoad(&gCampaign, &entry))
+	{
+		LOG(LM_MAIN, LL_ERROR, "Failed to load campaign %s", campaignPath);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	if (missionIndex >= (int)gCampaign.Setting.Missions.size)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Campaign %s has only %d missions",
+			campaignPath, (int)gCampaign.Setting.Missions.size);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	gCampaign.MissionIndex = missionIndex;
+
+	GameEventsInit(&gGameEvents);
+	AddAIPlayers(numPlayers);
+	CampaignAndMissionSetup(&gCampaign, &gMission);
+	int idx = 0;
+	CA_FOREACH(PlayerData, p, gPlayerDatas)
+		AICoopSelectWeapons(p, idx, &gMission.Weapons);
+		idx++;
+	CA_FOREACH_END()
+
+	printf("Campaign:   %s\n", campaignPath);
+	printf("Mission:    %d (%s)\n", missionIndex, gMission.missionData->Title);
+	printf("Map size:   %dx%d\n",
+		gMission.missionData->Size.x, gMission.missionData->Size.y);
+	printf("AI players: %d\n", numPlayers);
+	printf("Seed:       %u\n", seed);
+	if (render)
+	{
+		printf("Render:     %dx%d%s\n",
+			gGraphicsDevice.cachedConfig.Res.x,
+			gGraphicsDevice.cachedConfig.Res.y,
+			renderThreads ? ", threaded" : "");
+	}
+
+	// FNV-1a offset basis
+	Uint32 hash = 2166136261u;
+	gTickProfile.Enabled = true;
+	RunGameHeadless(
+		&gCampaign, &gMission, &gMap, ticks, render,
+		render && frameHash ? &hash : NULL);
+	gTickProfile.Enabled = false;
+	if (render && frameHash)
+	{
+		printf("Frame hash: %08x\n", (unsigned int)hash);
+	}
+
+	TickProfilePrint(&gTickProfile, stdout);
+	PathCacheStatsPrint(&gPathCache, stdout);
+
+	MissionOptionsTerminate(&gMission);
+	GameEventsTerminate(&gGameEvents);
+	CampaignUnload(&gCampaign);
+
+bail:
+	MapTerminate(&gMap);
+	PlayerDataTerminate(&gPlayerDatas);
+	CArrayTerminate(&gPlayerTemplates);
+	MapObjectsTerminate(&gMapObjects);
+	PickupClassesTerminate(&gPickupClasses);
+	ParticleClassesTerminate(&gParticleClasses);
+	AmmoTerminate(&gAmmo);
+	WeaponTerminate(&gGunDescriptions);
+	BulletTerminate(&gBulletClasses);
+	CharacterClassesTerminate(&gCharacterClasses);
+	NetServerTerminate(&gNetServer);
+	NetClientTerminate(&gNetClient);
+	enet_deinitialize();
+	CampaignTerminate(&gCampaign);
+	GraphicsTerminate(&gGraphicsDevice);
+	FontTerminate(&gFont);
+	PicManagerTerminate(&gPicManager);
+	TickProfileTerminate(&gTickProfile);
+	ConfigDestroy(&gConfig);
+	SDL_Quit();
+
+	return err;
+}
+
+static void AddAIPlayers(const int numPlayers)
+{
+	for (int i = 0; i < numPlayers; i++)
+	{
+		GameEvent e = GameEventNew(GAME_EVENT_PLAYER_DATA);
+		e.u.PlayerData = PlayerDataDefault(i);
+		e.u.PlayerData.UID = gNetClient.FirstPlayerUID + i;
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	// Process the events to force add the players
+	HandleGameEvents(&gGameEvents, NULL, NULL, NULL);
+	CA_FOREACH(PlayerData, p, gPlayerDatas)
+		PlayerTrySetInputDevice(p, INPUT_DEVICE_AI, 0);
+	CA_FOREACH_END()
+}
@@ -393,6 +393,7 @@ int main(int argc, char *argv[])
 	LOG(LM_MAIN, LL_INFO, "data dir(%s)", buf);
 	LOG(LM_MAIN, LL_INFO, "config dir(%s)", GetConfigFilePath(""));
 
+	const Uint64 startupStart = SDL_GetPerformanceCounter();
 	SoundInitialize(&gSoundDevice, "sounds");
 	if (!gSoundDevice.isInitialised)
 	{
@@ -438,8 +439,10 @@ int main(int argc, char *argv[])
 		goto bail;
 	}
 	FontLoadFromJSON(&gFont, "graphics/font.png", "graphics/font.json");
-	PicManagerLoadDir(&gPicManager, "graphics");
+	PicManagerLoadDir(
+		&gPicManager, "graphics", GetConfigFilePath(GRAPHICS_CACHE_FILE));
 
+	const Uint64 dataStart = SDL_GetPerformanceCounter();
 	ParticleClassesInit(&gParticleClasses, "data/particles.json");
 	AmmoInitialize(&gAmmo, "data/ammo.json");
 	BulletAndWeaponInitialize(
@@ -452,10 +455,19 @@ int main(int argc, char *argv[])
 		&gPickupClasses, "data/pickups.json", &gAmmo, &gGunDescriptions);
 	MapObjectsInit(
 		&gMapObjects, "data/map_objects.json", &gAmmo, &gGunDescriptions);
+	const Uint64 campaignsStart = SDL_GetPerformanceCounter();
 	CollisionSystemInit(&gCollisionSystem);
 	CampaignInit(&gCampaign);
 	LoadAllCampaigns(&campaigns);
 	PlayerDataInit(&gPlayerDatas);
+	const Uint64 startupEnd = SDL_GetPerformanceCounter();
+	const double freq = (double)SDL_GetPerformanceFrequency();
+	LOG(LM_MAIN, LL_INFO, "loaded game data in %.2fms",
+		(campaignsStart - dataStart) * 1000.0 / freq);
+	LOG(LM_MAIN, LL_INFO, "loaded campaign list in %.2fms",
+		(startupEnd - campaignsStart) * 1000.0 / freq);
+	LOG(LM_MAIN, LL_INFO, "startup took %.2fms",
+		(startupEnd - startupStart) * 1000.0 / freq);
 
 	GrafxMakeRandomBackground(
 		&gGraphicsDevice, &gCampaign, &gMission, &gMap);
@@ -540,6 +540,17 @@ ASPath ASPathCopy(ASPath path)
     }
 }
 
+ASPath ASPathCreateFromNodes(size_t nodeSize, const void *nodes, size_t count, float cost)
+{
+    ASPath path;
+    CMALLOC(path, sizeof(struct __ASPath) + (count * nodeSize));
+    path->nodeSize = nodeSize;
+    path->count = count;
+    path->cost = cost;
+    memcpy(path->nodeKeys, nodes, count * nodeSize);
+    return path;
+}
+
 size_t ASPathGetCount(ASPath path)
 {
     return path? path->count : 0;
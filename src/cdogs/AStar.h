@@ -60,6 +60,10 @@ void ASPathDestroy(ASPath path);
 // you must call ASPathDestroy() with the resulting path to clean it up or it will cause a leak
 ASPath ASPathCopy(ASPath path);
 
+// creates a path from an array of count nodes, e.g. when joining paths together
+// you must call ASPathDestroy() with the resulting path to clean it up
+ASPath ASPathCreateFromNodes(size_t nodeSize, const void *nodes, size_t count, float cost);
+
 // fetches the number of nodes in the path
 size_t ASPathGetCount(ASPath path);
 
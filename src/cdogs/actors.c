@@ -65,6 +65,7 @@
 #include "game_events.h"
 #include "log.h"
 #include "pic_manager.h"
+#include "pool.h"
 #include "sounds.h"
 #include "defs.h"
 #include "objs.h"
@@ -76,6 +77,15 @@
 #include "game.h"
 #include "utils.h"
 
+static ConfigHandle configAIChatter = CONFIG_HANDLE("Interface.AIChatter");
+static ConfigHandle configAmmo = CONFIG_HANDLE("Game.Ammo");
+static ConfigHandle configFireMoveStyle = CONFIG_HANDLE("Game.FireMoveStyle");
+static ConfigHandle configFootsteps = CONFIG_HANDLE("Sound.Footsteps");
+static ConfigHandle configFriendlyFire = CONFIG_HANDLE("Game.FriendlyFire");
+static ConfigHandle configGore = CONFIG_HANDLE("Game.Gore");
+static ConfigHandle configShotsPushback = CONFIG_HANDLE("Game.ShotsPushback");
+static ConfigHandle configSwitchMoveStyle = CONFIG_HANDLE("Game.SwitchMoveStyle");
+
 #define FOOTSTEP_DISTANCE_PLUS 380
 #define REPEL_STRENGTH 14
 #define SLIDE_LOCK 50
@@ -94,6 +104,7 @@ CArray gPlayerIds;
 
 CArray gActors;
 static unsigned int sActorUIDs = 0;
+static Pool sActorPool;
 
 
 void ActorSetState(TActor *actor, const ActorAnimation state)
@@ -149,6 +160,7 @@ void UpdateActorState(TActor * actor, int ticks)
 		actor->MoveVel = Vec2iZero();
 		actor->stateCounter = 4;
 		actor->tileItem.flags = 0;
+		MapUpdateTileItem(&gMap, &actor->tileItem);
 		return;
 	}
 
@@ -175,7 +187,7 @@ void UpdateActorState(TActor * actor, int ticks)
 	// Footstep sounds
 	// Step on 1
 	// TODO: custom animation and footstep frames
-	if (ConfigGetBool(&gConfig, "Sound.Footsteps") &&
+	if (ConfigHandleGetBool(&configFootsteps) &&
 		AnimationGetFrame(&actor->anim) == STATE_WALKING_1 &&
 		actor->anim.newFrame)
 	{
@@ -240,7 +252,8 @@ bool TryMoveActor(TActor *actor, Vec2i pos)
 					// Tell the server that we want to melee something
 					GameEvent e = GameEventNew(GAME_EVENT_ACTOR_MELEE);
 					e.u.Melee.UID = actor->uid;
-					strcpy(e.u.Melee.BulletClass, gun->Gun->Bullet->Name);
+					e.u.Melee.BulletClassId =
+						BulletClassId(gun->Gun->Bullet);
 					e.u.Melee.TargetKind = target->kind;
 					switch (target->kind)
 					{
@@ -565,7 +578,7 @@ void ActorReplaceGun(const NActorReplaceGun rg)
 {
 	TActor *a = ActorGetByUID(rg.UID);
 	if (a == NULL || !a->isInUse) return;
-	const GunDescription *gun = StrGunDescription(rg.Gun);
+	const GunDescription *gun = IdGunDescription(rg.GunId);
 	CASSERT(gun != NULL, "cannot find gun");
 	// If player already has gun, don't do anything
 	if (ActorHasGun(a, gun))
@@ -603,7 +616,7 @@ void ActorSetAIState(TActor *actor, const AIState s)
 {
 	if (AIContextSetState(actor->aiContext, s) &&
 		AIContextShowChatter(
-		actor->aiContext, ConfigGetEnum(&gConfig, "Interface.AIChatter")))
+		actor->aiContext, ConfigHandleGetEnum(&configAIChatter)))
 	{
 		// Say something for a while
 		strcpy(actor->Chatter, AIStateGetChatterText(actor->aiContext->State));
@@ -616,7 +629,7 @@ void Shoot(TActor *actor)
 	Weapon *gun = ActorGetGun(actor);
 	if (!ActorCanFire(actor))
 	{
-		if (!WeaponIsLocked(gun) && ConfigGetBool(&gConfig, "Game.Ammo"))
+		if (!WeaponIsLocked(gun) && ConfigHandleGetBool(&configAmmo))
 		{
 			CASSERT(ActorGunGetAmmo(actor, gun) == 0, "should be out of ammo");
 			// Play a clicking sound if this gun is out of ammo
@@ -639,7 +652,7 @@ void Shoot(TActor *actor)
 		actor->uid);
 	if (actor->PlayerUID >= 0)
 	{
-		if (ConfigGetBool(&gConfig, "Game.Ammo") && gun->Gun->AmmoId >= 0)
+		if (ConfigHandleGetBool(&configAmmo) && gun->Gun->AmmoId >= 0)
 		{
 			GameEvent e = GameEventNew(GAME_EVENT_ACTOR_USE_AMMO);
 			e.u.UseAmmo.UID = actor->uid;
@@ -665,8 +678,8 @@ static bool ActorTryChangeDirection(
 	const bool willChangeDirecton =
 		!actor->petrified &&
 		CMD_HAS_DIRECTION(cmd) &&
-		(!(cmd & CMD_BUTTON2) || ConfigGetEnum(&gConfig, "Game.SwitchMoveStyle") != SWITCHMOVE_STRAFE) &&
-		(!(prevCmd & CMD_BUTTON1) || ConfigGetEnum(&gConfig, "Game.FireMoveStyle") != FIREMOVE_STRAFE);
+		(!(cmd & CMD_BUTTON2) || ConfigHandleGetEnum(&configSwitchMoveStyle) != SWITCHMOVE_STRAFE) &&
+		(!(prevCmd & CMD_BUTTON1) || ConfigHandleGetEnum(&configFireMoveStyle) != FIREMOVE_STRAFE);
 	const direction_e dir = CmdToDirection(cmd);
 	if (willChangeDirecton && dir != actor->direction)
 	{
@@ -760,9 +773,9 @@ void CommandActor(TActor * actor, int cmd, int ticks)
 static bool ActorTryMove(TActor *actor, int cmd, int hasShot, int ticks)
 {
 	const bool canMoveWhenShooting =
-		ConfigGetEnum(&gConfig, "Game.FireMoveStyle") != FIREMOVE_STOP ||
+		ConfigHandleGetEnum(&configFireMoveStyle) != FIREMOVE_STOP ||
 		!hasShot ||
-		(ConfigGetEnum(&gConfig, "Game.SwitchMoveStyle") == SWITCHMOVE_STRAFE &&
+		(ConfigHandleGetEnum(&configSwitchMoveStyle) == SWITCHMOVE_STRAFE &&
 		(cmd & CMD_BUTTON2));
 	const bool willMove =
 		!actor->petrified && CMD_HAS_DIRECTION(cmd) && canMoveWhenShooting;
@@ -994,7 +1007,7 @@ static void ActorAddGunPickup(const TActor *actor);
 static void ActorDie(TActor *actor)
 {
 	// Add an ammo pickup of the actor's gun
-	if (ConfigGetBool(&gConfig, "Game.Ammo"))
+	if (ConfigHandleGetBool(&configAmmo))
 	{
 		ActorAddAmmoPickup(actor);
 	}
@@ -1100,6 +1113,7 @@ void ActorsInit(void)
 	CArrayInit(&gActors, sizeof(TActor));
 	CArrayReserve(&gActors, 64);
 	sActorUIDs = 0;
+	PoolInit(&sActorPool);
 }
 void ActorsTerminate(void)
 {
@@ -1108,23 +1122,12 @@ void ActorsTerminate(void)
 		ActorDestroy(a);
 	CA_FOREACH_END()
 	CArrayTerminate(&gActors);
+	PoolTerminate(&sActorPool);
 }
 int ActorsGetNextUID(void)
 {
 	return sActorUIDs++;
 }
-int ActorsGetFreeIndex(void)
-{
-	// Find an empty slot in actor list
-	// actors.size if no slot found (i.e. add to end)
-	CA_FOREACH(const TActor, a, gActors)
-		if (!a->isInUse)
-		{
-			return _ca_index;
-		}
-	CA_FOREACH_END()
-	return (int)gActors.size;
-}
 
 static void GoreEmitterInit(Emitter *em, const char *particleClassName);
 TActor *ActorAdd(NActorAdd aa)
@@ -1136,7 +1139,7 @@ TActor *ActorAdd(NActorAdd aa)
 			"actor uid(%d) already exists; not adding", (int)aa.UID);
 		return NULL;
 	}
-	const int id = ActorsGetFreeIndex();
+	const int id = PoolAdd(&sActorPool, aa.UID);
 	while (id >= (int)gActors.size)
 	{
 		TActor a;
@@ -1260,6 +1263,7 @@ void ActorDestroy(TActor *a)
 	if (p != NULL) p->ActorUID = -1;
 	AIContextDestroy(a->aiContext);
 	a->isInUse = false;
+	PoolRemove(&sActorPool, a->tileItem.id);
 }
 
 unsigned char BestMatch(const TPalette palette, int r, int g, int b)
@@ -1284,13 +1288,8 @@ unsigned char BestMatch(const TPalette palette, int r, int g, int b)
 
 TActor *ActorGetByUID(const int uid)
 {
-	CA_FOREACH(TActor, a, gActors)
-		if (a->uid == uid)
-		{
-			return a;
-		}
-	CA_FOREACH_END()
-	return NULL;
+	const int id = PoolFindUID(&sActorPool, uid);
+	return id >= 0 ? CArrayGet(&gActors, id) : NULL;
 }
 
 const Character *ActorGetCharacter(const TActor *a)
@@ -1320,7 +1319,7 @@ bool ActorCanFire(const TActor *a)
 	const bool hasAmmo = ActorGunGetAmmo(a, w) != 0;
 	return
 		!WeaponIsLocked(w) &&
-		(!ConfigGetBool(&gConfig, "Game.Ammo") || hasAmmo);
+		(!ConfigHandleGetBool(&configAmmo) || hasAmmo);
 }
 bool ActorCanSwitchGun(const TActor *a)
 {
@@ -1437,7 +1436,7 @@ bool ActorIsInvulnerable(
 			actor->PlayerUID >= 0 || (actor->flags & FLAGS_GOOD_GUY);
 		// Friendly fire (NPCs)
 		if (!IsPVP(mode) &&
-			!ConfigGetBool(&gConfig, "Game.FriendlyFire") &&
+			!ConfigHandleGetBool(&configFriendlyFire) &&
 			isGood && isTargetGood)
 		{
 			return 1;
@@ -1454,7 +1453,7 @@ bool ActorIsInvulnerable(
 
 void ActorAddBloodSplatters(TActor *a, const int power, const Vec2i hitVector)
 {
-	const GoreAmount ga = ConfigGetEnum(&gConfig, "Game.Gore");
+	const GoreAmount ga = ConfigHandleGetEnum(&configGore);
 	if (ga == GORE_NONE) return;
 
 	// Emit blood based on power and gore setting
@@ -1462,7 +1461,7 @@ void ActorAddBloodSplatters(TActor *a, const int power, const Vec2i hitVector)
 	// Randomly cycle through the blood types
 	int bloodSize = 1;
 	// Spray the blood back with the shot if pushback enabled
-	const bool shotsPushBack = ConfigGetBool(&gConfig, "Game.ShotsPushback");
+	const bool shotsPushBack = ConfigHandleGetBool(&configShotsPushback);
 	while (bloodPower > 0)
 	{
 		Emitter *em = NULL;
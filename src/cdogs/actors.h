@@ -190,7 +190,6 @@ void ActorSetAIState(TActor *actor, const AIState s);
 void ActorsInit(void);
 void ActorsTerminate(void);
 int ActorsGetNextUID(void);
-int ActorsGetFreeIndex(void);
 TActor *ActorAdd(NActorAdd aa);
 void ActorDestroy(TActor *a);
 
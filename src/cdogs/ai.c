@@ -58,6 +58,7 @@
 #include "defs.h"
 #include "actors.h"
 #include "events.h"
+#include "flow_field.h"
 #include "game_events.h"
 #include "gamedata.h"
 #include "handle_game_events.h"
@@ -66,6 +67,9 @@
 #include "sys_specifics.h"
 #include "utils.h"
 
+static ConfigHandle configDifficulty = CONFIG_HANDLE("Game.Difficulty");
+static ConfigHandle configEnemyDensity = CONFIG_HANDLE("Game.EnemyDensity");
+
 static int gBaddieCount = 0;
 static int gAreGoodGuysPresent = 0;
 
@@ -294,7 +298,7 @@ void CommandBadGuys(int ticks)
 	int delayModifier;
 	int rollLimit;
 
-	switch (ConfigGetEnum(&gConfig, "Game.Difficulty"))
+	switch (ConfigHandleGetEnum(&configDifficulty))
 	{
 	case DIFFICULTY_VERYEASY:
 		delayModifier = 4;
@@ -318,6 +322,8 @@ void CommandBadGuys(int ticks)
 		break;
 	}
 
+	FlowFieldsUpdate(&gFlowFields, ticks);
+
 	CA_FOREACH(TActor, actor, gActors)
 		if (!actor->isInUse)
 		{
@@ -485,7 +491,7 @@ void CommandBadGuys(int ticks)
 	CA_FOREACH_END()
 	if (gMission.missionData->Enemies.size > 0 &&
 		gMission.missionData->EnemyDensity > 0 &&
-		count < MAX(1, (gMission.missionData->EnemyDensity * ConfigGetInt(&gConfig, "Game.EnemyDensity")) / 100))
+		count < MAX(1, (gMission.missionData->EnemyDensity * ConfigHandleGetInt(&configEnemyDensity)) / 100))
 	{
 		NActorAdd aa = NActorAdd_init_default;
 		aa.UID = ActorsGetNextUID();
@@ -523,6 +529,14 @@ static int Follow(TActor *a)
 	else
 	{
 		ActorSetAIState(a, AI_STATE_FOLLOW);
+		// Share the player's flow field with other followers to get around
+		// obstacles, instead of pathfinding
+		const TActor *player = AIGetClosestPlayer(a->Pos);
+		int cmd;
+		if (player != NULL && AIFlowTowards(a, player, &cmd))
+		{
+			return cmd;
+		}
 		return AIGoto(a, AIGetClosestPlayerPos(a->Pos), true);
 	}
 }
@@ -597,7 +611,7 @@ void CreateEnemies(void)
 
 	const int density =
 		gMission.missionData->EnemyDensity *
-		ConfigGetInt(&gConfig, "Game.EnemyDensity");
+		ConfigHandleGetInt(&configEnemyDensity);
 	for (int i = 0; i < density / 100; i++)
 	{
 		NActorAdd aa = NActorAdd_init_default;
@@ -32,6 +32,8 @@
 #include "gamedata.h"
 #include "pickup.h"
 
+static ConfigHandle configAmmo = CONFIG_HANDLE("Game.Ammo");
+
 // How many ticks to stay in one confusion state
 #define CONFUSION_STATE_TICKS_MIN 25
 #define CONFUSION_STATE_TICKS_RANGE 25
@@ -163,7 +165,7 @@ static int AICoopGetCmdNormal(TActor *actor)
 
 	// Check the weapon for ammo
 	int lowAmmoGun = -1;
-	if (ConfigGetBool(&gConfig, "Game.Ammo"))
+	if (ConfigHandleGetBool(&configAmmo))
 	{
 		// Check all our weapons
 		// Prefer guns using ammo
@@ -728,7 +730,7 @@ static bool OnClosestPickupGun(
 	ClosestObjective *co, const Pickup *p,
 	const TActor *actor, const TActor *closestPlayer)
 {
-	if (!ConfigGetBool(&gConfig, "Game.Ammo"))
+	if (!ConfigHandleGetBool(&configAmmo))
 	{
 		return false;
 	}
@@ -871,7 +873,7 @@ void AICoopSelectWeapons(
 		p->weaponCount++;
 	}
 
-	if (ConfigGetBool(&gConfig, "Game.Ammo"))
+	if (ConfigHandleGetBool(&configAmmo))
 	{
 		// Select pistol as an infinite-ammo backup
 		const GunDescription *pistol = StrGunDescription("Pistol");
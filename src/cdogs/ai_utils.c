@@ -49,9 +49,11 @@
 #include "ai_utils.h"
 
 #include <assert.h>
+#include <math.h>
 
 #include "algorithms.h"
 #include "collision.h"
+#include "flow_field.h"
 #include "gamedata.h"
 #include "map.h"
 #include "objs.h"
@@ -221,7 +223,6 @@ static bool AIHasClearLine(
 
 	return HasClearLineXiaolinWu(from, to, &data);
 }
-static bool IsTileWalkableOrOpenable(Map *map, Vec2i pos);
 bool IsTileWalkable(Map *map, const Vec2i pos)
 {
 	if (!IsTileWalkableOrOpenable(map, pos))
@@ -292,7 +293,7 @@ static bool IsPosNoWalkAroundObjects(void *data, Vec2i pos)
 {
 	return !IsTileWalkableAroundObjects(data, Vec2iToTile(pos));
 }
-static bool IsTileWalkableOrOpenable(Map *map, Vec2i pos)
+bool IsTileWalkableOrOpenable(Map *map, const Vec2i pos)
 {
 	const Tile *tile = MapGetTile(map, pos);
 	if (tile == NULL)
@@ -605,9 +606,11 @@ int AIHunt(TActor *actor, Vec2i targetPos)
 int AIHuntClosest(TActor *actor)
 {
 	Vec2i targetPos = actor->Pos;
+	const TActor *target = NULL;
 	if (!(actor->PlayerUID >= 0 || (actor->flags & FLAGS_GOOD_GUY)))
 	{
 		targetPos = AIGetClosestPlayerPos(actor->Pos);
+		target = AIGetClosestPlayer(actor->Pos);
 	}
 
 	if (actor->flags & FLAGS_VISIBLE)
@@ -617,11 +620,56 @@ int AIHuntClosest(TActor *actor)
 		if (a)
 		{
 			targetPos = a->Pos;
+			target = a;
 		}
 	}
+	// If hunting a player that is behind obstacles, use the player's flow
+	// field to find a way around
+	int cmd;
+	if (target != NULL && target->PlayerUID >= 0 &&
+		!(actor->flags & FLAGS_RUNS_AWAY) &&
+		AIFlowTowards(actor, target, &cmd))
+	{
+		return cmd;
+	}
 	return AIHunt(actor, targetPos);
 }
 
+// Only follow flow fields if the way to the target is this much longer than
+// a straight line, i.e. there are obstacles in the way
+#define FLOW_DETOUR_RATIO 1.2f
+bool AIFlowTowards(TActor *actor, const TActor *target, int *cmd)
+{
+	const FlowField *ff = FlowFieldsGet(&gFlowFields, target);
+	if (ff == NULL)
+	{
+		return false;
+	}
+	const Vec2i realPos = Vec2iFull2Real(actor->Pos);
+	const Vec2i tile = Vec2iToTile(realPos);
+	const float dist = FlowFieldGetDistance(ff, &gMap, tile);
+	if (dist < 0)
+	{
+		return false;
+	}
+	const float straight = (float)sqrt(DistanceSquared(
+		Vec2iCenterOfTile(tile), Vec2iCenterOfTile(ff->Target)));
+	if (dist <= straight * FLOW_DETOUR_RATIO + TILE_WIDTH)
+	{
+		return false;
+	}
+	// Make sure we are fully within the current tile before moving on,
+	// otherwise we may get stuck at corners
+	Vec2i next = tile;
+	if (IsTileItemInsideTile(&actor->tileItem, tile) &&
+		!FlowFieldGetNext(ff, &gMap, tile, &next))
+	{
+		return false;
+	}
+	*cmd = AIGotoDirect(realPos, Vec2iCenterOfTile(next));
+	return true;
+}
+
 // Move away from the target
 // Usually used for a simple flee
 int AIRetreatFrom(TActor *actor, const Vec2i from)
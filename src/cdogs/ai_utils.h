@@ -74,10 +74,15 @@ int AIGoto(TActor *actor, Vec2i target, bool ignoreObjects);
 int AIGotoDirect(const Vec2i a, const Vec2i p);
 int AIHunt(TActor *actor, Vec2i targetPos);
 int AIHuntClosest(TActor *actor);
+// Move towards a target around obstacles, using its flow field
+// Returns false if the way is clear or there is no way to the target
+bool AIFlowTowards(TActor *actor, const TActor *target, int *cmd);
 int AIRetreatFrom(TActor *actor, const Vec2i from);
 // Like Hunt but biases towards 8 axis movement
 int AITrack(TActor *actor, const Vec2i targetPos);
 
 // Pathfinding helper functions
+// Walkable ignoring all objects, including doors that can be opened
+bool IsTileWalkableOrOpenable(Map *map, const Vec2i pos);
 bool IsTileWalkable(Map *map, const Vec2i pos);
 bool IsTileWalkableAroundObjects(Map *map, const Vec2i pos);
@@ -0,0 +1,204 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "asset_cache.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "sys_config.h"
+#include "utils.h"
+
+#define ASSET_CACHE_MAGIC "CDAC"
+#define PAD8(_x) (((_x) + 7) & ~(size_t)7)
+
+typedef struct
+{
+	char Magic[4];
+	Uint32 Version;
+	Uint32 Tag;
+	Uint32 Count;
+} AssetCacheHeader;
+
+
+static bool ReadEntries(AssetCache *c);
+void AssetCacheOpen(AssetCache *c, const char *path, const Uint32 tag)
+{
+	memset(c, 0, sizeof *c);
+	c->entries = hashmap_new();
+	c->tag = tag;
+	if (!FileMapOpen(&c->file, path))
+	{
+		return;
+	}
+	if (!ReadEntries(c))
+	{
+		LOG(LM_MAIN, LL_INFO, "discarding stale asset cache %s", path);
+		hashmap_free(c->entries);
+		c->entries = hashmap_new();
+	}
+}
+static bool ReadEntries(AssetCache *c)
+{
+	const char *p = c->file.Data;
+	const char *end = p + c->file.Len;
+	if (c->file.Len < sizeof(AssetCacheHeader))
+	{
+		return false;
+	}
+	const AssetCacheHeader *h = (const AssetCacheHeader *)p;
+	if (memcmp(h->Magic, ASSET_CACHE_MAGIC, sizeof h->Magic) != 0 ||
+		h->Version != ASSET_CACHE_VERSION || h->Tag != c->tag)
+	{
+		return false;
+	}
+	p += sizeof *h;
+	for (Uint32 i = 0; i < h->Count; i++)
+	{
+		if ((size_t)(end - p) < sizeof(AssetCacheEntry))
+		{
+			return false;
+		}
+		const AssetCacheEntry *e = (const AssetCacheEntry *)p;
+		p += sizeof *e;
+		const char *name = p;
+		if ((size_t)(end - p) < PAD8((size_t)e->NameLen + 1) ||
+			name[e->NameLen] != '\0')
+		{
+			return false;
+		}
+		p += PAD8((size_t)e->NameLen + 1);
+		if ((size_t)(end - p) < e->DataLen)
+		{
+			return false;
+		}
+		p += MIN(PAD8(e->DataLen), (size_t)(end - p));
+		// Store the entry's offset; the map can't hold const pointers
+		const intptr_t offset = (const char *)e - c->file.Data;
+		if (hashmap_put(c->entries, name, (any_t)offset) != MAP_OK)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+void AssetCacheClose(AssetCache *c)
+{
+	hashmap_free(c->entries);
+	FileMapClose(&c->file);
+	memset(c, 0, sizeof *c);
+}
+
+const void *AssetCacheGet(
+	const AssetCache *c, const char *name, const Sint64 mtime,
+	const Uint64 size, size_t *len)
+{
+	any_t item;
+	if (hashmap_get(c->entries, name, &item) != MAP_OK)
+	{
+		return NULL;
+	}
+	const AssetCacheEntry *e =
+		(const AssetCacheEntry *)(c->file.Data + (intptr_t)item);
+	if (e->MTime != mtime || e->Size != size)
+	{
+		return NULL;
+	}
+	*len = e->DataLen;
+	return (const char *)(e + 1) + PAD8((size_t)e->NameLen + 1);
+}
+
+static bool WritePadded(FILE *f, const void *data, const size_t len);
+bool AssetCacheWrite(const char *path, const Uint32 tag, const CArray *items)
+{
+	bool res = false;
+	char tmpPath[CDOGS_PATH_MAX];
+	snprintf(tmpPath, sizeof tmpPath, "%s.tmp", path);
+	FILE *f = fopen(tmpPath, "wb");
+	if (f == NULL)
+	{
+		LOG(LM_MAIN, LL_WARN, "cannot write asset cache %s: %s",
+			tmpPath, strerror(errno));
+		return false;
+	}
+	AssetCacheHeader h;
+	memcpy(h.Magic, ASSET_CACHE_MAGIC, sizeof h.Magic);
+	h.Version = ASSET_CACHE_VERSION;
+	h.Tag = tag;
+	h.Count = (Uint32)items->size;
+	if (fwrite(&h, sizeof h, 1, f) != 1)
+	{
+		goto bail;
+	}
+	CA_FOREACH(const AssetCacheItem, item, *items)
+		AssetCacheEntry e;
+		e.MTime = item->MTime;
+		e.Size = item->Size;
+		e.NameLen = (Uint32)strlen(item->Name);
+		e.DataLen = (Uint32)item->DataLen;
+		if (fwrite(&e, sizeof e, 1, f) != 1 ||
+			!WritePadded(f, item->Name, e.NameLen + 1) ||
+			!WritePadded(f, item->Data, item->DataLen))
+		{
+			goto bail;
+		}
+	CA_FOREACH_END()
+	res = true;
+
+bail:
+	if (fclose(f) != 0)
+	{
+		res = false;
+	}
+	if (res)
+	{
+#ifdef _WIN32
+		// Windows can't rename over an existing file
+		remove(path);
+#endif
+		res = rename(tmpPath, path) == 0;
+	}
+	if (!res)
+	{
+		LOG(LM_MAIN, LL_WARN, "cannot write asset cache %s: %s",
+			path, strerror(errno));
+		remove(tmpPath);
+	}
+	return res;
+}
+static bool WritePadded(FILE *f, const void *data, const size_t len)
+{
+	static const char zeros[8];
+	const size_t padding = PAD8(len) - len;
+	return
+		(len == 0 || fwrite(data, len, 1, f) == 1) &&
+		(padding == 0 || fwrite(zeros, padding, 1, f) == 1);
+}
@@ -0,0 +1,83 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL_stdinc.h>
+
+#include "c_array.h"
+#include "c_hashmap/hashmap.h"
+#include "file_map.h"
+
+#define ASSET_CACHE_VERSION 1
+
+// Binary file of decoded assets, keyed by the source file's name and
+// valid for as long as the source's size and mtime stay the same
+// The file is mapped read-only, so that cached data is used in place
+// Cached data must be plain bytes with no pointers
+typedef struct
+{
+	FileMap file;
+	map_t entries;	// of name -> offset of AssetCacheEntry in file
+	Uint32 tag;
+} AssetCache;
+
+// Header of each entry in the cache file; the name and data follow,
+// each padded to 8 bytes
+typedef struct
+{
+	Sint64 MTime;
+	Uint64 Size;
+	Uint32 NameLen;
+	Uint32 DataLen;
+} AssetCacheEntry;
+
+// Open the cache file at path; a missing or stale file leaves the cache
+// empty. The tag identifies the decoding, e.g. the pixel format, so that
+// data decoded differently is discarded
+void AssetCacheOpen(AssetCache *c, const char *path, const Uint32 tag);
+void AssetCacheClose(AssetCache *c);
+// Get the cached data of a source file, or NULL if it has changed
+const void *AssetCacheGet(
+	const AssetCache *c, const char *name, const Sint64 mtime,
+	const Uint64 size, size_t *len);
+
+typedef struct
+{
+	const char *Name;
+	Sint64 MTime;
+	Uint64 Size;
+	const void *Data;
+	size_t DataLen;
+} AssetCacheItem;
+// Write a new cache file of AssetCacheItem, replacing the old one only
+// once it has been written in full
+bool AssetCacheWrite(const char *path, const Uint32 tag, const CArray *items);
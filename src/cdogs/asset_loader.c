@@ -0,0 +1,208 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "asset_loader.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <SDL_cpuinfo.h>
+#include <SDL_timer.h>
+#include <tinydir/tinydir.h>
+
+#include "log.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+
+void AssetLoadInit(AssetLoad *l, const char *category)
+{
+	memset(l, 0, sizeof *l);
+	l->Category = category;
+	CArrayInit(&l->Files, sizeof(AssetFile));
+	l->start = SDL_GetPerformanceCounter();
+}
+void AssetLoadTerminate(AssetLoad *l)
+{
+	CArrayTerminate(&l->Files);
+	if (l->cachePath != NULL)
+	{
+		AssetCacheClose(&l->cache);
+	}
+}
+
+static void ScanDir(AssetLoad *l, const char *path, const char *prefix);
+void AssetLoadScan(AssetLoad *l, const char *path)
+{
+	ScanDir(l, path, NULL);
+	l->scanEnd = SDL_GetPerformanceCounter();
+}
+static void ScanDir(AssetLoad *l, const char *path, const char *prefix)
+{
+	tinydir_dir dir;
+	if (tinydir_open(&dir, path) == -1)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Cannot open %s dir '%s'", l->Category, path);
+		goto bail;
+	}
+	for (; dir.has_next; tinydir_next(&dir))
+	{
+		tinydir_file file;
+		if (tinydir_readfile(&dir, &file) == -1)
+		{
+			LOG(LM_MAIN, LL_ERROR, "Cannot read %s file '%s'",
+				l->Category, file.path);
+			continue;
+		}
+		char name[CDOGS_PATH_MAX];
+		if (prefix != NULL)
+		{
+			sprintf(name, "%s/%s", prefix, file.name);
+		}
+		else
+		{
+			strcpy(name, file.name);
+		}
+		if (file.is_reg)
+		{
+			AssetFile f;
+			memset(&f, 0, sizeof f);
+			strcpy(f.Path, file.path);
+			strcpy(f.Name, name);
+			struct stat st;
+			if (stat(file.path, &st) == 0)
+			{
+				f.MTime = (Sint64)st.st_mtime;
+				f.Size = (Uint64)st.st_size;
+			}
+			CArrayPushBack(&l->Files, &f);
+		}
+		else if (file.is_dir && file.name[0] != '.')
+		{
+			ScanDir(l, file.path, name);
+		}
+	}
+
+bail:
+	tinydir_close(&dir);
+}
+
+void AssetLoadUseCache(
+	AssetLoad *l, const char *path, const Uint32 tag,
+	AssetCheckFunc check)
+{
+	l->cachePath = path;
+	l->cacheCheck = check;
+	AssetCacheOpen(&l->cache, path, tag);
+}
+
+static void DecodeFile(void *item);
+void AssetLoadDecode(AssetLoad *l, AssetDecodeFunc decode)
+{
+	CA_FOREACH(AssetFile, f, l->Files)
+		f->decode = decode;
+		if (l->cachePath == NULL) continue;
+		const void *data = AssetCacheGet(
+			&l->cache, f->Name, f->MTime, f->Size, &f->DataLen);
+		if (data != NULL && l->cacheCheck(data, f->DataLen))
+		{
+			// Cached data is read-only; the flag stops it being freed
+			f->Data = (void *)(uintptr_t)data;
+			f->Cached = true;
+			l->cacheHits++;
+		}
+	CA_FOREACH_END()
+	ThreadPool pool;
+	ThreadPoolInit(&pool, MAX(SDL_GetCPUCount() - 1, 0));
+	ThreadPoolRun(
+		&pool, DecodeFile, l->Files.data, l->Files.elemSize,
+		(int)l->Files.size);
+	ThreadPoolTerminate(&pool);
+	l->decodeEnd = SDL_GetPerformanceCounter();
+}
+static void DecodeFile(void *item)
+{
+	AssetFile *f = item;
+	if (f->Cached)
+	{
+		return;
+	}
+	f->Data = f->decode(f->Path, &f->DataLen);
+}
+
+void AssetLoadSaveCache(AssetLoad *l)
+{
+	if (l->cachePath == NULL)
+	{
+		return;
+	}
+	CArray items;
+	CArrayInit(&items, sizeof(AssetCacheItem));
+	CA_FOREACH(const AssetFile, f, l->Files)
+		if (f->Data == NULL || f->DataLen == 0) continue;
+		AssetCacheItem item;
+		item.Name = f->Name;
+		item.MTime = f->MTime;
+		item.Size = f->Size;
+		item.Data = f->Data;
+		item.DataLen = f->DataLen;
+		CArrayPushBack(&items, &item);
+	CA_FOREACH_END()
+	// Every file was cached and nothing was removed, so the cache is current
+	if (l->cacheHits == (int)items.size &&
+		hashmap_length(l->cache.entries) == l->cacheHits)
+	{
+		goto bail;
+	}
+	if (AssetCacheWrite(l->cachePath, l->cache.tag, &items))
+	{
+		LOG(LM_MAIN, LL_DEBUG, "wrote %d %s files to cache %s",
+			(int)items.size, l->Category, l->cachePath);
+	}
+
+bail:
+	CArrayTerminate(&items);
+}
+
+static double CounterMs(const Uint64 counter);
+void AssetLoadLogTimes(const AssetLoad *l)
+{
+	const Uint64 end = SDL_GetPerformanceCounter();
+	LOG(LM_MAIN, LL_INFO,
+		"loaded %d %s files in %.2fms "
+		"(scan %.2fms, decode %.2fms, register %.2fms, %d cached)",
+		(int)l->Files.size, l->Category, CounterMs(end - l->start),
+		CounterMs(l->scanEnd - l->start),
+		CounterMs(l->decodeEnd - l->scanEnd),
+		CounterMs(end - l->decodeEnd), l->cacheHits);
+}
+static double CounterMs(const Uint64 counter)
+{
+	return counter * 1000.0 / SDL_GetPerformanceFrequency();
+}
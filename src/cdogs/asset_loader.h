@@ -0,0 +1,90 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL_stdinc.h>
+
+#include "asset_cache.h"
+#include "c_array.h"
+#include "sys_config.h"
+
+// Decodes the file at path into an asset, setting len to its size if it is
+// cacheable; returns NULL on failure
+// Called on worker threads, so it must not touch shared state
+typedef void *(*AssetDecodeFunc)(const char *path, size_t *len);
+// Whether cached data of len bytes is a whole asset, e.g. that its size
+// matches its header; the cache only checks that the source is unchanged
+typedef bool (*AssetCheckFunc)(const void *data, const size_t len);
+
+typedef struct
+{
+	char Path[CDOGS_PATH_MAX];
+	char Name[CDOGS_PATH_MAX];	// path relative to the scanned dir
+	Sint64 MTime;
+	Uint64 Size;
+	AssetDecodeFunc decode;
+	void *Data;	// decoded asset, or NULL if decoding failed
+	size_t DataLen;
+	bool Cached;	// Data points into the cache and isn't owned
+} AssetFile;
+
+// Loads a directory of assets in three steps: scan the files, decode
+// them in parallel, then register the decoded assets on the calling thread
+// Files are kept in directory order so that registration is deterministic
+typedef struct
+{
+	const char *Category;
+	CArray Files;	// of AssetFile
+	const char *cachePath;
+	AssetCache cache;
+	AssetCheckFunc cacheCheck;
+	int cacheHits;
+	Uint64 start;
+	Uint64 scanEnd;
+	Uint64 decodeEnd;
+} AssetLoad;
+
+void AssetLoadInit(AssetLoad *l, const char *category);
+void AssetLoadTerminate(AssetLoad *l);
+// Find the files under path recursively, skipping hidden dirs
+void AssetLoadScan(AssetLoad *l, const char *path);
+// Take decoded files from the cache at path where they are unchanged and
+// pass the check; others are decoded again
+void AssetLoadUseCache(
+	AssetLoad *l, const char *path, const Uint32 tag,
+	AssetCheckFunc check);
+// Decode every file, using a worker per extra CPU
+void AssetLoadDecode(AssetLoad *l, AssetDecodeFunc decode);
+// Rewrite the cache if any file was decoded or removed
+void AssetLoadSaveCache(AssetLoad *l);
+// Log how long each step took; registration is timed up to this call
+void AssetLoadLogTimes(const AssetLoad *l);
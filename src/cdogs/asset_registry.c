@@ -0,0 +1,156 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "asset_registry.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "utils.h"
+
+
+void AssetRegistryInit(
+	AssetRegistry *r, const CArray *builtin, const CArray *custom,
+	AssetNameFunc nameFunc)
+{
+	memset(r, 0, sizeof *r);
+	r->builtin = builtin;
+	r->custom = custom;
+	r->nameFunc = nameFunc;
+	r->ids = hashmap_new();
+}
+void AssetRegistryTerminate(AssetRegistry *r)
+{
+	if (r->ids != NULL)
+	{
+		hashmap_free(r->ids);
+	}
+	memset(r, 0, sizeof *r);
+}
+
+static void AddIds(
+	AssetRegistry *r, const CArray *assets, const int idStart);
+void AssetRegistryIndex(AssetRegistry *r)
+{
+	// Ignore uninitialised registries, e.g. sounds without audio
+	if (r->builtin == NULL)
+	{
+		return;
+	}
+	if (r->ids != NULL)
+	{
+		hashmap_free(r->ids);
+	}
+	r->ids = hashmap_new();
+	// Add custom assets first so that they take the name
+	AddIds(r, r->custom, (int)r->builtin->size);
+	AddIds(r, r->builtin, 0);
+}
+static void AddIds(
+	AssetRegistry *r, const CArray *assets, const int idStart)
+{
+	for (int i = 0; i < (int)assets->size; i++)
+	{
+		const char *name = r->nameFunc(CArrayGet(assets, i));
+		if (name == NULL || AssetRegistryFind(r, name) >= 0)
+		{
+			continue;
+		}
+		const intptr_t id = idStart + i + 1;
+		if (hashmap_put(r->ids, name, (any_t)id) != MAP_OK)
+		{
+			CASSERT(false, "cannot add asset name");
+		}
+	}
+}
+
+int AssetRegistryFind(const AssetRegistry *r, const char *name)
+{
+	if (r->ids == NULL || name == NULL || name[0] == '\0')
+	{
+		return -1;
+	}
+	any_t id;
+	if (hashmap_get(r->ids, name, &id) != MAP_OK)
+	{
+		return -1;
+	}
+	return (int)(intptr_t)id - 1;
+}
+
+void *AssetRegistryGet(const AssetRegistry *r, const int id)
+{
+	if (r->builtin == NULL || id < 0)
+	{
+		return NULL;
+	}
+	if (id < (int)r->builtin->size)
+	{
+		return CArrayGet(r->builtin, id);
+	}
+	if (id < (int)(r->builtin->size + r->custom->size))
+	{
+		return CArrayGet(r->custom, id - (int)r->builtin->size);
+	}
+	return NULL;
+}
+
+static int ArrayIndex(const CArray *a, const void *elem);
+int AssetRegistryId(const AssetRegistry *r, const void *asset)
+{
+	if (r->builtin == NULL)
+	{
+		return -1;
+	}
+	int idx = ArrayIndex(r->builtin, asset);
+	if (idx >= 0)
+	{
+		return idx;
+	}
+	idx = ArrayIndex(r->custom, asset);
+	if (idx >= 0)
+	{
+		return (int)r->builtin->size + idx;
+	}
+	return -1;
+}
+static int ArrayIndex(const CArray *a, const void *elem)
+{
+	// Assets are stored inline, so the index follows from the address
+	if (a->size == 0)
+	{
+		return -1;
+	}
+	const char *start = a->data;
+	const char *p = elem;
+	if (p < start || p >= start + a->size * a->elemSize)
+	{
+		return -1;
+	}
+	return (int)((size_t)(p - start) / a->elemSize);
+}
@@ -0,0 +1,62 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "c_array.h"
+#include "c_hashmap/hashmap.h"
+
+// Returns the name of an asset stored in a registry's arrays
+typedef const char *(*AssetNameFunc)(const void *);
+
+// Index of interned asset names to integer IDs
+// Assets live in a built-in array and a custom (campaign) array; the ID of
+// an asset is its built-in index, or the built-in count plus its custom
+// index, so hosts with the same data and campaign agree on IDs
+typedef struct
+{
+	const CArray *builtin;
+	const CArray *custom;
+	AssetNameFunc nameFunc;
+	map_t ids;	// of name -> ID + 1
+} AssetRegistry;
+
+void AssetRegistryInit(
+	AssetRegistry *r, const CArray *builtin, const CArray *custom,
+	AssetNameFunc nameFunc);
+void AssetRegistryTerminate(AssetRegistry *r);
+// Rebuild the index; call whenever either array changes
+// Custom assets shadow built-in ones of the same name
+void AssetRegistryIndex(AssetRegistry *r);
+
+// Returns -1 if not found
+int AssetRegistryFind(const AssetRegistry *r, const char *name);
+// Returns NULL if the ID is out of range
+void *AssetRegistryGet(const AssetRegistry *r, const int id);
+// Returns -1 if the asset is not in the registry's arrays
+int AssetRegistryId(const AssetRegistry *r, const void *asset);
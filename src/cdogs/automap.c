@@ -52,6 +52,7 @@
 #include <string.h>
 
 #include "actors.h"
+#include "blit_kernels.h"
 #include "config.h"
 #include "draw.h"
 #include "drawtools.h"
@@ -65,7 +66,7 @@
 
 
 #define MAP_FACTOR 2
-#define MASK_ALPHA 128;
+#define MASK_ALPHA 128
 
 color_t colorWall = { 72, 152, 72, 255 };
 color_t colorFloor = { 12, 92, 12, 255 };
@@ -77,6 +78,8 @@ color_t colorBlueDoor = { 0, 252, 252, 255 };
 color_t colorRedDoor = { 132, 0, 0, 255 };
 color_t colorExit = { 255, 255, 255, 255 };
 
+AutomapCache gAutomapCache;
+
 
 
 static void DisplayPlayer(const TActor *player, Vec2i pos, const int scale)
@@ -95,7 +98,7 @@ static void DisplayPlayer(const TActor *player, Vec2i pos, const int scale)
 }
 
 static void DisplayObjective(
-	TTileItem *t, int objectiveIndex, Vec2i pos, int scale, int flags)
+	const TTileItem *t, int objectiveIndex, Vec2i pos, int scale, int flags)
 {
 	Vec2i objectivePos = Vec2iNew(t->x / TILE_WIDTH, t->y / TILE_HEIGHT);
 	const Objective *o =
@@ -190,60 +193,133 @@ color_t DoorColor(int x, int y)
 	}
 }
 
-void DrawDot(TTileItem *t, color_t color, Vec2i pos, int scale)
+void DrawDot(const TTileItem *t, color_t color, Vec2i pos, int scale)
 {
 	Vec2i dotPos = Vec2iNew(t->x / TILE_WIDTH, t->y / TILE_HEIGHT);
 	pos = Vec2iAdd(pos, Vec2iScale(dotPos, scale));
 	Draw_Rect(pos.x, pos.y, scale, scale, color);
 }
 
+void AutomapCacheInit(AutomapCache *c, const Map *map)
+{
+	AutomapCacheTerminate(c);
+	c->Size = map->Size;
+	CArrayInit(&c->all, sizeof(Uint32));
+	CArrayResize(&c->all, map->Size.x * map->Size.y, NULL);
+	CArrayInit(&c->visited, sizeof(Uint32));
+	CArrayResize(&c->visited, map->Size.x * map->Size.y, NULL);
+	CArrayInit(&c->line, sizeof(Uint32));
+	c->isDirty = true;
+}
+void AutomapCacheTerminate(AutomapCache *c)
+{
+	CArrayTerminate(&c->all);
+	CArrayTerminate(&c->visited);
+	CArrayTerminate(&c->line);
+	memset(c, 0, sizeof *c);
+}
+
+static Uint32 TilePixel(const Tile *tile, const Vec2i pos)
+{
+	if (tile->flags & MAPTILE_IS_NOTHING)
+	{
+		return 0;
+	}
+	color_t color = colorRoom;
+	if (tile->flags & MAPTILE_IS_WALL)
+	{
+		color = colorWall;
+	}
+	else if (tile->flags & MAPTILE_NO_WALK)
+	{
+		color = DoorColor(pos.x, pos.y);
+	}
+	else if (tile->flags & MAPTILE_IS_NORMAL_FLOOR)
+	{
+		color = colorFloor;
+	}
+	return COLOR2PIXEL(color);
+}
+static void UpdateTile(AutomapCache *c, Map *map, const Vec2i pos)
+{
+	const Tile *tile = MapGetTile(map, pos);
+	const int idx = pos.y * c->Size.x + pos.x;
+	const Uint32 pixel = TilePixel(tile, pos);
+	*(Uint32 *)CArrayGet(&c->all, idx) = pixel;
+	*(Uint32 *)CArrayGet(&c->visited, idx) = tile->isVisited ? pixel : 0;
+}
+void AutomapCacheUpdateTile(AutomapCache *c, Map *map, const Vec2i pos)
+{
+	// Dirty caches are updated in full before drawing
+	if (c->isDirty || !Vec2iEqual(c->Size, map->Size))
+	{
+		return;
+	}
+	UpdateTile(c, map, pos);
+}
+static void AutomapCacheUpdateAll(AutomapCache *c, Map *map)
+{
+	Vec2i v;
+	for (v.y = 0; v.y < c->Size.y; v.y++)
+	{
+		for (v.x = 0; v.x < c->Size.x; v.x++)
+		{
+			UpdateTile(c, map, v);
+		}
+	}
+	c->isDirty = false;
+}
+
 static void DrawMap(
 	Map *map,
 	Vec2i center, Vec2i centerOn, Vec2i size,
 	int scale, int flags)
 {
-	int x, y;
-	Vec2i mapPos = Vec2iAdd(center, Vec2iScale(centerOn, -scale));
-	for (y = 0; y < gMap.Size.y; y++)
+	AutomapCache *c = &gAutomapCache;
+	if (c->isDirty)
+	{
+		AutomapCacheUpdateAll(c, map);
+	}
+	const CArray *pixels =
+		(flags & AUTOMAP_FLAGS_SHOWALL) ? &c->all : &c->visited;
+	GraphicsDevice *g = &gGraphicsDevice;
+	const Vec2i mapPos = Vec2iAdd(center, Vec2iScale(centerOn, -scale));
+	// Only look at the tiles that are inside the clipping rect
+	const BlitClipping *clip = GraphicsGetBlitClip(g);
+	const int left = MAX(mapPos.x, clip->left);
+	const int right = MIN(mapPos.x + c->Size.x * scale - 1, clip->right);
+	const int top = MAX(mapPos.y, clip->top);
+	const int bottom =
+		MIN(mapPos.y + c->Size.y * scale - 1, clip->bottom);
+	if (left <= right && top <= bottom)
 	{
-		int i;
-		for (i = 0; i < scale; i++)
+		const int w = right - left + 1;
+		CArrayResize(&c->line, w, NULL);
+		Uint32 *line = c->line.data;
+		const Uint32 white = COLOR2PIXEL(colorWhite);
+		int lineRow = -1;
+		for (int y = top; y <= bottom; y++)
 		{
-			for (x = 0; x < gMap.Size.x; x++)
+			// Scale up a row of tiles into a line of pixels
+			const int row = (y - mapPos.y) / scale;
+			if (row != lineRow)
 			{
-				Tile *tile = MapGetTile(map, Vec2iNew(x, y));
-				if (!(tile->flags & MAPTILE_IS_NOTHING) &&
-					(tile->isVisited || (flags & AUTOMAP_FLAGS_SHOWALL)))
+				const Uint32 *src = CArrayGet(pixels, row * c->Size.x);
+				for (int x = 0; x < w; x++)
 				{
-					int j;
-					for (j = 0; j < scale; j++)
-					{
-						Vec2i drawPos = Vec2iNew(
-							mapPos.x + x*scale + j,
-							mapPos.y + y*scale + i);
-						color_t color = colorRoom;
-						if (tile->flags & MAPTILE_IS_WALL)
-						{
-							color = colorWall;
-						}
-						else if (tile->flags & MAPTILE_NO_WALK)
-						{
-							color = DoorColor(x, y);
-						}
-						else if (tile->flags & MAPTILE_IS_NORMAL_FLOOR)
-						{
-							color = colorFloor;
-						}
-						if (!ColorEquals(color, colorBlack))
-						{
-							if (flags & AUTOMAP_FLAGS_MASK)
-							{
-								color.a = MASK_ALPHA;
-							}
-							Draw_Point(drawPos.x, drawPos.y, color);
-						}
-					}
+					line[x] = src[(left + x - mapPos.x) / scale];
 				}
+				lineRow = row;
+			}
+			Uint32 *dst = g->buf + left + y * g->cachedConfig.Res.x;
+			if (flags & AUTOMAP_FLAGS_MASK)
+			{
+				gBlitKernels->Blend(
+					dst, line, w, white, MASK_ALPHA, g->Amask);
+			}
+			else
+			{
+				gBlitKernels->CopyKeyed(dst, line, w, 0xFFFFFFFF);
 			}
 		}
 	}
@@ -259,24 +335,31 @@ static void DrawMap(
 }
 
 static void DrawTileItem(
-	TTileItem *t, Tile *tile, Vec2i pos, int scale, int flags);
+	const TTileItem *t, Map *map, Vec2i pos, int scale, int flags);
+// Objectives and keys can only be actors, objects or pickups
 static void DrawObjectivesAndKeys(Map *map, Vec2i pos, int scale, int flags)
 {
-	for (int y = 0; y < map->Size.y; y++)
-	{
-		for (int x = 0; x < map->Size.x; x++)
-		{
-			Tile *tile = MapGetTile(map, Vec2iNew(x, y));
-			CA_FOREACH(ThingId, tid, tile->things)
-				DrawTileItem(
-					ThingIdGetTileItem(tid), tile, pos, scale, flags);
-			CA_FOREACH_END()
-		}
-	}
+	CA_FOREACH(const TActor, a, gActors)
+		if (!a->isInUse) continue;
+		DrawTileItem(&a->tileItem, map, pos, scale, flags);
+	CA_FOREACH_END()
+	CA_FOREACH(const TObject, o, gObjs)
+		if (!o->isInUse) continue;
+		DrawTileItem(&o->tileItem, map, pos, scale, flags);
+	CA_FOREACH_END()
+	CA_FOREACH(const Pickup, p, gPickups)
+		if (!p->isInUse) continue;
+		DrawTileItem(&p->tileItem, map, pos, scale, flags);
+	CA_FOREACH_END()
 }
 static void DrawTileItem(
-	TTileItem *t, Tile *tile, Vec2i pos, int scale, int flags)
+	const TTileItem *t, Map *map, Vec2i pos, int scale, int flags)
 {
+	const Tile *tile = MapGetTile(map, Vec2iToTile(Vec2iNew(t->x, t->y)));
+	if (tile == NULL)
+	{
+		return;
+	}
 	if ((t->flags & TILEITEM_OBJECTIVE) != 0)
 	{
 		const int obj = ObjectiveFromTileItem(t->flags);
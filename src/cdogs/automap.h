@@ -35,6 +35,23 @@
 #define AUTOMAP_FLAGS_SHOWALL 0x01
 #define AUTOMAP_FLAGS_MASK 0x02
 
+// Automap pixel of every map tile, kept up to date as tiles are explored
+// or changed, so that drawing the automap doesn't look at every tile
+typedef struct
+{
+	Vec2i Size;
+	CArray all;	// of Uint32; pixel of each tile, or 0 if not drawn
+	CArray visited;	// of Uint32; as above, but 0 for unvisited tiles
+	CArray line;	// of Uint32, scratch for drawing scaled lines
+	bool isDirty;	// all tiles need updating
+} AutomapCache;
+extern AutomapCache gAutomapCache;
+
+void AutomapCacheInit(AutomapCache *c, const Map *map);
+void AutomapCacheTerminate(AutomapCache *c);
+// Call when a tile is visited or changed
+void AutomapCacheUpdateTile(AutomapCache *c, Map *map, const Vec2i pos);
+
 void AutomapDraw(int flags, bool showExit);
 void AutomapDrawRegion(
 	Map *map,
@@ -56,6 +56,7 @@
 
 #include <SDL.h>
 
+#include "blit_kernels.h"
 #include "config.h"
 #include "log.h"
 
@@ -80,16 +81,17 @@ void BlitPicHighlight(
 	GraphicsDevice *g, const Pic *pic, const Vec2i pos, const color_t color)
 {
 	// Draw highlight around the picture
+	const BlitClipping *clip = GraphicsGetBlitClip(g);
 	int i;
 	for (i = -1; i < pic->size.y + 1; i++)
 	{
 		int j;
 		int yoff = i + pos.y + pic->offset.y;
-		if (yoff > g->clipping.bottom)
+		if (yoff > clip->bottom)
 		{
 			break;
 		}
-		if (yoff < g->clipping.top)
+		if (yoff < clip->top)
 		{
 			continue;
 		}
@@ -97,11 +99,11 @@ void BlitPicHighlight(
 		for (j = -1; j < pic->size.x + 1; j++)
 		{
 			int xoff = j + pos.x + pic->offset.x;
-			if (xoff < g->clipping.left)
+			if (xoff < clip->left)
 			{
 				continue;
 			}
-			if (xoff > g->clipping.right)
+			if (xoff > clip->right)
 			{
 				break;
 			}
@@ -125,107 +127,103 @@ void BlitPicHighlight(
 	}
 }
 
+// Visible part of a pic drawn to the device, as row pointers
+typedef struct
+{
+	const Uint32 *src;
+	Uint32 *dst;
+	Vec2i size;
+	int srcStride;
+	int dstStride;
+} BlitRows;
+// Clip a rectangle of pixels, drawn at pos, to the clipping rect
+// Returns false if none of it is visible
+static bool BlitClipRect(
+	const GraphicsDevice *g, const Uint32 *src, const int srcStride,
+	const Vec2i pos, const Vec2i size, BlitRows *r)
+{
+	const BlitClipping *clip = GraphicsGetBlitClip(g);
+	const int left = MAX(pos.x, clip->left);
+	const int top = MAX(pos.y, clip->top);
+	const int right = MIN(pos.x + size.x - 1, clip->right);
+	const int bottom = MIN(pos.y + size.y - 1, clip->bottom);
+	if (left > right || top > bottom)
+	{
+		return false;
+	}
+	r->srcStride = srcStride;
+	r->dstStride = g->cachedConfig.Res.x;
+	r->src = src + (left - pos.x) + (top - pos.y) * r->srcStride;
+	r->dst = g->buf + left + top * r->dstStride;
+	r->size = Vec2iNew(right - left + 1, bottom - top + 1);
+	return true;
+}
+static bool BlitClip(
+	const GraphicsDevice *g, const Pic *pic, const Vec2i pos, BlitRows *r)
+{
+	return BlitClipRect(g, pic->Data, pic->size.x, pos, pic->size, r);
+}
+
 void BlitBackground(
 	GraphicsDevice *device,
 	const Pic *pic, Vec2i pos, const HSV *tint, const bool isTransparent)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitRows r;
+	if (!BlitClip(device, pic, Vec2iAdd(pos, pic->offset), &r))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+		return;
+	}
+	for (int i = 0; i < r.size.y; i++)
+	{
+		const Uint32 *src = r.src + i * r.srcStride;
+		Uint32 *dst = r.dst + i * r.dstStride;
+		if (tint == NULL)
 		{
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
+			if (isTransparent)
 			{
-				current++;
-				continue;
+				gBlitKernels->CopyKeyed(dst, src, r.size.x, 0xFFFFFFFF);
 			}
-			if (xoff > device->clipping.right)
+			else
 			{
-				current += pic->size.x - j;
-				break;
+				memcpy(dst, src, r.size.x * sizeof *dst);
 			}
-			if ((isTransparent && *current) ||  !isTransparent)
+			continue;
+		}
+		for (int j = 0; j < r.size.x; j++)
+		{
+			if (isTransparent && src[j] == 0)
 			{
-				Uint32 *target = gGraphicsDevice.buf + yoff + xoff;
-				if (tint != NULL)
-				{
-					const color_t targetColor = PIXEL2COLOR(*target);
-					const color_t blendedColor = ColorTint(targetColor, *tint);
-					*target = COLOR2PIXEL(blendedColor);
-				}
-				else
-				{
-					*target = *current;
-				}
+				continue;
 			}
-			current++;
+			const color_t targetColor = PIXEL2COLOR(dst[j]);
+			const color_t blendedColor = ColorTint(targetColor, *tint);
+			dst[j] = COLOR2PIXEL(blendedColor);
 		}
 	}
 }
 
 void Blit(GraphicsDevice *device, const Pic *pic, Vec2i pos)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitRows r;
+	if (!BlitClip(device, pic, Vec2iAdd(pos, pic->offset), &r))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if ((*current & device->Amask) == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = *current;
-			current++;
-		}
+		return;
+	}
+	for (int i = 0; i < r.size.y; i++)
+	{
+		gBlitKernels->CopyKeyed(
+			r.dst + i * r.dstStride, r.src + i * r.srcStride, r.size.x,
+			device->Amask);
 	}
 }
 
 static Uint32 PixelMult(Uint32 p, Uint32 m)
 {
 	return
-		((p & 0xFF) * (m & 0xFF) / 0xFF) |
-		((((p & 0xFF00) >> 8) * ((m & 0xFF00) >> 8) / 0xFF) << 8) |
-		((((p & 0xFF0000) >> 16) * ((m & 0xFF0000) >> 16) / 0xFF) << 16) |
-		((((p & 0xFF000000) >> 24) * ((m & 0xFF000000) >> 24) / 0xFF) << 24);
+		DIV255((p & 0xFF) * (m & 0xFF)) |
+		(DIV255(((p >> 8) & 0xFF) * ((m >> 8) & 0xFF)) << 8) |
+		(DIV255(((p >> 16) & 0xFF) * ((m >> 16) & 0xFF)) << 16) |
+		(DIV255((p >> 24) * (m >> 24)) << 24);
 }
 void BlitMasked(
 	GraphicsDevice *device,
@@ -234,96 +232,74 @@ void BlitMasked(
 	color_t mask,
 	int isTransparent)
 {
-	Uint32 *current = pic->Data;
+	BlitRows r;
+	if (!BlitClip(device, pic, Vec2iAdd(pos, pic->offset), &r))
+	{
+		return;
+	}
 	const Uint32 maskPixel = COLOR2PIXEL(mask);
-	int i;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (i = 0; i < pic->size.y; i++)
+	for (int i = 0; i < r.size.y; i++)
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (isTransparent && *current == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = PixelMult(*current, maskPixel);
-			current++;
-		}
+		gBlitKernels->Mult(
+			r.dst + i * r.dstStride, r.src + i * r.srcStride, r.size.x,
+			maskPixel, isTransparent);
 	}
 }
 static color_t CharColorsGetChannelMask(
 	const CharColors *c, const uint8_t alpha);
+void BlitPixels(
+	GraphicsDevice *g, const Uint32 *src, const int srcStride,
+	const Vec2i pos, const Vec2i size, const color_t mask)
+{
+	BlitRows r;
+	if (!BlitClipRect(g, src, srcStride, pos, size, &r))
+	{
+		return;
+	}
+	if (ColorEquals(mask, colorWhite))
+	{
+		for (int i = 0; i < r.size.y; i++)
+		{
+			memcpy(
+				r.dst + i * r.dstStride, r.src + i * r.srcStride,
+				r.size.x * sizeof *r.dst);
+		}
+		return;
+	}
+	const Uint32 maskPixel = COLOR2PIXEL(mask);
+	for (int i = 0; i < r.size.y; i++)
+	{
+		gBlitKernels->Mult(
+			r.dst + i * r.dstStride, r.src + i * r.srcStride, r.size.x,
+			maskPixel, false);
+	}
+}
+
 void BlitCharMultichannel(
 	GraphicsDevice *device,
 	const Pic *pic,
 	const Vec2i pos,
 	const CharColors *masks)
 {
-	Uint32 *current = pic->Data;
-	Vec2i v = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitRows r;
+	if (!BlitClip(device, pic, Vec2iAdd(pos, pic->offset), &r))
 	{
-		int yoff = i + v.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+		return;
+	}
+	for (int i = 0; i < r.size.y; i++)
+	{
+		const Uint32 *src = r.src + i * r.srcStride;
+		Uint32 *dst = r.dst + i * r.dstStride;
+		for (int j = 0; j < r.size.x; j++)
 		{
-			Uint32 *target;
-			const int xoff = j + v.x;
-			if (xoff < device->clipping.left)
+			if (src[j] == 0)
 			{
-				current++;
 				continue;
 			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (*current == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			const color_t color = PIXEL2COLOR(*current);
-			*target = PixelMult(
-				*current,
+			const color_t color = PIXEL2COLOR(src[j]);
+			dst[j] = PixelMult(
+				src[j],
 				COLOR2PIXEL(CharColorsGetChannelMask(masks, color.a)));
-			current++;
 		}
 	}
 }
@@ -346,49 +322,17 @@ static color_t CharColorsGetChannelMask(
 void BlitBlend(
 	GraphicsDevice *g, const Pic *pic, Vec2i pos, const color_t blend)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitRows r;
+	if (!BlitClip(g, pic, Vec2iAdd(pos, pic->offset), &r))
 	{
-		int yoff = i + pos.y;
-		if (yoff > g->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < g->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= g->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			int xoff = j + pos.x;
-			if (xoff < g->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > g->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (*current == 0)
-			{
-				current++;
-				continue;
-			}
-			Uint32 *target = g->buf + yoff + xoff;
-			const color_t currentColor = PIXEL2COLOR(*current);
-			color_t blendedColor = ColorMult(
-				currentColor, blend);
-			blendedColor.a = blend.a;
-			const color_t targetColor = PIXEL2COLOR(*target);
-			blendedColor = ColorAlphaBlend(targetColor, blendedColor);
-			*target = COLOR2PIXEL(blendedColor);
-			current++;
-		}
+		return;
+	}
+	const Uint32 blendPixel = COLOR2PIXEL(blend);
+	for (int i = 0; i < r.size.y; i++)
+	{
+		gBlitKernels->Blend(
+			r.dst + i * r.dstStride, r.src + i * r.srcStride, r.size.x,
+			blendPixel, blend.a, g->Amask);
 	}
 }
 
@@ -398,41 +342,19 @@ static void ApplyBrightness(Uint32 *screen, Vec2i screenSize, int brightness)
 	{
 		return;
 	}
-	double f = pow(1.07177346254, brightness);	// 10th root of 2; i.e. n^10 = 2
-	int m = (int)(0xFF * f);
-	int y;
-	for (y = 0; y < screenSize.y; y++)
+	// Rebuild the lookup table only when the brightness changes
+	static BlitBrightness b;
+	if (b.Level != brightness)
 	{
-		int x;
-		for (x = 0; x < screenSize.x; x++)
-		{
-			// Semi-optimised pixel multiplcation routine
-			// Multiply each 8-bit component with the gamma mask
-			// Detect overflows by checking if there are bits above 255
-			// If so, turning into boolean (!!) and negation will create
-			// a -1 (i.e. FFFFFFFF) mask which fills all the bits with 1
-			// i.e. saturated multiply
-			int idx = x + y * screenSize.x;
-			Uint32 p = screen[idx];
-			Uint32 pp;
-			screen[idx] = 0;
-			pp = ((p & 0xFF) * m / 0xFF);
-			screen[idx] |= (pp | -!!(pp >> 8)) & 0xFF;
-			pp = (((p >> 8) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 8;
-			pp = (((p >> 16) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 16;
-			pp = (((p >> 24) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 24;
-		}
+		BlitBrightnessInit(&b, brightness);
 	}
+	gBlitKernels->Brightness(screen, screenSize.x * screenSize.y, &b);
 }
 
 void BlitFlip(GraphicsDevice *g)
 {
 	ApplyBrightness(
-		g->buf, g->cachedConfig.Res,
-		ConfigGetInt(&gConfig, "Graphics.Brightness"));
+		g->buf, g->cachedConfig.Res, g->cachedConfig.Brightness);
 
 	SDL_UpdateTexture(
 		g->screen, NULL, g->buf, g->cachedConfig.Res.x * sizeof(Uint32));
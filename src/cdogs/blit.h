@@ -84,6 +84,11 @@ void BlitMasked(
 	Vec2i pos,
 	color_t mask,
 	int isTransparent);
+// Draw a rectangle of opaque pixels, with srcStride pixels between lines,
+// multiplied by mask; same as BlitMasked but from any pixel buffer
+void BlitPixels(
+	GraphicsDevice *g, const Uint32 *src, const int srcStride,
+	const Vec2i pos, const Vec2i size, const color_t mask);
 void BlitCharMultichannel(
 	GraphicsDevice *device,
 	const Pic *pic,
@@ -0,0 +1,161 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "blit_kernels.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+// Process 8 pixels at a time, leaving the rest of the row to the scalar
+// kernels
+// Note: unpack and pack work within each 128-bit lane, so pixel order is
+// preserved
+#define STEP 8
+
+// Exact division by 255 of 16-bit lanes holding at most 65279
+#define DIV255_EPI16(_x) _mm256_srli_epi16( \
+	_mm256_add_epi16(_mm256_add_epi16((_x), one), _mm256_srli_epi16((_x), 8)), 8)
+
+// Lanes of b where key is set, otherwise lanes of a
+#define SELECT(_key, _a, _b) \
+	_mm256_or_si256(_mm256_and_si256((_key), (_b)), _mm256_andnot_si256((_key), (_a)))
+
+
+static void CopyKeyed(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 keyMask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i key = _mm256_set1_epi32((int)keyMask);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		const __m256i skip = _mm256_cmpeq_epi32(_mm256_and_si256(s, key), zero);
+		_mm256_storeu_si256((__m256i *)(dst + i), SELECT(skip, s, d));
+	}
+	gBlitKernelsScalar.CopyKeyed(dst + i, src + i, n - i, keyMask);
+}
+static void Mult(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i m = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)mask), zero);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), m);
+		__m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), m);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		__m256i r = _mm256_packus_epi16(lo, hi);
+		if (isTransparent)
+		{
+			const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+			r = SELECT(_mm256_cmpeq_epi32(s, zero), r, d);
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i), r);
+	}
+	gBlitKernelsScalar.Mult(dst + i, src + i, n - i, mask, isTransparent);
+}
+static void Blend(
+	Uint32 *dst, const Uint32 *src, const int n,
+	const Uint32 blend, const Uint8 alpha, const Uint32 amask)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i b = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)blend), zero);
+	const __m256i a = _mm256_set1_epi16(alpha);
+	const __m256i ia = _mm256_set1_epi16(0xFF - alpha);
+	const __m256i am = _mm256_set1_epi32((int)amask);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		__m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), b);
+		__m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), b);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		lo = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), ia),
+			_mm256_mullo_epi16(lo, a));
+		hi = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), ia),
+			_mm256_mullo_epi16(hi, a));
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		// The alpha channel is computed too, but overwritten as opaque
+		const __m256i r = _mm256_or_si256(_mm256_packus_epi16(lo, hi), am);
+		_mm256_storeu_si256(
+			(__m256i *)(dst + i), SELECT(_mm256_cmpeq_epi32(s, zero), r, d));
+	}
+	gBlitKernelsScalar.Blend(dst + i, src + i, n - i, blend, alpha, amask);
+}
+static void Brightness(Uint32 *buf, const int n, const BlitBrightness *b)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	// Multipliers over 255 are split into c + c * (m - 255) / 255 so that
+	// the products fit in 16 bits; the pack saturates the result
+	const bool isBrighter = b->Mult > 0xFF;
+	const __m256i m =
+		_mm256_set1_epi16((short)(isBrighter ? b->Mult - 0xFF : b->Mult));
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m256i p = _mm256_loadu_si256((const __m256i *)(buf + i));
+		const __m256i plo = _mm256_unpacklo_epi8(p, zero);
+		const __m256i phi = _mm256_unpackhi_epi8(p, zero);
+		__m256i lo = _mm256_mullo_epi16(plo, m);
+		__m256i hi = _mm256_mullo_epi16(phi, m);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		if (isBrighter)
+		{
+			lo = _mm256_add_epi16(lo, plo);
+			hi = _mm256_add_epi16(hi, phi);
+		}
+		_mm256_storeu_si256((__m256i *)(buf + i), _mm256_packus_epi16(lo, hi));
+	}
+	gBlitKernelsScalar.Brightness(buf + i, n - i, b);
+}
+static const BlitKernels kernels =
+{
+	"AVX2", CopyKeyed, Mult, Blend, Brightness
+};
+const BlitKernels *gBlitKernelsAVX2 = &kernels;
+
+#else
+
+const BlitKernels *gBlitKernelsAVX2 = NULL;
+
+#endif
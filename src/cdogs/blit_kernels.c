@@ -0,0 +1,169 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "blit_kernels.h"
+
+#include <math.h>
+
+#include <SDL_cpuinfo.h>
+
+#include "log.h"
+#include "utils.h"
+
+
+void BlitBrightnessInit(BlitBrightness *b, const int level)
+{
+	b->Level = level;
+	// 10th root of 2; i.e. n^10 = 2
+	b->Mult = level == 0 ? 0xFF : (int)(0xFF * pow(1.07177346254, level));
+	for (int i = 0; i < 256; i++)
+	{
+		b->LUT[i] = (Uint8)MIN(i * b->Mult / 0xFF, 0xFF);
+	}
+}
+
+
+static void CopyKeyed(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 keyMask)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (src[i] & keyMask)
+		{
+			dst[i] = src[i];
+		}
+	}
+}
+static void Mult(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	for (int i = 0; i < n; i++)
+	{
+		const Uint32 p = src[i];
+		if (isTransparent && p == 0)
+		{
+			continue;
+		}
+		Uint32 out = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			const Uint32 c = ((p >> shift) & 0xFF) * ((mask >> shift) & 0xFF);
+			out |= DIV255(c) << shift;
+		}
+		dst[i] = out;
+	}
+}
+static void Blend(
+	Uint32 *dst, const Uint32 *src, const int n,
+	const Uint32 blend, const Uint8 alpha, const Uint32 amask)
+{
+	for (int i = 0; i < n; i++)
+	{
+		const Uint32 p = src[i];
+		if (p == 0)
+		{
+			continue;
+		}
+		const Uint32 t = dst[i];
+		Uint32 out = amask;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			if ((amask >> shift) & 0xFF)
+			{
+				continue;
+			}
+			Uint32 c = ((p >> shift) & 0xFF) * ((blend >> shift) & 0xFF);
+			c = DIV255(c);
+			c = ((t >> shift) & 0xFF) * (0xFF - alpha) + c * alpha;
+			out |= DIV255(c) << shift;
+		}
+		dst[i] = out;
+	}
+}
+static void Brightness(Uint32 *buf, const int n, const BlitBrightness *b)
+{
+	for (int i = 0; i < n; i++)
+	{
+		const Uint32 p = buf[i];
+		buf[i] =
+			(Uint32)b->LUT[p & 0xFF] |
+			((Uint32)b->LUT[(p >> 8) & 0xFF] << 8) |
+			((Uint32)b->LUT[(p >> 16) & 0xFF] << 16) |
+			((Uint32)b->LUT[p >> 24] << 24);
+	}
+}
+const BlitKernels gBlitKernelsScalar =
+{
+	"scalar", CopyKeyed, Mult, Blend, Brightness
+};
+
+
+const BlitKernels *gBlitKernels = &gBlitKernelsScalar;
+
+const char *BlitKernelsTypeStr(const BlitKernelsType t)
+{
+	switch (t)
+	{
+		T2S(BLIT_KERNELS_SCALAR, "scalar");
+		T2S(BLIT_KERNELS_SSE2, "SSE2");
+		T2S(BLIT_KERNELS_AVX2, "AVX2");
+	default:
+		return "";
+	}
+}
+
+void BlitKernelsInit(void)
+{
+	for (int t = BLIT_KERNELS_COUNT - 1; t >= 0; t--)
+	{
+		const BlitKernels *k = BlitKernelsGet((BlitKernelsType)t);
+		if (k != NULL)
+		{
+			gBlitKernels = k;
+			break;
+		}
+	}
+	LOG(LM_GFX, LL_INFO, "using %s blit kernels", gBlitKernels->Name);
+}
+
+const BlitKernels *BlitKernelsGet(const BlitKernelsType t)
+{
+	switch (t)
+	{
+	case BLIT_KERNELS_SCALAR:
+		return &gBlitKernelsScalar;
+	case BLIT_KERNELS_SSE2:
+		return SDL_HasSSE2() ? gBlitKernelsSSE2 : NULL;
+	case BLIT_KERNELS_AVX2:
+		return SDL_HasAVX2() ? gBlitKernelsAVX2 : NULL;
+	default:
+		CASSERT(false, "unknown blit kernels type");
+		return NULL;
+	}
+}
@@ -0,0 +1,93 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+// Row kernels used by the blitters. Each processes n contiguous pixels of
+// one row; clipping is done by the caller.
+// There are scalar and SIMD implementations, chosen at runtime by what the
+// CPU supports; all of them produce identical results.
+
+typedef struct
+{
+	int Level;
+	// Channel multiplier out of 255; results saturate at 255
+	int Mult;
+	Uint8 LUT[256];
+} BlitBrightness;
+void BlitBrightnessInit(BlitBrightness *b, const int level);
+
+typedef struct
+{
+	const char *Name;
+	// Copy source pixels that have any bits of keyMask set
+	void (*CopyKeyed)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 keyMask);
+	// Multiply each channel of the source pixels by the mask pixel
+	// If isTransparent, zero source pixels are skipped
+	void (*Mult)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+		const bool isTransparent);
+	// Multiply the source pixels by the blend pixel, then alpha blend them
+	// onto the target with the blend alpha, giving opaque pixels
+	// Zero source pixels are skipped
+	void (*Blend)(
+		Uint32 *dst, const Uint32 *src, const int n,
+		const Uint32 blend, const Uint8 alpha, const Uint32 amask);
+	// Scale each channel by the brightness multiplier
+	void (*Brightness)(Uint32 *buf, const int n, const BlitBrightness *b);
+} BlitKernels;
+
+typedef enum
+{
+	BLIT_KERNELS_SCALAR,
+	BLIT_KERNELS_SSE2,
+	BLIT_KERNELS_AVX2,
+	BLIT_KERNELS_COUNT
+} BlitKernelsType;
+const char *BlitKernelsTypeStr(const BlitKernelsType t);
+
+// Kernels currently used by the blitters
+extern const BlitKernels *gBlitKernels;
+// Select the fastest kernels that the CPU supports
+void BlitKernelsInit(void);
+// Get kernels by type; NULL if not built or not supported by the CPU
+const BlitKernels *BlitKernelsGet(const BlitKernelsType t);
+
+// Exact x / 255 for 0 <= x <= 65279, without dividing
+#define DIV255(_x) (((_x) + 1 + ((_x) >> 8)) >> 8)
+
+extern const BlitKernels gBlitKernelsScalar;
+// SIMD implementations, defined in their own files so they can be built
+// with the instruction set enabled; NULL if not built for this target
+extern const BlitKernels *gBlitKernelsSSE2;
+extern const BlitKernels *gBlitKernelsAVX2;
@@ -0,0 +1,160 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "blit_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+// Process 4 pixels at a time, leaving the rest of the row to the scalar
+// kernels
+#define STEP 4
+
+// Exact division by 255 of 16-bit lanes holding at most 65279
+#define DIV255_EPI16(_x) _mm_srli_epi16( \
+	_mm_add_epi16(_mm_add_epi16((_x), one), _mm_srli_epi16((_x), 8)), 8)
+
+// Lanes of b where key is set, otherwise lanes of a
+#define SELECT(_key, _a, _b) \
+	_mm_or_si128(_mm_and_si128((_key), (_b)), _mm_andnot_si128((_key), (_a)))
+
+
+static void CopyKeyed(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 keyMask)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i key = _mm_set1_epi32((int)keyMask);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		const __m128i skip = _mm_cmpeq_epi32(_mm_and_si128(s, key), zero);
+		_mm_storeu_si128((__m128i *)(dst + i), SELECT(skip, s, d));
+	}
+	gBlitKernelsScalar.CopyKeyed(dst + i, src + i, n - i, keyMask);
+}
+static void Mult(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i m = _mm_unpacklo_epi8(_mm_set1_epi32((int)mask), zero);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), m);
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), m);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		__m128i r = _mm_packus_epi16(lo, hi);
+		if (isTransparent)
+		{
+			const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+			r = SELECT(_mm_cmpeq_epi32(s, zero), r, d);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), r);
+	}
+	gBlitKernelsScalar.Mult(dst + i, src + i, n - i, mask, isTransparent);
+}
+static void Blend(
+	Uint32 *dst, const Uint32 *src, const int n,
+	const Uint32 blend, const Uint8 alpha, const Uint32 amask)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i b = _mm_unpacklo_epi8(_mm_set1_epi32((int)blend), zero);
+	const __m128i a = _mm_set1_epi16(alpha);
+	const __m128i ia = _mm_set1_epi16(0xFF - alpha);
+	const __m128i am = _mm_set1_epi32((int)amask);
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), b);
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), b);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		lo = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia),
+			_mm_mullo_epi16(lo, a));
+		hi = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia),
+			_mm_mullo_epi16(hi, a));
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		// The alpha channel is computed too, but overwritten as opaque
+		const __m128i r = _mm_or_si128(_mm_packus_epi16(lo, hi), am);
+		_mm_storeu_si128(
+			(__m128i *)(dst + i), SELECT(_mm_cmpeq_epi32(s, zero), r, d));
+	}
+	gBlitKernelsScalar.Blend(dst + i, src + i, n - i, blend, alpha, amask);
+}
+static void Brightness(Uint32 *buf, const int n, const BlitBrightness *b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	// Multipliers over 255 are split into c + c * (m - 255) / 255 so that
+	// the products fit in 16 bits; the pack saturates the result
+	const bool isBrighter = b->Mult > 0xFF;
+	const __m128i m =
+		_mm_set1_epi16((short)(isBrighter ? b->Mult - 0xFF : b->Mult));
+	int i = 0;
+	for (; i + STEP <= n; i += STEP)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i *)(buf + i));
+		const __m128i plo = _mm_unpacklo_epi8(p, zero);
+		const __m128i phi = _mm_unpackhi_epi8(p, zero);
+		__m128i lo = _mm_mullo_epi16(plo, m);
+		__m128i hi = _mm_mullo_epi16(phi, m);
+		lo = DIV255_EPI16(lo);
+		hi = DIV255_EPI16(hi);
+		if (isBrighter)
+		{
+			lo = _mm_add_epi16(lo, plo);
+			hi = _mm_add_epi16(hi, phi);
+		}
+		_mm_storeu_si128((__m128i *)(buf + i), _mm_packus_epi16(lo, hi));
+	}
+	gBlitKernelsScalar.Brightness(buf + i, n - i, b);
+}
+static const BlitKernels kernels =
+{
+	"SSE2", CopyKeyed, Mult, Blend, Brightness
+};
+const BlitKernels *gBlitKernelsSSE2 = &kernels;
+
+#else
+
+const BlitKernels *gBlitKernelsSSE2 = NULL;
+
+#endif
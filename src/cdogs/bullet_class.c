@@ -65,27 +65,26 @@ BulletClasses gBulletClasses;
 #define SPECIAL_LOCK 12
 
 
-// TODO: use map structure?
 BulletClass *StrBulletClass(const char *s)
 {
 	if (s == NULL || strlen(s) == 0)
 	{
 		return NULL;
 	}
-	CA_FOREACH(BulletClass, b, gBulletClasses.CustomClasses)
-		if (strcmp(s, b->Name) == 0)
-		{
-			return b;
-		}
-	CA_FOREACH_END()
-	CA_FOREACH(BulletClass, b, gBulletClasses.Classes)
-		if (strcmp(s, b->Name) == 0)
-		{
-			return b;
-		}
-	CA_FOREACH_END()
-	CASSERT(false, "cannot parse bullet name");
-	return NULL;
+	BulletClass *b = IdBulletClass(
+		AssetRegistryFind(&gBulletClasses.registry, s));
+	CASSERT(b != NULL, "cannot parse bullet name");
+	return b;
+}
+BulletClass *IdBulletClass(const int id)
+{
+	return AssetRegistryGet(&gBulletClasses.registry, id);
+}
+int BulletClassId(const BulletClass *b)
+{
+	const int id = AssetRegistryId(&gBulletClasses.registry, b);
+	CASSERT(id >= 0, "cannot find bullet class");
+	return id;
 }
 
 // Draw functions
@@ -460,6 +459,7 @@ static HitType GetHitType(
 
 
 #define VERSION 1
+static const char *BulletClassName(const void *b);
 static void LoadBullet(
 	BulletClass *b, json_t *node, const BulletClass *defaultBullet);
 void BulletInitialize(BulletClasses *bullets)
@@ -467,6 +467,13 @@ void BulletInitialize(BulletClasses *bullets)
 	memset(bullets, 0, sizeof *bullets);
 	CArrayInit(&bullets->Classes, sizeof(BulletClass));
 	CArrayInit(&bullets->CustomClasses, sizeof(BulletClass));
+	AssetRegistryInit(
+		&bullets->registry, &bullets->Classes, &bullets->CustomClasses,
+		BulletClassName);
+}
+static const char *BulletClassName(const void *b)
+{
+	return ((const BulletClass *)b)->Name;
 }
 static void BulletClassFree(BulletClass *b);
 void BulletLoadJSON(
@@ -496,6 +503,7 @@ void BulletLoadJSON(
 		LoadBullet(&b, child, &bullets->Default);
 		CArrayPushBack(classes, &b);
 	}
+	AssetRegistryIndex(&bullets->registry);
 
 	bullets->root = bulletNode;
 }
@@ -677,6 +685,7 @@ static void BulletClassesLoadWeapons(CArray *classes)
 }
 void BulletTerminate(BulletClasses *bullets)
 {
+	AssetRegistryTerminate(&bullets->registry);
 	BulletClassFree(&bullets->Default);
 	BulletClassesClear(&bullets->Classes);
 	CArrayTerminate(&bullets->Classes);
@@ -707,29 +716,8 @@ void BulletAdd(const NAddBullet add)
 {
 	const Vec2i pos = Net2Vec2i(add.MuzzlePos);
 
-	// Find an empty slot in mobobj list
-	TMobileObject *obj = NULL;
-	int i;
-	for (i = 0; i < (int)gMobObjs.size; i++)
-	{
-		TMobileObject *m = CArrayGet(&gMobObjs, i);
-		if (!m->isInUse)
-		{
-			obj = m;
-			break;
-		}
-	}
-	if (obj == NULL)
-	{
-		TMobileObject m;
-		memset(&m, 0, sizeof m);
-		CArrayPushBack(&gMobObjs, &m);
-		i = (int)gMobObjs.size - 1;
-		obj = CArrayGet(&gMobObjs, i);
-	}
-	memset(obj, 0, sizeof *obj);
-	obj->UID = add.UID;
-	obj->bulletClass = StrBulletClass(add.BulletClass);
+	TMobileObject *obj = MobObjAdd(add.UID);
+	obj->bulletClass = IdBulletClass(add.BulletClassId);
 	obj->x = pos.x;
 	obj->y = pos.y;
 	obj->z = add.MuzzleHeight;
@@ -754,13 +742,9 @@ void BulletAdd(const NAddBullet add)
 		obj->flags |= FLAGS_HURTALWAYS;
 	}
 
-	obj->tileItem.kind = KIND_MOBILEOBJECT;
-	obj->tileItem.id = i;
-	obj->isInUse = true;
-	obj->tileItem.x = obj->tileItem.y = -1;
 	obj->tileItem.getPicFunc = NULL;
 	obj->tileItem.drawFunc = NULL;
-	obj->tileItem.drawData.MobObjId = i;
+	obj->tileItem.drawData.MobObjId = obj->tileItem.id;
 	obj->tileItem.CPic = obj->bulletClass->CPic;
 	obj->tileItem.CPicFunc = GetBulletDrawContext;
 	obj->tileItem.size = obj->bulletClass->Size;
@@ -52,6 +52,7 @@
 
 #include "proto/msg.pb.h"
 
+#include "asset_registry.h"
 #include "particle.h"
 #include "sounds.h"
 #include "tile.h"
@@ -104,11 +105,14 @@ typedef struct
 	CArray Classes;	// of BulletClass
 	BulletClass Default;
 	CArray CustomClasses;	// of BulletClass
+	AssetRegistry registry;	// of Classes and CustomClasses
 	json_t *root;
 } BulletClasses;
 extern BulletClasses gBulletClasses;
 
 BulletClass *StrBulletClass(const char *s);
+BulletClass *IdBulletClass(const int id);
+int BulletClassId(const BulletClass *b);
 
 void BulletInitialize(BulletClasses *bullets);
 void BulletLoadJSON(
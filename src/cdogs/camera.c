@@ -32,8 +32,11 @@
 #include "events.h"
 #include "font.h"
 #include "los.h"
+#include "particle.h"
 #include "player.h"
 
+static ConfigHandle configSplitscreen = CONFIG_HANDLE("Interface.Splitscreen");
+
 
 #define PAN_SPEED 4
 
@@ -42,6 +45,17 @@ void CameraInit(Camera *camera)
 	memset(camera, 0, sizeof *camera);
 	DrawBufferInit(
 		&camera->Buffer, Vec2iNew(X_TILES, Y_TILES), &gGraphicsDevice);
+	for (int i = 0; i < MAX_LOCAL_PLAYERS; i++)
+	{
+		DrawBufferInit(
+			&camera->views[i].Buffer, Vec2iNew(X_TILES, Y_TILES),
+			&gGraphicsDevice);
+	}
+	// The calling thread draws one of the views itself
+	ThreadPoolInit(
+		&camera->viewThreads,
+		ConfigGetBool(&gConfig, "Graphics.ThreadedRender") ?
+		MAX_LOCAL_PLAYERS - 1 : 0);
 	camera->lastPosition = Vec2iZero();
 	HUDInit(&camera->HUD, &gGraphicsDevice, &gMission);
 	camera->shake = ScreenShakeZero();
@@ -50,6 +64,11 @@ void CameraInit(Camera *camera)
 void CameraTerminate(Camera *camera)
 {
 	DrawBufferTerminate(&camera->Buffer);
+	for (int i = 0; i < MAX_LOCAL_PLAYERS; i++)
+	{
+		DrawBufferTerminate(&camera->views[i].Buffer);
+	}
+	ThreadPoolTerminate(&camera->viewThreads);
 	HUDTerminate(&camera->HUD);
 }
 
@@ -117,6 +136,10 @@ void CameraUpdate(Camera *camera, const int ticks, const int ms)
 static void FollowPlayer(Vec2i *pos, const int playerUID);
 static void DoBuffer(
 	DrawBuffer *b, Vec2i center, int w, Vec2i noise, Vec2i offset);
+static void AddView(
+	Camera *camera, const Vec2i center, const int w, const Vec2i noise,
+	const Vec2i offset);
+static void DrawViews(Camera *camera);
 void CameraDraw(
 	Camera *camera, const input_device_e pausingDevice,
 	const bool controllerUnplugged)
@@ -128,13 +151,19 @@ void CameraDraw(
 	const int w = gGraphicsDevice.cachedConfig.Res.x;
 	const int h = gGraphicsDevice.cachedConfig.Res.y;
 
-	for (int i = 0; i < GraphicsGetScreenSize(&gGraphicsDevice.cachedConfig); i++)
+	const Uint32 black = COLOR2PIXEL(colorBlack);
+	const int screenSize = GraphicsGetScreenSize(&gGraphicsDevice.cachedConfig);
+	for (int i = 0; i < screenSize; i++)
 	{
-		gGraphicsDevice.buf[i] = COLOR2PIXEL(colorBlack);
+		gGraphicsDevice.buf[i] = black;
 	}
 
 	const Vec2i noise = ScreenShakeGetDelta(camera->shake);
 
+	// Particles need to be on their tiles before the tiles are copied into
+	// the draw buffers
+	ParticlesPlaceOnMap(&gParticles);
+
 	GraphicsResetBlitClip(&gGraphicsDevice);
 	if (numLocalPlayersAlive == 0)
 	{
@@ -285,12 +314,13 @@ void CameraDraw(
 				}
 
 				LOSCalcFrom(&gMap, Vec2iToTile(camera->lastPosition), false);
-				DoBuffer(
-					&camera->Buffer,
-					camera->lastPosition,
+				AddView(
+					camera, camera->lastPosition,
 					X_TILES_HALF, noise, centerOffsetPlayer);
 				SoundSetEarsSide(idx == 0, camera->lastPosition);
 			}
+			DrawViews(camera);
+			GraphicsResetBlitClip(&gGraphicsDevice);
 			Draw_Line(w / 2 - 1, 0, w / 2 - 1, h - 1, colorBlack);
 			Draw_Line(w / 2, 0, w / 2, h - 1, colorBlack);
 		}
@@ -310,9 +340,9 @@ void CameraDraw(
 				}
 				Vec2i centerOffsetPlayer = centerOffset;
 				const int clipLeft = (idx & 1) ? w / 2 : 0;
-				const int clipTop = (idx < 2) ? 0 : h / 2 - 1;
+				const int clipTop = (idx < 2) ? 0 : h / 2;
 				const int clipRight = (idx & 1) ? w - 1 : (w / 2) - 1;
-				const int clipBottom = (idx < 2) ? h / 2 : h - 1;
+				const int clipBottom = (idx < 2) ? h / 2 - 1 : h - 1;
 				isLocalPlayerAlive[idx] = IsPlayerAliveOrDying(p);
 				if (!isLocalPlayerAlive[idx])
 				{
@@ -336,9 +366,8 @@ void CameraDraw(
 					centerOffsetPlayer.y += h / 4;
 				}
 				LOSCalcFrom(&gMap, Vec2iToTile(camera->lastPosition), false);
-				DoBuffer(
-					&camera->Buffer,
-					camera->lastPosition,
+				AddView(
+					camera, camera->lastPosition,
 					X_TILES_HALF, noise, centerOffsetPlayer);
 
 				// Set the sound "ears"
@@ -362,6 +391,8 @@ void CameraDraw(
 					SoundSetEarsSide(!isLeft, camera->lastPosition);
 				}
 			}
+			DrawViews(camera);
+			GraphicsResetBlitClip(&gGraphicsDevice);
 			Draw_Line(w / 2 - 1, 0, w / 2 - 1, h - 1, colorBlack);
 			Draw_Line(w / 2, 0, w / 2, h - 1, colorBlack);
 			Draw_Line(0, h / 2 - 1, w - 1, h / 2 - 1, colorBlack);
@@ -456,10 +487,45 @@ static void DoBuffer(
 	}
 	DrawBufferDraw(b, offset, NULL);
 }
+// Split screen views are set up one at a time, while the line of sight and
+// blit clip are the view's, then drawn together. Each buffer keeps its own
+// copy of the line of sight, as out-of-sight flags, and drawing only reads
+// the view and the map, so the views can be drawn on separate threads;
+// the floor cache is filled beforehand for that reason.
+static void AddView(
+	Camera *camera, const Vec2i center, const int w, const Vec2i noise,
+	const Vec2i offset)
+{
+	CASSERT(camera->numViews < MAX_LOCAL_PLAYERS, "too many views");
+	CameraView *v = &camera->views[camera->numViews];
+	camera->numViews++;
+	DrawBufferSetFromMap(&v->Buffer, &gMap, Vec2iAdd(center, noise), w);
+	if (gPlayerDatas.size > 0)
+	{
+		DrawBufferFix(&v->Buffer);
+	}
+	DrawBufferCacheFloor(&v->Buffer);
+	v->Offset = offset;
+	v->Clip = gGraphicsDevice.clipping;
+}
+static void DrawView(void *item)
+{
+	CameraView *v = item;
+	GraphicsSetThreadBlitClip(&v->Clip);
+	DrawBufferDraw(&v->Buffer, v->Offset, NULL);
+	GraphicsSetThreadBlitClip(NULL);
+}
+static void DrawViews(Camera *camera)
+{
+	ThreadPoolRun(
+		&camera->viewThreads, DrawView,
+		camera->views, sizeof camera->views[0], camera->numViews);
+	camera->numViews = 0;
+}
 
 bool CameraIsSingleScreen(void)
 {
-	if (ConfigGetEnum(&gConfig, "Interface.Splitscreen") == SPLITSCREEN_ALWAYS)
+	if (ConfigHandleGetEnum(&configSplitscreen) == SPLITSCREEN_ALWAYS)
 	{
 		return false;
 	}
@@ -476,7 +542,7 @@ bool CameraIsSingleScreen(void)
 	}
 	// Otherwise, if we are forcing never splitscreen, use single screen
 	// regardless of whether the players are within camera range
-	if (ConfigGetEnum(&gConfig, "Interface.Splitscreen") == SPLITSCREEN_NEVER)
+	if (ConfigHandleGetEnum(&configSplitscreen) == SPLITSCREEN_NEVER)
 	{
 		return true;
 	}
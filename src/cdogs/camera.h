@@ -28,7 +28,9 @@
 
 #include "draw_buffer.h"
 #include "hud.h"
+#include "player.h"
 #include "screen_shake.h"
+#include "thread_pool.h"
 
 #define CAMERA_SPLIT_PADDING 40
 
@@ -39,9 +41,23 @@ typedef enum
 	SPECTATE_FREE
 } SpectateMode;
 
+// A split screen view, prepared on the main thread and then drawn into its
+// own part of the screen, possibly on another thread
 typedef struct
 {
 	DrawBuffer Buffer;
+	Vec2i Offset;
+	BlitClipping Clip;
+} CameraView;
+
+typedef struct
+{
+	DrawBuffer Buffer;
+	// Split screen views of the frame being drawn
+	CameraView views[MAX_LOCAL_PLAYERS];
+	int numViews;
+	// Draws the views; only has worker threads if Graphics.ThreadedRender
+	ThreadPool viewThreads;
 	Vec2i lastPosition;
 	HUD HUD;
 	ScreenShake shake;
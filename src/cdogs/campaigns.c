@@ -70,12 +70,16 @@ void CampaignSettingTerminate(CampaignSetting *setting)
 
 	// Unload previous custom data
 	SoundClear(&gSoundDevice.customSounds);
+	AssetRegistryIndex(&gSoundDevice.registry);
 	PicManagerClearCustom(&gPicManager);
 	ParticleClassesClear(&gParticleClasses.CustomClasses);
+	AssetRegistryIndex(&gParticleClasses.registry);
 	AmmoClassesClear(&gAmmo.CustomAmmo);
 	CharacterClassesClear(&gCharacterClasses.CustomClasses);
 	BulletClassesClear(&gBulletClasses.CustomClasses);
+	AssetRegistryIndex(&gBulletClasses.registry);
 	WeaponClassesClear(&gGunDescriptions.CustomGuns);
+	AssetRegistryIndex(&gGunDescriptions.registry);
 	PickupClassesClear(&gPickupClasses.CustomClasses);
 	MapObjectsClear(&gMapObjects.CustomClasses);
 }
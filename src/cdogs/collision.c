@@ -54,9 +54,17 @@
 
 CollisionSystem gCollisionSystem;
 
+static void OnAllyCollisionChanged(Config *c, void *data);
 void CollisionSystemInit(CollisionSystem *cs)
 {
-	cs->allyCollision = ConfigGetEnum(&gConfig, "Game.AllyCollision");
+	Config *c = ConfigGet(&gConfig, "Game.AllyCollision");
+	cs->allyCollision = c->u.Enum.Value;
+	ConfigAddListener(c, OnAllyCollisionChanged, cs);
+}
+static void OnAllyCollisionChanged(Config *c, void *data)
+{
+	CollisionSystem *cs = data;
+	cs->allyCollision = c->u.Enum.Value;
 }
 
 CollisionTeam CalcCollisionTeam(const bool isActor, const TActor *actor)
@@ -177,7 +185,7 @@ bool IsCollisionDiamond(const Map *map, const Vec2i pos, const Vec2i fullSize)
 }
 
 static bool ItemsCollide(
-	const TTileItem *item1, const TTileItem *item2, const Vec2i pos)
+	const TTileItem *item1, const CollisionGridItem *item2, const Vec2i pos)
 {
 	int dx = abs(pos.x - item2->x);
 	int dy = abs(pos.y - item2->y);
@@ -203,17 +211,17 @@ bool AreasCollide(
 	return d.x < r.x && d.y < r.y;
 }
 
-bool CollisionIsOnSameTeam(
-	const TTileItem *i, const CollisionTeam team, const bool isPVP)
+static bool ThingIdIsOnSameTeam(
+	const ThingId *tid, const CollisionTeam team, const bool isPVP)
 {
 	if (gCollisionSystem.allyCollision == ALLYCOLLISION_NORMAL)
 	{
 		return false;
 	}
 	CollisionTeam itemTeam = COLLISIONTEAM_NONE;
-	if (i->kind == KIND_CHARACTER)
+	if (tid->Kind == KIND_CHARACTER)
 	{
-		const TActor *a = CArrayGet(&gActors, i->id);
+		const TActor *a = CArrayGet(&gActors, tid->Id);
 		itemTeam = CalcCollisionTeam(1, a);
 	}
 	return
@@ -222,6 +230,24 @@ bool CollisionIsOnSameTeam(
 		team == itemTeam &&
 		!isPVP;
 }
+bool CollisionIsOnSameTeam(
+	const TTileItem *i, const CollisionTeam team, const bool isPVP)
+{
+	ThingId tid;
+	tid.Id = i->id;
+	tid.Kind = i->kind;
+	return ThingIdIsOnSameTeam(&tid, team, isPVP);
+}
+
+// Common filters for grid items: not the querying item, matching mask
+static bool GridItemIsCandidate(
+	const TTileItem *item, const CollisionGridItem *gi, const int mask)
+{
+	// No same-item collision
+	if (item->id == gi->id.Id && item->kind == gi->id.Kind) return false;
+	if (mask != 0 && !(gi->flags & mask)) return false;
+	return true;
+}
 
 void CollideTileItems(
 	const TTileItem *item, const Vec2i pos,
@@ -240,18 +266,21 @@ void CollideTileItems(
 			{
 				continue;
 			}
-			CArray *tileThings = &MapGetTile(&gMap, dtv)->things;
-			for (int i = 0; i < (int)tileThings->size; i++)
+			const CArray *cell = CollisionGridGetCell(&gMap.Collision, dtv);
+			if (cell == NULL)
 			{
-				TTileItem *ti = ThingIdGetTileItem(CArrayGet(tileThings, i));
+				continue;
+			}
+			for (int i = 0; i < (int)cell->size; i++)
+			{
+				const CollisionGridItem *gi = CArrayGet(cell, i);
+				if (!GridItemIsCandidate(item, gi, mask)) continue;
+				if (!ItemsCollide(item, gi, pos)) continue;
 				// Don't collide if items are on the same team
-				if (CollisionIsOnSameTeam(ti, team, isPVP)) continue;
-				// No same-item collision
-				if (item == ti) continue;
-				if (mask != 0 && !(ti->flags & mask)) continue;
-				if (!ItemsCollide(item, ti, pos)) continue;
+				if (ThingIdIsOnSameTeam(&gi->id, team, isPVP)) continue;
 				// Collision callback and check continue
-				if (!func(ti, data))
+				ThingId tid = gi->id;
+				if (!func(ThingIdGetTileItem(&tid), data))
 				{
 					return;
 				}
@@ -277,7 +306,6 @@ static bool CollideGetFirstItemCallback(TTileItem *ti, void *data)
 	return false;
 }
 
-// TODO: refactor with Collide functions
 TTileItem *OverlapGetFirstItem(
 	const TTileItem *item, const Vec2i pos, const Vec2i size,
 	const int mask, const CollisionTeam team, const bool isPVP)
@@ -294,21 +322,24 @@ TTileItem *OverlapGetFirstItem(
 			{
 				continue;
 			}
-			CArray *tileThings = &MapGetTile(&gMap, dtv)->things;
-			for (int i = 0; i < (int)tileThings->size; i++)
+			const CArray *cell = CollisionGridGetCell(&gMap.Collision, dtv);
+			if (cell == NULL)
 			{
-				TTileItem *ti = ThingIdGetTileItem(CArrayGet(tileThings, i));
-				// Don't collide if items are on the same team
-				if (CollisionIsOnSameTeam(ti, team, isPVP)) continue;
-				// No same-item collision
-				if (item == ti) continue;
-				if (mask != 0 && !(ti->flags & mask)) continue;
-				if (!AreasCollide(pos, Vec2iNew(ti->x, ti->y), size, ti->size))
+				continue;
+			}
+			for (int i = 0; i < (int)cell->size; i++)
+			{
+				const CollisionGridItem *gi = CArrayGet(cell, i);
+				if (!GridItemIsCandidate(item, gi, mask)) continue;
+				if (!AreasCollide(pos, Vec2iNew(gi->x, gi->y), size, gi->size))
 				{
 					continue;
 				}
+				// Don't collide if items are on the same team
+				if (ThingIdIsOnSameTeam(&gi->id, team, isPVP)) continue;
 				// Overlaps
-				return ti;
+				ThingId tid = gi->id;
+				return ThingIdGetTileItem(&tid);
 			}
 		}
 	}
@@ -0,0 +1,132 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "collision_grid.h"
+
+#include "utils.h"
+
+
+void CollisionGridInit(CollisionGrid *g, const Vec2i size)
+{
+	g->Size = size;
+	CArrayInit(&g->cells, sizeof(CArray));
+	CArrayResize(&g->cells, size.x * size.y, NULL);
+	CArrayFillZero(&g->cells);
+}
+void CollisionGridTerminate(CollisionGrid *g)
+{
+	CA_FOREACH(CArray, cell, g->cells)
+		if (cell->elemSize > 0)
+		{
+			CArrayTerminate(cell);
+		}
+	CA_FOREACH_END()
+	CArrayTerminate(&g->cells);
+	g->Size = Vec2iZero();
+}
+
+static CArray *GetCell(const CollisionGrid *g, const Vec2i cell)
+{
+	if (cell.x < 0 || cell.x >= g->Size.x || cell.y < 0 || cell.y >= g->Size.y)
+	{
+		return NULL;
+	}
+	return CArrayGet(&g->cells, cell.y * g->Size.x + cell.x);
+}
+
+static void GridItemFromTileItem(CollisionGridItem *gi, const TTileItem *t)
+{
+	gi->x = t->x;
+	gi->y = t->y;
+	gi->size = t->size;
+	gi->flags = t->flags;
+	gi->id.Id = t->id;
+	gi->id.Kind = t->kind;
+}
+
+void CollisionGridAdd(CollisionGrid *g, const Vec2i cell, const TTileItem *t)
+{
+	CArray *c = GetCell(g, cell);
+	CASSERT(c != NULL, "collision grid cell out of bounds");
+	// Lazy initialisation
+	if (c->elemSize == 0)
+	{
+		CArrayInit(c, sizeof(CollisionGridItem));
+	}
+	CollisionGridItem gi;
+	GridItemFromTileItem(&gi, t);
+	CArrayPushBack(c, &gi);
+}
+
+static int FindItem(const CArray *c, const TTileItem *t)
+{
+	if (c == NULL)
+	{
+		return -1;
+	}
+	CA_FOREACH(const CollisionGridItem, gi, *c)
+		if (gi->id.Id == t->id && gi->id.Kind == t->kind)
+		{
+			return _ca_index;
+		}
+	CA_FOREACH_END()
+	return -1;
+}
+
+void CollisionGridRemove(
+	CollisionGrid *g, const Vec2i cell, const TTileItem *t)
+{
+	CArray *c = GetCell(g, cell);
+	const int idx = FindItem(c, t);
+	CASSERT(idx >= 0, "Did not find element to delete");
+	if (idx >= 0)
+	{
+		CArrayDelete(c, idx);
+	}
+}
+
+void CollisionGridUpdate(
+	CollisionGrid *g, const Vec2i cell, const TTileItem *t)
+{
+	CArray *c = GetCell(g, cell);
+	const int idx = FindItem(c, t);
+	if (idx >= 0)
+	{
+		GridItemFromTileItem(CArrayGet(c, idx), t);
+	}
+}
+
+const CArray *CollisionGridGetCell(const CollisionGrid *g, const Vec2i cell)
+{
+	const CArray *c = GetCell(g, cell);
+	if (c == NULL || c->elemSize == 0)
+	{
+		return NULL;
+	}
+	return c;
+}
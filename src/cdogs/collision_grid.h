@@ -0,0 +1,67 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "c_array.h"
+#include "tile.h"
+#include "vector.h"
+
+// Collision data for one tile item, kept inline in its grid cell so that
+// collision queries can be resolved without touching the owning arrays
+// (gActors, gMobObjs etc.) until a hit is found.
+typedef struct
+{
+	int x, y;
+	Vec2i size;
+	int flags;
+	ThingId id;
+} CollisionGridItem;
+
+// Uniform grid of cells, one per map tile.
+// Each cell holds a contiguous array of the items whose position is inside
+// that tile, in the same order as Tile.things.
+typedef struct
+{
+	Vec2i Size;
+	CArray cells;	// of CArray of CollisionGridItem
+} CollisionGrid;
+
+void CollisionGridInit(CollisionGrid *g, const Vec2i size);
+void CollisionGridTerminate(CollisionGrid *g);
+
+void CollisionGridAdd(CollisionGrid *g, const Vec2i cell, const TTileItem *t);
+void CollisionGridRemove(
+	CollisionGrid *g, const Vec2i cell, const TTileItem *t);
+// Refresh the cached position, size and flags of an item in a cell
+void CollisionGridUpdate(
+	CollisionGrid *g, const Vec2i cell, const TTileItem *t);
+
+// Get the items in a cell; returns NULL if the cell is outside the grid or
+// has never had any items
+const CArray *CollisionGridGetCell(const CollisionGrid *g, const Vec2i cell);
@@ -31,6 +31,8 @@
 #include <limits.h>
 #include <stdio.h>
 
+#include <SDL_atomic.h>
+
 #include "blit.h"
 #include "collision.h"
 #include "config_json.h"
@@ -171,6 +173,24 @@ int StrSplitscreenStyle(const char *s)
 	S2T(SPLITSCREEN_NEVER, "Never");
 	return SPLITSCREEN_NORMAL;
 }
+const char *NetStatsLogStr(int l)
+{
+	switch (l)
+	{
+		T2S(NET_STATS_LOG_OFF, "Off");
+		T2S(NET_STATS_LOG_CSV, "CSV");
+		T2S(NET_STATS_LOG_JSON, "JSON");
+		default:
+			return "";
+	}
+}
+int StrNetStatsLog(const char *s)
+{
+	S2T(NET_STATS_LOG_OFF, "Off");
+	S2T(NET_STATS_LOG_CSV, "CSV");
+	S2T(NET_STATS_LOG_JSON, "JSON");
+	return NET_STATS_LOG_OFF;
+}
 const char *AIChatterStr(int c)
 {
 	switch (c)
@@ -288,6 +308,7 @@ static Config ConfigNew(const char *name, const ConfigType type)
 void ConfigDestroy(Config *c)
 {
 	CFREE(c->Name);
+	CArrayTerminate(&c->listeners);
 	if (c->Type == CONFIG_TYPE_GROUP)
 	{
 		CA_FOREACH(Config, child, c->u.Group)
@@ -374,27 +395,35 @@ bool ConfigChanged(const Config *c)
 	}
 }
 
+static bool StringsEqual(const char *s1, const char *s2);
 void ConfigResetChanged(Config *c)
 {
+	bool changed = false;
 	switch (c->Type)
 	{
 	case CONFIG_TYPE_STRING:
+		changed = !StringsEqual(c->u.String.Value, c->u.String.Last);
 		CFREE(c->u.String.Value);
+		c->u.String.Value = NULL;
 		if (c->u.String.Last != NULL)
 		{
 			CSTRDUP(c->u.String.Value, c->u.String.Last);
 		}
 		break;
 	case CONFIG_TYPE_INT:
+		changed = c->u.Int.Value != c->u.Int.Last;
 		c->u.Int.Value = c->u.Int.Last;
 		break;
 	case CONFIG_TYPE_FLOAT:
+		changed = c->u.Float.Value != c->u.Float.Last;
 		c->u.Float.Value = c->u.Float.Last;
 		break;
 	case CONFIG_TYPE_BOOL:
+		changed = c->u.Bool.Value != c->u.Bool.Last;
 		c->u.Bool.Value = c->u.Bool.Last;
 		break;
 	case CONFIG_TYPE_ENUM:
+		changed = c->u.Enum.Value != c->u.Enum.Last;
 		c->u.Enum.Value = c->u.Enum.Last;
 		break;
 	case CONFIG_TYPE_GROUP:
@@ -406,6 +435,19 @@ void ConfigResetChanged(Config *c)
 		CASSERT(false, "Unknown config type");
 		break;
 	}
+	// Listeners need to hear about reverts as well as changes
+	if (changed)
+	{
+		ConfigNotifyChanged(c);
+	}
+}
+static bool StringsEqual(const char *s1, const char *s2)
+{
+	if (s1 == NULL || s2 == NULL)
+	{
+		return s1 == s2;
+	}
+	return strcmp(s1, s2) == 0;
 }
 
 void ConfigSetChanged(Config *c)
@@ -522,10 +564,77 @@ void ConfigSetInt(Config *c, const char *name, const int value)
 		c->u.Int.Value = MAX(c->u.Int.Value, c->u.Int.Min);
 	if (c->u.Int.Max > 0)
 		c->u.Int.Value = MIN(c->u.Int.Value, c->u.Int.Max);
+	ConfigNotifyChanged(c);
+}
+
+void ConfigAddListener(Config *c, ConfigListenerFunc func, void *data)
+{
+	if (c->listeners.elemSize == 0)
+	{
+		CArrayInit(&c->listeners, sizeof(ConfigListener));
+	}
+	// Ignore duplicate registrations, e.g. from repeated init calls
+	CA_FOREACH(const ConfigListener, l, c->listeners)
+		if (l->Func == func && l->Data == data)
+		{
+			return;
+		}
+	CA_FOREACH_END()
+	ConfigListener l;
+	l.Func = func;
+	l.Data = data;
+	CArrayPushBack(&c->listeners, &l);
+}
+void ConfigNotifyChanged(Config *c)
+{
+	CA_FOREACH(const ConfigListener, l, c->listeners)
+		l->Func(c, l->Data);
+	CA_FOREACH_END()
+}
+
+// Incremented whenever a config tree is created, so that handles resolved
+// against an older gConfig are resolved again
+static int configGeneration = 1;
+Config *ConfigHandleGet(ConfigHandle *h)
+{
+	// Views drawn on separate threads may resolve the same handle at once;
+	// they resolve it to the same entry, which is stored before the
+	// generation so that a thread seeing the new generation sees the entry
+	if (SDL_AtomicGet(&h->generation) != configGeneration)
+	{
+		SDL_AtomicSetPtr(&h->c, ConfigGet(&gConfig, h->Name));
+		SDL_AtomicSet(&h->generation, configGeneration);
+	}
+	return SDL_AtomicGetPtr(&h->c);
+}
+int ConfigHandleGetInt(ConfigHandle *h)
+{
+	const Config *c = ConfigHandleGet(h);
+	CASSERT(c->Type == CONFIG_TYPE_INT, "wrong config type");
+	return c->u.Int.Value;
+}
+double ConfigHandleGetFloat(ConfigHandle *h)
+{
+	const Config *c = ConfigHandleGet(h);
+	CASSERT(c->Type == CONFIG_TYPE_FLOAT, "wrong config type");
+	return c->u.Float.Value;
+}
+bool ConfigHandleGetBool(ConfigHandle *h)
+{
+	const Config *c = ConfigHandleGet(h);
+	CASSERT(c->Type == CONFIG_TYPE_BOOL, "wrong config type");
+	return c->u.Bool.Value;
+}
+int ConfigHandleGetEnum(ConfigHandle *h)
+{
+	const Config *c = ConfigHandleGet(h);
+	CASSERT(c->Type == CONFIG_TYPE_ENUM, "wrong config type");
+	return c->u.Enum.Value;
 }
 
 Config ConfigDefault(void)
 {
+	configGeneration++;
 	Config root = ConfigNewGroup(NULL);
 	
 	Config game = ConfigNewGroup("Game");
@@ -608,6 +717,7 @@ Config ConfigDefault(void)
 		"ScaleMode", SCALE_MODE_NN, SCALE_MODE_NN, SCALE_MODE_BILINEAR,
 		StrScaleMode, ScaleModeStr));
 	ConfigGroupAdd(&gfx, ConfigNewBool("OriginalPics", false));
+	ConfigGroupAdd(&gfx, ConfigNewBool("ThreadedRender", false));
 	ConfigGroupAdd(&root, gfx);
 
 	Config input = ConfigNewGroup("Input");
@@ -647,6 +757,11 @@ Config ConfigDefault(void)
 		"Splitscreen", SPLITSCREEN_NEVER,
 		SPLITSCREEN_NORMAL, SPLITSCREEN_NEVER,
 		StrSplitscreenStyle, SplitscreenStyleStr));
+	ConfigGroupAdd(&itf, ConfigNewBool("ShowNetStats", false));
+	ConfigGroupAdd(&itf, ConfigNewEnum(
+		"NetStatsLog", NET_STATS_LOG_OFF,
+		NET_STATS_LOG_OFF, NET_STATS_LOG_JSON,
+		StrNetStatsLog, NetStatsLogStr));
 	ConfigGroupAdd(&root, itf);
 
 	Config snd = ConfigNewGroup("Sound");
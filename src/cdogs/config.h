@@ -31,6 +31,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <SDL_atomic.h>
+
 #include "c_array.h"
 
 #define CONFIG_FILE "options.cnf"
@@ -102,6 +104,15 @@ typedef enum
 const char *SplitscreenStyleStr(int s);
 int StrSplitscreenStyle(const char *str);
 
+typedef enum
+{
+	NET_STATS_LOG_OFF,
+	NET_STATS_LOG_CSV,
+	NET_STATS_LOG_JSON
+} NetStatsLog;
+const char *NetStatsLogStr(int l);
+int StrNetStatsLog(const char *s);
+
 typedef enum
 {
 	AICHATTER_NONE,
@@ -170,8 +181,16 @@ typedef struct
 #undef FORMATTED_VALUES
 		CArray Group;	// of Config
 	} u;
+	CArray listeners;	// of ConfigListener
 } Config;
 
+typedef void (*ConfigListenerFunc)(Config *c, void *data);
+typedef struct
+{
+	ConfigListenerFunc Func;
+	void *Data;
+} ConfigListener;
+
 Config ConfigNewString(const char *name, const char *defaultValue);
 Config ConfigNewInt(
 	const char *name, const int defaultValue,
@@ -228,5 +247,30 @@ CArray *ConfigGetGroup(Config *c, const char *name);
 // Min/max range is also checked and enforced
 void ConfigSetInt(Config *c, const char *name, const int value);
 
+// Call func whenever the value of this config entry is changed, through
+// ConfigSetInt, ConfigApply or a config event from the server
+// Use this to keep values derived from config up to date
+void ConfigAddListener(Config *c, ConfigListenerFunc func, void *data);
+void ConfigNotifyChanged(Config *c);
+
+// Pre-resolved gConfig entry, for looking up values on hot paths without
+// parsing the dot-separated name each time
+// The name is resolved on first use, and again if gConfig is reloaded
+// Handles can be used from several threads, e.g. when drawing views
+// Usage: static ConfigHandle h = CONFIG_HANDLE("Game.FPS");
+//        ConfigHandleGetInt(&h);
+typedef struct
+{
+	const char *Name;
+	void *c;	// Config *; accessed atomically
+	SDL_atomic_t generation;
+} ConfigHandle;
+#define CONFIG_HANDLE(_name) { _name, NULL, { 0 } }
+Config *ConfigHandleGet(ConfigHandle *h);
+int ConfigHandleGetInt(ConfigHandle *h);
+double ConfigHandleGetFloat(ConfigHandle *h);
+bool ConfigHandleGetBool(ConfigHandle *h);
+int ConfigHandleGetEnum(ConfigHandle *h);
+
 bool ConfigApply(Config *config);
 int ConfigGetVersion(FILE *f);
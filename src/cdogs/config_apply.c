@@ -29,16 +29,16 @@
 #include "config.h"
 
 #include "blit.h"
-#include "collision.h"
 #include "gamedata.h"
 #include "grafx_bg.h"
 #include "pic_manager.h"
 
 
+static void NotifyChanged(Config *c);
 bool ConfigApply(Config *config)
 {
 	gCampaign.seed = ConfigGetInt(config, "Game.RandomSeed");
-	CollisionSystemInit(&gCollisionSystem);
+	NotifyChanged(config);
 	if (ConfigChanged(ConfigGet(config, "Sound")))
 	{
 		SoundReconfigure(&gSoundDevice);
@@ -53,3 +53,16 @@ bool ConfigApply(Config *config)
 	ConfigSetChanged(config);
 	return gGraphicsDevice.IsInitialized;
 }
+static void NotifyChanged(Config *c)
+{
+	if (c->Type == CONFIG_TYPE_GROUP)
+	{
+		CA_FOREACH(Config, child, c->u.Group)
+			NotifyChanged(child);
+		CA_FOREACH_END()
+	}
+	else if (ConfigChanged(c))
+	{
+		ConfigNotifyChanged(c);
+	}
+}
@@ -49,6 +49,7 @@ void PicFromPicPaletted(Pic *pic, const PicPaletted *picP)
 {
 	pic->size = Vec2iNew(picP->w, picP->h);
 	pic->offset = Vec2iZero();
+	pic->packed = false;
 	CMALLOC(pic->Data, pic->size.x * pic->size.y * sizeof *pic->Data);
 	for (int i = 0; i < pic->size.x * pic->size.y; i++)
 	{
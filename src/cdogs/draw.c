@@ -64,6 +64,10 @@
 #include "blit.h"
 #include "pic_manager.h"
 
+static ConfigHandle configFPS = CONFIG_HANDLE("Game.FPS");
+static ConfigHandle configFog = CONFIG_HANDLE("Game.Fog");
+static ConfigHandle configLaserSight = CONFIG_HANDLE("Game.LaserSight");
+
 
 // For actor drawing
 typedef struct
@@ -85,15 +89,15 @@ typedef struct
 // Unvisited: black
 // Out of sight: dark, or if fog disabled, black
 // In sight: full color
-static color_t GetTileLOSMask(Tile *tile)
+static color_t GetTileLOSMask(const DrawBufferTile *tile)
 {
-	if (!tile->isVisited)
+	if (!tile->MapTile->isVisited)
 	{
 		return colorBlack;
 	}
-	if (tile->flags & MAPTILE_OUT_OF_SIGHT)
+	if (tile->Flags & MAPTILE_OUT_OF_SIGHT)
 	{
-		if (ConfigGetBool(&gConfig, "Game.Fog"))
+		if (ConfigHandleGetBool(&configFog))
 		{
 			color_t mask = { 96, 96, 96, 255 };
 			return mask;
@@ -106,13 +110,13 @@ static color_t GetTileLOSMask(Tile *tile)
 	return colorWhite;
 }
 
-void DrawWallColumn(int y, Vec2i pos, Tile *tile)
+static void DrawWallColumn(int y, Vec2i pos, const DrawBufferTile *tile)
 {
-	while (y >= 0 && (tile->flags & MAPTILE_IS_WALL))
+	while (y >= 0 && (tile->Flags & MAPTILE_IS_WALL))
 	{
 		BlitMasked(
 			&gGraphicsDevice,
-			&tile->pic->pic,
+			&tile->MapTile->pic->pic,
 			pos,
 			GetTileLOSMask(tile),
 			0);
@@ -132,6 +136,7 @@ static void DrawExtra(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra);
 
 void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
 {
+	DrawBufferBuildQueues(b);
 	// First draw the floor tiles (which do not obstruct anything)
 	DrawFloor(b, offset);
 	// Then draw debris (wrecks)
@@ -149,124 +154,169 @@ void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
 	}
 }
 
+// Consecutive floor tiles in the floor cache with the same LOS mask,
+// drawn with one copy per line
+typedef struct
+{
+	const Uint32 *Pixels;
+	int Length;	// in tiles
+	Vec2i Pos;
+	color_t Mask;
+} FloorRun;
+static void FloorRunFlush(FloorRun *r, const FloorCache *cache)
+{
+	if (r->Length == 0)
+	{
+		return;
+	}
+	BlitPixels(
+		&gGraphicsDevice, r->Pixels, cache->Stride, r->Pos,
+		Vec2iNew(r->Length * TILE_WIDTH, TILE_HEIGHT), r->Mask);
+	r->Length = 0;
+}
+static bool IsFloorDrawn(const DrawBufferTile *tile)
+{
+	const NamedPic *pic = tile->MapTile->pic;
+	return pic != NULL && pic->pic.Data != NULL &&
+		!(tile->Flags & (MAPTILE_IS_WALL | MAPTILE_HIDE_PIC));
+}
 static void DrawFloor(DrawBuffer *b, Vec2i offset)
 {
-	int x, y;
+	FloorCache *cache = &b->map->Floor;
+	FloorRun run;
+	memset(&run, 0, sizeof run);
 	Vec2i pos;
-	Tile *tile = &b->tiles[0][0];
-	for (y = 0, pos.y = b->dy + offset.y;
-		 y < Y_TILES;
-		 y++, pos.y += TILE_HEIGHT)
-	{
-		for (x = 0, pos.x = b->dx + offset.x;
-			x < b->Size.x;
-			x++, tile++, pos.x += TILE_WIDTH)
+	const DrawBufferTile *tile = b->tiles;
+	pos.y = b->dy + offset.y;
+	for (int y = 0; y < Y_TILES; y++, pos.y += TILE_HEIGHT)
+	{
+		pos.x = b->dx + offset.x;
+		for (int x = 0; x < b->Size.x; x++, tile++, pos.x += TILE_WIDTH)
 		{
-			if (tile->pic != NULL && tile->pic->pic.Data != NULL &&
-				!(tile->flags & MAPTILE_IS_WALL))
+			if (!IsFloorDrawn(tile))
 			{
-				BlitMasked(
-					&gGraphicsDevice,
-					&tile->pic->pic,
-					pos,
-					GetTileLOSMask(tile),
-					0);
+				FloorRunFlush(&run, cache);
+				continue;
+			}
+			const NamedPic *pic = tile->MapTile->pic;
+			const color_t mask = GetTileLOSMask(tile);
+			bool isOpaque;
+			const Uint32 *pixels = FloorCacheGet(
+				cache, Vec2iNew(x + b->xStart, y + b->yStart), pic,
+				&isOpaque);
+			// Opaque pixels masked black are the same as the cleared screen
+			if (pixels != NULL && isOpaque && ColorEquals(mask, colorBlack))
+			{
+				FloorRunFlush(&run, cache);
+				continue;
 			}
+			if (pixels != NULL && run.Length > 0 &&
+				ColorEquals(mask, run.Mask))
+			{
+				run.Length++;
+				continue;
+			}
+			FloorRunFlush(&run, cache);
+			if (pixels == NULL)
+			{
+				// Pic doesn't fill the tile; draw it on its own
+				BlitMasked(&gGraphicsDevice, &pic->pic, pos, mask, 0);
+				continue;
+			}
+			run.Pixels = pixels;
+			run.Length = 1;
+			run.Pos = pos;
+			run.Mask = mask;
 		}
+		FloorRunFlush(&run, cache);
 		tile += X_TILES - b->Size.x;
 	}
 }
 
-static void DrawThing(DrawBuffer *b, const TTileItem *t, const Vec2i offset);
-
-static void DrawDebris(DrawBuffer *b, Vec2i offset)
+void DrawBufferCacheFloor(DrawBuffer *b)
 {
-	Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	for (int y = 0; y < Y_TILES; y++)
 	{
-		CArrayClear(&b->displaylist);
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
-			if (tile->flags & MAPTILE_OUT_OF_SIGHT)
+			if (IsFloorDrawn(tile))
 			{
-				continue;
+				bool isOpaque;
+				FloorCacheGet(
+					&b->map->Floor, Vec2iNew(x + b->xStart, y + b->yStart),
+					tile->MapTile->pic, &isOpaque);
 			}
-			CA_FOREACH(ThingId, tid, tile->things)
-				const TTileItem *ti = ThingIdGetTileItem(tid);
-				if (TileItemIsDebris(ti))
-				{
-					CArrayPushBack(&b->displaylist, &ti);
-				}
-			CA_FOREACH_END()
 		}
-		DrawBufferSortDisplayList(b);
-		CA_FOREACH(const TTileItem *, tp, b->displaylist)
-			DrawThing(b, *tp, offset);
-		CA_FOREACH_END()
 		tile += X_TILES - b->Size.x;
 	}
 }
 
+static void DrawThing(DrawBuffer *b, const TTileItem *t, const Vec2i offset);
+static void DrawQueueRow(
+	DrawBuffer *b, const DrawBufferQueue *q, const int row,
+	const Vec2i offset);
+
+static void DrawDebris(DrawBuffer *b, Vec2i offset)
+{
+	for (int y = 0; y < Y_TILES; y++)
+	{
+		DrawQueueRow(b, &b->debris, y, offset);
+	}
+}
+
 static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 {
 	Vec2i pos;
-	Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	pos.y = b->dy + cWallOffset.dy + offset.y;
 	for (int y = 0; y < Y_TILES; y++, pos.y += TILE_HEIGHT)
 	{
-		CArrayClear(&b->displaylist);
 		pos.x = b->dx + cWallOffset.dx + offset.x;
 		for (int x = 0; x < b->Size.x; x++, tile++, pos.x += TILE_WIDTH)
 		{
-			if (tile->flags & MAPTILE_IS_WALL)
+			if (tile->Flags & MAPTILE_IS_WALL)
 			{
-				if (!(tile->flags & MAPTILE_DELAY_DRAW))
+				if (!(tile->Flags & MAPTILE_DELAY_DRAW))
 				{
 					DrawWallColumn(y, pos, tile);
 				}
 			}
-			else if (tile->flags & MAPTILE_OFFSET_PIC)
+			else if (tile->Flags & MAPTILE_OFFSET_PIC)
 			{
 				// Drawing doors
 				// Doors may be offset; vertical doors are drawn centered
 				// horizontal doors are bottom aligned
+				const Pic *door = &tile->MapTile->picAlt->pic;
 				Vec2i doorPos = pos;
-				doorPos.x += (TILE_WIDTH - tile->picAlt->pic.size.x) / 2;
-				if (tile->picAlt->pic.size.y > 16)
+				doorPos.x += (TILE_WIDTH - door->size.x) / 2;
+				if (door->size.y > 16)
 				{
-					doorPos.y +=
-						TILE_HEIGHT - (tile->picAlt->pic.size.y % TILE_HEIGHT);
+					doorPos.y += TILE_HEIGHT - (door->size.y % TILE_HEIGHT);
 				}
 				BlitMasked(
 					&gGraphicsDevice,
-					&tile->picAlt->pic,
+					door,
 					doorPos,
 					GetTileLOSMask(tile),
 					0);
 			}
-
-			// Draw the items that are in LOS
-			if (tile->flags & MAPTILE_OUT_OF_SIGHT)
-			{
-				continue;
-			}
-			CA_FOREACH(ThingId, tid, tile->things)
-				const TTileItem *ti = ThingIdGetTileItem(tid);
-				// Don't draw debris, they are drawn later
-				if (TileItemIsDebris(ti))
-				{
-					continue;
-				}
-				CArrayPushBack(&b->displaylist, &ti);
-			CA_FOREACH_END()
 		}
-		DrawBufferSortDisplayList(b);
-		CA_FOREACH(const TTileItem *, tp, b->displaylist)
-			DrawThing(b, *tp, offset);
-		CA_FOREACH_END()
+		// Draw the items that are in LOS
+		DrawQueueRow(b, &b->things, y, offset);
 		tile += X_TILES - b->Size.x;
 	}
 }
+static void DrawQueueRow(
+	DrawBuffer *b, const DrawBufferQueue *q, const int row,
+	const Vec2i offset)
+{
+	for (int i = q->RowStarts[row]; i < q->RowStarts[row + 1]; i++)
+	{
+		const TTileItem **tp = CArrayGet(&q->Items, i);
+		DrawThing(b, *tp, offset);
+	}
+}
 static void GetCharacterPicsFromActor(ActorPics *pics, TActor *a);
 static void DrawActorPics(const ActorPics *pics, const Vec2i picPos);
 static void DrawLaserSight(
@@ -520,7 +570,7 @@ static void DrawLaserSight(
 	// Don't draw if dead or transparent
 	if (pics->IsDead || pics->IsTransparent) return;
 	// Check config
-	const LaserSight ls = ConfigGetEnum(&gConfig, "Game.LaserSight");
+	const LaserSight ls = ConfigHandleGetEnum(&configLaserSight);
 	if (ls != LASER_SIGHT_ALL &&
 		!(ls == LASER_SIGHT_PLAYERS && a->PlayerUID >= 0))
 	{
@@ -559,16 +609,16 @@ static void DrawLaserSightSingle(
 }
 
 static void DrawObjectiveHighlight(
-	TTileItem *ti, Tile *tile, DrawBuffer *b, Vec2i offset);
+	TTileItem *ti, const DrawBufferTile *tile, DrawBuffer *b, Vec2i offset);
 static void DrawObjectiveHighlights(DrawBuffer *b, Vec2i offset)
 {
-	Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	for (int y = 0; y < Y_TILES; y++)
 	{
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
 			// Draw the items that are in LOS
-			CA_FOREACH(ThingId, tid, tile->things)
+			CA_FOREACH(ThingId, tid, tile->MapTile->things)
 				TTileItem *ti = ThingIdGetTileItem(tid);
 				DrawObjectiveHighlight(ti, tile, b, offset);
 			CA_FOREACH_END()
@@ -577,7 +627,7 @@ static void DrawObjectiveHighlights(DrawBuffer *b, Vec2i offset)
 	}
 }
 static void DrawObjectiveHighlight(
-	TTileItem *ti, Tile *tile, DrawBuffer *b, Vec2i offset)
+	TTileItem *ti, const DrawBufferTile *tile, DrawBuffer *b, Vec2i offset)
 {
 	if (!(ti->flags & TILEITEM_OBJECTIVE))
 	{
@@ -591,14 +641,14 @@ static void DrawObjectiveHighlight(
 		return;
 	}
 	if (!(o->Flags & OBJECTIVE_POSKNOWN) &&
-		(tile->flags & MAPTILE_OUT_OF_SIGHT))
+		(tile->Flags & MAPTILE_OUT_OF_SIGHT))
 	{
 		return;
 	}
 	const Vec2i pos = Vec2iNew(
 		ti->x - b->xTop + offset.x, ti->y - b->yTop + offset.y);
 	color_t color = o->color;
-	const int pulsePeriod = ConfigGetInt(&gConfig, "Game.FPS");
+	const int pulsePeriod = ConfigHandleGetInt(&configFPS);
 	int alphaUnscaled =
 		(gMission.time % pulsePeriod) * 255 / (pulsePeriod / 2);
 	if (alphaUnscaled > 255)
@@ -640,12 +690,12 @@ static void DrawChatter(
 	const TTileItem *ti, DrawBuffer *b, const Vec2i offset);
 static void DrawChatters(DrawBuffer *b, Vec2i offset)
 {
-	const Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	for (int y = 0; y < Y_TILES; y++)
 	{
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
-			CA_FOREACH(ThingId, tid, tile->things)
+			CA_FOREACH(ThingId, tid, tile->MapTile->things)
 				const TTileItem *ti = ThingIdGetTileItem(tid);
 				if (ti->kind != KIND_CHARACTER)
 				{
@@ -731,7 +781,7 @@ static void DrawExtra(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
 static void DrawEditorTiles(DrawBuffer *b, const Vec2i offset)
 {
 	Vec2i pos;
-	Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	pos.y = b->dy + offset.y;
 	for (int y = 0; y < Y_TILES; y++, pos.y += TILE_HEIGHT)
 	{
@@ -790,12 +840,12 @@ static void DrawSpawnerName(
 	const TObject *obj, DrawBuffer *b, const Vec2i offset);
 static void DrawObjectNames(DrawBuffer *b, const Vec2i offset)
 {
-	const Tile *tile = &b->tiles[0][0];
+	const DrawBufferTile *tile = b->tiles;
 	for (int y = 0; y < Y_TILES; y++)
 	{
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
-			CA_FOREACH(ThingId, tid, tile->things)
+			CA_FOREACH(ThingId, tid, tile->MapTile->things)
 				const TTileItem *ti = ThingIdGetTileItem(tid);
 				if (ti->flags & TILEITEM_OBJECTIVE)
 				{
@@ -53,6 +53,10 @@
 #include "grafx_bg.h"
 
 void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra);
+// Render the buffer's floor tiles into the map's floor cache ahead of
+// drawing, so that buffers can then be drawn on several threads at once
+// without writing to the shared cache
+void DrawBufferCacheFloor(DrawBuffer *b);
 void DrawCharacterSimple(
 	Character *c, const Vec2i pos, const direction_e d,
 	const bool hilite, const bool showGun);
@@ -49,39 +49,58 @@
 #include "draw_buffer.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "algorithms.h"
 #include "los.h"
 
 
+// Stands in for tiles outside the map
+static Tile sTileNone;
+static bool sTileNoneInit = false;
+
+static void QueueInit(DrawBufferQueue *q, const int rows);
+static void QueueTerminate(DrawBufferQueue *q);
 void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g)
 {
 	debug(D_MAX, "Initialising draw buffer %dx%d\n", size.x, size.y);
-	b->OrigSize = size;
-	CMALLOC(b->tiles, size.x * sizeof *b->tiles);
-	CMALLOC(b->tiles[0], size.x * size.y * sizeof *b->tiles[0]);
-	for (int i = 1; i < size.x; i++)
+	if (!sTileNoneInit)
 	{
-		b->tiles[i] = b->tiles[0] + i * size.y;
+		sTileNone = TileNone();
+		sTileNoneInit = true;
 	}
+	b->OrigSize = size;
+	CMALLOC(b->tiles, size.x * size.y * sizeof *b->tiles);
 	b->g = g;
-	CArrayInit(&b->displaylist, sizeof(const TTileItem *));
-	CArrayReserve(&b->displaylist, 32);
+	QueueInit(&b->debris, size.y);
+	QueueInit(&b->things, size.y);
+	CArrayInit(&b->rowItems, sizeof(const TTileItem *));
 	debug(D_MAX, "Initialised draw buffer %dx%d\n", size.x, size.y);
 }
 void DrawBufferTerminate(DrawBuffer *b)
 {
-	CFREE(b->tiles[0]);
 	CFREE(b->tiles);
-	CArrayTerminate(&b->displaylist);
+	QueueTerminate(&b->debris);
+	QueueTerminate(&b->things);
+	CArrayTerminate(&b->rowItems);
+}
+
+static void QueueInit(DrawBufferQueue *q, const int rows)
+{
+	CArrayInit(&q->Items, sizeof(const TTileItem *));
+	CArrayReserve(&q->Items, 32);
+	CCALLOC(q->RowStarts, (rows + 1) * sizeof *q->RowStarts);
+}
+static void QueueTerminate(DrawBufferQueue *q)
+{
+	CArrayTerminate(&q->Items);
+	CFREE(q->RowStarts);
 }
 
 void DrawBufferSetFromMap(
 	DrawBuffer *buffer, Map *map, Vec2i origin, int width)
 {
-	int x, y;
-	Tile *bufTile;
-
+	buffer->map = map;
 	buffer->Size = Vec2iNew(width, buffer->OrigSize.y);
 
 	buffer->xTop = origin.x - TILE_WIDTH * width / 2;
@@ -102,21 +121,27 @@ void DrawBufferSetFromMap(
 	buffer->dx = buffer->xStart * TILE_WIDTH - buffer->xTop;
 	buffer->dy = buffer->yStart * TILE_HEIGHT - buffer->yTop;
 
-	bufTile = &buffer->tiles[0][0];
-	for (y = buffer->yStart; y < buffer->yStart + buffer->Size.y; y++)
+	DrawBufferTile *bufTile = buffer->tiles;
+	for (int y = buffer->yStart; y < buffer->yStart + buffer->Size.y; y++)
 	{
-		for (x = buffer->xStart;
+		Tile *mapRow = NULL;
+		if (y >= 0 && y < map->Size.y)
+		{
+			mapRow = CArrayGet(&map->Tiles, y * map->Size.x);
+		}
+		for (int x = buffer->xStart;
 			x < buffer->xStart + buffer->Size.x;
 			x++, bufTile++)
 		{
-			if (x >= 0 && x < map->Size.x && y >= 0 && y < map->Size.y)
+			if (mapRow != NULL && x >= 0 && x < map->Size.x)
 			{
-				*bufTile = *MapGetTile(map, Vec2iNew(x, y));
+				bufTile->MapTile = mapRow + x;
 			}
 			else
 			{
-				*bufTile = TileNone();
+				bufTile->MapTile = &sTileNone;
 			}
+			bufTile->Flags = bufTile->MapTile->flags;
 		}
 		bufTile += buffer->OrigSize.x - buffer->Size.x;
 	}
@@ -125,29 +150,29 @@ void DrawBufferSetFromMap(
 // Set visibility and draw order for wall/door columns
 void DrawBufferFix(DrawBuffer *buffer)
 {
-	Tile *tile = &buffer->tiles[0][0];
-	Tile *tileBelow = &buffer->tiles[0][0] + X_TILES;
-	for (int y = 0; y < Y_TILES - 1; y++)
+	DrawBufferTile *tile = buffer->tiles;
+	DrawBufferTile *tileBelow = buffer->tiles + buffer->OrigSize.x;
+	for (int y = 0; y < buffer->Size.y - 1; y++)
 	{
 		for (int x = 0; x < buffer->Size.x; x++, tile++, tileBelow++)
 		{
-			if (!(tile->flags & (MAPTILE_IS_WALL | MAPTILE_OFFSET_PIC)) &&
-				(tileBelow->flags & MAPTILE_IS_WALL))
+			if (!(tile->Flags & (MAPTILE_IS_WALL | MAPTILE_OFFSET_PIC)) &&
+				(tileBelow->Flags & MAPTILE_IS_WALL))
 			{
-				tile->pic = NULL;
+				tile->Flags |= MAPTILE_HIDE_PIC;
 			}
-			else if ((tile->flags & MAPTILE_IS_WALL) &&
-				(tileBelow->flags & MAPTILE_IS_WALL))
+			else if ((tile->Flags & MAPTILE_IS_WALL) &&
+				(tileBelow->Flags & MAPTILE_IS_WALL))
 			{
-				tile->flags |= MAPTILE_DELAY_DRAW;
+				tile->Flags |= MAPTILE_DELAY_DRAW;
 			}
 		}
-		tile += X_TILES - buffer->Size.x;
-		tileBelow += X_TILES - buffer->Size.x;
+		tile += buffer->OrigSize.x - buffer->Size.x;
+		tileBelow += buffer->OrigSize.x - buffer->Size.x;
 	}
 
-	tile = &buffer->tiles[0][0];
-	for (int y = 0; y < Y_TILES; y++)
+	tile = buffer->tiles;
+	for (int y = 0; y < buffer->Size.y; y++)
 	{
 		for (int x = 0; x < buffer->Size.x; x++, tile++)
 		{
@@ -155,37 +180,83 @@ void DrawBufferFix(DrawBuffer *buffer)
 				Vec2iNew(x + buffer->xStart, y + buffer->yStart);
 			if (!LOSTileIsVisible(&gMap, mapTile))
 			{
-				tile->flags |= MAPTILE_OUT_OF_SIGHT;
+				tile->Flags |= MAPTILE_OUT_OF_SIGHT;
 			}
-			else
+		}
+		tile += buffer->OrigSize.x - buffer->Size.x;
+	}
+}
+
+static void QueueRowBegin(DrawBufferQueue *q, const int row);
+static void QueueRowEnd(
+	DrawBufferQueue *q, const int row, CArray *scratch, const int rowTop);
+void DrawBufferBuildQueues(DrawBuffer *buffer)
+{
+	CArrayClear(&buffer->debris.Items);
+	CArrayClear(&buffer->things.Items);
+	const DrawBufferTile *tile = buffer->tiles;
+	for (int y = 0; y < buffer->Size.y; y++)
+	{
+		QueueRowBegin(&buffer->debris, y);
+		QueueRowBegin(&buffer->things, y);
+		for (int x = 0; x < buffer->Size.x; x++, tile++)
+		{
+			if (tile->Flags & MAPTILE_OUT_OF_SIGHT)
 			{
-				tile->flags &= ~MAPTILE_OUT_OF_SIGHT;
+				continue;
 			}
+			CA_FOREACH(ThingId, tid, tile->MapTile->things)
+				const TTileItem *ti = ThingIdGetTileItem(tid);
+				CArrayPushBack(
+					TileItemIsDebris(ti) ?
+					&buffer->debris.Items : &buffer->things.Items,
+					&ti);
+			CA_FOREACH_END()
 		}
-		tile += X_TILES - buffer->Size.x;
+		const int rowTop = (buffer->yStart + y) * TILE_HEIGHT;
+		QueueRowEnd(&buffer->debris, y, &buffer->rowItems, rowTop);
+		QueueRowEnd(&buffer->things, y, &buffer->rowItems, rowTop);
+		tile += buffer->OrigSize.x - buffer->Size.x;
 	}
+	buffer->debris.RowStarts[buffer->Size.y] =
+		(int)buffer->debris.Items.size;
+	buffer->things.RowStarts[buffer->Size.y] =
+		(int)buffer->things.Items.size;
 }
-
-static int CompareY(const void *v1, const void *v2);
-void DrawBufferSortDisplayList(DrawBuffer *buffer)
+static void QueueRowBegin(DrawBufferQueue *q, const int row)
 {
-	qsort(
-		buffer->displaylist.data,
-		buffer->displaylist.size,
-		buffer->displaylist.elemSize,
-		CompareY);
+	q->RowStarts[row] = (int)q->Items.size;
 }
-static int CompareY(const void *v1, const void *v2)
+// Sort the row's items by y; since they are all on the same tile row there
+// are only TILE_HEIGHT distinct y values, so use a counting sort.
+// The sort is stable, so items on the same y keep their tile order, which
+// doesn't change between frames unless they move.
+static void QueueRowEnd(
+	DrawBufferQueue *q, const int row, CArray *scratch, const int rowTop)
 {
-	const TTileItem * const *t1 = v1;
-	const TTileItem * const *t2 = v2;
-	if ((*t1)->y < (*t2)->y)
+	const int start = q->RowStarts[row];
+	const int n = (int)q->Items.size - start;
+	if (n < 2)
+	{
+		return;
+	}
+	const TTileItem **items = CArrayGet(&q->Items, start);
+	int counts[TILE_HEIGHT + 1];
+	memset(counts, 0, sizeof counts);
+	for (int i = 0; i < n; i++)
+	{
+		counts[CLAMP(items[i]->y - rowTop, 0, TILE_HEIGHT - 1) + 1]++;
+	}
+	for (int i = 1; i < TILE_HEIGHT; i++)
 	{
-		return -1;
+		counts[i] += counts[i - 1];
 	}
-	else if ((*t1)->y >(*t2)->y)
+	CArrayResize(scratch, n, NULL);
+	const TTileItem **sorted = CArrayGet(scratch, 0);
+	for (int i = 0; i < n; i++)
 	{
-		return 1;
+		sorted[counts[CLAMP(items[i]->y - rowTop, 0, TILE_HEIGHT - 1)]++] =
+			items[i];
 	}
-	return 0;
+	memcpy(items, sorted, n * sizeof *items);
 }
@@ -51,16 +51,35 @@
 
 #include "map.h"
 
+// A view of a map tile for one frame; the tile itself is not copied,
+// only the flags which the draw routines adjust (MAPTILE_DELAY_DRAW etc.)
+typedef struct
+{
+	Tile *MapTile;
+	int Flags;
+} DrawBufferTile;
+
+// Tile items of one kind in the buffer, in draw order:
+// grouped by tile row, then by y within each row
+typedef struct
+{
+	CArray Items;	// of const TTileItem *
+	int *RowStarts;	// index of first item of each row, plus end of last row
+} DrawBufferQueue;
+
 typedef struct
 {
 	GraphicsDevice *g;
+	Map *map;
 	int xTop, yTop;	// offset from top/left in pixels
 	int xStart, yStart;	// starting tile of buffer
 	int dx, dy;	// remainder pixel offset from starting tile
 	Vec2i OrigSize;
 	Vec2i Size;	// size in tiles
-	Tile **tiles;
-	CArray displaylist;	// of const TTileItem *, to determine draw order
+	DrawBufferTile *tiles;	// row-major, stride OrigSize.x
+	DrawBufferQueue debris;
+	DrawBufferQueue things;	// everything apart from debris
+	CArray rowItems;	// of const TTileItem *, scratch for sorting a row
 } DrawBuffer;
 
 void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g);
@@ -69,6 +88,7 @@ void DrawBufferTerminate(DrawBuffer *b);
 void DrawBufferSetFromMap(
 	DrawBuffer *buffer, Map *map, Vec2i origin, int width);
 void DrawBufferFix(DrawBuffer *buffer);
-void DrawBufferSortDisplayList(DrawBuffer *buffer);
+// Collect the in-sight tile items into the debris and things queues
+void DrawBufferBuildQueues(DrawBuffer *buffer);
 
 #endif
@@ -55,6 +55,8 @@
 #include "blit.h"
 #include "grafx.h"
 
+static ConfigHandle configShadows = CONFIG_HANDLE("Game.Shadows");
+
 
 void Draw_Point(const int x, const int y, color_t c)
 {
@@ -64,10 +66,8 @@ void Draw_Point(const int x, const int y, color_t c)
 		y,
 		gGraphicsDevice.cachedConfig.Res.x,
 		gGraphicsDevice.cachedConfig.Res.y);
-	if (x < gGraphicsDevice.clipping.left ||
-		x > gGraphicsDevice.clipping.right ||
-		y < gGraphicsDevice.clipping.top ||
-		y > gGraphicsDevice.clipping.bottom)
+	const BlitClipping *clip = GraphicsGetBlitClip(&gGraphicsDevice);
+	if (x < clip->left || x > clip->right || y < clip->top || y > clip->bottom)
 	{
 		return;
 	}
@@ -177,10 +177,9 @@ void DrawPointMask(GraphicsDevice *device, Vec2i pos, color_t mask)
 		device->cachedConfig.Res.x,
 		device->cachedConfig.Res.y);
 	color_t c;
-	if (pos.x < gGraphicsDevice.clipping.left ||
-		pos.x > gGraphicsDevice.clipping.right ||
-		pos.y < gGraphicsDevice.clipping.top ||
-		pos.y > gGraphicsDevice.clipping.bottom)
+	const BlitClipping *clip = GraphicsGetBlitClip(device);
+	if (pos.x < clip->left || pos.x > clip->right ||
+		pos.y < clip->top || pos.y > clip->bottom)
 	{
 		return;
 	}
@@ -197,8 +196,9 @@ void DrawPointTint(GraphicsDevice *device, Vec2i pos, HSV tint)
 		device->cachedConfig.Res.x,
 		device->cachedConfig.Res.y);
 	color_t c;
-	if (pos.x < device->clipping.left || pos.x > device->clipping.right ||
-		pos.y < device->clipping.top || pos.y > device->clipping.bottom)
+	const BlitClipping *clip = GraphicsGetBlitClip(device);
+	if (pos.x < clip->left || pos.x > clip->right ||
+		pos.y < clip->top || pos.y > clip->bottom)
 	{
 		return;
 	}
@@ -210,21 +210,22 @@ void DrawPointTint(GraphicsDevice *device, Vec2i pos, HSV tint)
 void DrawRectangle(
 	GraphicsDevice *device, Vec2i pos, Vec2i size, color_t color, int flags)
 {
+	const BlitClipping *clip = GraphicsGetBlitClip(device);
 	int y;
 	if (size.x < 3 || size.y < 3)
 	{
 		flags &= ~DRAW_FLAG_ROUNDED;
 	}
-	for (y = MAX(pos.y, device->clipping.top);
-		y < MIN(pos.y + size.y, device->clipping.bottom + 1);
+	for (y = MAX(pos.y, clip->top);
+		y < MIN(pos.y + size.y, clip->bottom + 1);
 		y++)
 	{
 		int isFirstOrLastLine = y == pos.y || y == pos.y + size.y - 1;
 		if (isFirstOrLastLine && (flags & DRAW_FLAG_ROUNDED))
 		{
 			int x;
-			for (x = MAX(pos.x + 1, device->clipping.left);
-				x < MIN(pos.x + size.x - 1, device->clipping.right + 1);
+			for (x = MAX(pos.x + 1, clip->left);
+				x < MIN(pos.x + size.x - 1, clip->right + 1);
 				x++)
 			{
 				Draw_Point(x, y, color);
@@ -238,8 +239,8 @@ void DrawRectangle(
 		else
 		{
 			int x;
-			for (x = MAX(pos.x, device->clipping.left);
-				x < MIN(pos.x + size.x, device->clipping.right + 1);
+			for (x = MAX(pos.x, clip->left);
+				x < MIN(pos.x + size.x, clip->right + 1);
 				x++)
 			{
 				Draw_Point(x, y, color);
@@ -265,17 +266,18 @@ void DrawShadow(GraphicsDevice *device, Vec2i pos, Vec2i size)
 {
 	Vec2i drawPos;
 	HSV tint = { -1.0, 1.0, 0.0 };
-	if (!ConfigGetBool(&gConfig, "Game.Shadows"))
+	if (!ConfigHandleGetBool(&configShadows))
 	{
 		return;
 	}
+	const BlitClipping *clip = GraphicsGetBlitClip(device);
 	for (drawPos.y = pos.y - size.y; drawPos.y < pos.y + size.y; drawPos.y++)
 	{
-		if (drawPos.y >= device->clipping.bottom)
+		if (drawPos.y >= clip->bottom)
 		{
 			break;
 		}
-		if (drawPos.y < device->clipping.top)
+		if (drawPos.y < clip->top)
 		{
 			continue;
 		}
@@ -284,11 +286,11 @@ void DrawShadow(GraphicsDevice *device, Vec2i pos, Vec2i size)
 			// Calculate value tint based on distance from center
 			Vec2i scaledPos;
 			int distance2;
-			if (drawPos.x >= device->clipping.right)
+			if (drawPos.x >= clip->right)
 			{
 				break;
 			}
-			if (drawPos.x < device->clipping.left)
+			if (drawPos.x < clip->left)
 			{
 				continue;
 			}
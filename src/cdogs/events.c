@@ -38,6 +38,9 @@
 #include "music.h"
 #include "pic_manager.h"
 
+static ConfigHandle configScaleFactor = CONFIG_HANDLE("Graphics.ScaleFactor");
+static ConfigHandle configStartServer = CONFIG_HANDLE("StartServer");
+
 
 EventHandlers gEventHandlers;
 
@@ -163,7 +166,7 @@ void EventPoll(EventHandlers *handlers, Uint32 ticks)
 				MusicSetPlaying(&gSoundDevice, true);
 				break;
 			case SDL_WINDOWEVENT_FOCUS_LOST:
-				if (!gCampaign.IsClient && !ConfigGetBool(&gConfig, "StartServer"))
+				if (!gCampaign.IsClient && !ConfigHandleGetBool(&configStartServer))
 				{
 					MusicSetPlaying(&gSoundDevice, false);
 					handlers->HasLostFocus = true;
@@ -176,7 +179,7 @@ void EventPoll(EventHandlers *handlers, Uint32 ticks)
 				handlers->HasResolutionChanged = true;
 				if (gGraphicsDevice.cachedConfig.IsEditor)
 				{
-					const int scale = ConfigGetInt(&gConfig, "Graphics.ScaleFactor");
+					const int scale = ConfigHandleGetInt(&configScaleFactor);
 					GraphicsConfigSet(
 						&gGraphicsDevice.cachedConfig,
 						Vec2iNew(e.window.data1 / scale, e.window.data2 / scale),
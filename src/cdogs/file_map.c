@@ -0,0 +1,150 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "file_map.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "log.h"
+#include "utils.h"
+
+
+static bool ReadIntoBuf(FileMap *m, const char *path);
+#ifndef _WIN32
+static bool TryMap(FileMap *m, const char *path);
+#endif
+bool FileMapOpen(FileMap *m, const char *path)
+{
+	memset(m, 0, sizeof *m);
+#ifndef _WIN32
+	if (TryMap(m, path))
+	{
+		return true;
+	}
+#endif
+	return ReadIntoBuf(m, path);
+}
+void FileMapClose(FileMap *m)
+{
+#ifndef _WIN32
+	if (m->mapped != NULL)
+	{
+		munmap(m->mapped, m->Len);
+	}
+#endif
+	CFREE(m->buf);
+	memset(m, 0, sizeof *m);
+}
+
+#ifndef _WIN32
+static bool TryMap(FileMap *m, const char *path)
+{
+	bool res = false;
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+	{
+		goto bail;
+	}
+	// The mapping is only NUL-terminated if the file doesn't fill its last
+	// page, since the rest of that page reads as zeros
+	const long pageSize = sysconf(_SC_PAGESIZE);
+	if (pageSize <= 0 || st.st_size % pageSize == 0)
+	{
+		goto bail;
+	}
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		LOG(LM_MAIN, LL_DEBUG, "cannot map file %s: %s",
+			path, strerror(errno));
+		goto bail;
+	}
+	m->mapped = data;
+	m->Data = data;
+	m->Len = (size_t)st.st_size;
+	res = true;
+
+bail:
+	close(fd);
+	return res;
+}
+#endif
+
+static bool ReadIntoBuf(FileMap *m, const char *path)
+{
+	bool res = false;
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		LOG(LM_MAIN, LL_DEBUG, "cannot open file %s: %s",
+			path, strerror(errno));
+		goto bail;
+	}
+	if (fseek(f, 0L, SEEK_END) != 0)
+	{
+		goto bail;
+	}
+	const long len = ftell(f);
+	if (len < 0 || fseek(f, 0L, SEEK_SET) != 0)
+	{
+		goto bail;
+	}
+	CCALLOC(m->buf, len + 1);
+	if (len > 0 && fread(m->buf, 1, (size_t)len, f) != (size_t)len)
+	{
+		LOG(LM_MAIN, LL_DEBUG, "cannot read file %s: %s",
+			path, strerror(errno));
+		CFREE(m->buf);
+		m->buf = NULL;
+		goto bail;
+	}
+	m->Data = m->buf;
+	m->Len = (size_t)len;
+	res = true;
+
+bail:
+	if (f != NULL)
+	{
+		fclose(f);
+	}
+	return res;
+}
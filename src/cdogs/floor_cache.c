@@ -0,0 +1,100 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "floor_cache.h"
+
+#include <string.h>
+
+#include "grafx.h"
+#include "tile.h"
+#include "utils.h"
+
+
+void FloorCacheInit(FloorCache *c, const Vec2i size)
+{
+	c->Size = size;
+	c->Stride = size.x * TILE_WIDTH;
+	CCALLOC(c->rows, size.y * sizeof *c->rows);
+	CCALLOC(c->pics, size.x * size.y * sizeof *c->pics);
+	CCALLOC(c->opaque, size.x * size.y * sizeof *c->opaque);
+}
+void FloorCacheTerminate(FloorCache *c)
+{
+	if (c->rows != NULL)
+	{
+		for (int y = 0; y < c->Size.y; y++)
+		{
+			CFREE(c->rows[y]);
+		}
+	}
+	CFREE(c->rows);
+	CFREE(c->pics);
+	CFREE(c->opaque);
+	memset(c, 0, sizeof *c);
+}
+
+const Uint32 *FloorCacheGet(
+	FloorCache *c, const Vec2i pos, const NamedPic *pic, bool *isOpaque)
+{
+	const Pic *p = &pic->pic;
+	if (p->size.x != TILE_WIDTH || p->size.y != TILE_HEIGHT ||
+		!Vec2iIsZero(p->offset))
+	{
+		return NULL;
+	}
+	if (c->rows[pos.y] == NULL)
+	{
+		CMALLOC(
+			c->rows[pos.y],
+			c->Stride * TILE_HEIGHT * sizeof *c->rows[pos.y]);
+	}
+	Uint32 *pixels = c->rows[pos.y] + pos.x * TILE_WIDTH;
+	const int idx = pos.y * c->Size.x + pos.x;
+	if (c->pics[idx] != pic)
+	{
+		for (int i = 0; i < TILE_HEIGHT; i++)
+		{
+			memcpy(
+				pixels + i * c->Stride, p->Data + i * TILE_WIDTH,
+				TILE_WIDTH * sizeof *pixels);
+		}
+		const Uint32 amask = gGraphicsDevice.Amask;
+		c->opaque[idx] = true;
+		for (int i = 0; i < TILE_WIDTH * TILE_HEIGHT; i++)
+		{
+			if ((p->Data[i] & amask) != amask)
+			{
+				c->opaque[idx] = false;
+				break;
+			}
+		}
+		c->pics[idx] = pic;
+	}
+	*isOpaque = c->opaque[idx];
+	return pixels;
+}
@@ -0,0 +1,58 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+#include "cpic.h"
+#include "vector.h"
+
+// Floor pics of the map, prerendered into one strip of pixels per tile row,
+// so that runs of floor tiles can be drawn with one copy per line.
+// Each tile remembers the pic it was rendered with, and is rendered again
+// once its tile's pic changes (doors, exits, tile set events etc.).
+typedef struct
+{
+	Vec2i Size;	// in tiles
+	int Stride;	// pixels per line of each strip
+	Uint32 **rows;	// pixel strip of each tile row, allocated on first use
+	const NamedPic **pics;	// pic rendered into each tile
+	bool *opaque;	// whether each tile's pixels are all fully opaque
+} FloorCache;
+
+void FloorCacheInit(FloorCache *c, const Vec2i size);
+void FloorCacheTerminate(FloorCache *c);
+
+// Get the prerendered pixels of a tile, rendering them if pic has changed
+// Returns NULL if the pic doesn't fill the tile exactly, and so can't be
+// copied along with its neighbours
+const Uint32 *FloorCacheGet(
+	FloorCache *c, const Vec2i pos, const NamedPic *pic, bool *isOpaque);
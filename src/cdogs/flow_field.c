@@ -0,0 +1,323 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "flow_field.h"
+
+#include "ai_utils.h"
+#include "path_cache.h"
+
+FlowFields gFlowFields;
+
+typedef struct
+{
+	float Dist;
+	int Idx;
+} HeapItem;
+
+
+void FlowFieldsInit(FlowFields *f, Map *map)
+{
+	memset(f, 0, sizeof *f);
+	f->map = map;
+	CArrayInit(&f->fields, sizeof(FlowField));
+	CArrayInit(&f->heap, sizeof(HeapItem));
+	CArrayInit(&f->walkable, sizeof(char));
+	CArrayResize(&f->walkable, map->Size.x * map->Size.y, NULL);
+}
+void FlowFieldsTerminate(FlowFields *f)
+{
+	if (f->fields.elemSize == 0)
+	{
+		return;
+	}
+	CA_FOREACH(FlowField, ff, f->fields)
+		CArrayTerminate(&ff->dist);
+	CA_FOREACH_END()
+	CArrayTerminate(&f->fields);
+	CArrayTerminate(&f->heap);
+	CArrayTerminate(&f->walkable);
+	memset(f, 0, sizeof *f);
+}
+
+void FlowFieldsUpdate(FlowFields *f, const int ticks)
+{
+	f->ticks += ticks;
+	if (f->fields.elemSize == 0)
+	{
+		return;
+	}
+	for (int i = (int)f->fields.size - 1; i >= 0; i--)
+	{
+		FlowField *ff = CArrayGet(&f->fields, i);
+		const TActor *a = ActorGetByUID(ff->TargetUID);
+		if (a == NULL || !a->isInUse)
+		{
+			CArrayTerminate(&ff->dist);
+			CArrayDelete(&f->fields, i);
+		}
+	}
+}
+
+void FlowFieldsUpdateTile(FlowFields *f, const Vec2i tile)
+{
+	if (f->fields.elemSize == 0)
+	{
+		return;
+	}
+	CA_FOREACH(FlowField, ff, f->fields)
+		if (ff->dirty) continue;
+		// A tile only affects steps to and from its neighbours, so the
+		// field is unchanged unless it reaches one of them
+		Vec2i v;
+		for (v.y = tile.y - 1; v.y <= tile.y + 1 && !ff->dirty; v.y++)
+		{
+			for (v.x = tile.x - 1; v.x <= tile.x + 1; v.x++)
+			{
+				if (FlowFieldGetDistance(ff, f->map, v) >= 0)
+				{
+					ff->dirty = true;
+					break;
+				}
+			}
+		}
+	CA_FOREACH_END()
+}
+void FlowFieldsInvalidate(FlowFields *f)
+{
+	if (f->fields.elemSize == 0)
+	{
+		return;
+	}
+	CA_FOREACH(FlowField, ff, f->fields)
+		ff->dirty = true;
+	CA_FOREACH_END()
+}
+
+static void HeapPush(CArray *heap, const HeapItem item)
+{
+	CArrayPushBack(heap, &item);
+	HeapItem *h = heap->data;
+	int i = (int)heap->size - 1;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (h[parent].Dist <= item.Dist) break;
+		h[i] = h[parent];
+		i = parent;
+	}
+	h[i] = item;
+}
+static HeapItem HeapPop(CArray *heap)
+{
+	HeapItem *h = heap->data;
+	const HeapItem top = h[0];
+	const HeapItem last = h[heap->size - 1];
+	heap->size--;
+	const int size = (int)heap->size;
+	int i = 0;
+	for (;;)
+	{
+		int child = 2 * i + 1;
+		if (child >= size) break;
+		if (child + 1 < size && h[child + 1].Dist < h[child].Dist)
+		{
+			child++;
+		}
+		if (last.Dist <= h[child].Dist) break;
+		h[i] = h[child];
+		i = child;
+	}
+	if (size > 0)
+	{
+		h[i] = last;
+	}
+	return top;
+}
+
+static bool CanStep(Map *map, const Vec2i from, const Vec2i to)
+{
+	// Same rules as pathfinding: if moving diagonally,
+	// the axis-aligned neighbours also need to be clear
+	return IsTileWalkable(map, to) &&
+		IsTileWalkable(map, Vec2iNew(from.x, to.y)) &&
+		IsTileWalkable(map, Vec2iNew(to.x, from.y));
+}
+
+// Walkability, cached for the duration of an update
+#define WALKABLE_UNKNOWN 0
+#define WALKABLE_YES 1
+#define WALKABLE_NO 2
+static bool IsWalkableCached(FlowFields *f, const Vec2i v)
+{
+	if (!MapIsTileIn(f->map, v))
+	{
+		return false;
+	}
+	char *w = CArrayGet(&f->walkable, v.y * f->map->Size.x + v.x);
+	if (*w == WALKABLE_UNKNOWN)
+	{
+		*w = IsTileWalkable(f->map, v) ? WALKABLE_YES : WALKABLE_NO;
+	}
+	return *w == WALKABLE_YES;
+}
+
+// Dijkstra outwards from the target tile
+static void FlowFieldCalc(FlowFields *f, FlowField *ff)
+{
+	Map *map = f->map;
+	float *dist = ff->dist.data;
+	for (int i = 0; i < (int)ff->dist.size; i++)
+	{
+		dist[i] = -1;
+	}
+	if (!MapIsTileIn(map, ff->Target))
+	{
+		return;
+	}
+	CArrayClear(&f->heap);
+	CArrayFillZero(&f->walkable);
+	const int targetIdx = ff->Target.y * map->Size.x + ff->Target.x;
+	dist[targetIdx] = 0;
+	HeapItem start = { 0, targetIdx };
+	HeapPush(&f->heap, start);
+	while (f->heap.size > 0)
+	{
+		const HeapItem item = HeapPop(&f->heap);
+		if (item.Dist > dist[item.Idx])
+		{
+			continue;
+		}
+		const Vec2i v = Vec2iNew(item.Idx % map->Size.x, item.Idx / map->Size.x);
+		Vec2i w;
+		for (w.y = v.y - 1; w.y <= v.y + 1; w.y++)
+		{
+			for (w.x = v.x - 1; w.x <= v.x + 1; w.x++)
+			{
+				if (Vec2iEqual(v, w) || !MapIsTileIn(map, w))
+				{
+					continue;
+				}
+				// Moves are symmetric, so check the step from w to v
+				if (!IsWalkableCached(f, w) ||
+					!IsWalkableCached(f, Vec2iNew(w.x, v.y)) ||
+					!IsWalkableCached(f, Vec2iNew(v.x, w.y)))
+				{
+					continue;
+				}
+				const int wIdx = w.y * map->Size.x + w.x;
+				const float d = item.Dist + PathStepCost(v, w);
+				if (d > FLOW_FIELD_MAX_DIST)
+				{
+					continue;
+				}
+				if (dist[wIdx] < 0 || d < dist[wIdx])
+				{
+					dist[wIdx] = d;
+					HeapItem next = { d, wIdx };
+					HeapPush(&f->heap, next);
+				}
+			}
+		}
+	}
+}
+
+const FlowField *FlowFieldsGet(FlowFields *f, const TActor *target)
+{
+	if (f->fields.elemSize == 0 || target == NULL)
+	{
+		return NULL;
+	}
+	FlowField *ff = NULL;
+	CA_FOREACH(FlowField, ffi, f->fields)
+		if (ffi->TargetUID == target->uid)
+		{
+			ff = ffi;
+			break;
+		}
+	CA_FOREACH_END()
+	if (ff == NULL)
+	{
+		FlowField ffNew;
+		memset(&ffNew, 0, sizeof ffNew);
+		ffNew.TargetUID = target->uid;
+		ffNew.Target = Vec2iNew(-1, -1);
+		CArrayInit(&ffNew.dist, sizeof(float));
+		CArrayResize(&ffNew.dist, f->map->Size.x * f->map->Size.y, NULL);
+		CArrayPushBack(&f->fields, &ffNew);
+		ff = CArrayGet(&f->fields, (int)f->fields.size - 1);
+		ff->updateTicks = f->ticks - FLOW_FIELD_UPDATE_TICKS;
+	}
+	const Vec2i targetTile = Vec2iToTile(Vec2iFull2Real(target->Pos));
+	if (ff->dirty ||
+		(f->ticks - ff->updateTicks >= FLOW_FIELD_UPDATE_TICKS &&
+		!Vec2iEqual(targetTile, ff->Target)))
+	{
+		ff->Target = targetTile;
+		FlowFieldCalc(f, ff);
+		ff->updateTicks = f->ticks;
+		ff->dirty = false;
+	}
+	return ff;
+}
+
+float FlowFieldGetDistance(
+	const FlowField *ff, const Map *map, const Vec2i tile)
+{
+	if (!MapIsTileIn(map, tile))
+	{
+		return -1;
+	}
+	return *(float *)CArrayGet(&ff->dist, tile.y * map->Size.x + tile.x);
+}
+
+bool FlowFieldGetNext(
+	const FlowField *ff, Map *map, const Vec2i tile, Vec2i *next)
+{
+	float best = FlowFieldGetDistance(ff, map, tile);
+	if (best < 0)
+	{
+		return false;
+	}
+	bool found = false;
+	Vec2i w;
+	for (w.y = tile.y - 1; w.y <= tile.y + 1; w.y++)
+	{
+		for (w.x = tile.x - 1; w.x <= tile.x + 1; w.x++)
+		{
+			const float d = FlowFieldGetDistance(ff, map, w);
+			if (d < 0 || d >= best || !CanStep(map, tile, w))
+			{
+				continue;
+			}
+			best = d;
+			*next = w;
+			found = true;
+		}
+	}
+	return found;
+}
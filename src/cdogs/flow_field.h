@@ -0,0 +1,84 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "actors.h"
+#include "c_array.h"
+#include "map.h"
+#include "vector.h"
+
+// Flow fields: distance maps towards a target actor over walkable tiles
+// Many AI actors chasing the same target can share one field, stepping
+// downhill instead of pathfinding individually.
+
+// Recalculate fields at most this often
+#define FLOW_FIELD_UPDATE_TICKS 35
+// Maximum path cost covered by fields; beyond this AI is usually asleep
+#define FLOW_FIELD_MAX_DIST (48 * TILE_WIDTH)
+
+typedef struct
+{
+	int TargetUID;
+	Vec2i Target;	// target tile at last update
+	int updateTicks;	// ticks at last update
+	bool dirty;	// the map changed where the field reaches
+	CArray dist;	// of float; path cost to target, negative if unreachable
+} FlowField;
+
+typedef struct
+{
+	Map *map;
+	CArray fields;	// of FlowField
+	int ticks;
+	CArray heap;	// scratch space for updates
+	CArray walkable;	// of char; per-tile cache for updates
+} FlowFields;
+
+// Note: lifetime managed by Map
+extern FlowFields gFlowFields;
+
+void FlowFieldsInit(FlowFields *f, Map *map);
+void FlowFieldsTerminate(FlowFields *f);
+// Advance time, and drop fields whose target actor is gone
+void FlowFieldsUpdate(FlowFields *f, const int ticks);
+// Recalculate fields that reach a tile whose walkability may have changed
+void FlowFieldsUpdateTile(FlowFields *f, const Vec2i tile);
+// Recalculate all fields, e.g. when doors are unlocked
+void FlowFieldsInvalidate(FlowFields *f);
+
+// Get the field towards a target actor, updating it if stale
+const FlowField *FlowFieldsGet(FlowFields *f, const TActor *target);
+
+// Path cost from tile to the target; negative if unreachable
+float FlowFieldGetDistance(
+	const FlowField *ff, const Map *map, const Vec2i tile);
+// Get the next tile to move to from a tile
+// Returns false if there is no way towards the target
+bool FlowFieldGetNext(
+	const FlowField *ff, Map *map, const Vec2i tile, Vec2i *next);
@@ -75,9 +75,10 @@ static GameEventEntry sGameEventEntries[] =
 	{ GAME_EVENT_GAME_BEGIN, true, false, true, true, NULL },
 
 	{ GAME_EVENT_ACTOR_ADD, true, false, true, true, NActorAdd_fields },
-	{ GAME_EVENT_ACTOR_MOVE, true, true, true, true, NActorMove_fields },
-	{ GAME_EVENT_ACTOR_STATE, true, true, true, true, NActorState_fields },
-	{ GAME_EVENT_ACTOR_DIR, true, true, true, true, NActorDir_fields },
+	// Servers send these to clients in snapshots instead (see net_snapshot.h)
+	{ GAME_EVENT_ACTOR_MOVE, false, true, true, true, NActorMove_fields },
+	{ GAME_EVENT_ACTOR_STATE, false, true, true, true, NActorState_fields },
+	{ GAME_EVENT_ACTOR_DIR, false, true, true, true, NActorDir_fields },
 	{ GAME_EVENT_ACTOR_SLIDE, true, true, true, true, NActorSlide_fields },
 	{ GAME_EVENT_ACTOR_IMPULSE, true, false, true, true, NActorImpulse_fields },
 	{ GAME_EVENT_ACTOR_SWITCH_GUN, true, true, true, true, NActorSwitchGun_fields },
@@ -98,7 +99,8 @@ static GameEventEntry sGameEventEntries[] =
 	{ GAME_EVENT_PARTICLE_REMOVE, false, false, true, true, NULL },
 	{ GAME_EVENT_GUN_FIRE, true, true, true, true, NGunFire_fields },
 	{ GAME_EVENT_GUN_RELOAD, true, true, true, true, NGunReload_fields },
-	{ GAME_EVENT_GUN_STATE, true, true, true, true, NGunState_fields },
+	// Sent in snapshots
+	{ GAME_EVENT_GUN_STATE, false, true, true, true, NGunState_fields },
 	{ GAME_EVENT_ADD_BULLET, true, false, true, true, NAddBullet_fields },
 	{ GAME_EVENT_ADD_PARTICLE, false, false, true, true, NULL },
 	{ GAME_EVENT_TRIGGER, true, false, true, true, NTrigger_fields },
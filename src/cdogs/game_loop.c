@@ -32,9 +32,11 @@
 
 #include "config.h"
 #include "events.h"
+#include "grafx.h"
 #include "net_client.h"
 #include "net_server.h"
 #include "sounds.h"
+#include "tick_profile.h"
 
 
 GameLoopData GameLoopDataNew(
@@ -51,23 +53,36 @@ GameLoopData GameLoopDataNew(
 	return g;
 }
 
+// Time that the nth tick after start is due, in performance counter units
+// Computed from the start rather than adding up rounded tick lengths, so
+// that the tick rate doesn't drift
+static Uint64 TickTime(const Uint64 start, const Uint64 n, const int fps)
+{
+	return start + n * SDL_GetPerformanceFrequency() / fps;
+}
+
+static void GameLoopHeadless(GameLoopData *data);
 void GameLoop(GameLoopData *data)
 {
+	if (data->Headless)
+	{
+		GameLoopHeadless(data);
+		return;
+	}
 	EventReset(
 		&gEventHandlers,
 		gEventHandlers.mouse.cursor, gEventHandlers.mouse.trail);
 	GameLoopResult result = UPDATE_RESULT_OK;
-	Uint32 ticksNow = SDL_GetTicks();
-	Uint32 ticksElapsed = 0;
+	// Ticks are run on a schedule starting here
+	Uint64 ticksStart = SDL_GetPerformanceCounter();
+	Uint64 ticks = 0;
 	int framesSkipped = 0;
 	const int maxFrameskip = data->FPS / 5;
 	for (; result != UPDATE_RESULT_EXIT; )
 	{
 		// Frame rate control
-		const Uint32 ticksThen = ticksNow;
-		ticksNow = SDL_GetTicks();
-		ticksElapsed += ticksNow - ticksThen;
-		if ((int)ticksElapsed < 1000 / data->FPS)
+		const Uint64 now = SDL_GetPerformanceCounter();
+		if (now < TickTime(ticksStart, ticks + 1, data->FPS))
 		{
 			SDL_Delay(1);
 			continue;
@@ -76,7 +91,7 @@ void GameLoop(GameLoopData *data)
 		// Input
 		if ((data->Frames & 1) || !data->InputEverySecondFrame)
 		{
-			EventPoll(&gEventHandlers, ticksNow);
+			EventPoll(&gEventHandlers, SDL_GetTicks());
 			if (data->InputFunc)
 			{
 				data->InputFunc(data->InputData);
@@ -87,7 +102,9 @@ void GameLoop(GameLoopData *data)
 		NetServerPoll(&gNetServer);
 
 		// Update
+		TickProfileTickBegin(&gTickProfile);
 		result = data->UpdateFunc(data->UpdateData);
+		TickProfileTickEnd(&gTickProfile);
 		NetServerFlush(&gNetServer);
 		NetClientFlush(&gNetClient);
 		bool draw = !data->HasDrawnFirst;
@@ -106,16 +123,21 @@ void GameLoop(GameLoopData *data)
 			CASSERT(false, "Unknown loop result");
 			break;
 		}
-		ticksElapsed -= 1000 / data->FPS;
+		ticks++;
 		data->Frames++;
+		if (data->MaxFrames > 0 && data->Frames >= data->MaxFrames)
+		{
+			break;
+		}
 		// frame skip
-		if ((int)ticksElapsed > 1000 / data->FPS)
+		if (now > TickTime(ticksStart, ticks + 1, data->FPS))
 		{
 			framesSkipped++;
 			if (framesSkipped == maxFrameskip)
 			{
 				// We've skipped too many frames; give up
-				ticksElapsed = 0;
+				ticksStart = now;
+				ticks = 0;
 			}
 			else
 			{
@@ -136,3 +158,63 @@ void GameLoop(GameLoopData *data)
 		}
 	}
 }
+static Uint32 HashFrame(Uint32 hash);
+static void GameLoopHeadless(GameLoopData *data)
+{
+	GameLoopResult result = UPDATE_RESULT_OK;
+	Uint64 ticksStart = SDL_GetPerformanceCounter();
+	Uint64 ticks = 0;
+	while (result != UPDATE_RESULT_EXIT &&
+		(data->MaxFrames <= 0 || data->Frames < data->MaxFrames) &&
+		(data->HeadlessQuit == NULL || !*data->HeadlessQuit))
+	{
+		if (data->HeadlessRealtime)
+		{
+			const Uint64 freq = SDL_GetPerformanceFrequency();
+			const Uint64 now = SDL_GetPerformanceCounter();
+			const Uint64 next = TickTime(ticksStart, ticks, data->FPS);
+			if (next > now)
+			{
+				SDL_Delay((Uint32)((next - now) * 1000 / freq));
+			}
+			else if (now - next > freq)
+			{
+				// We've fallen too far behind; don't try to catch up
+				ticksStart = now;
+				ticks = 0;
+			}
+			ticks++;
+		}
+
+		NetClientPoll(&gNetClient);
+		NetServerPoll(&gNetServer);
+
+		TickProfileTickBegin(&gTickProfile);
+		result = data->UpdateFunc(data->UpdateData);
+		if (data->HeadlessDraw && data->DrawFunc)
+		{
+			TickProfileSectionBegin(&gTickProfile);
+			data->DrawFunc(data->DrawData);
+			TickProfileSectionEnd(&gTickProfile, TICK_SECTION_RENDER);
+			if (data->FrameHash != NULL)
+			{
+				*data->FrameHash = HashFrame(*data->FrameHash);
+			}
+		}
+		TickProfileTickEnd(&gTickProfile);
+
+		NetServerFlush(&gNetServer);
+		NetClientFlush(&gNetClient);
+		data->Frames++;
+	}
+}
+// FNV-1a over the frame buffer, continuing from a previous frame's hash
+static Uint32 HashFrame(Uint32 hash)
+{
+	const int size = GraphicsGetScreenSize(&gGraphicsDevice.cachedConfig);
+	for (int i = 0; i < size; i++)
+	{
+		hash = (hash ^ gGraphicsDevice.buf[i]) * 16777619u;
+	}
+	return hash;
+}
@@ -29,8 +29,11 @@
 #ifndef __GAME_LOOP
 #define __GAME_LOOP
 
+#include <signal.h>
 #include <stdbool.h>
 
+#include <SDL_stdinc.h>
+
 // Result from calling update callback,
 // what the game loop should do after update
 typedef enum
@@ -53,6 +56,21 @@ typedef struct
 	bool InputEverySecondFrame;
 	int Frames;		// total frames looped
 	bool HasDrawnFirst;
+	// Run updates back-to-back, without frame rate control, input or drawing
+	bool Headless;
+	// When headless, still draw every frame into the graphics buffer,
+	// without presenting it
+	bool HeadlessDraw;
+	// If set, every frame drawn headless is hashed into this, to check that
+	// different ways of drawing give the same frames
+	Uint32 *FrameHash;
+	// Exit after this many frames; 0 for no limit
+	int MaxFrames;
+	// When headless, run at FPS instead of as fast as possible
+	bool HeadlessRealtime;
+	// If set, a headless loop exits once this is non-zero; it can be set
+	// from a signal handler
+	volatile sig_atomic_t *HeadlessQuit;
 } GameLoopData;
 
 GameLoopData GameLoopDataNew(
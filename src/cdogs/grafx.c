@@ -58,6 +58,7 @@
 #include <SDL_mouse.h>
 
 #include "blit.h"
+#include "blit_kernels.h"
 #include "config.h"
 #include "defs.h"
 #include "grafx_bg.h"
@@ -132,6 +133,7 @@ static void AddGraphicsMode(GraphicsDevice *device, const int w, const int h)
 	CArrayInsert(&device->validModes, i, &mode);
 }
 
+static void OnBrightnessChanged(Config *c, void *data);
 void GraphicsInit(GraphicsDevice *device, Config *c)
 {
 	device->IsInitialized = 0;
@@ -153,6 +155,15 @@ void GraphicsInit(GraphicsDevice *device, Config *c)
 	device->buf = NULL;
 	device->bkg = NULL;
 	GraphicsConfigSetFromConfig(&device->cachedConfig, c);
+	Config *brightness = ConfigGet(c, "Graphics.Brightness");
+	device->cachedConfig.Brightness = brightness->u.Int.Value;
+	ConfigAddListener(brightness, OnBrightnessChanged, device);
+	BlitKernelsInit();
+}
+static void OnBrightnessChanged(Config *c, void *data)
+{
+	GraphicsDevice *device = data;
+	device->cachedConfig.Brightness = c->u.Int.Value;
 }
 
 static void AddSupportedGraphicsModes(GraphicsDevice *device)
@@ -317,6 +328,27 @@ void GraphicsInitialize(GraphicsDevice *g, const bool force)
 	g->cachedConfig.needRestart = false;
 }
 
+void GraphicsInitializeHeadless(GraphicsDevice *g)
+{
+	LOG(LM_GFX, LL_INFO, "headless graphics (%dx%d)",
+		g->cachedConfig.Res.x, g->cachedConfig.Res.y);
+	SDL_FreeFormat(g->Format);
+	g->Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	g->Amask =
+		0xffffffff & ~(g->Format->Rmask | g->Format->Gmask | g->Format->Bmask);
+	g->Ashift = 48 - g->Format->Rshift - g->Format->Gshift - g->Format->Bshift;
+
+	CFREE(g->buf);
+	CCALLOC(g->buf, GraphicsGetMemSize(&g->cachedConfig));
+	CFREE(g->bkg);
+	CCALLOC(g->bkg, GraphicsGetMemSize(&g->cachedConfig));
+	GraphicsSetBlitClip(
+		g, 0, 0, g->cachedConfig.Res.x - 1, g->cachedConfig.Res.y - 1);
+
+	g->IsInitialized = true;
+	g->cachedConfig.needRestart = false;
+}
+
 void GraphicsTerminate(GraphicsDevice *g)
 {
 	debug(D_NORMAL, "Shutting down video...\n");
@@ -400,3 +432,13 @@ void GraphicsResetBlitClip(GraphicsDevice *device)
 		device->cachedConfig.Res.x - 1,
 		device->cachedConfig.Res.y - 1);
 }
+
+static THREAD_LOCAL const BlitClipping *tClip = NULL;
+const BlitClipping *GraphicsGetBlitClip(const GraphicsDevice *device)
+{
+	return tClip != NULL ? tClip : &device->clipping;
+}
+void GraphicsSetThreadBlitClip(const BlitClipping *clip)
+{
+	tClip = clip;
+}
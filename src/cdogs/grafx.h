@@ -66,6 +66,8 @@ typedef struct
 	int ScaleFactor;
 	ScaleMode ScaleMode;
 	bool IsEditor;
+	// Kept in sync with Graphics.Brightness by a config listener
+	int Brightness;
 
 	bool needRestart;
 } GraphicsConfig;
@@ -101,6 +103,9 @@ extern GraphicsDevice gGraphicsDevice;
 
 void GraphicsInit(GraphicsDevice *device, Config *c);
 void GraphicsInitialize(GraphicsDevice *g, const bool force);
+// Initialise the frame buffers and pixel format without creating a window
+// or renderer; drawing still works but nothing is presented
+void GraphicsInitializeHeadless(GraphicsDevice *g);
 void GraphicsTerminate(GraphicsDevice *g);
 int GraphicsGetScreenSize(GraphicsConfig *config);
 int GraphicsGetMemSize(GraphicsConfig *config);
@@ -118,6 +123,12 @@ char *GrafxGetModeStr(void);
 void GraphicsSetBlitClip(
 	GraphicsDevice *device, int left, int top, int right, int bottom);
 void GraphicsResetBlitClip(GraphicsDevice *device);
+// Clipping rect for blits on the calling thread; this is the device's,
+// unless the thread has its own
+const BlitClipping *GraphicsGetBlitClip(const GraphicsDevice *device);
+// Give the calling thread its own clipping rect, so that views drawn on
+// different threads can be clipped separately; NULL to use the device's
+void GraphicsSetThreadBlitClip(const BlitClipping *clip);
 
 #define CenterX(w)		((gGraphicsDevice.cachedConfig.Res.x - w) / 2)
 #define CenterY(h)		((gGraphicsDevice.cachedConfig.Res.y - h) / 2)
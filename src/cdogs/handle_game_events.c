@@ -29,10 +29,13 @@
 
 #include "actor_placement.h"
 #include "ai_utils.h"
+#include "automap.h"
 #include "damage.h"
 #include "events.h"
+#include "flow_field.h"
 #include "game_events.h"
 #include "joystick.h"
+#include "los.h"
 #include "net_server.h"
 #include "objs.h"
 #include "particle.h"
@@ -89,11 +92,19 @@ static void HandleGameEvent(
 			for (int i = 0; i <= e.u.TileSet.RunLength; i++)
 			{
 				Tile *t = MapGetTile(&gMap, pos);
+				const bool wasNoSee = t->flags & MAPTILE_NO_SEE;
 				t->flags = e.u.TileSet.Flags;
+				if (wasNoSee != !!(t->flags & MAPTILE_NO_SEE))
+				{
+					LOSUpdateTile(&gMap.LOS, pos);
+				}
 				t->pic = PicManagerGetNamedPic(
 					&gPicManager, e.u.TileSet.PicName);
 				t->picAlt = PicManagerGetNamedPic(
 					&gPicManager, e.u.TileSet.PicAltName);
+				PathCacheUpdateTile(&gPathCache, pos);
+				FlowFieldsUpdateTile(&gFlowFields, pos);
+				AutomapCacheUpdateTile(&gAutomapCache, &gMap, pos);
 				pos.x++;
 				if (pos.x == gMap.Size.x)
 				{
@@ -140,6 +151,7 @@ static void HandleGameEvent(
 			CASSERT(false, "Unknown config type");
 			break;
 		}
+		ConfigNotifyChanged(c);
 	}
 	break;
 	case GAME_EVENT_SCORE:
@@ -158,7 +170,7 @@ static void HandleGameEvent(
 		{
 			SoundPlayAt(
 				&gSoundDevice,
-				StrSound(e.u.SoundAt.Sound), Net2Vec2i(e.u.SoundAt.Pos));
+				IdSound(e.u.SoundAt.SoundId), Net2Vec2i(e.u.SoundAt.Pos));
 		}
 		break;
 	case GAME_EVENT_SCREEN_SHAKE:
@@ -326,7 +338,7 @@ static void HandleGameEvent(
 		{
 			const TActor *a = ActorGetByUID(e.u.Melee.UID);
 			if (!a->isInUse) break;
-			const BulletClass *b = StrBulletClass(e.u.Melee.BulletClass);
+			const BulletClass *b = IdBulletClass(e.u.Melee.BulletClassId);
 			if ((HitType)e.u.Melee.HitType != HIT_NONE &&
 				HasHitSound(b->Power, a->flags, a->PlayerUID,
 				(TileItemKind)e.u.Melee.TargetKind, e.u.Melee.TargetUID,
@@ -395,7 +407,7 @@ static void HandleGameEvent(
 		break;
 	case GAME_EVENT_GUN_FIRE:
 		{
-			const GunDescription *g = StrGunDescription(e.u.GunFire.Gun);
+			const GunDescription *g = IdGunDescription(e.u.GunFire.GunId);
 			const Vec2i fullPos = Net2Vec2i(e.u.GunFire.MuzzleFullPos);
 
 			// Add bullets
@@ -417,7 +429,7 @@ static void HandleGameEvent(
 						i * g->Spread.Width + recoil;
 					GameEvent ab = GameEventNew(GAME_EVENT_ADD_BULLET);
 					ab.u.AddBullet.UID = MobObjsObjsGetNextUID();
-					strcpy(ab.u.AddBullet.BulletClass, g->Bullet->Name);
+					ab.u.AddBullet.BulletClassId = BulletClassId(g->Bullet);
 					ab.u.AddBullet.MuzzlePos = Vec2i2Net(fullPos);
 					ab.u.AddBullet.MuzzleHeight = e.u.GunFire.Z;
 					ab.u.AddBullet.Angle = (float)finalAngle;
@@ -464,7 +476,7 @@ static void HandleGameEvent(
 		break;
 	case GAME_EVENT_GUN_RELOAD:
 		{
-			const GunDescription *g = StrGunDescription(e.u.GunReload.Gun);
+			const GunDescription *g = IdGunDescription(e.u.GunReload.GunId);
 			const Vec2i fullPos = Net2Vec2i(e.u.GunReload.FullPos);
 			SoundPlayAtPlusDistance(
 				&gSoundDevice,
@@ -587,8 +599,9 @@ static void HandleGameEvent(
 		gMission.KeyFlags |= e.u.AddKeys.KeyFlags;
 		SoundPlayAt(
 			&gSoundDevice, gSoundDevice.keySound, Net2Vec2i(e.u.AddKeys.Pos));
-		// Clear cache since we may now have new paths
-		PathCacheClear(&gPathCache);
+		// Update paths through the doors that can now be opened
+		PathCacheUpdateDoors(&gPathCache, e.u.AddKeys.KeyFlags);
+		FlowFieldsInvalidate(&gFlowFields);
 		break;
 	case GAME_EVENT_MISSION_COMPLETE:
 		if (camera != NULL && e.u.MissionComplete.ShowMsg)
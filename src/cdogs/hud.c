@@ -50,6 +50,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 
 #include "actors.h"
@@ -61,7 +62,18 @@
 #include "font.h"
 #include "game_events.h"
 #include "mission.h"
+#include "net_client.h"
+#include "net_server.h"
+#include "objs.h"
 #include "pic_manager.h"
+#include "pickup.h"
+
+static ConfigHandle configAmmo = CONFIG_HANDLE("Game.Ammo");
+static ConfigHandle configShowFPS = CONFIG_HANDLE("Interface.ShowFPS");
+static ConfigHandle configShowNetStats = CONFIG_HANDLE("Interface.ShowNetStats");
+static ConfigHandle configShowHUDMap = CONFIG_HANDLE("Interface.ShowHUDMap");
+static ConfigHandle configShowTime = CONFIG_HANDLE("Interface.ShowTime");
+static ConfigHandle configSplitscreen = CONFIG_HANDLE("Interface.Splitscreen");
 
 
 // Total number of milliseconds that the numeric update lasts for
@@ -100,6 +112,66 @@ void FPSCounterDraw(FPSCounter *counter)
 	FontStrOpt(s, Vec2iZero(), opts);
 }
 
+#define NET_STATS_TOP_TYPES 3
+// Draw traffic rates, peer connection quality and the message types using
+// the most bandwidth, above the FPS counter
+static void NetStatsDraw(const NetStats *stats)
+{
+	char s[128];
+	FontOpts opts = FontOptsNew();
+	opts.HAlign = ALIGN_END;
+	opts.VAlign = ALIGN_END;
+	opts.Area = gGraphicsDevice.cachedConfig.Res;
+	opts.Pad = Vec2iNew(10, 5 + FontH() * 2);
+
+	int top[NET_STATS_TOP_TYPES];
+	for (int i = 0; i < NET_STATS_TOP_TYPES; i++)
+	{
+		top[i] = -1;
+	}
+	for (int i = 0; i < NET_STATS_TYPES; i++)
+	{
+		const NetTraffic *t = &stats->TypesRate[i];
+		const Uint64 bytes = t->Sent.Bytes + t->Recv.Bytes;
+		if (bytes == 0) continue;
+		// Insertion sort into the top types
+		for (int j = 0; j < NET_STATS_TOP_TYPES; j++)
+		{
+			const NetTraffic *tj = top[j] < 0 ? NULL : &stats->TypesRate[top[j]];
+			if (tj == NULL || bytes > tj->Sent.Bytes + tj->Recv.Bytes)
+			{
+				memmove(top + j + 1, top + j,
+					(NET_STATS_TOP_TYPES - j - 1) * sizeof top[0]);
+				top[j] = i;
+				break;
+			}
+		}
+	}
+	for (int i = NET_STATS_TOP_TYPES - 1; i >= 0; i--)
+	{
+		if (top[i] < 0) continue;
+		const NetTraffic *t = &stats->TypesRate[top[i]];
+		sprintf(s, "%s: %d/s %.1f KB/s",
+			NetStatsTypeStr(top[i]),
+			(int)(t->Sent.Msgs + t->Recv.Msgs),
+			(t->Sent.Bytes + t->Recv.Bytes) / 1024.0);
+		FontStrOpt(s, Vec2iZero(), opts);
+		opts.Pad.y += FontH();
+	}
+	for (int i = (int)stats->Peers.size - 1; i >= 0; i--)
+	{
+		const NetPeerStats *ps = CArrayGet(&stats->Peers, i);
+		sprintf(s, "Peer %d: RTT %dms loss %.1f%% queue %d",
+			ps->Id, ps->RTTMs, ps->PacketLoss * 100, ps->Queue);
+		FontStrOpt(s, Vec2iZero(), opts);
+		opts.Pad.y += FontH();
+	}
+	sprintf(s, "Net up: %.1f KB/s down: %.1f KB/s",
+		stats->TotalRate.Sent.Bytes / 1024.0,
+		stats->TotalRate.Recv.Bytes / 1024.0);
+	FontStrOpt(s, Vec2iZero(), opts);
+}
+
 void WallClockSetTime(WallClock *wc)
 {
 	time_t t = time(NULL);
@@ -371,7 +443,7 @@ static void DrawWeaponStatus(
 	opts.Area = gGraphicsDevice.cachedConfig.Res;
 	opts.Pad = Vec2iNew(pos.x + GUN_ICON_PAD, pos.y);
 	char buf[128];
-	if (ConfigGetBool(&gConfig, "Game.Ammo") && weapon->Gun->AmmoId >= 0)
+	if (ConfigHandleGetBool(&configAmmo) && weapon->Gun->AmmoId >= 0)
 	{
 		// Include ammo counter
 		sprintf(buf, "%s %d/%d",
@@ -642,7 +714,7 @@ static void DrawPlayerStatus(
 	char s[50];
 	if (IsScoreNeeded(gCampaign.Entry.Mode))
 	{
-		if (ConfigGetBool(&gConfig, "Game.Ammo"))
+		if (ConfigHandleGetBool(&configAmmo))
 		{
 			// Display money instead of ammo
 			sprintf(s, "Cash: $%d", data->Stats.Score);
@@ -680,7 +752,7 @@ static void DrawPlayerStatus(
 		FontStrOpt(s, Vec2iZero(), opts);
 	}
 
-	if (ConfigGetBool(&gConfig, "Interface.ShowHUDMap") &&
+	if (ConfigHandleGetBool(&configShowHUDMap) &&
 		!(flags & HUDFLAGS_SHARE_SCREEN) &&
 		IsAutoMapEnabled(gCampaign.Entry.Mode))
 	{
@@ -692,6 +764,8 @@ static void DrawPlayerStatus(
 static void DrawCompassArrow(
 	GraphicsDevice *g, Rect2i r, Vec2i pos, Vec2i playerPos, color_t mask,
 	const char *label);
+static void DrawObjectiveArrow(
+	GraphicsDevice *g, Rect2i r, const TTileItem *ti, Vec2i playerPos);
 static void DrawObjectiveCompass(
 	GraphicsDevice *g, Vec2i playerPos, Rect2i r, bool showExit)
 {
@@ -703,35 +777,43 @@ static void DrawObjectiveCompass(
 	}
 
 	// Draw objectives
-	Map *map = &gMap;
-	Vec2i tilePos;
-	for (tilePos.y = 0; tilePos.y < map->Size.y; tilePos.y++)
+	CA_FOREACH(const TActor, a, gActors)
+		if (!a->isInUse) continue;
+		DrawObjectiveArrow(g, r, &a->tileItem, playerPos);
+	CA_FOREACH_END()
+	CA_FOREACH(const TObject, o, gObjs)
+		if (!o->isInUse) continue;
+		DrawObjectiveArrow(g, r, &o->tileItem, playerPos);
+	CA_FOREACH_END()
+	CA_FOREACH(const Pickup, p, gPickups)
+		if (!p->isInUse) continue;
+		DrawObjectiveArrow(g, r, &p->tileItem, playerPos);
+	CA_FOREACH_END()
+}
+static void DrawObjectiveArrow(
+	GraphicsDevice *g, Rect2i r, const TTileItem *ti, Vec2i playerPos)
+{
+	if (!(ti->flags & TILEITEM_OBJECTIVE))
+	{
+		return;
+	}
+	const int objective = ObjectiveFromTileItem(ti->flags);
+	const Objective *o =
+		CArrayGet(&gMission.missionData->Objectives, objective);
+	if (o->Flags & OBJECTIVE_HIDDEN)
+	{
+		return;
+	}
+	if (!(o->Flags & OBJECTIVE_POSKNOWN))
 	{
-		for (tilePos.x = 0; tilePos.x < map->Size.x; tilePos.x++)
+		const Tile *tile =
+			MapGetTile(&gMap, Vec2iToTile(Vec2iNew(ti->x, ti->y)));
+		if (tile == NULL || !tile->isVisited)
 		{
-			Tile *tile = MapGetTile(map, tilePos);
-			CA_FOREACH(ThingId, tid, tile->things)
-				TTileItem *ti = ThingIdGetTileItem(tid);
-				if (!(ti->flags & TILEITEM_OBJECTIVE))
-				{
-					continue;
-				}
-				const int objective = ObjectiveFromTileItem(ti->flags);
-				const Objective *o =
-					CArrayGet(&gMission.missionData->Objectives, objective);
-				if (o->Flags & OBJECTIVE_HIDDEN)
-				{
-					continue;
-				}
-				if (!(o->Flags & OBJECTIVE_POSKNOWN) && !tile->isVisited)
-				{
-					continue;
-				}
-				DrawCompassArrow(
-					g, r, Vec2iNew(ti->x, ti->y), playerPos, o->color, NULL);
-			CA_FOREACH_END()
+			return;
 		}
 	}
+	DrawCompassArrow(g, r, Vec2iNew(ti->x, ti->y), playerPos, o->color, NULL);
 }
 
 #define COMP_SATURATE_DIST 350
@@ -880,7 +962,7 @@ void HUDDraw(
 		flags = 0;
 	}
 	else if (
-		ConfigGetEnum(&gConfig, "Interface.Splitscreen") == SPLITSCREEN_NEVER)
+		ConfigHandleGetEnum(&configSplitscreen) == SPLITSCREEN_NEVER)
 	{
 		flags |= HUDFLAGS_SHARE_SCREEN;
 	}
@@ -932,7 +1014,7 @@ void HUDDraw(
 		DrawAmmoUpdate(&hud->ammoUpdates[idx], drawFlags);
 	}
 	// Only draw radar once if shared
-	if (ConfigGetBool(&gConfig, "Interface.ShowHUDMap") &&
+	if (ConfigHandleGetBool(&configShowHUDMap) &&
 		(flags & HUDFLAGS_SHARE_SCREEN) &&
 		IsAutoMapEnabled(gCampaign.Entry.Mode))
 	{
@@ -1037,14 +1119,25 @@ void HUDDraw(
 		FontStrMask(hud->message, pos, colorCyan);
 	}
 
-	if (ConfigGetBool(&gConfig, "Interface.ShowFPS"))
+	if (ConfigHandleGetBool(&configShowFPS))
 	{
 		FPSCounterDraw(&hud->fpsCounter);
 	}
-	if (ConfigGetBool(&gConfig, "Interface.ShowTime"))
+	if (ConfigHandleGetBool(&configShowTime))
 	{
 		WallClockDraw(&hud->clock);
 	}
+	if (ConfigHandleGetBool(&configShowNetStats))
+	{
+		if (gCampaign.IsClient)
+		{
+			NetStatsDraw(&gNetClient.Stats);
+		}
+		else if (gNetServer.server != NULL)
+		{
+			NetStatsDraw(&gNetServer.Stats);
+		}
+	}
 
 	DrawKeycards(hud);
 
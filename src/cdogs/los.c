@@ -32,60 +32,210 @@
 #include "game_events.h"
 #include "net_util.h"
 
+static ConfigHandle configSightRange = CONFIG_HANDLE("Game.SightRange");
 
+// Number of viewpoints to keep cached visibility for; enough for every
+// player plus the positions they have just left
+#define LOS_VIEWS_MAX 8
+
+
+static void ClearViews(LineOfSight *los);
 void LOSInit(Map *map, const Vec2i size)
 {
-	CArrayInit(&map->LOS.LOS, sizeof(bool));
-	CArrayInit(&map->LOS.Explored, sizeof(bool));
+	LineOfSight *los = &map->LOS;
+	CArrayInit(&los->LOS, sizeof(bool));
+	CArrayInit(&los->Explored, sizeof(bool));
 	Vec2i v;
 	for (v.y = 0; v.y < size.y; v.y++)
 	{
 		for (v.x = 0; v.x < size.x; v.x++)
 		{
 			const bool f = false;
-			CArrayPushBack(&map->LOS.LOS, &f);
-			CArrayPushBack(&map->LOS.Explored, &f);
+			CArrayPushBack(&los->LOS, &f);
+			CArrayPushBack(&los->Explored, &f);
 		}
 	}
+	los->size = size;
+	los->visibleMin = size;
+	los->visibleMax = Vec2iNew(-1, -1);
+	los->sightRange = ConfigHandleGetInt(&configSightRange);
+	CArrayInit(&los->views, sizeof(LOSView));
+	los->useCounter = 0;
+	CArrayInit(&los->mask, sizeof(bool));
 }
 void LOSTerminate(LineOfSight *los)
 {
 	CArrayTerminate(&los->LOS);
 	CArrayTerminate(&los->Explored);
+	CA_FOREACH(LOSView, v, los->views)
+		CArrayTerminate(&v->Visible);
+	CA_FOREACH_END()
+	CArrayTerminate(&los->views);
+	CArrayTerminate(&los->mask);
+}
+static void ClearViews(LineOfSight *los)
+{
+	CA_FOREACH(LOSView, v, los->views)
+		v->isDirty = true;
+	CA_FOREACH_END()
 }
 
 // Reset lines of sight by setting all cells to unseen
+// Only the area made visible since the last reset is cleared
 void LOSReset(LineOfSight *los)
 {
-	CArrayFillZero(&los->LOS);
-	CArrayFillZero(&los->Explored);
+	if (los->visibleMin.x <= los->visibleMax.x)
+	{
+		const int width = los->visibleMax.x - los->visibleMin.x + 1;
+		for (int y = los->visibleMin.y; y <= los->visibleMax.y; y++)
+		{
+			memset(
+				CArrayGet(&los->LOS, y * los->size.x + los->visibleMin.x),
+				0, width * sizeof(bool));
+		}
+	}
+	los->visibleMin = los->size;
+	los->visibleMax = Vec2iNew(-1, -1);
+
+	// Sight range can be changed by the server mid-game
+	const int sightRange = ConfigHandleGetInt(&configSightRange);
+	if (sightRange != los->sightRange)
+	{
+		los->sightRange = sightRange;
+		ClearViews(los);
+	}
 }
 void LOSSetAllVisible(LineOfSight *los)
 {
 	CA_FOREACH(bool, l, los->LOS)
 		*l = true;
 	CA_FOREACH_END()
+	los->visibleMin = Vec2iZero();
+	los->visibleMax = Vec2iNew(los->size.x - 1, los->size.y - 1);
+}
+
+void LOSUpdateTile(LineOfSight *los, const Vec2i tile)
+{
+	// Any view whose window includes this tile may see differently now
+	const int r = MAX(los->sightRange, 1);
+	CA_FOREACH(LOSView, v, los->views)
+		if (abs(tile.x - v->Pos.x) <= r && abs(tile.y - v->Pos.y) <= r)
+		{
+			v->isDirty = true;
+		}
+	CA_FOREACH_END()
+}
+
+static LOSView *GetView(Map *map, const Vec2i pos);
+static void MarkActorsVisible(const Tile *t);
+static void EnqueueExploreEvents(Map *map, const LOSView *v);
+void LOSCalcFrom(Map *map, const Vec2i pos, const bool explore)
+{
+	LineOfSight *los = &map->LOS;
+	const LOSView *v = GetView(map, pos);
+	if (v->Visible.size == 0) return;
+
+	bool anyExplored = false;
+	CA_FOREACH(const int, idx, v->Visible)
+		*((bool *)CArrayGet(&los->LOS, *idx)) = true;
+		const Tile *t = CArrayGet(&map->Tiles, *idx);
+		if (!t->isVisited && explore)
+		{
+			// Cache the newly explored tile
+			*((bool *)CArrayGet(&los->Explored, *idx)) = true;
+			anyExplored = true;
+		}
+		MarkActorsVisible(t);
+	CA_FOREACH_END()
+	los->visibleMin = Vec2iMin(los->visibleMin, v->Min);
+	los->visibleMax = Vec2iMax(los->visibleMax, v->Max);
+
+	if (anyExplored)
+	{
+		EnqueueExploreEvents(map, v);
+	}
+}
+static void ComputeView(Map *map, LOSView *v);
+static LOSView *GetView(Map *map, const Vec2i pos)
+{
+	LineOfSight *los = &map->LOS;
+	los->useCounter++;
+	LOSView *lru = NULL;
+	CA_FOREACH(LOSView, v, los->views)
+		if (Vec2iEqual(v->Pos, pos))
+		{
+			if (v->isDirty)
+			{
+				ComputeView(map, v);
+			}
+			v->lastUsed = los->useCounter;
+			return v;
+		}
+		if (lru == NULL || v->lastUsed < lru->lastUsed)
+		{
+			lru = v;
+		}
+	CA_FOREACH_END()
+	if (los->views.size < LOS_VIEWS_MAX)
+	{
+		LOSView v;
+		memset(&v, 0, sizeof v);
+		CArrayInit(&v.Visible, sizeof(int));
+		CArrayPushBack(&los->views, &v);
+		lru = CArrayGet(&los->views, (int)los->views.size - 1);
+	}
+	lru->Pos = pos;
+	ComputeView(map, lru);
+	lru->lastUsed = los->useCounter;
+	return lru;
+}
+static void MarkActorsVisible(const Tile *t)
+{
+	// Mark any actors on this tile as visible
+	// This affects some AI
+	CA_FOREACH(ThingId, tid, t->things)
+		const TTileItem *ti = ThingIdGetTileItem(tid);
+		if (ti->kind == KIND_CHARACTER)
+		{
+			TActor *a = CArrayGet(&gActors, ti->id);
+			a->flags |= FLAGS_VISIBLE;
+		}
+	CA_FOREACH_END()
 }
 
+// Window of tiles around a view center, used while computing visibility
 typedef struct
 {
 	Map *Map;
 	Vec2i Center;
 	int SightRange2;
-	bool Explore;
-} LOSData;
-// Calculate LOS cells from a certain start position
-// Sight range based on config
-static void SetLOSVisible(Map *map, const Vec2i pos, const bool explore);
+	Vec2i Origin;
+	int Size;
+	bool *Mask;
+} LOSWindow;
+static bool WindowIsVisible(const LOSWindow *w, const Vec2i pos);
+static void WindowSetVisible(LOSWindow *w, const Vec2i pos);
 static bool IsNextTileBlockedAndSetVisibility(void *data, Vec2i pos);
-static void SetObstructionVisible(
-	Map *map, const Vec2i pos, const bool explore);
-void LOSCalcFrom(Map *map, const Vec2i pos, const bool explore)
+static bool HasVisibleNonObstructionNeighbour(
+	const LOSWindow *w, const Vec2i pos);
+static void ComputeView(Map *map, LOSView *v)
 {
 	// Perform LOS by casting rays from the centre to the edges, terminating
 	// whenever an obstruction or out-of-range is reached.
-
-	CArrayFillZero(&map->LOS.Explored);
+	// Tiles are marked in a window centered on the view position
+	LineOfSight *los = &map->LOS;
+	LOSWindow w;
+	w.Map = map;
+	w.Center = v->Pos;
+	const int sightRange = los->sightRange;
+	w.SightRange2 = sightRange * sightRange;
+	const int r = MAX(sightRange, 1);
+	w.Origin = Vec2iNew(v->Pos.x - r, v->Pos.y - r);
+	w.Size = 2 * r + 1;
+	const bool f = false;
+	CArrayResize(&los->mask, w.Size * w.Size, &f);
+	CArrayFillZero(&los->mask);
+	w.Mask = los->mask.data;
 
 	// First mark center tile and all adjacent tiles as visible
 	// +-+-+-+
@@ -95,158 +245,169 @@ void LOSCalcFrom(Map *map, const Vec2i pos, const bool explore)
 	// +-+-+-+
 	// |V|V|V|  (C=center, V=visible)
 	// +-+-+-+
-	Vec2i end;
-	for (end.x = pos.x - 1; end.x <= pos.x + 1; end.x++)
+	Vec2i pos;
+	for (pos.y = v->Pos.y - 1; pos.y <= v->Pos.y + 1; pos.y++)
 	{
-		for (end.y = pos.y - 1; end.y <= pos.y + 1; end.y++)
+		for (pos.x = v->Pos.x - 1; pos.x <= v->Pos.x + 1; pos.x++)
 		{
-			SetLOSVisible(map, end, explore);
+			WindowSetVisible(&w, pos);
 		}
 	}
 
-	const int sightRange = ConfigGetInt(&gConfig, "Game.SightRange");
-	if (sightRange == 0) return;
-
-	// Limit the perimeter to the sight range
-	const Vec2i origin = Vec2iNew(pos.x - sightRange, pos.y - sightRange);
-	const Vec2i perimSize = Vec2iScale(Vec2iMinus(pos, origin), 2);
-
-	LOSData data;
-	data.Map = map;
-	data.Center = pos;
-	data.SightRange2 = sightRange * sightRange;
-	data.Explore = explore;
-
-	// Start from the top-left cell, and proceed clockwise around
-	end = origin;
-	HasClearLineData lineData;
-	lineData.IsBlocked = IsNextTileBlockedAndSetVisibility;
-	lineData.data = &data;
-	// Top edge
-	for (; end.x < origin.x + perimSize.x; end.x++)
-	{
-		HasClearLineXiaolinWu(pos, end, &lineData);
-	}
-	// right edge
-	for (; end.y < origin.y + perimSize.y; end.y++)
-	{
-		HasClearLineXiaolinWu(pos, end, &lineData);
-	}
-	// bottom edge
-	for (; end.x > origin.x; end.x--)
-	{
-		HasClearLineXiaolinWu(pos, end, &lineData);
-	}
-	// left edge
-	for (; end.y > origin.y; end.y--)
+	if (sightRange > 0)
 	{
-		HasClearLineXiaolinWu(pos, end, &lineData);
-	}
+		// Limit the perimeter to the sight range
+		const Vec2i origin = w.Origin;
+		const int perimSize = 2 * sightRange;
 
-	// Second pass: make any non-visible obstructions that are adjacent to
-	// visible non-obstructions visible too
-	// This is to ensure runs of walls stay visible
-	for (end.y = origin.y; end.y < origin.y + perimSize.y; end.y++)
-	{
-		for (end.x = origin.x; end.x < origin.x + perimSize.x; end.x++)
+		// Start from the top-left cell, and proceed clockwise around
+		Vec2i end = origin;
+		HasClearLineData lineData;
+		lineData.IsBlocked = IsNextTileBlockedAndSetVisibility;
+		lineData.data = &w;
+		// Top edge
+		for (; end.x < origin.x + perimSize; end.x++)
 		{
-			const Tile *tile = MapGetTile(map, end);
-			if (!tile || !(tile->flags & MAPTILE_NO_SEE))
-			{
-				continue;
-			}
-			// Check sight range
-			if (DistanceSquared(pos, end) >= data.SightRange2)
-			{
-				continue;
-			}
-			SetObstructionVisible(map, end, explore);
+			HasClearLineXiaolinWu(v->Pos, end, &lineData);
+		}
+		// right edge
+		for (; end.y < origin.y + perimSize; end.y++)
+		{
+			HasClearLineXiaolinWu(v->Pos, end, &lineData);
+		}
+		// bottom edge
+		for (; end.x > origin.x; end.x--)
+		{
+			HasClearLineXiaolinWu(v->Pos, end, &lineData);
+		}
+		// left edge
+		for (; end.y > origin.y; end.y--)
+		{
+			HasClearLineXiaolinWu(v->Pos, end, &lineData);
 		}
-	}
 
-	// Find all the newly visible tiles and set events for them
-	GameEvent e = GameEventNew(GAME_EVENT_EXPLORE_TILES);
-	e.u.ExploreTiles.Runs_count = 0;
-	e.u.ExploreTiles.Runs[0].Run = 0;
-	bool run = false;
-	for (end.y = 0; end.y < map->Size.y; end.y++)
-	{
-		for (end.x = 0; end.x < map->Size.x; end.x++)
+		// Second pass: make any non-visible obstructions that are adjacent
+		// to visible non-obstructions visible too
+		// This is to ensure runs of walls stay visible
+		for (pos.y = origin.y; pos.y < origin.y + perimSize; pos.y++)
 		{
-			if (LOSAddRun(
-				&e.u.ExploreTiles, &run, end,
-				*((bool *)CArrayGet(&map->LOS.Explored, end.y * map->Size.x + end.x))))
+			for (pos.x = origin.x; pos.x < origin.x + perimSize; pos.x++)
 			{
-				GameEventsEnqueue(&gGameEvents, e);
-				e.u.ExploreTiles.Runs_count = 0;
-				e.u.ExploreTiles.Runs[0].Run = 0;
-				run = false;
+				const Tile *t = MapGetTile(map, pos);
+				if (t == NULL || !(t->flags & MAPTILE_NO_SEE) ||
+					DistanceSquared(v->Pos, pos) >= w.SightRange2)
+				{
+					continue;
+				}
+				if (HasVisibleNonObstructionNeighbour(&w, pos))
+				{
+					WindowSetVisible(&w, pos);
+				}
 			}
 		}
 	}
-	if (e.u.ExploreTiles.Runs_count > 0)
+
+	// Collect the visible tiles and their bounds
+	CArrayClear(&v->Visible);
+	v->Min = map->Size;
+	v->Max = Vec2iNew(-1, -1);
+	for (pos.y = w.Origin.y; pos.y < w.Origin.y + w.Size; pos.y++)
 	{
-		GameEventsEnqueue(&gGameEvents, e);
+		for (pos.x = w.Origin.x; pos.x < w.Origin.x + w.Size; pos.x++)
+		{
+			if (!WindowIsVisible(&w, pos)) continue;
+			const int idx = pos.y * map->Size.x + pos.x;
+			CArrayPushBack(&v->Visible, &idx);
+			v->Min = Vec2iMin(v->Min, pos);
+			v->Max = Vec2iMax(v->Max, pos);
+		}
 	}
-	CArrayFillZero(&map->LOS.Explored);
+	v->isDirty = false;
 }
-static void SetLOSVisible(Map *map, const Vec2i pos, const bool explore)
+static bool WindowIsVisible(const LOSWindow *w, const Vec2i pos)
 {
-	const Tile *t = MapGetTile(map, pos);
-	if (t == NULL) return;
-	*((bool *)CArrayGet(&map->LOS.LOS, pos.y * map->Size.x + pos.x)) = true;
-	if (!t->isVisited && explore)
-	{
-		// Cache the newly explored tile
-		*((bool *)CArrayGet(&map->LOS.Explored, pos.y * map->Size.x + pos.x)) = true;
-	}
-	// Mark any actors on this tile as visible
-	// This affects some AI
-	CA_FOREACH(ThingId, tid, t->things)
-		const TTileItem *ti = ThingIdGetTileItem(tid);
-		if (ti->kind == KIND_CHARACTER)
-		{
-			TActor *a = CArrayGet(&gActors, ti->id);
-			a->flags |= FLAGS_VISIBLE;
-		}
-	CA_FOREACH_END()
+	const int x = pos.x - w->Origin.x;
+	const int y = pos.y - w->Origin.y;
+	if (x < 0 || x >= w->Size || y < 0 || y >= w->Size) return false;
+	return w->Mask[y * w->Size + x];
+}
+static void WindowSetVisible(LOSWindow *w, const Vec2i pos)
+{
+	// Only tiles inside the map can be seen
+	if (MapGetTile(w->Map, pos) == NULL) return;
+	w->Mask[(pos.y - w->Origin.y) * w->Size + pos.x - w->Origin.x] = true;
 }
 static bool IsNextTileBlockedAndSetVisibility(void *data, Vec2i pos)
 {
-	LOSData *lData = data;
+	LOSWindow *w = data;
 	// Check sight range
-	if (DistanceSquared(lData->Center, pos) >= lData->SightRange2) return true;
+	if (DistanceSquared(w->Center, pos) >= w->SightRange2) return true;
 	// Check map range
-	const Tile *t = MapGetTile(lData->Map, pos);
+	const Tile *t = MapGetTile(w->Map, pos);
 	if (t == NULL) return true;
-	SetLOSVisible(lData->Map, pos, lData->Explore);
+	WindowSetVisible(w, pos);
 	// Check if this tile is an obstruction
 	return t->flags & MAPTILE_NO_SEE;
 }
-static bool IsTileVisibleNonObstruction(Map *map, const Vec2i pos);
-static void SetObstructionVisible(
-	Map *map, const Vec2i pos, const bool explore)
+static bool IsTileVisibleNonObstruction(const LOSWindow *w, const Vec2i pos);
+static bool HasVisibleNonObstructionNeighbour(
+	const LOSWindow *w, const Vec2i pos)
 {
 	Vec2i d;
-	for (d.x = -1; d.x < 2; d.x++)
+	for (d.y = -1; d.y < 2; d.y++)
 	{
-		for (d.y = -1; d.y < 2; d.y++)
+		for (d.x = -1; d.x < 2; d.x++)
 		{
-			if (IsTileVisibleNonObstruction(map, Vec2iAdd(pos, d)))
+			if (IsTileVisibleNonObstruction(w, Vec2iAdd(pos, d)))
 			{
-				SetLOSVisible(map, pos, explore);
-				return;
+				return true;
 			}
 		}
 	}
+	return false;
 }
-static bool IsTileVisibleNonObstruction(Map *map, const Vec2i pos)
+static bool IsTileVisibleNonObstruction(const LOSWindow *w, const Vec2i pos)
 {
-	const Tile *t = MapGetTile(map, pos);
+	const Tile *t = MapGetTile(w->Map, pos);
 	if (t == NULL) return false;
-	return !(t->flags & MAPTILE_NO_SEE) && LOSTileIsVisible(map, pos);
+	return !(t->flags & MAPTILE_NO_SEE) && WindowIsVisible(w, pos);
 }
 
+static void EnqueueExploreEvents(Map *map, const LOSView *v)
+{
+	// Find all the newly visible tiles and set events for them
+	LineOfSight *los = &map->LOS;
+	GameEvent e = GameEventNew(GAME_EVENT_EXPLORE_TILES);
+	e.u.ExploreTiles.Runs_count = 0;
+	e.u.ExploreTiles.Runs[0].Run = 0;
+	bool run = false;
+	Vec2i end;
+	for (end.y = v->Min.y; end.y <= v->Max.y; end.y++)
+	{
+		// Scan one past the end of each row so that runs end there instead
+		// of wrapping onto the next row
+		for (end.x = v->Min.x; end.x <= v->Max.x + 1; end.x++)
+		{
+			const bool explored = end.x <= v->Max.x &&
+				*((bool *)CArrayGet(
+				&los->Explored, end.y * map->Size.x + end.x));
+			if (LOSAddRun(&e.u.ExploreTiles, &run, end, explored))
+			{
+				GameEventsEnqueue(&gGameEvents, e);
+				e.u.ExploreTiles.Runs_count = 0;
+				e.u.ExploreTiles.Runs[0].Run = 0;
+				run = false;
+			}
+		}
+	}
+	if (e.u.ExploreTiles.Runs_count > 0)
+	{
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	CA_FOREACH(const int, idx, v->Visible)
+		*((bool *)CArrayGet(&los->Explored, *idx)) = false;
+	CA_FOREACH_END()
+}
 bool LOSAddRun(
 	NExploreTiles *runs, bool *run, const Vec2i tile, const bool explored)
 {
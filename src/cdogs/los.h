@@ -37,6 +37,9 @@ void LOSTerminate(LineOfSight *los);
 void LOSReset(LineOfSight *los);
 void LOSSetAllVisible(LineOfSight *los);
 void LOSCalcFrom(Map *map, const Vec2i pos, const bool explore);
+// Mark cached views that could see the tile as needing recalculation
+// Call when the tile's MAPTILE_NO_SEE flag changes
+void LOSUpdateTile(LineOfSight *los, const Vec2i tile);
 
 // Helper function for populating explore tiles runs
 // Returns true if the runs have filled
@@ -54,9 +54,11 @@
 
 #include "algorithms.h"
 #include "ammo.h"
+#include "automap.h"
 #include "collision.h"
 #include "config.h"
 #include "door.h"
+#include "flow_field.h"
 #include "game_events.h"
 #include "gamedata.h"
 #include "los.h"
@@ -156,6 +158,13 @@ static Tile *MapGetTileOfItem(Map *map, TTileItem *t)
 	return MapGetTile(map, pos);
 }
 
+// Particles are only drawn, never collided with, so they are kept out of
+// the collision grid
+static bool TileItemCollides(const TTileItem *t)
+{
+	return t->kind != KIND_PARTICLE;
+}
+
 static void AddItemToTile(TTileItem *t, Tile *tile);
 bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 {
@@ -173,6 +182,10 @@ bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 	{
 		t->x = pos.x;
 		t->y = pos.y;
+		if (TileItemCollides(t))
+		{
+			CollisionGridUpdate(&map->Collision, t2, t);
+		}
 		return true;
 	}
 	// Moving; remove from old tile...
@@ -184,6 +197,10 @@ bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 	t->x = pos.x;
 	t->y = pos.y;
 	AddItemToTile(t, MapGetTile(map, t2));
+	if (TileItemCollides(t))
+	{
+		CollisionGridAdd(&map->Collision, t2, t);
+	}
 	return true;
 }
 static void AddItemToTile(TTileItem *t, Tile *tile)
@@ -208,6 +225,11 @@ void MapRemoveTileItem(Map *map, TTileItem *t)
 		return;
 	}
 	Tile *tile = MapGetTileOfItem(map, t);
+	if (TileItemCollides(t))
+	{
+		CollisionGridRemove(
+			&map->Collision, Vec2iToTile(Vec2iNew(t->x, t->y)), t);
+	}
 	CA_FOREACH(ThingId, tid, tile->things)
 		if (tid->Id == t->id && tid->Kind == t->kind)
 		{
@@ -218,6 +240,16 @@ void MapRemoveTileItem(Map *map, TTileItem *t)
 	CASSERT(false, "Did not find element to delete");
 }
 
+void MapUpdateTileItem(Map *map, const TTileItem *t)
+{
+	if (!MapIsRealPosIn(map, Vec2iNew(t->x, t->y)) || !TileItemCollides(t))
+	{
+		return;
+	}
+	CollisionGridUpdate(
+		&map->Collision, Vec2iToTile(Vec2iNew(t->x, t->y)), t);
+}
+
 static Vec2i GuessCoords(Map *map)
 {
 	return Vec2iNew(rand() % map->Size.x, rand() % map->Size.y);
@@ -663,7 +695,11 @@ void MapTerminate(Map *map)
 	CArrayTerminate(&map->Tiles);
 	CArrayTerminate(&map->iMap);
 	LOSTerminate(&map->LOS);
+	CollisionGridTerminate(&map->Collision);
+	FloorCacheTerminate(&map->Floor);
 	PathCacheTerminate(&gPathCache);
+	FlowFieldsTerminate(&gFlowFields);
+	AutomapCacheTerminate(&gAutomapCache);
 }
 void MapLoad(
 	Map *map, const struct MissionOptions *mo, const CampaignOptions *co)
@@ -677,8 +713,12 @@ void MapLoad(
 	const Mission *mission = mo->missionData;
 	map->Size = mission->Size;
 	LOSInit(map, map->Size);
+	CollisionGridInit(&map->Collision, map->Size);
+	FloorCacheInit(&map->Floor, map->Size);
 	CArrayInit(&map->triggers, sizeof(Trigger *));
 	PathCacheInit(&gPathCache, map);
+	FlowFieldsInit(&gFlowFields, map);
+	AutomapCacheInit(&gAutomapCache, map);
 
 	Vec2i v;
 	for (v.y = 0; v.y < map->Size.y; v.y++)
@@ -872,21 +912,18 @@ bool MapIsTileAreaClear(Map *map, const Vec2i fullPos, const Vec2i size)
 			{
 				continue;
 			}
-			const CArray *tileThings = &MapGetTile(map, dtv)->things;
-			if (tileThings == NULL)
+			const CArray *cell = CollisionGridGetCell(&map->Collision, dtv);
+			if (cell == NULL)
 			{
 				continue;
 			}
-			for (int i = 0; i < (int)tileThings->size; i++)
-			{
-				const TTileItem *ti =
-					ThingIdGetTileItem(CArrayGet(tileThings, i));
+			CA_FOREACH(const CollisionGridItem, gi, *cell)
 				if (AreasCollide(
-						realPos, Vec2iNew(ti->x, ti->y), size, ti->size))
+						realPos, Vec2iNew(gi->x, gi->y), size, gi->size))
 				{
 					return false;
 				}
-			}
+			CA_FOREACH_END()
 		}
 	}
 
@@ -901,6 +938,7 @@ void MapMarkAsVisited(Map *map, Vec2i pos)
 		map->tilesSeen++;
 	}
 	t->isVisited = true;
+	AutomapCacheUpdateTile(&gAutomapCache, map, pos);
 }
 
 void MapMarkAllAsVisited(Map *map)
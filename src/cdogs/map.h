@@ -51,6 +51,8 @@
 #include <stdbool.h>
 
 #include "campaigns.h"
+#include "collision_grid.h"
+#include "floor_cache.h"
 #include "map_object.h"
 #include "mission.h"
 #include "pic.h"
@@ -82,6 +84,17 @@ IMapType StrIMapType(const char *s);
 
 #define MAP_LEAVEFREE       4096
 
+// Cached set of tiles visible from one tile
+typedef struct
+{
+	Vec2i Pos;
+	CArray Visible;	// of int (tile index)
+	Vec2i Min;
+	Vec2i Max;
+	int lastUsed;
+	bool isDirty;
+} LOSView;
+
 typedef struct
 {
 	// Array of bools to set lines of sight
@@ -89,6 +102,17 @@ typedef struct
 
 	// Array of bools for tracking new tiles in line of sight, for delayed messaging
 	CArray Explored; // of bool
+
+	Vec2i size;
+	// Bounding box of tiles set in LOS since the last reset
+	Vec2i visibleMin;
+	Vec2i visibleMax;
+
+	int sightRange;
+	CArray views;	// of LOSView
+	int useCounter;
+	// Scratch visibility window used while casting
+	CArray mask;	// of bool
 } LineOfSight;
 
 typedef struct
@@ -100,6 +124,8 @@ typedef struct
 	CArray iMap;	// of unsigned short
 
 	LineOfSight LOS;
+	CollisionGrid Collision;
+	FloorCache Floor;
 
 	CArray triggers;	// of Trigger *; owner
 	int triggerId;
@@ -129,6 +155,8 @@ int MapGetDoorKeycardFlag(Map *map, Vec2i pos);
 // Return false if cannot move to new position
 bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos);
 void MapRemoveTileItem(Map *map, TTileItem *t);
+// Call when an item's collision properties (e.g. flags) change in place
+void MapUpdateTileItem(Map *map, const TTileItem *t);
 
 void MapTerminate(Map *map);
 void MapLoad(
@@ -32,6 +32,7 @@
 
 #include "ammo.h"
 #include "character_class.h"
+#include "file_map.h"
 #include "files.h"
 #include "json_utils.h"
 #include "log.h"
@@ -39,8 +40,6 @@
 #include "pickup.h"
 
 
-static char *ReadFileIntoBuf(const char *path, const char *mode, long *len);
-
 static json_t *ReadArchiveJSON(const char *archive, const char *filename);
 int MapNewScanArchive(
 	const char *filename, char **title, int *numMissions)
@@ -63,6 +62,18 @@ bail:
 	return err;
 }
 
+// Times each stage of loading an archive, to find what makes large
+// campaigns slow to open
+typedef struct
+{
+	const char *archive;
+	Uint64 start;
+	Uint64 stageStart;
+} LoadTimer;
+static void LoadTimerInit(LoadTimer *t, const char *archive);
+static void LoadTimerStage(LoadTimer *t, const char *stage);
+static void LoadTimerEnd(const LoadTimer *t);
+
 static void LoadArchiveSounds(
 	SoundDevice *device, const char *archive, const char *dirname);
 static void LoadArchivePics(
@@ -71,6 +82,8 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 {
 	LOG(LM_MAP, LL_DEBUG, "Loading archive map %s", filename);
 	int err = 0;
+	LoadTimer timer;
+	LoadTimerInit(&timer, filename);
 	json_t *root = ReadArchiveJSON(filename, "campaign.json");
 	if (root == NULL)
 	{
@@ -86,17 +99,23 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	}
 	MapNewLoadCampaignJSON(root, c);
 	json_free_value(&root);
+	LoadTimerStage(&timer, "campaign");
 
 	// Load any custom data
 	LoadArchiveSounds(&gSoundDevice, filename, "sounds");
+	AssetRegistryIndex(&gSoundDevice.registry);
+	LoadTimerStage(&timer, "sounds");
 
 	LoadArchivePics(&gPicManager, filename, "graphics");
+	LoadTimerStage(&timer, "graphics");
 
 	root = ReadArchiveJSON(filename, "particles.json");
 	if (root != NULL)
 	{
 		ParticleClassesLoadJSON(&gParticleClasses.CustomClasses, root);
+		AssetRegistryIndex(&gParticleClasses.registry);
 	}
+	LoadTimerStage(&timer, "particles");
 
 	root = ReadArchiveJSON(filename, "character_classes.json");
 	if (root != NULL)
@@ -104,6 +123,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 		CharacterClassesLoadJSON(
 			&gCharacterClasses.CustomClasses, root);
 	}
+	LoadTimerStage(&timer, "character classes");
 
 	root = ReadArchiveJSON(filename, "bullets.json");
 	if (root != NULL)
@@ -111,6 +131,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 		BulletLoadJSON(
 			&gBulletClasses, &gBulletClasses.CustomClasses, root);
 	}
+	LoadTimerStage(&timer, "bullets");
 
 	root = ReadArchiveJSON(filename, "ammo.json");
 	if (root != NULL)
@@ -118,6 +139,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 		AmmoLoadJSON(&gAmmo.CustomAmmo, root);
 		json_free_value(&root);
 	}
+	LoadTimerStage(&timer, "ammo");
 
 	root = ReadArchiveJSON(filename, "guns.json");
 	if (root != NULL)
@@ -128,6 +150,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	}
 
 	BulletLoadWeapons(&gBulletClasses);
+	LoadTimerStage(&timer, "guns");
 
 	root = ReadArchiveJSON(filename, "pickups.json");
 	if (root != NULL)
@@ -137,6 +160,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	PickupClassesLoadAmmo(&gPickupClasses.CustomClasses, &gAmmo.CustomAmmo);
 	PickupClassesLoadGuns(
 		&gPickupClasses.CustomClasses, &gGunDescriptions.CustomGuns);
+	LoadTimerStage(&timer, "pickups");
 
 	root = ReadArchiveJSON(filename, "map_objects.json");
 	if (root != NULL)
@@ -145,6 +169,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	}
 	MapObjectsLoadAmmoAndGunSpawners(
 		&gMapObjects, &gAmmo, &gGunDescriptions, true);
+	LoadTimerStage(&timer, "map objects");
 
 
 	root = ReadArchiveJSON(filename, "missions.json");
@@ -156,6 +181,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	LoadMissions(
 		&c->Missions, json_find_first_label(root, "Missions")->child, version);
 	json_free_value(&root);
+	LoadTimerStage(&timer, "missions");
 
 	// Note: some campaigns don't have characters (e.g. dogfights)
 	root = ReadArchiveJSON(filename, "characters.json");
@@ -165,40 +191,62 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 			&c->characters, json_find_first_label(root, "Characters")->child,
 			version);
 	}
+	LoadTimerStage(&timer, "characters");
+	LoadTimerEnd(&timer);
 
 bail:
 	json_free_value(&root);
 	return err;
 }
 
+static double CounterMs(const Uint64 counter)
+{
+	return counter * 1000.0 / SDL_GetPerformanceFrequency();
+}
+static void LoadTimerInit(LoadTimer *t, const char *archive)
+{
+	t->archive = archive;
+	t->start = t->stageStart = SDL_GetPerformanceCounter();
+}
+static void LoadTimerStage(LoadTimer *t, const char *stage)
+{
+	const Uint64 now = SDL_GetPerformanceCounter();
+	LOG(LM_MAP, LL_DEBUG, "loaded %s in %.2fms",
+		stage, CounterMs(now - t->stageStart));
+	t->stageStart = now;
+}
+static void LoadTimerEnd(const LoadTimer *t)
+{
+	LOG(LM_MAP, LL_INFO, "loaded archive %s in %.2fms",
+		t->archive, CounterMs(SDL_GetPerformanceCounter() - t->start));
+}
+
 static json_t *ReadArchiveJSON(const char *archive, const char *filename)
 {
 	json_t *root = NULL;
 	debug(D_VERBOSE, "Loading archive json %s %s\n", archive, filename);
 	char path[CDOGS_PATH_MAX];
 	sprintf(path, "%s/%s", archive, filename);
-	long len;
-	char *buf = ReadFileIntoBuf(path, "rb", &len);
-	if (buf == NULL) goto bail;
-	const enum json_error e = json_parse_document(&root, buf);
+	// Parse straight from the mapped file, without copying it first
+	FileMap m;
+	if (!FileMapOpen(&m, path))
+	{
+		return NULL;
+	}
+	const enum json_error e = json_parse_document(&root, m.Data);
 	if (e != JSON_OK)
 	{
 		LOG(LM_MAP, LL_ERROR, "Invalid syntax in JSON file (%s) error(%d)",
 			filename, (int)e);
 		root = NULL;
-		goto bail;
 	}
-
-bail:
-	CFREE(buf);
+	FileMapClose(&m);
 	return root;
 }
 
 static void LoadArchiveSounds(
 	SoundDevice *device, const char *archive, const char *dirname)
 {
-	char *buf = NULL;
-
 	char path[CDOGS_PATH_MAX];
 	sprintf(path, "%s/%s", archive, dirname);
 	tinydir_dir dir;
@@ -212,10 +260,9 @@ static void LoadArchiveSounds(
 		tinydir_file file;
 		tinydir_readfile(&dir, &file);
 		if (!file.is_reg) goto nextFile;
-		long len;
-		buf = ReadFileIntoBuf(file.path, "rb", &len);
-		if (buf == NULL) goto nextFile;
-		SDL_RWops *rwops = SDL_RWFromMem(buf, len);
+		FileMap m;
+		if (!FileMapOpen(&m, file.path)) goto nextFile;
+		SDL_RWops *rwops = SDL_RWFromConstMem(m.Data, (int)m.Len);
 		Mix_Chunk *data = Mix_LoadWAV_RW(rwops, 0);
 		if (data != NULL)
 		{
@@ -230,9 +277,8 @@ static void LoadArchiveSounds(
 			SoundAdd(&device->customSounds, nameBuf, data);
 		}
 		rwops->close(rwops);
+		FileMapClose(&m);
 	nextFile:
-		CFREE(buf);
-		buf = NULL;
 		if (tinydir_next(&dir) != 0)
 		{
 			printf(
@@ -243,14 +289,11 @@ static void LoadArchiveSounds(
 	}
 
 bail:
-	CFREE(buf);
 	tinydir_close(&dir);
 }
 static void LoadArchivePics(
 	PicManager *pm, const char *archive, const char *dirname)
 {
-	char *buf = NULL;
-
 	char path[CDOGS_PATH_MAX];
 	sprintf(path, "%s/%s", archive, dirname);
 	tinydir_dir dir;
@@ -268,10 +311,9 @@ static void LoadArchivePics(
 			break;
 		}
 		if (!file.is_reg) goto nextFile;
-		long len;
-		buf = ReadFileIntoBuf(file.path, "rb", &len);
-		if (buf == NULL) goto nextFile;
-		SDL_RWops *rwops = SDL_RWFromMem(buf, len);
+		FileMap m;
+		if (!FileMapOpen(&m, file.path)) goto nextFile;
+		SDL_RWops *rwops = SDL_RWFromConstMem(m.Data, (int)m.Len);
 		bool isPng = IMG_isPNG(rwops);
 		if (isPng)
 		{
@@ -284,9 +326,8 @@ static void LoadArchivePics(
 			}
 		}
 		rwops->close(rwops);
+		FileMapClose(&m);
 	nextFile:
-		CFREE(buf);
-		buf = NULL;
 		if (tinydir_next(&dir) != 0)
 		{
 			printf(
@@ -297,59 +338,10 @@ static void LoadArchivePics(
 	}
 
 bail:
-	CFREE(buf);
 	tinydir_close(&dir);
+	PicManagerPack(pm);
 }
 
-static char *ReadFileIntoBuf(const char *path, const char *mode, long *len)
-{
-	char *buf = NULL;
-	FILE *f = fopen(path, mode);
-	if (f == NULL)
-	{
-		debug(D_NORMAL, "Did not open file %s: %s.\n", path, strerror(errno));
-		goto bail;
-	}
-
-	// Read into buffer
-	if (fseek(f, 0L, SEEK_END) != 0)
-	{
-		debug(D_NORMAL, "Cannot seek file %s: %s.\n", path, strerror(errno));
-		goto bail;
-	}
-	*len = ftell(f);
-	if (*len == -1)
-	{
-		debug(D_NORMAL, "Cannot tell file %s: %s.\n", path, strerror(errno));
-		goto bail;
-	}
-	CCALLOC(buf, *len + 1);
-	if (fseek(f, 0L, SEEK_SET) != 0)
-	{
-		debug(D_NORMAL, "Cannot seek file %s: %s.\n", path, strerror(errno));
-		goto bail;
-	}
-	if (fread(buf, 1, *len, f) == 0)
-	{
-		debug(D_NORMAL, "Cannot read file %s: %s.\n", path, strerror(errno));
-		goto bail;
-	}
-
-	goto end;
-
-bail:
-	CFREE(buf);
-	buf = NULL;
-
-end:
-	if (f != NULL && fclose(f) != 0)
-	{
-		debug(D_NORMAL, "Cannot close file %s: %s.\n", path, strerror(errno));
-	}
-	return buf;
-}
-
-
 static json_t *SaveMissions(CArray *a);
 static json_t *SaveCharacters(CharacterStore *s);
 bool TrySaveJSONFile(json_t *node, const char *filename);
@@ -0,0 +1,196 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "net_batch.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "utils.h"
+
+
+// Where a queued message lives in the batch's data
+typedef struct
+{
+	// GAME_EVENT_NONE if superseded
+	GameEventType Type;
+	int UID;
+	size_t Offset;
+	size_t Len;
+} NetBatchMsg;
+
+
+void NetBatchInit(NetBatch *b)
+{
+	CArrayInit(&b->data, sizeof(uint8_t));
+	CArrayInit(&b->msgs, sizeof(NetBatchMsg));
+}
+void NetBatchTerminate(NetBatch *b)
+{
+	CArrayTerminate(&b->data);
+	CArrayTerminate(&b->msgs);
+}
+void NetBatchClear(NetBatch *b)
+{
+	CArrayClear(&b->data);
+	CArrayClear(&b->msgs);
+}
+
+void NetBatchAdd(
+	NetBatch *b, const GameEventType e, const int supersedeUID,
+	const void *data, const size_t len)
+{
+	CASSERT(len <= UINT16_MAX, "net message too big");
+	if (supersedeUID >= 0)
+	{
+		// There is at most one live message per type and UID
+		for (int i = (int)b->msgs.size - 1; i >= 0; i--)
+		{
+			NetBatchMsg *m = CArrayGet(&b->msgs, i);
+			if (m->Type == e && m->UID == supersedeUID)
+			{
+				m->Type = GAME_EVENT_NONE;
+				break;
+			}
+		}
+	}
+
+	NetBatchMsg m;
+	m.Type = e;
+	m.UID = supersedeUID;
+	m.Offset = b->data.size;
+	m.Len = len;
+	CArrayPushBack(&b->msgs, &m);
+	if (len == 0)
+	{
+		return;
+	}
+	if (b->data.size + len > b->data.capacity)
+	{
+		CArrayReserve(&b->data, MAX(b->data.capacity * 2, b->data.size + len));
+	}
+	CArrayResize(&b->data, b->data.size + len, NULL);
+	memcpy(CArrayGet(&b->data, (int)m.Offset), data, len);
+}
+
+void NetBatchCount(const NetBatch *b, NetStats *s, NetTraffic *t)
+{
+	CA_FOREACH(const NetBatchMsg, m, b->msgs)
+		if (m->Type == GAME_EVENT_NONE) continue;
+		NetStatsSent(s, (int)m->Type, m->Len);
+		if (t != NULL) NetCounterAdd(&t->Sent, m->Len);
+	CA_FOREACH_END()
+}
+
+static size_t WriteMsg(uint8_t *dst, const NetBatch *b, const NetBatchMsg *m);
+int NetBatchSend(NetBatch *b, ENetPeer *peer, const enet_uint8 channelID)
+{
+	int packets = 0;
+	int start = 0;
+	while (start < (int)b->msgs.size)
+	{
+		// Take as many messages as fit, but at least one
+		size_t size = 0;
+		int end;
+		for (end = start; end < (int)b->msgs.size; end++)
+		{
+			const NetBatchMsg *m = CArrayGet(&b->msgs, end);
+			if (m->Type == GAME_EVENT_NONE) continue;
+			const size_t msgSize = NET_BATCH_MSG_HEADER_SIZE + m->Len;
+			if (size > 0 && size + msgSize > NET_BATCH_PACKET_SIZE) break;
+			size += msgSize;
+		}
+		if (size == 0)
+		{
+			// Only superseded messages were left
+			break;
+		}
+
+		ENetPacket *packet =
+			enet_packet_create(NULL, size, ENET_PACKET_FLAG_RELIABLE);
+		uint8_t *dst = packet->data;
+		for (int i = start; i < end; i++)
+		{
+			const NetBatchMsg *m = CArrayGet(&b->msgs, i);
+			if (m->Type == GAME_EVENT_NONE) continue;
+			dst += WriteMsg(dst, b, m);
+		}
+		if (enet_peer_send(peer, channelID, packet) == 0)
+		{
+			packets++;
+		}
+		else
+		{
+			LOG(LM_NET, LL_ERROR, "failed to send packet");
+			enet_packet_destroy(packet);
+		}
+		start = end;
+	}
+	NetBatchClear(b);
+	return packets;
+}
+static size_t WriteMsg(uint8_t *dst, const NetBatch *b, const NetBatchMsg *m)
+{
+	dst[0] = (uint8_t)(m->Type & 0xff);
+	dst[1] = (uint8_t)(m->Type >> 8);
+	dst[2] = (uint8_t)(m->Len & 0xff);
+	dst[3] = (uint8_t)(m->Len >> 8);
+	if (m->Len > 0)
+	{
+		memcpy(
+			dst + NET_BATCH_MSG_HEADER_SIZE,
+			CArrayGet(&b->data, (int)m->Offset), m->Len);
+	}
+	return NET_BATCH_MSG_HEADER_SIZE + m->Len;
+}
+
+bool NetBatchRead(const ENetPacket *packet, size_t *offset, NetMsg *msg)
+{
+	if (*offset + NET_BATCH_MSG_HEADER_SIZE > packet->dataLength)
+	{
+		if (*offset != packet->dataLength)
+		{
+			LOG(LM_NET, LL_ERROR, "truncated message header at %d/%d",
+				(int)*offset, (int)packet->dataLength);
+		}
+		return false;
+	}
+	uint8_t *src = packet->data + *offset;
+	msg->Type = (GameEventType)(src[0] | (src[1] << 8));
+	msg->Len = (size_t)(src[2] | (src[3] << 8));
+	msg->Data = src + NET_BATCH_MSG_HEADER_SIZE;
+	if (*offset + NET_BATCH_MSG_HEADER_SIZE + msg->Len > packet->dataLength)
+	{
+		LOG(LM_NET, LL_ERROR, "truncated message(%d) len(%d) at %d/%d",
+			(int)msg->Type, (int)msg->Len,
+			(int)*offset, (int)packet->dataLength);
+		return false;
+	}
+	*offset += NET_BATCH_MSG_HEADER_SIZE + msg->Len;
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <enet/enet.h>
+
+#include "c_array.h"
+#include "game_events.h"
+#include "net_stats.h"
+
+// Messages in a batch packet are framed by a 2-byte type and 2-byte length,
+// both little endian, followed by the encoded message
+#define NET_BATCH_MSG_HEADER_SIZE 4
+// Batches are split into packets no bigger than this, so that each packet
+// fits in one datagram at ENet's default MTU
+#define NET_BATCH_PACKET_SIZE 1200
+
+// An encoded message read from a batch packet
+typedef struct
+{
+	GameEventType Type;
+	uint8_t *Data;
+	size_t Len;
+} NetMsg;
+
+// Messages queued for one peer during a tick; sent together on flush
+typedef struct
+{
+	CArray data;	// of uint8_t; encoded messages
+	CArray msgs;	// of NetBatchMsg
+} NetBatch;
+
+void NetBatchInit(NetBatch *b);
+void NetBatchTerminate(NetBatch *b);
+void NetBatchClear(NetBatch *b);
+
+// Queue an encoded message
+// If supersedeUID is not negative, an earlier queued message with the same
+// type and UID is dropped, since this one replaces it
+void NetBatchAdd(
+	NetBatch *b, const GameEventType e, const int supersedeUID,
+	const void *data, const size_t len);
+// Count the queued messages that will be sent, in the stats and, if not
+// NULL, the peer's traffic
+void NetBatchCount(const NetBatch *b, NetStats *s, NetTraffic *t);
+// Pack the queued messages into reliable packets, send them and clear the
+// batch; returns the number of packets sent
+int NetBatchSend(NetBatch *b, ENetPeer *peer, const enet_uint8 channelID);
+
+// Read the next message of a batch packet, starting from *offset
+// Returns false at the end of the packet, or if the packet is malformed
+bool NetBatchRead(const ENetPacket *packet, size_t *offset, NetMsg *msg);
@@ -30,6 +30,8 @@
 
 #include <string.h>
 
+#include <SDL_timer.h>
+
 #include "proto/nanopb/pb_decode.h"
 #include "actors.h"
 #include "campaigns.h"
@@ -43,6 +45,8 @@
 
 NetClient gNetClient;
 
+static ConfigHandle configNetStatsLog = CONFIG_HANDLE("Interface.NetStatsLog");
+
 
 #define CONNECTION_WAIT_MS 5000
 #define FIND_CONNECTION_WAIT_SECONDS 1
@@ -54,15 +58,22 @@ void NetClientInit(NetClient *n)
 	memset(n, 0, sizeof *n);
 	n->ClientId = -1;	// -1 is unset
 	n->scanner = ENET_SOCKET_NULL;
-	n->client = enet_host_create(NULL, 1, 2,
-		57600 / 8 /* 56K modem with 56 Kbps downstream bandwidth */,
-		14400 / 8 /* 56K modem with 14 Kbps upstream bandwidth */);
+	n->client = enet_host_create(
+		NULL, 1, NET_HOST_CHANNELS,
+		NET_HOST_BANDWIDTH_IN, NET_HOST_BANDWIDTH_OUT);
 	if (n->client == NULL)
 	{
 		LOG(LM_NET, LL_ERROR, "cannot create ENet client host");
 	}
 	CArrayInit(&n->ScannedAddrs, sizeof(ScanInfo));
 	CArrayInit(&n->scannedAddrBuf, sizeof(ScanInfo));
+	NetBatchInit(&n->batch);
+	NetSnapshotHistoryInit(&n->snapshots);
+	NetSnapshotInit(&n->snapshotApplied);
+	NetSnapshotInit(&n->snapshotNext);
+	NetSnapshotInit(&n->snapshotInterp);
+	CArrayInit(&n->snapshotBuf, sizeof(uint8_t));
+	NetStatsInit(&n->Stats);
 }
 void NetClientTerminate(NetClient *n)
 {
@@ -81,6 +92,13 @@ void NetClientTerminate(NetClient *n)
 	}
 	CArrayTerminate(&n->ScannedAddrs);
 	CArrayTerminate(&n->scannedAddrBuf);
+	NetBatchTerminate(&n->batch);
+	NetSnapshotHistoryTerminate(&n->snapshots);
+	NetSnapshotTerminate(&n->snapshotApplied);
+	NetSnapshotTerminate(&n->snapshotNext);
+	NetSnapshotTerminate(&n->snapshotInterp);
+	CArrayTerminate(&n->snapshotBuf);
+	NetStatsTerminate(&n->Stats);
 }
 
 static bool TryScanHost(NetClient *n, const enet_uint32 host);
@@ -157,7 +175,7 @@ bool NetClientTryConnect(NetClient *n, const ENetAddress addr)
 	LOG(LM_NET, LL_INFO, "Connecting client to %s:%u...", buf, addr.port);
 
 	/* Initiate the connection, allocating the two channels 0 and 1. */
-	n->peer = enet_host_connect(n->client, &addr, 2, 0);
+	n->peer = enet_host_connect(n->client, &addr, NET_HOST_CHANNELS, 0);
 	if (n->peer == NULL)
 	{
 		LOG(LM_NET, LL_WARN, "No server connection found");
@@ -185,6 +203,7 @@ bool NetClientTryConnect(NetClient *n, const ENetAddress addr)
 
 	// Tell the server that this is a proper connection request
 	NetClientSendMsg(n, GAME_EVENT_CLIENT_CONNECT, NULL);
+	NetClientFlush(n);
 
 	return NetClientIsConnected(n);
 
@@ -271,13 +290,23 @@ void NetClientDisconnect(NetClient *n)
 	n->ClientId = -1;
 	n->FirstPlayerUID = 0;
 	n->Ready = false;
+	// Drop messages and snapshots of the old connection
+	NetBatchClear(&n->batch);
+	NetSnapshotHistoryReset(&n->snapshots);
+	CArrayClear(&n->snapshotApplied.Actors);
+	n->snapshotShown = 0;
+	n->snapshotAck = 0;
+	n->snapshotAckPending = false;
+	NetStatsReset(&n->Stats);
 	// Also reset the scanned address buffer
 	CArrayClear(&n->ScannedAddrs);
 	CArrayClear(&n->scannedAddrBuf);
 }
 
 static void OnReceive(NetClient *n, ENetEvent event);
+static void OnSnapshot(NetClient *n, ENetPacket *packet);
 static void Scanning(NetClient *n);
+static void UpdateStats(NetClient *n);
 void NetClientPoll(NetClient *n)
 {
 	// Check to see if LAN servers have been scanned
@@ -305,7 +334,14 @@ void NetClientPoll(NetClient *n)
 			switch (event.type)
 			{
 			case ENET_EVENT_TYPE_RECEIVE:
-				OnReceive(n, event);
+				if (event.channelID == NET_SNAPSHOT_CHANNEL)
+				{
+					OnSnapshot(n, event.packet);
+				}
+				else
+				{
+					OnReceive(n, event);
+				}
 				break;
 			case ENET_EVENT_TYPE_DISCONNECT:
 				LOG(LM_NET, LL_INFO, "disconnected");
@@ -317,6 +353,17 @@ void NetClientPoll(NetClient *n)
 			}
 		}
 	} while (check > 0);
+
+	UpdateStats(n);
+}
+static void UpdateStats(NetClient *n)
+{
+	CArrayClear(&n->Stats.Peers);
+	const NetPeerStats ps = NetPeerStatsNew(n->peer, 0, n->Stats.Total);
+	CArrayPushBack(&n->Stats.Peers, &ps);
+	NetStatsUpdate(
+		&n->Stats, "client", SDL_GetTicks(),
+		(NetStatsLog)ConfigHandleGetEnum(&configNetStatsLog));
 }
 static void Scanning(NetClient *n)
 {
@@ -369,11 +416,135 @@ static void Scanning(NetClient *n)
 		}
 	}
 }
+static void ApplySnapshot(NetClient *n, const NetSnapshot *s);
+static void OnSnapshot(NetClient *n, ENetPacket *packet)
+{
+	// Until the game starts, there are no actors to apply snapshots to
+	if (!gMission.HasStarted)
+	{
+		enet_packet_destroy(packet);
+		return;
+	}
+	NetStatsRecv(&n->Stats, NET_STATS_SNAPSHOT, packet->dataLength);
+	const NetSnapshot *s = NetSnapshotDecode(
+		&n->snapshots, packet->data, packet->dataLength);
+	enet_packet_destroy(packet);
+	if (s == NULL)
+	{
+		LOG(LM_NET, LL_DEBUG, "cannot decode snapshot");
+		return;
+	}
+	n->snapshotAck = s->Seq;
+	n->snapshotAckPending = true;
+}
+void NetClientApplySnapshot(NetClient *n)
+{
+	const uint32_t seq = NetSnapshotNextShown(n->snapshotShown, n->snapshotAck);
+	if (seq == 0)
+	{
+		return;
+	}
+	n->snapshotShown = seq;
+	const NetSnapshot *s = NetSnapshotHistoryGet(&n->snapshots, seq);
+	if (s != NULL)
+	{
+		ApplySnapshot(n, s);
+		return;
+	}
+
+	// The snapshot was lost; interpolate between the ones around it
+	const NetSnapshot *before = NULL;
+	for (uint32_t i = 1; i < NET_SNAPSHOT_HISTORY && i < seq; i++)
+	{
+		before = NetSnapshotHistoryGet(&n->snapshots, seq - i);
+		if (before != NULL) break;
+	}
+	const NetSnapshot *after = NULL;
+	for (uint32_t i = seq + 1; i <= n->snapshotAck; i++)
+	{
+		after = NetSnapshotHistoryGet(&n->snapshots, i);
+		if (after != NULL) break;
+	}
+	if (before != NULL && after != NULL)
+	{
+		NetSnapshotInterpolate(&n->snapshotInterp, before, after, seq);
+		ApplySnapshot(n, &n->snapshotInterp);
+	}
+	else if (after != NULL)
+	{
+		ApplySnapshot(n, after);
+	}
+}
+static void ApplySnapshot(NetClient *n, const NetSnapshot *s)
+{
+	// Turn changes since the last applied snapshot into game events, so
+	// that state the client changes by itself, like gun recoil, is only
+	// overridden when the server's state changes
+	CArrayClear(&n->snapshotNext.Actors);
+	CA_FOREACH(const NetActorSnapshot, as, s->Actors)
+		const TActor *a = ActorGetByUID(as->UID);
+		// Actors may not have been added yet; local players are our own
+		if (a == NULL || !a->isInUse || ActorIsLocalPlayer(as->UID))
+		{
+			continue;
+		}
+		const NetActorSnapshot *prev =
+			NetSnapshotFindActor(&n->snapshotApplied, as->UID);
+		if (prev == NULL ||
+			!Vec2iEqual(prev->Pos, as->Pos) ||
+			!Vec2iEqual(prev->MoveVel, as->MoveVel))
+		{
+			GameEvent e = GameEventNew(GAME_EVENT_ACTOR_MOVE);
+			e.u.ActorMove.UID = as->UID;
+			e.u.ActorMove.Pos = Vec2i2Net(as->Pos);
+			e.u.ActorMove.MoveVel = Vec2i2Net(as->MoveVel);
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		if (prev == NULL || prev->Dir != as->Dir)
+		{
+			GameEvent e = GameEventNew(GAME_EVENT_ACTOR_DIR);
+			e.u.ActorDir.UID = as->UID;
+			e.u.ActorDir.Dir = as->Dir;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		if (prev == NULL || prev->State != as->State)
+		{
+			GameEvent e = GameEventNew(GAME_EVENT_ACTOR_STATE);
+			e.u.ActorState.UID = as->UID;
+			e.u.ActorState.State = as->State;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		if ((prev == NULL || prev->GunState != as->GunState) &&
+			a->guns.size > 0)
+		{
+			GameEvent e = GameEventNew(GAME_EVENT_GUN_STATE);
+			e.u.GunState.ActorUID = as->UID;
+			e.u.GunState.State = as->GunState;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		CArrayPushBack(&n->snapshotNext.Actors, as);
+	CA_FOREACH_END()
+	const NetSnapshot temp = n->snapshotApplied;
+	n->snapshotApplied = n->snapshotNext;
+	n->snapshotNext = temp;
+}
+static void OnReceiveMsg(NetClient *n, const NetMsg *msg);
 static void OnReceive(NetClient *n, ENetEvent event)
 {
-	const GameEventType msg = (GameEventType)*(uint32_t *)event.packet->data;
-	LOG(LM_NET, LL_TRACE, "recv msg(%u)", msg);
-	const GameEventEntry gee = GameEventGetEntry(msg);
+	// Each packet is a batch of messages
+	size_t offset = 0;
+	NetMsg msg;
+	while (NetBatchRead(event.packet, &offset, &msg))
+	{
+		NetStatsRecv(&n->Stats, (int)msg.Type, msg.Len);
+		OnReceiveMsg(n, &msg);
+	}
+	enet_packet_destroy(event.packet);
+}
+static void OnReceiveMsg(NetClient *n, const NetMsg *msg)
+{
+	LOG(LM_NET, LL_TRACE, "recv msg(%u)", msg->Type);
+	const GameEventEntry gee = GameEventGetEntry(msg->Type);
 	if (gee.Enqueue)
 	{
 		if (gee.GameStart && !gMission.HasStarted)
@@ -388,7 +559,7 @@ static void OnReceive(NetClient *n, ENetEvent event)
 			GameEvent e = GameEventNew(gee.Type);
 			if (gee.Fields != NULL)
 			{
-				NetDecode(event.packet, &e.u, gee.Fields);
+				NetDecode(msg, &e.u, gee.Fields);
 			}
 
 			// For actor events, check if UID is not for local player
@@ -444,7 +615,7 @@ static void OnReceive(NetClient *n, ENetEvent event)
 					n->ClientId == -1,
 					"unexpected client ID message, already set");
 				NClientId cid;
-				NetDecode(event.packet, &cid, NClientId_fields);
+				NetDecode(msg, &cid, NClientId_fields);
 				LOG(LM_NET, LL_DEBUG, "recv clientId(%u) uid(%u)",
 					cid.Id, cid.FirstPlayerUID);
 				n->ClientId = (int)cid.Id;
@@ -460,7 +631,7 @@ static void OnReceive(NetClient *n, ENetEvent event)
 			{
 				LOG(LM_NET, LL_DEBUG, "NetClient: received campaign def, loading...");
 				NCampaignDef def;
-				NetDecode(event.packet, &def, NCampaignDef_fields);
+				NetDecode(msg, &def, NCampaignDef_fields);
 				gCampaign.Entry.Mode = (GameMode)def.GameMode;
 				// Normalise the path
 				char buf[CDOGS_PATH_MAX];
@@ -487,6 +658,9 @@ static void OnReceive(NetClient *n, ENetEvent event)
 			if (n->Ready)
 			{
 				gMission.HasStarted = true;
+				// Actor UIDs restart each mission; don't diff the new
+				// mission's actors against the old one's
+				CArrayClear(&n->snapshotApplied.Actors);
 			}
 			break;
 		default:
@@ -494,12 +668,32 @@ static void OnReceive(NetClient *n, ENetEvent event)
 			break;
 		}
 	}
-	enet_packet_destroy(event.packet);
 }
 
 void NetClientFlush(NetClient *n)
 {
 	if (n->client == NULL) return;
+	if (n->peer != NULL)
+	{
+		NetBatchCount(&n->batch, &n->Stats, NULL);
+		NetBatchSend(&n->batch, n->peer, 0);
+		if (n->snapshotAckPending)
+		{
+			NetSnapshotEncodeAck(&n->snapshotBuf, n->snapshotAck);
+			ENetPacket *packet = enet_packet_create(
+				n->snapshotBuf.data, n->snapshotBuf.size, 0);
+			if (enet_peer_send(n->peer, NET_SNAPSHOT_CHANNEL, packet) != 0)
+			{
+				enet_packet_destroy(packet);
+			}
+			else
+			{
+				NetStatsSent(
+					&n->Stats, NET_STATS_SNAPSHOT, n->snapshotBuf.size);
+			}
+			n->snapshotAckPending = false;
+		}
+	}
 	enet_host_flush(n->client);
 }
 
@@ -511,7 +705,9 @@ void NetClientSendMsg(NetClient *n, const GameEventType e, const void *data)
 	}
 
 	LOG(LM_NET, LL_TRACE, "NetClient: send msg type %d", (int)e);
-	enet_peer_send(n->peer, 0, NetEncode(e, data));
+	uint8_t buf[NET_MSG_MAX_SIZE];
+	const size_t len = NetEncode(buf, e, data);
+	NetBatchAdd(&n->batch, e, NetSupersedeUID(e, data), buf, len);
 }
 
 bool NetClientIsConnected(const NetClient *n)
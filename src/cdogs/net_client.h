@@ -30,6 +30,8 @@
 
 #include <time.h>
 
+#include "net_snapshot.h"
+#include "net_stats.h"
 #include "net_util.h"
 
 // Stored information about game servers scanned
@@ -55,6 +57,22 @@ typedef struct
 	CArray ScannedAddrs;		// of ScanInfo
 	// Buffer of scanned addresses - new ones will be scanned here
 	CArray scannedAddrBuf;	// of ScanInfo
+	// Messages to send on the next flush
+	NetBatch batch;
+	// Snapshots received, as baselines for the next ones
+	NetSnapshotHistory snapshots;
+	// Actor states from snapshots that have been applied to the game
+	NetSnapshot snapshotApplied;
+	NetSnapshot snapshotNext;
+	// For snapshots that were lost, interpolated from their neighbours
+	NetSnapshot snapshotInterp;
+	// Last snapshot applied to the game
+	uint32_t snapshotShown;
+	// Latest snapshot received, and whether it needs acking
+	uint32_t snapshotAck;
+	bool snapshotAckPending;
+	CArray snapshotBuf;	// of uint8_t
+	NetStats Stats;
 } NetClient;
 
 extern NetClient gNetClient;
@@ -71,8 +89,11 @@ bool NetClientTryConnect(NetClient *n, const ENetAddress addr);
 bool NetClientTryScanAndConnect(NetClient *n, const enet_uint32 host);
 void NetClientDisconnect(NetClient *n);
 void NetClientPoll(NetClient *n);
+// Send the messages queued since the last flush
 void NetClientFlush(NetClient *n);
-// Send a command to the server
+// Apply the next received snapshot to remote actors; call once per tick
+void NetClientApplySnapshot(NetClient *n);
+// Queue a command to send to the server
 void NetClientSendMsg(NetClient *n, const GameEventType e, const void *data);
 
 bool NetClientIsConnected(const NetClient *n);
@@ -30,9 +30,12 @@
 
 #include <string.h>
 
+#include <SDL_timer.h>
+
 #include "proto/nanopb/pb_encode.h"
 
 #include "actor_placement.h"
+#include "actors.h"
 #include "ai_utils.h"
 #include "campaign_entry.h"
 #include "events.h"
@@ -48,14 +51,22 @@
 
 NetServer gNetServer;
 
+static ConfigHandle configNetStatsLog = CONFIG_HANDLE("Interface.NetStatsLog");
+
 
 void NetServerInit(NetServer *n)
 {
 	memset(n, 0, sizeof *n);
+	NetSnapshotHistoryInit(&n->snapshots);
+	CArrayInit(&n->snapshotBuf, sizeof(uint8_t));
+	NetStatsInit(&n->Stats);
 }
 void NetServerTerminate(NetServer *n)
 {
 	NetServerClose(n);
+	NetSnapshotHistoryTerminate(&n->snapshots);
+	CArrayTerminate(&n->snapshotBuf);
+	NetStatsTerminate(&n->Stats);
 }
 void NetServerReset(NetServer *n)
 {
@@ -76,6 +87,7 @@ void NetServerOpen(NetServer *n)
 	{
 		return;
 	}
+	NetStatsReset(&n->Stats);
 
 	// Start listen socket, to respond to UDP scans
 	if (!ListenSocketTryOpen(&n->listen))
@@ -97,7 +109,9 @@ static ENetHost *HostOpen(void)
 	ENetAddress address;
 	address.host = ENET_HOST_ANY;
 	address.port = ENET_PORT_ANY;
-	ENetHost *host = enet_host_create(&address, NET_SERVER_MAX_CLIENTS, 2, 0, 0);
+	ENetHost *host = enet_host_create(
+		&address, NET_SERVER_MAX_CLIENTS, NET_HOST_CHANNELS,
+		NET_HOST_BANDWIDTH_IN, NET_HOST_BANDWIDTH_OUT);
 	if (host == NULL)
 	{
 		LOG(LM_NET, LL_ERROR, "cannot create server host");
@@ -142,6 +156,7 @@ static bool ListenSocketTryOpen(ENetSocket *listen)
 	return true;
 }
 
+static void PeerDataFree(ENetPeer *peer);
 void NetServerClose(NetServer *n)
 {
 	if (n->server)
@@ -150,15 +165,26 @@ void NetServerClose(NetServer *n)
 		{
 			ENetPeer *peer = n->server->peers + i;
 			enet_peer_disconnect_now(peer, 0);
+			PeerDataFree(peer);
 		}
 		enet_host_destroy(n->server);
 	}
 	n->server = NULL;
 }
+static void PeerDataFree(ENetPeer *peer)
+{
+	NetPeerData *data = peer->data;
+	if (data == NULL) return;
+	NetBatchTerminate(&data->Batch);
+	CFREE(data);
+	peer->data = NULL;
+}
 
 static void PollListener(NetServer *n);
 static void OnReceive(NetServer *n, ENetEvent event);
+static void OnSnapshotAck(ENetEvent event);
 static void OnDisconnect(const ENetEvent event);
+static void UpdateStats(NetServer *n);
 void NetServerPoll(NetServer *n)
 {
 	if (!n->server)
@@ -197,7 +223,14 @@ void NetServerPoll(NetServer *n)
 				}
 				break;
 			case ENET_EVENT_TYPE_RECEIVE:
-				OnReceive(n, event);
+				if (event.channelID == NET_SNAPSHOT_CHANNEL)
+				{
+					OnSnapshotAck(event);
+				}
+				else
+				{
+					OnReceive(n, event);
+				}
 				break;
 			case ENET_EVENT_TYPE_DISCONNECT:
 				OnDisconnect(event);
@@ -210,6 +243,22 @@ void NetServerPoll(NetServer *n)
 	} while (check > 0);
 
 	NetServerFlush(n);
+	UpdateStats(n);
+}
+static void UpdateStats(NetServer *n)
+{
+	CArrayClear(&n->Stats.Peers);
+	for (int i = 0; i < (int)n->server->peerCount; i++)
+	{
+		const ENetPeer *peer = n->server->peers + i;
+		const NetPeerData *data = peer->data;
+		if (data == NULL) continue;
+		const NetPeerStats ps = NetPeerStatsNew(peer, data->Id, data->Traffic);
+		CArrayPushBack(&n->Stats.Peers, &ps);
+	}
+	NetStatsUpdate(
+		&n->Stats, "server", SDL_GetTicks(),
+		(NetStatsLog)ConfigHandleGetEnum(&configNetStatsLog));
 }
 static void PollListener(NetServer *n)
 {
@@ -262,25 +311,58 @@ static void PollListener(NetServer *n)
 		LOG(LM_NET, LL_ERROR, "Failed to reply to scanner");
 	}
 }
-static void OnConnect(NetServer *n, ENetEvent event);
+static void OnSnapshotAck(ENetEvent event)
+{
+	NetPeerData *data = event.peer->data;
+	if (data != NULL)
+	{
+		NetStatsRecv(&gNetServer.Stats, NET_STATS_SNAPSHOT,
+			event.packet->dataLength);
+		NetCounterAdd(&data->Traffic.Recv, event.packet->dataLength);
+	}
+	uint32_t seq;
+	if (data != NULL &&
+		NetSnapshotDecodeAck(
+			event.packet->data, event.packet->dataLength, &seq) &&
+		seq > data->SnapshotAck)
+	{
+		data->SnapshotAck = seq;
+	}
+	enet_packet_destroy(event.packet);
+}
+static void OnReceiveMsg(NetServer *n, ENetPeer *peer, const NetMsg *msg);
 static void OnReceive(NetServer *n, ENetEvent event)
 {
-	const GameEventType msg = (GameEventType)*(uint32_t *)event.packet->data;
+	// Each packet is a batch of messages
+	size_t offset = 0;
+	NetMsg msg;
+	while (NetBatchRead(event.packet, &offset, &msg))
+	{
+		OnReceiveMsg(n, event.peer, &msg);
+	}
+	enet_packet_destroy(event.packet);
+}
+static void OnConnect(NetServer *n, ENetPeer *peer);
+static void OnReceiveMsg(NetServer *n, ENetPeer *peer, const NetMsg *msg)
+{
 	int peerId = -1;
-	if (event.peer->data != NULL)
+	NetStatsRecv(&n->Stats, (int)msg->Type, msg->Len);
+	if (peer->data != NULL)
 	{
 		// We may not have assigned peer ID
-		peerId = ((NetPeerData *)event.peer->data)->Id;
+		NetPeerData *data = peer->data;
+		peerId = data->Id;
+		NetCounterAdd(&data->Traffic.Recv, msg->Len);
 		LOG(LM_NET, LL_TRACE, "recv message from peerId(%d) msg(%d)",
-			peerId, (int)msg);
+			peerId, (int)msg->Type);
 	}
-	const GameEventEntry gee = GameEventGetEntry(msg);
+	const GameEventEntry gee = GameEventGetEntry(msg->Type);
 	if (gee.Enqueue)
 	{
 		// Game event message; decode and add to event queue
 		LOG(LM_NET, LL_TRACE, "recv gameEvent(%d)", (int)gee.Type);
 		GameEvent e = GameEventNew(gee.Type);
-		NetDecode(event.packet, &e.u, gee.Fields);
+		NetDecode(msg, &e.u, gee.Fields);
 		GameEventsEnqueue(&gGameEvents, e);
 	}
 	else
@@ -288,7 +370,7 @@ static void OnReceive(NetServer *n, ENetEvent event)
 		switch (gee.Type)
 		{
 		case GAME_EVENT_CLIENT_CONNECT:
-			OnConnect(n, event);
+			OnConnect(n, peer);
 			break;
 		case GAME_EVENT_CLIENT_READY:
 			CASSERT(peerId >= 0, "peer id unset");
@@ -341,18 +423,22 @@ static void OnReceive(NetServer *n, ENetEvent event)
 			break;
 		}
 	}
-	enet_packet_destroy(event.packet);
 }
-static void OnConnect(NetServer *n, ENetEvent event)
+static void OnConnect(NetServer *n, ENetPeer *peer)
 {
 	char buf[256];
-	enet_address_get_host_ip(&event.peer->address, buf, sizeof buf);
+	enet_address_get_host_ip(&peer->address, buf, sizeof buf);
 	LOG(LM_NET, LL_INFO, "new client connected from %s:%u",
-		buf, event.peer->address.port);
+		buf, peer->address.port);
 	/* Store any relevant client information here. */
-	CMALLOC(event.peer->data, sizeof(NetPeerData));
+	NetPeerData *data;
+	CMALLOC(data, sizeof *data);
 	const int peerId = n->peerId;
-	((NetPeerData *)event.peer->data)->Id = peerId;
+	data->Id = peerId;
+	NetBatchInit(&data->Batch);
+	data->SnapshotAck = 0;
+	memset(&data->Traffic, 0, sizeof data->Traffic);
+	peer->data = data;
 	n->peerId++;
 
 	// Send the client ID
@@ -378,8 +464,7 @@ static void OnDisconnect(const ENetEvent event)
 	if (event.peer->data != NULL)
 	{
 		peerId = ((NetPeerData *)event.peer->data)->Id;
-		CFREE(event.peer->data);
-		event.peer->data = NULL;
+		PeerDataFree(event.peer);
 	}
 	CASSERT(peerId >= 0, "Cannot find disconnected peer id");
 	char buf[256];
@@ -398,6 +483,14 @@ static void OnDisconnect(const ENetEvent event)
 void NetServerFlush(NetServer *n)
 {
 	if (n->server == NULL) return;
+	for (int i = 0; i < (int)n->server->peerCount; i++)
+	{
+		ENetPeer *peer = n->server->peers + i;
+		NetPeerData *data = peer->data;
+		if (data == NULL) continue;
+		NetBatchCount(&data->Batch, &n->Stats, &data->Traffic);
+		NetBatchSend(&data->Batch, peer, 0);
+	}
 	enet_host_flush(n->server);
 }
 
@@ -590,6 +683,9 @@ void NetServerSendMsg(
 {
 	if (!n->server) return;
 
+	uint8_t buf[NET_MSG_MAX_SIZE];
+	const size_t len = NetEncode(buf, e, data);
+	const int supersedeUID = NetSupersedeUID(e, data);
 	if (peerId >= 0)
 	{
 		LOG(LM_NET, LL_TRACE, "send msg(%d) to peers(%d)",
@@ -597,11 +693,10 @@ void NetServerSendMsg(
 		// Find the peer and send
 		for (int i = 0; i < (int)n->server->peerCount; i++)
 		{
-			ENetPeer *peer = n->server->peers + i;
-			if (peer->data != NULL &&
-				((NetPeerData *)peer->data)->Id == peerId)
+			NetPeerData *pd = n->server->peers[i].data;
+			if (pd != NULL && pd->Id == peerId)
 			{
-				enet_peer_send(peer, 0, NetEncode(e, data));
+				NetBatchAdd(&pd->Batch, e, supersedeUID, buf, len);
 				return;
 			}
 		}
@@ -611,6 +706,54 @@ void NetServerSendMsg(
 	{
 		LOG(LM_NET, LL_TRACE, "bcast msg(%d) to peers(%d)",
 			(int)e, (int)n->server->connectedPeers);
-		enet_host_broadcast(n->server, 0, NetEncode(e, data));
+		// Only peers that have sent their connect message get broadcasts
+		for (int i = 0; i < (int)n->server->peerCount; i++)
+		{
+			NetPeerData *pd = n->server->peers[i].data;
+			if (pd == NULL) continue;
+			NetBatchAdd(&pd->Batch, e, supersedeUID, buf, len);
+		}
+	}
+}
+
+void NetServerSendSnapshot(NetServer *n)
+{
+	if (n->server == NULL || n->server->connectedPeers == 0) return;
+
+	n->snapshotSeq++;
+	NetSnapshot *s = NetSnapshotHistoryAdd(&n->snapshots, n->snapshotSeq);
+	CA_FOREACH(const TActor, a, gActors)
+		if (!a->isInUse) continue;
+		NetActorSnapshot as;
+		as.UID = a->uid;
+		as.Pos = a->Pos;
+		as.MoveVel = a->MoveVel;
+		as.Dir = (int)a->direction;
+		as.State = (int)a->anim.Type;
+		as.GunState =
+			a->guns.size > 0 ? (int)ActorGetGun(a)->state : GUNSTATE_READY;
+		CArrayPushBack(&s->Actors, &as);
+	CA_FOREACH_END()
+	NetSnapshotSort(s);
+
+	for (int i = 0; i < (int)n->server->peerCount; i++)
+	{
+		ENetPeer *peer = n->server->peers + i;
+		NetPeerData *data = peer->data;
+		if (data == NULL) continue;
+		// If the peer's ack is too old, it gets the whole snapshot
+		const NetSnapshot *base =
+			NetSnapshotHistoryGet(&n->snapshots, data->SnapshotAck);
+		NetSnapshotEncode(&n->snapshotBuf, s, base);
+		ENetPacket *packet = enet_packet_create(
+			n->snapshotBuf.data, n->snapshotBuf.size,
+			ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT);
+		if (enet_peer_send(peer, NET_SNAPSHOT_CHANNEL, packet) != 0)
+		{
+			enet_packet_destroy(packet);
+			continue;
+		}
+		NetStatsSent(&n->Stats, NET_STATS_SNAPSHOT, n->snapshotBuf.size);
+		NetCounterAdd(&data->Traffic.Sent, n->snapshotBuf.size);
 	}
 }
@@ -31,6 +31,8 @@
 #include <stdbool.h>
 
 #include "c_array.h"
+#include "net_snapshot.h"
+#include "net_stats.h"
 #include "net_util.h"
 
 
@@ -47,6 +49,11 @@ typedef struct
 	int PrevCmd;
 	int Cmd;
 	int peerId;	// auto-incrementing id for the next connected peer
+	// Recent actor snapshots, for peers to use as delta baselines
+	NetSnapshotHistory snapshots;
+	uint32_t snapshotSeq;
+	CArray snapshotBuf;	// of uint8_t
+	NetStats Stats;
 } NetServer;
 
 extern NetServer gNetServer;
@@ -54,6 +61,11 @@ extern NetServer gNetServer;
 typedef struct
 {
 	int Id;
+	// Messages to send on the next flush
+	NetBatch Batch;
+	// Latest snapshot the peer has received; 0 if none
+	uint32_t SnapshotAck;
+	NetTraffic Traffic;
 } NetPeerData;
 
 void NetServerInit(NetServer *n);
@@ -65,10 +77,14 @@ void NetServerOpen(NetServer *n);
 void NetServerClose(NetServer *n);
 // Service the recv buffer; if data is received then activate this device
 void NetServerPoll(NetServer *n);
+// Send each peer its batch of messages queued since the last flush
 void NetServerFlush(NetServer *n);
 
-// If peerId is -1, broadcast
+// Queue a message for a peer; if peerId is -1, broadcast
 void NetServerSendMsg(
 	NetServer *n, const int peerId, const GameEventType e, const void *data);
 
 void NetServerSendGameStartMessages(NetServer *n, const int peerId);
+// Send every peer a snapshot of all actors' movement and animation state,
+// as a delta against the last snapshot the peer acknowledged
+void NetServerSendSnapshot(NetServer *n);
@@ -0,0 +1,393 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "net_snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+
+// Which fields of an actor have changed since the baseline
+#define SNAPSHOT_POS 0x01
+#define SNAPSHOT_MOVE_VEL 0x02
+#define SNAPSHOT_DIR 0x04
+#define SNAPSHOT_STATE 0x08
+#define SNAPSHOT_GUN_STATE 0x10
+
+
+void NetSnapshotInit(NetSnapshot *s)
+{
+	s->Seq = 0;
+	CArrayInit(&s->Actors, sizeof(NetActorSnapshot));
+}
+void NetSnapshotTerminate(NetSnapshot *s)
+{
+	CArrayTerminate(&s->Actors);
+}
+
+void NetSnapshotHistoryInit(NetSnapshotHistory *h)
+{
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++)
+	{
+		NetSnapshotInit(&h->Snapshots[i]);
+	}
+}
+void NetSnapshotHistoryTerminate(NetSnapshotHistory *h)
+{
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++)
+	{
+		NetSnapshotTerminate(&h->Snapshots[i]);
+	}
+}
+void NetSnapshotHistoryReset(NetSnapshotHistory *h)
+{
+	for (int i = 0; i < NET_SNAPSHOT_HISTORY; i++)
+	{
+		h->Snapshots[i].Seq = 0;
+		CArrayClear(&h->Snapshots[i].Actors);
+	}
+}
+const NetSnapshot *NetSnapshotHistoryGet(
+	const NetSnapshotHistory *h, const uint32_t seq)
+{
+	if (seq == 0) return NULL;
+	const NetSnapshot *s = &h->Snapshots[seq % NET_SNAPSHOT_HISTORY];
+	return s->Seq == seq ? s : NULL;
+}
+NetSnapshot *NetSnapshotHistoryAdd(NetSnapshotHistory *h, const uint32_t seq)
+{
+	NetSnapshot *s = &h->Snapshots[seq % NET_SNAPSHOT_HISTORY];
+	s->Seq = seq;
+	CArrayClear(&s->Actors);
+	return s;
+}
+
+static int CompareActorUID(const void *v1, const void *v2)
+{
+	const NetActorSnapshot *a1 = v1;
+	const NetActorSnapshot *a2 = v2;
+	return a1->UID - a2->UID;
+}
+void NetSnapshotSort(NetSnapshot *s)
+{
+	qsort(
+		s->Actors.data, s->Actors.size, s->Actors.elemSize, CompareActorUID);
+}
+// Index of the first actor whose UID is not less than uid
+static int LowerBound(const NetSnapshot *s, const int uid)
+{
+	int lo = 0;
+	int hi = (int)s->Actors.size;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) / 2;
+		const NetActorSnapshot *a = CArrayGet(&s->Actors, mid);
+		if (a->UID < uid) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+const NetActorSnapshot *NetSnapshotFindActor(
+	const NetSnapshot *s, const int uid)
+{
+	const int i = LowerBound(s, uid);
+	if (i == (int)s->Actors.size) return NULL;
+	const NetActorSnapshot *a = CArrayGet(&s->Actors, i);
+	return a->UID == uid ? a : NULL;
+}
+
+
+static int Quantize(const int v)
+{
+	// Round to nearest, with negative numbers rounding the same way
+	const int half = NET_SNAPSHOT_POS_SCALE / 2;
+	return v >= -half ?
+		(v + half) / NET_SNAPSHOT_POS_SCALE :
+		-((-v - half + NET_SNAPSHOT_POS_SCALE - 1) / NET_SNAPSHOT_POS_SCALE);
+}
+
+static void WriteVarint(CArray *out, uint32_t v)
+{
+	while (v >= 0x80)
+	{
+		const uint8_t b = (uint8_t)(v | 0x80);
+		CArrayPushBack(out, &b);
+		v >>= 7;
+	}
+	const uint8_t b = (uint8_t)v;
+	CArrayPushBack(out, &b);
+}
+// Signed values are zigzag encoded so that small negatives stay small
+static void WriteSigned(CArray *out, const int v)
+{
+	WriteVarint(out, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+static uint8_t ChangedFields(
+	const NetActorSnapshot *a, const NetActorSnapshot *base);
+void NetSnapshotEncode(
+	CArray *out, const NetSnapshot *s, const NetSnapshot *base)
+{
+	CArrayClear(out);
+	WriteVarint(out, s->Seq);
+	WriteVarint(out, base != NULL ? base->Seq : 0);
+
+	// Actors in the baseline that are gone
+	int removed = 0;
+	if (base != NULL)
+	{
+		CA_FOREACH(const NetActorSnapshot, a, base->Actors)
+			if (NetSnapshotFindActor(s, a->UID) == NULL) removed++;
+		CA_FOREACH_END()
+	}
+	WriteVarint(out, (uint32_t)removed);
+	int lastUID = 0;
+	if (base != NULL)
+	{
+		CA_FOREACH(const NetActorSnapshot, a, base->Actors)
+			if (NetSnapshotFindActor(s, a->UID) != NULL) continue;
+			WriteVarint(out, (uint32_t)(a->UID - lastUID));
+			lastUID = a->UID;
+		CA_FOREACH_END()
+	}
+
+	// New actors, and actors that have changed; new ones are sent as changes
+	// from an actor with all fields zero
+	const NetActorSnapshot zero = { 0, { 0, 0 }, { 0, 0 }, 0, 0, 0 };
+	int changed = 0;
+	CA_FOREACH(const NetActorSnapshot, a, s->Actors)
+		const NetActorSnapshot *b = base ? NetSnapshotFindActor(base, a->UID) : NULL;
+		if (b == NULL || ChangedFields(a, b) != 0) changed++;
+	CA_FOREACH_END()
+	WriteVarint(out, (uint32_t)changed);
+	lastUID = 0;
+	CA_FOREACH(const NetActorSnapshot, a, s->Actors)
+		const NetActorSnapshot *b = base ? NetSnapshotFindActor(base, a->UID) : NULL;
+		const uint8_t fields = ChangedFields(a, b != NULL ? b : &zero);
+		if (b != NULL && fields == 0) continue;
+		if (b == NULL) b = &zero;
+		WriteVarint(out, (uint32_t)(a->UID - lastUID));
+		lastUID = a->UID;
+		CArrayPushBack(out, &fields);
+		if (fields & SNAPSHOT_POS)
+		{
+			WriteSigned(out, Quantize(a->Pos.x) - Quantize(b->Pos.x));
+			WriteSigned(out, Quantize(a->Pos.y) - Quantize(b->Pos.y));
+		}
+		if (fields & SNAPSHOT_MOVE_VEL)
+		{
+			WriteSigned(out, a->MoveVel.x - b->MoveVel.x);
+			WriteSigned(out, a->MoveVel.y - b->MoveVel.y);
+		}
+		if (fields & SNAPSHOT_DIR) WriteVarint(out, (uint32_t)a->Dir);
+		if (fields & SNAPSHOT_STATE) WriteVarint(out, (uint32_t)a->State);
+		if (fields & SNAPSHOT_GUN_STATE) WriteVarint(out, (uint32_t)a->GunState);
+	CA_FOREACH_END()
+}
+static uint8_t ChangedFields(
+	const NetActorSnapshot *a, const NetActorSnapshot *base)
+{
+	uint8_t fields = 0;
+	if (Quantize(a->Pos.x) != Quantize(base->Pos.x) ||
+		Quantize(a->Pos.y) != Quantize(base->Pos.y))
+	{
+		fields |= SNAPSHOT_POS;
+	}
+	if (!Vec2iEqual(a->MoveVel, base->MoveVel)) fields |= SNAPSHOT_MOVE_VEL;
+	if (a->Dir != base->Dir) fields |= SNAPSHOT_DIR;
+	if (a->State != base->State) fields |= SNAPSHOT_STATE;
+	if (a->GunState != base->GunState) fields |= SNAPSHOT_GUN_STATE;
+	return fields;
+}
+
+typedef struct
+{
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+	bool ok;
+} Reader;
+static uint32_t ReadVarint(Reader *r)
+{
+	uint32_t v = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (r->pos >= r->len)
+		{
+			break;
+		}
+		const uint8_t b = r->data[r->pos++];
+		v |= (uint32_t)(b & 0x7f) << shift;
+		if (!(b & 0x80))
+		{
+			return v;
+		}
+	}
+	r->ok = false;
+	return 0;
+}
+static int ReadSigned(Reader *r)
+{
+	const uint32_t v = ReadVarint(r);
+	return (int)(v >> 1) ^ -(int)(v & 1);
+}
+
+static NetActorSnapshot *FindOrAddActor(NetSnapshot *s, const int uid);
+const NetSnapshot *NetSnapshotDecode(
+	NetSnapshotHistory *h, const uint8_t *data, const size_t len)
+{
+	Reader r = { data, len, 0, true };
+	const uint32_t seq = ReadVarint(&r);
+	const uint32_t baseSeq = ReadVarint(&r);
+	if (!r.ok || seq == 0 || baseSeq >= seq ||
+		(baseSeq != 0 && seq - baseSeq >= NET_SNAPSHOT_HISTORY))
+	{
+		return NULL;
+	}
+	const NetSnapshot *base = NetSnapshotHistoryGet(h, baseSeq);
+	if (baseSeq != 0 && base == NULL)
+	{
+		return NULL;
+	}
+
+	// The baseline is in a different slot, so it survives this
+	NetSnapshot *s = NetSnapshotHistoryAdd(h, seq);
+	if (base != NULL)
+	{
+		CArrayCopy(&s->Actors, &base->Actors);
+	}
+
+	const uint32_t removed = ReadVarint(&r);
+	int uid = 0;
+	for (uint32_t i = 0; r.ok && i < removed; i++)
+	{
+		uid += (int)ReadVarint(&r);
+		if (NetSnapshotFindActor(s, uid) == NULL)
+		{
+			r.ok = false;
+			break;
+		}
+		CArrayDelete(&s->Actors, LowerBound(s, uid));
+	}
+
+	const uint32_t changed = ReadVarint(&r);
+	uid = 0;
+	for (uint32_t i = 0; r.ok && i < changed; i++)
+	{
+		uid += (int)ReadVarint(&r);
+		if (r.pos >= r.len)
+		{
+			r.ok = false;
+			break;
+		}
+		const uint8_t fields = r.data[r.pos++];
+		NetActorSnapshot *a = FindOrAddActor(s, uid);
+		if (fields & SNAPSHOT_POS)
+		{
+			a->Pos.x = (Quantize(a->Pos.x) + ReadSigned(&r)) *
+				NET_SNAPSHOT_POS_SCALE;
+			a->Pos.y = (Quantize(a->Pos.y) + ReadSigned(&r)) *
+				NET_SNAPSHOT_POS_SCALE;
+		}
+		if (fields & SNAPSHOT_MOVE_VEL)
+		{
+			a->MoveVel.x += ReadSigned(&r);
+			a->MoveVel.y += ReadSigned(&r);
+		}
+		if (fields & SNAPSHOT_DIR) a->Dir = (int)ReadVarint(&r);
+		if (fields & SNAPSHOT_STATE) a->State = (int)ReadVarint(&r);
+		if (fields & SNAPSHOT_GUN_STATE) a->GunState = (int)ReadVarint(&r);
+	}
+
+	if (!r.ok || r.pos != r.len)
+	{
+		s->Seq = 0;
+		CArrayClear(&s->Actors);
+		return NULL;
+	}
+	return s;
+}
+static NetActorSnapshot *FindOrAddActor(NetSnapshot *s, const int uid)
+{
+	const int i = LowerBound(s, uid);
+	if (i < (int)s->Actors.size)
+	{
+		NetActorSnapshot *a = CArrayGet(&s->Actors, i);
+		if (a->UID == uid) return a;
+	}
+	NetActorSnapshot a;
+	memset(&a, 0, sizeof a);
+	a.UID = uid;
+	CArrayInsert(&s->Actors, i, &a);
+	return CArrayGet(&s->Actors, i);
+}
+
+uint32_t NetSnapshotNextShown(const uint32_t shown, const uint32_t latest)
+{
+	if (latest <= NET_SNAPSHOT_DELAY)
+	{
+		return 0;
+	}
+	const uint32_t target = latest - NET_SNAPSHOT_DELAY;
+	if (shown + NET_SNAPSHOT_DELAY < target)
+	{
+		return target;
+	}
+	return shown < latest ? shown + 1 : 0;
+}
+
+void NetSnapshotInterpolate(
+	NetSnapshot *out, const NetSnapshot *a, const NetSnapshot *b,
+	const uint32_t seq)
+{
+	CASSERT(a->Seq < seq && seq < b->Seq, "cannot interpolate outside range");
+	out->Seq = seq;
+	CArrayCopy(&out->Actors, &a->Actors);
+	const int num = (int)(seq - a->Seq);
+	const int den = (int)(b->Seq - a->Seq);
+	CA_FOREACH(NetActorSnapshot, as, out->Actors)
+		const NetActorSnapshot *bs = NetSnapshotFindActor(b, as->UID);
+		if (bs == NULL) continue;
+		as->Pos = Vec2iAdd(as->Pos, Vec2iScaleDiv(
+			Vec2iScale(Vec2iMinus(bs->Pos, as->Pos), num), den));
+	CA_FOREACH_END()
+}
+
+void NetSnapshotEncodeAck(CArray *out, const uint32_t seq)
+{
+	CArrayClear(out);
+	WriteVarint(out, seq);
+}
+bool NetSnapshotDecodeAck(const uint8_t *data, const size_t len, uint32_t *seq)
+{
+	Reader r = { data, len, 0, true };
+	*seq = ReadVarint(&r);
+	return r.ok && r.pos == r.len;
+}
@@ -0,0 +1,115 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "c_array.h"
+#include "vector.h"
+
+// Actor state that changes every tick is sent as snapshots on this channel,
+// unreliable and sequenced, so that a lost packet is replaced by the next
+// one instead of holding up the ones after it
+#define NET_SNAPSHOT_CHANNEL 1
+// Host settings shared by client and server; a bandwidth of 0 leaves ENet
+// unthrottled, as a fixed low limit would starve the snapshot stream
+#define NET_HOST_CHANNELS 2
+#define NET_HOST_BANDWIDTH_IN 0
+#define NET_HOST_BANDWIDTH_OUT 0
+// Snapshots that can be used as delta baselines
+#define NET_SNAPSHOT_HISTORY 32
+// Positions are sent in units of this many full coordinates (1/16 pixel)
+#define NET_SNAPSHOT_POS_SCALE 16
+// Clients show snapshots this many ticks behind the latest one, so that a
+// lost or late snapshot can be interpolated over instead of stuttering
+#define NET_SNAPSHOT_DELAY 2
+
+typedef struct
+{
+	int UID;
+	Vec2i Pos;
+	Vec2i MoveVel;
+	int Dir;
+	int State;
+	int GunState;
+} NetActorSnapshot;
+
+typedef struct
+{
+	// Sequence numbers start at 1; 0 is unused
+	uint32_t Seq;
+	CArray Actors;	// of NetActorSnapshot, sorted by UID
+} NetSnapshot;
+
+typedef struct
+{
+	NetSnapshot Snapshots[NET_SNAPSHOT_HISTORY];
+} NetSnapshotHistory;
+
+void NetSnapshotInit(NetSnapshot *s);
+void NetSnapshotTerminate(NetSnapshot *s);
+// Sort a snapshot's actors by UID; call after adding them
+void NetSnapshotSort(NetSnapshot *s);
+const NetActorSnapshot *NetSnapshotFindActor(
+	const NetSnapshot *s, const int uid);
+
+void NetSnapshotHistoryInit(NetSnapshotHistory *h);
+void NetSnapshotHistoryTerminate(NetSnapshotHistory *h);
+void NetSnapshotHistoryReset(NetSnapshotHistory *h);
+// Get a snapshot by sequence, or NULL if it is no longer in the history
+const NetSnapshot *NetSnapshotHistoryGet(
+	const NetSnapshotHistory *h, const uint32_t seq);
+// Start a new, empty snapshot, replacing the oldest one
+NetSnapshot *NetSnapshotHistoryAdd(NetSnapshotHistory *h, const uint32_t seq);
+
+// Encode a snapshot into out (of uint8_t), as a delta against base
+// If base is NULL, the whole snapshot is encoded
+void NetSnapshotEncode(
+	CArray *out, const NetSnapshot *s, const NetSnapshot *base);
+// Decode a snapshot into the history, using the baseline it was encoded
+// against; returns NULL if the packet is malformed or the baseline is gone
+const NetSnapshot *NetSnapshotDecode(
+	NetSnapshotHistory *h, const uint8_t *data, const size_t len);
+
+// Which snapshot a client should show next, given the one it showed last
+// tick and the latest one received; advances one per tick, but jumps ahead
+// if it falls too far behind. Returns 0 if there is nothing new to show.
+uint32_t NetSnapshotNextShown(const uint32_t shown, const uint32_t latest);
+// Fill out with the actors of a, with positions interpolated towards b for
+// the snapshot seq between them
+void NetSnapshotInterpolate(
+	NetSnapshot *out, const NetSnapshot *a, const NetSnapshot *b,
+	const uint32_t seq);
+
+// Acks tell the server which snapshot the client has; they are also sent on
+// the snapshot channel
+void NetSnapshotEncodeAck(CArray *out, const uint32_t seq);
+bool NetSnapshotDecodeAck(const uint8_t *data, const size_t len, uint32_t *seq);
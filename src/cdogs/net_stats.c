@@ -0,0 +1,304 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "net_stats.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "log.h"
+#include "utils.h"
+
+
+void NetCounterAdd(NetCounter *c, const size_t bytes)
+{
+	c->Msgs++;
+	c->Bytes += bytes;
+}
+void NetTrafficSub(NetTraffic *t, const NetTraffic *other)
+{
+	t->Sent.Msgs -= other->Sent.Msgs;
+	t->Sent.Bytes -= other->Sent.Bytes;
+	t->Recv.Msgs -= other->Recv.Msgs;
+	t->Recv.Bytes -= other->Recv.Bytes;
+}
+
+NetPeerStats NetPeerStatsNew(
+	const ENetPeer *peer, const int id, const NetTraffic traffic)
+{
+	NetPeerStats ps;
+	ps.Id = id;
+	ps.RTTMs = (int)peer->roundTripTime;
+	ps.PacketLoss = (double)peer->packetLoss / ENET_PEER_PACKET_LOSS_SCALE;
+	// enet_list_size takes a non-const list, so count the nodes here
+	ps.Queue = 0;
+	const ENetListNode *node;
+	for (node = peer->outgoingReliableCommands.sentinel.next;
+		node != &peer->outgoingReliableCommands.sentinel;
+		node = node->next)
+	{
+		ps.Queue++;
+	}
+	for (node = peer->sentReliableCommands.sentinel.next;
+		node != &peer->sentReliableCommands.sentinel;
+		node = node->next)
+	{
+		ps.Queue++;
+	}
+	ps.Traffic = traffic;
+	return ps;
+}
+
+void NetStatsInit(NetStats *s)
+{
+	memset(s, 0, sizeof *s);
+	CArrayInit(&s->Peers, sizeof(NetPeerStats));
+}
+void NetStatsTerminate(NetStats *s)
+{
+	CArrayTerminate(&s->Peers);
+}
+void NetStatsReset(NetStats *s)
+{
+	CArray peers = s->Peers;
+	CArrayClear(&peers);
+	memset(s, 0, sizeof *s);
+	s->Peers = peers;
+}
+
+const char *NetStatsTypeStr(const int type)
+{
+	switch (type)
+	{
+		T2S(GAME_EVENT_NONE, "none");
+		T2S(GAME_EVENT_CLIENT_CONNECT, "client_connect");
+		T2S(GAME_EVENT_CLIENT_ID, "client_id");
+		T2S(GAME_EVENT_CAMPAIGN_DEF, "campaign_def");
+		T2S(GAME_EVENT_PLAYER_DATA, "player_data");
+		T2S(GAME_EVENT_PLAYER_REMOVE, "player_remove");
+		T2S(GAME_EVENT_TILE_SET, "tile_set");
+		T2S(GAME_EVENT_MAP_OBJECT_ADD, "map_object_add");
+		T2S(GAME_EVENT_MAP_OBJECT_DAMAGE, "map_object_damage");
+		T2S(GAME_EVENT_MAP_OBJECT_REMOVE, "map_object_remove");
+		T2S(GAME_EVENT_CLIENT_READY, "client_ready");
+		T2S(GAME_EVENT_NET_GAME_START, "net_game_start");
+		T2S(GAME_EVENT_CONFIG, "config");
+		T2S(GAME_EVENT_SCORE, "score");
+		T2S(GAME_EVENT_SOUND_AT, "sound_at");
+		T2S(GAME_EVENT_SCREEN_SHAKE, "screen_shake");
+		T2S(GAME_EVENT_SET_MESSAGE, "set_message");
+		T2S(GAME_EVENT_GAME_START, "game_start");
+		T2S(GAME_EVENT_GAME_BEGIN, "game_begin");
+		T2S(GAME_EVENT_ACTOR_ADD, "actor_add");
+		T2S(GAME_EVENT_ACTOR_MOVE, "actor_move");
+		T2S(GAME_EVENT_ACTOR_STATE, "actor_state");
+		T2S(GAME_EVENT_ACTOR_DIR, "actor_dir");
+		T2S(GAME_EVENT_ACTOR_SLIDE, "actor_slide");
+		T2S(GAME_EVENT_ACTOR_IMPULSE, "actor_impulse");
+		T2S(GAME_EVENT_ACTOR_SWITCH_GUN, "actor_switch_gun");
+		T2S(GAME_EVENT_ACTOR_PICKUP_ALL, "actor_pickup_all");
+		T2S(GAME_EVENT_ACTOR_REPLACE_GUN, "actor_replace_gun");
+		T2S(GAME_EVENT_ACTOR_HEAL, "actor_heal");
+		T2S(GAME_EVENT_ACTOR_HIT, "actor_hit");
+		T2S(GAME_EVENT_ACTOR_ADD_AMMO, "actor_add_ammo");
+		T2S(GAME_EVENT_ACTOR_USE_AMMO, "actor_use_ammo");
+		T2S(GAME_EVENT_ACTOR_DIE, "actor_die");
+		T2S(GAME_EVENT_ACTOR_MELEE, "actor_melee");
+		T2S(GAME_EVENT_ADD_PICKUP, "add_pickup");
+		T2S(GAME_EVENT_REMOVE_PICKUP, "remove_pickup");
+		T2S(GAME_EVENT_BULLET_BOUNCE, "bullet_bounce");
+		T2S(GAME_EVENT_REMOVE_BULLET, "remove_bullet");
+		T2S(GAME_EVENT_PARTICLE_REMOVE, "particle_remove");
+		T2S(GAME_EVENT_GUN_FIRE, "gun_fire");
+		T2S(GAME_EVENT_GUN_RELOAD, "gun_reload");
+		T2S(GAME_EVENT_GUN_STATE, "gun_state");
+		T2S(GAME_EVENT_ADD_BULLET, "add_bullet");
+		T2S(GAME_EVENT_ADD_PARTICLE, "add_particle");
+		T2S(GAME_EVENT_TRIGGER, "trigger");
+		T2S(GAME_EVENT_EXPLORE_TILES, "explore_tiles");
+		T2S(GAME_EVENT_RESCUE_CHARACTER, "rescue_character");
+		T2S(GAME_EVENT_OBJECTIVE_UPDATE, "objective_update");
+		T2S(GAME_EVENT_ADD_KEYS, "add_keys");
+		T2S(GAME_EVENT_MISSION_COMPLETE, "mission_complete");
+		T2S(GAME_EVENT_MISSION_INCOMPLETE, "mission_incomplete");
+		T2S(GAME_EVENT_MISSION_PICKUP, "mission_pickup");
+		T2S(GAME_EVENT_MISSION_END, "mission_end");
+		T2S(NET_STATS_SNAPSHOT, "snapshot");
+		default:
+			return "unknown";
+	}
+}
+
+// Received types come off the wire, so unknown ones only count in the total
+void NetStatsSent(NetStats *s, const int type, const size_t bytes)
+{
+	if (type >= 0 && type < NET_STATS_TYPES)
+	{
+		NetCounterAdd(&s->Types[type].Sent, bytes);
+	}
+	NetCounterAdd(&s->Total.Sent, bytes);
+}
+void NetStatsRecv(NetStats *s, const int type, const size_t bytes)
+{
+	if (type >= 0 && type < NET_STATS_TYPES)
+	{
+		NetCounterAdd(&s->Types[type].Recv, bytes);
+	}
+	NetCounterAdd(&s->Total.Recv, bytes);
+}
+
+static void Format(const NetStats *s, const NetStatsLog format, CArray *out);
+void NetStatsUpdate(
+	NetStats *s, const char *name, const Uint32 ticks,
+	const NetStatsLog format)
+{
+	if (s->startTicks == 0)
+	{
+		s->startTicks = s->rateTicks = s->logTicks = ticks;
+		return;
+	}
+	if (ticks - s->rateTicks >= 1000)
+	{
+		for (int i = 0; i < NET_STATS_TYPES; i++)
+		{
+			s->TypesRate[i] = s->Types[i];
+			NetTrafficSub(&s->TypesRate[i], &s->typesStart[i]);
+			s->typesStart[i] = s->Types[i];
+		}
+		s->TotalRate = s->Total;
+		NetTrafficSub(&s->TotalRate, &s->totalStart);
+		s->totalStart = s->Total;
+		s->rateTicks = ticks;
+	}
+	if (format != NET_STATS_LOG_OFF && ticks - s->logTicks >= NET_STATS_LOG_MS)
+	{
+		CArray buf;
+		Format(s, format, &buf);
+		// LOG ends the line itself
+		char *text = buf.data;
+		const size_t len = strlen(text);
+		if (len > 0 && text[len - 1] == '\n') text[len - 1] = '\0';
+		LOG(LM_NET, LL_INFO, "%s network stats:\n%s", name, text);
+		CArrayTerminate(&buf);
+		s->logTicks = ticks;
+	}
+}
+
+// Append to a string kept in a CArray of char, including its terminator
+static void Appendf(CArray *out, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int n = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+	const size_t len = out->size - 1;
+	CArrayResize(out, len + n + 1, NULL);
+	va_start(args, fmt);
+	vsnprintf((char *)out->data + len, n + 1, fmt, args);
+	va_end(args);
+}
+static void AppendCSVRow(
+	CArray *out, const char *scope, const char *id, const NetTraffic *t)
+{
+	Appendf(out,
+		"%s,%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+		scope, id, t->Sent.Msgs, t->Sent.Bytes, t->Recv.Msgs, t->Recv.Bytes);
+}
+static void AppendJSONTraffic(CArray *out, const NetTraffic *t)
+{
+	Appendf(out,
+		"\"sent_msgs\":%" PRIu64 ",\"sent_bytes\":%" PRIu64 ","
+		"\"recv_msgs\":%" PRIu64 ",\"recv_bytes\":%" PRIu64,
+		t->Sent.Msgs, t->Sent.Bytes, t->Recv.Msgs, t->Recv.Bytes);
+}
+static void Format(const NetStats *s, const NetStatsLog format, CArray *out)
+{
+	CArrayInit(out, sizeof(char));
+	const char nul = '\0';
+	CArrayPushBack(out, &nul);
+	switch (format)
+	{
+	case NET_STATS_LOG_CSV:
+		Appendf(out,
+			"scope,id,sent_msgs,sent_bytes,recv_msgs,recv_bytes,"
+			"rtt_ms,loss_pct,queue\n");
+		AppendCSVRow(out, "total", "", &s->Total);
+		Appendf(out, ",,,\n");
+		for (int i = 0; i < NET_STATS_TYPES; i++)
+		{
+			const NetTraffic *t = &s->Types[i];
+			if (t->Sent.Msgs == 0 && t->Recv.Msgs == 0) continue;
+			AppendCSVRow(out, "type", NetStatsTypeStr(i), t);
+			Appendf(out, ",,,\n");
+		}
+		CA_FOREACH(const NetPeerStats, ps, s->Peers)
+			char buf[32];
+			sprintf(buf, "%d", ps->Id);
+			AppendCSVRow(out, "peer", buf, &ps->Traffic);
+			Appendf(out, ",%d,%.2f,%d\n",
+				ps->RTTMs, ps->PacketLoss * 100, ps->Queue);
+		CA_FOREACH_END()
+		break;
+	case NET_STATS_LOG_JSON:
+		{
+			Appendf(out, "{\"total\":{");
+			AppendJSONTraffic(out, &s->Total);
+			Appendf(out, "},\"types\":[");
+			bool first = true;
+			for (int i = 0; i < NET_STATS_TYPES; i++)
+			{
+				const NetTraffic *t = &s->Types[i];
+				if (t->Sent.Msgs == 0 && t->Recv.Msgs == 0) continue;
+				Appendf(out, "%s{\"type\":\"%s\",",
+					first ? "" : ",", NetStatsTypeStr(i));
+				AppendJSONTraffic(out, t);
+				Appendf(out, "}");
+				first = false;
+			}
+			Appendf(out, "],\"peers\":[");
+			CA_FOREACH(const NetPeerStats, ps, s->Peers)
+				Appendf(out, "%s{\"id\":%d,", _ca_index == 0 ? "" : ",", ps->Id);
+				AppendJSONTraffic(out, &ps->Traffic);
+				Appendf(out, ",\"rtt_ms\":%d,\"loss_pct\":%.2f,\"queue\":%d}",
+					ps->RTTMs, ps->PacketLoss * 100, ps->Queue);
+			CA_FOREACH_END()
+			Appendf(out, "]}\n");
+		}
+		break;
+	default:
+		break;
+	}
+}
+void NetStatsPrint(const NetStats *s, const NetStatsLog format, FILE *f)
+{
+	CArray buf;
+	Format(s, format, &buf);
+	fputs(buf.data, f);
+	CArrayTerminate(&buf);
+}
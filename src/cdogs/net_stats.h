@@ -0,0 +1,106 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <enet/enet.h>
+#include <SDL_stdinc.h>
+
+#include "c_array.h"
+#include "config.h"
+#include "game_events.h"
+
+// Messages are counted by game event type, with an extra slot for snapshots
+#define NET_STATS_SNAPSHOT (GAME_EVENT_MISSION_END + 1)
+#define NET_STATS_TYPES (NET_STATS_SNAPSHOT + 1)
+// How often the stats are dumped to the log, if enabled
+#define NET_STATS_LOG_MS 5000
+
+// Number of messages and their encoded size
+typedef struct
+{
+	Uint64 Msgs;
+	Uint64 Bytes;
+} NetCounter;
+void NetCounterAdd(NetCounter *c, const size_t bytes);
+typedef struct
+{
+	NetCounter Sent;
+	NetCounter Recv;
+} NetTraffic;
+void NetTrafficSub(NetTraffic *t, const NetTraffic *other);
+
+typedef struct
+{
+	int Id;
+	int RTTMs;
+	double PacketLoss;	// 0-1
+	// Reliable commands queued or waiting for acknowledgement
+	int Queue;
+	NetTraffic Traffic;
+} NetPeerStats;
+NetPeerStats NetPeerStatsNew(
+	const ENetPeer *peer, const int id, const NetTraffic traffic);
+
+// Network traffic of a client or server, since it started
+typedef struct
+{
+	NetTraffic Types[NET_STATS_TYPES];
+	NetTraffic Total;
+	CArray Peers;	// of NetPeerStats; refreshed by the owner
+	// Traffic over the last whole second
+	NetTraffic TypesRate[NET_STATS_TYPES];
+	NetTraffic TotalRate;
+	NetTraffic typesStart[NET_STATS_TYPES];
+	NetTraffic totalStart;
+	Uint32 rateTicks;
+	Uint32 logTicks;
+	Uint32 startTicks;
+} NetStats;
+
+void NetStatsInit(NetStats *s);
+void NetStatsTerminate(NetStats *s);
+void NetStatsReset(NetStats *s);
+
+// Name of a message type, as used in stats dumps; type is a GameEventType
+// or NET_STATS_SNAPSHOT
+const char *NetStatsTypeStr(const int type);
+// Count a message of a type
+void NetStatsSent(NetStats *s, const int type, const size_t bytes);
+void NetStatsRecv(NetStats *s, const int type, const size_t bytes);
+
+// Call with the current time in ms after refreshing Peers; updates the
+// rates and dumps the stats to the log periodically unless format is off
+void NetStatsUpdate(
+	NetStats *s, const char *name, const Uint32 ticks,
+	const NetStatsLog format);
+void NetStatsPrint(const NetStats *s, const NetStatsLog format, FILE *f);
@@ -32,27 +32,35 @@
 #include "proto/nanopb/pb_encode.h"
 
 
-ENetPacket *NetEncode(const GameEventType e, const void *data)
+size_t NetEncode(uint8_t *buf, const GameEventType e, const void *data)
 {
-	uint8_t buffer[1024];
-	pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof buffer);
+	pb_ostream_t stream = pb_ostream_from_buffer(buf, NET_MSG_MAX_SIZE);
 	const pb_field_t *fields = GameEventGetEntry(e).Fields;
 	const bool status =
 		(data && fields) ? pb_encode(&stream, fields, data) : true;
 	CASSERT(status, "Failed to encode pb");
-	int msgId = (int)e;
-	ENetPacket *packet = enet_packet_create(
-		&msgId, NET_MSG_SIZE + stream.bytes_written,
-		ENET_PACKET_FLAG_RELIABLE);
-	memcpy(packet->data + NET_MSG_SIZE, buffer, stream.bytes_written);
-	return packet;
+	return stream.bytes_written;
+}
+int NetSupersedeUID(const GameEventType e, const void *data)
+{
+	switch (e)
+	{
+	case GAME_EVENT_ACTOR_MOVE:
+		return (int)((const NActorMove *)data)->UID;
+	case GAME_EVENT_ACTOR_STATE:
+		return (int)((const NActorState *)data)->UID;
+	case GAME_EVENT_ACTOR_DIR:
+		return (int)((const NActorDir *)data)->UID;
+	case GAME_EVENT_GUN_STATE:
+		return (int)((const NGunState *)data)->ActorUID;
+	default:
+		return -1;
+	}
 }
 
-bool NetDecode(
-	ENetPacket *packet, void *dest, const pb_field_t *fields)
+bool NetDecode(const NetMsg *msg, void *dest, const pb_field_t *fields)
 {
-	pb_istream_t stream = pb_istream_from_buffer(
-		packet->data + NET_MSG_SIZE, packet->dataLength - NET_MSG_SIZE);
+	pb_istream_t stream = pb_istream_from_buffer(msg->Data, msg->Len);
 	bool status = pb_decode(&stream, fields, dest);
 	CASSERT(status, "Failed to decode pb");
 	return status;
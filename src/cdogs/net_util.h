@@ -36,20 +36,26 @@
 #include "campaigns.h"
 #include "game_events.h"
 #include "map.h"
+#include "net_batch.h"
 #include "player.h"
 
 #define NET_LISTEN_PORT 34219
 
-#define NET_PROTOCOL_VERSION 2
+#define NET_PROTOCOL_VERSION 4
 
 // Messages
 
-// All messages start with 4 bytes message type followed by the message struct
-#define NET_MSG_SIZE sizeof(uint32_t)
+// Messages are queued per peer and sent once per tick in batch packets;
+// see net_batch.h for the framing
+#define NET_MSG_MAX_SIZE 1024
 
-
-ENetPacket *NetEncode(const GameEventType e, const void *data);
-bool NetDecode(ENetPacket *packet, void *dest, const pb_field_t *fields);
+// Encode a message into buf, which must hold NET_MSG_MAX_SIZE bytes
+// Returns the encoded length
+size_t NetEncode(uint8_t *buf, const GameEventType e, const void *data);
+// For messages that only carry an actor's latest state, return the actor UID
+// so that older messages in the same batch can be dropped; otherwise -1
+int NetSupersedeUID(const GameEventType e, const void *data);
+bool NetDecode(const NetMsg *msg, void *dest, const pb_field_t *fields);
 
 NPlayerData NMakePlayerData(const PlayerData *p);
 NCampaignDef NMakeCampaignDef(const CampaignOptions *co);
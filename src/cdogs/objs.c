@@ -56,6 +56,7 @@
 #include "collision.h"
 #include "config.h"
 #include "damage.h"
+#include "flow_field.h"
 #include "game_events.h"
 #include "log.h"
 #include "map.h"
@@ -64,6 +65,7 @@
 #include "blit.h"
 #include "pic_manager.h"
 #include "pickup.h"
+#include "pool.h"
 #include "defs.h"
 #include "actors.h"
 #include "gamedata.h"
@@ -71,10 +73,14 @@
 #include "game.h"
 #include "utils.h"
 
+static ConfigHandle configShotsPushback = CONFIG_HANDLE("Game.ShotsPushback");
+
 CArray gObjs;
 CArray gMobObjs;
 static unsigned int sObjUIDs = 0;
 static unsigned int sMobObjUIDs = 0;
+static Pool sObjPool;
+static Pool sMobObjPool;
 
 
 // Draw functions
@@ -142,7 +148,8 @@ void ObjRemove(const NMapObjectRemove mor)
 		// TODO: doesn't need to be network event
 		GameEvent e = GameEventNew(GAME_EVENT_ADD_BULLET);
 		e.u.AddBullet.UID = MobObjsObjsGetNextUID();
-		strcpy(e.u.AddBullet.BulletClass, "fireball_wreck");
+		e.u.AddBullet.BulletClassId =
+			BulletClassId(StrBulletClass("fireball_wreck"));
 		e.u.AddBullet.MuzzlePos = Vec2i2Net(fullPos);
 		e.u.AddBullet.MuzzleHeight = 0;
 		e.u.AddBullet.Angle = 0;
@@ -159,6 +166,7 @@ void ObjRemove(const NMapObjectRemove mor)
 	if (o->Class->Wreck.Pic)
 	{
 		o->tileItem.flags = TILEITEM_IS_WRECK;
+		MapUpdateTileItem(&gMap, &o->tileItem);
 	}
 	else
 	{
@@ -167,7 +175,8 @@ void ObjRemove(const NMapObjectRemove mor)
 
 	// Update pathfinding cache since this object could have blocked a path
 	// before
-	PathCacheClear(&gPathCache);
+	const Vec2i tv = Vec2iToTile(realPos);
+	PathCacheInvalidate(&gPathCache, tv, tv);
 }
 
 bool CanHit(const int flags, const int uid, const TTileItem *target)
@@ -262,7 +271,7 @@ static void DoDamageCharacter(
 	CASSERT(actor->isInUse, "Cannot damage nonexistent player");
 	CASSERT(CanHitCharacter(flags, uid, actor), "damaging undamageable actor");
 
-	if (ConfigGetBool(&gConfig, "Game.ShotsPushback"))
+	if (ConfigHandleGetBool(&configShotsPushback))
 	{
 		GameEvent ei = GameEventNew(GAME_EVENT_ACTOR_IMPULSE);
 		ei.u.ActorImpulse.UID = actor->uid;
@@ -334,6 +343,7 @@ void ObjsInit(void)
 	CArrayInit(&gObjs, sizeof(TObject));
 	CArrayReserve(&gObjs, 1024);
 	sObjUIDs = 0;
+	PoolInit(&sObjPool);
 }
 void ObjsTerminate(void)
 {
@@ -344,12 +354,23 @@ void ObjsTerminate(void)
 		}
 	CA_FOREACH_END()
 	CArrayTerminate(&gObjs);
+	PoolTerminate(&sObjPool);
 }
 int ObjsGetNextUID(void)
 {
 	return sObjUIDs++;
 }
 
+// AI walks around dangerous objects, so flow fields near them need updating
+// whenever they come and go
+static void UpdateFlowFields(const TObject *o)
+{
+	if (ObjIsDangerous(o))
+	{
+		FlowFieldsUpdateTile(
+			&gFlowFields, Vec2iToTile(Vec2iNew(o->tileItem.x, o->tileItem.y)));
+	}
+}
 void ObjAdd(const NMapObjectAdd amo)
 {
 	// Don't add if UID exists
@@ -359,26 +380,14 @@ void ObjAdd(const NMapObjectAdd amo)
 			"object uid(%d) already exists; not adding", (int)amo.UID);
 		return;
 	}
-	// Find an empty slot in object list
-	TObject *o = NULL;
-	int i;
-	for (i = 0; i < (int)gObjs.size; i++)
-	{
-		TObject *obj = CArrayGet(&gObjs, i);
-		if (!obj->isInUse)
-		{
-			o = obj;
-			break;
-		}
-	}
-	if (o == NULL)
+	const int i = PoolAdd(&sObjPool, amo.UID);
+	if (i == (int)gObjs.size)
 	{
 		TObject obj;
 		memset(&obj, 0, sizeof obj);
 		CArrayPushBack(&gObjs, &obj);
-		i = (int)gObjs.size - 1;
-		o = CArrayGet(&gObjs, i);
 	}
+	TObject *o = CArrayGet(&gObjs, i);
 	memset(o, 0, sizeof *o);
 	o->uid = amo.UID;
 	o->Class = StrMapObject(amo.MapObjectClass);
@@ -391,6 +400,7 @@ void ObjAdd(const NMapObjectAdd amo)
 	o->tileItem.id = i;
 	MapTryMoveTileItem(&gMap, &o->tileItem, Net2Vec2i(amo.Pos));
 	o->isInUse = true;
+	UpdateFlowFields(o);
 	LOG(LM_MAIN, LL_DEBUG,
 		"added object uid(%d) class(%s) health(%d) pos(%d, %d)",
 		(int)amo.UID, amo.MapObjectClass, amo.Health, amo.Pos.x, amo.Pos.y);
@@ -398,8 +408,10 @@ void ObjAdd(const NMapObjectAdd amo)
 void ObjDestroy(TObject *o)
 {
 	CASSERT(o->isInUse, "Destroying in-use object");
+	UpdateFlowFields(o);
 	MapRemoveTileItem(&gMap, &o->tileItem);
 	o->isInUse = false;
+	PoolRemove(&sObjPool, o->tileItem.id);
 }
 
 bool ObjIsDangerous(const TObject *o)
@@ -453,13 +465,8 @@ void UpdateObjects(const int ticks)
 
 TObject *ObjGetByUID(const int uid)
 {
-	CA_FOREACH(TObject, o, gObjs)
-		if (o->uid == uid)
-		{
-			return o;
-		}
-	CA_FOREACH_END()
-	return NULL;
+	const int i = PoolFindUID(&sObjPool, uid);
+	return i >= 0 ? CArrayGet(&gObjs, i) : NULL;
 }
 
 
@@ -468,6 +475,7 @@ void MobObjsInit(void)
 	CArrayInit(&gMobObjs, sizeof(TMobileObject));
 	CArrayReserve(&gMobObjs, 1024);
 	sMobObjUIDs = 0;
+	PoolInit(&sMobObjPool);
 }
 void MobObjsTerminate(void)
 {
@@ -478,24 +486,39 @@ void MobObjsTerminate(void)
 		}
 	CA_FOREACH_END()
 	CArrayTerminate(&gMobObjs);
+	PoolTerminate(&sMobObjPool);
 }
 int MobObjsObjsGetNextUID(void)
 {
 	return sMobObjUIDs++;
 }
+TMobileObject *MobObjAdd(const int uid)
+{
+	const int i = PoolAdd(&sMobObjPool, uid);
+	if (i == (int)gMobObjs.size)
+	{
+		TMobileObject m;
+		memset(&m, 0, sizeof m);
+		CArrayPushBack(&gMobObjs, &m);
+	}
+	TMobileObject *m = CArrayGet(&gMobObjs, i);
+	memset(m, 0, sizeof *m);
+	m->UID = uid;
+	m->tileItem.kind = KIND_MOBILEOBJECT;
+	m->tileItem.id = i;
+	m->tileItem.x = m->tileItem.y = -1;
+	m->isInUse = true;
+	return m;
+}
 TMobileObject *MobObjGetByUID(const int uid)
 {
-	CA_FOREACH(TMobileObject, o, gMobObjs)
-		if (o->UID == uid)
-		{
-			return o;
-		}
-	CA_FOREACH_END()
-	return NULL;
+	const int i = PoolFindUID(&sMobObjPool, uid);
+	return i >= 0 ? CArrayGet(&gMobObjs, i) : NULL;
 }
 void MobObjDestroy(TMobileObject *m)
 {
 	CASSERT(m->isInUse, "Destroying not-in-use mobobj");
 	MapRemoveTileItem(&gMap, &m->tileItem);
 	m->isInUse = false;
+	PoolRemove(&sMobObjPool, m->tileItem.id);
 }
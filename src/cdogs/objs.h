@@ -132,5 +132,7 @@ void UpdateMobileObjects(int ticks);
 void MobObjsInit(void);
 void MobObjsTerminate(void);
 int MobObjsObjsGetNextUID(void);
+// Get a cleared, in-use mobile object in a free slot
+TMobileObject *MobObjAdd(const int uid);
 TMobileObject *MobObjGetByUID(const int uid);
 void MobObjDestroy(TMobileObject *m);
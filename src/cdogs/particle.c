@@ -35,15 +35,19 @@
 
 
 ParticleClasses gParticleClasses;
-CArray gParticles;
+Particles gParticles;
 
 #define VERSION 1
 
+static const char *ParticleClassName(const void *c);
 static void LoadParticleClass(ParticleClass *c, json_t *node);
 void ParticleClassesInit(ParticleClasses *classes, const char *filename)
 {
 	CArrayInit(&classes->Classes, sizeof(ParticleClass));
 	CArrayInit(&classes->CustomClasses, sizeof(ParticleClass));
+	AssetRegistryInit(
+		&classes->registry, &classes->Classes, &classes->CustomClasses,
+		ParticleClassName);
 
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, filename);
@@ -61,6 +65,7 @@ void ParticleClassesInit(ParticleClasses *classes, const char *filename)
 		goto bail;
 	}
 	ParticleClassesLoadJSON(&classes->Classes, root);
+	AssetRegistryIndex(&classes->registry);
 
 bail:
 	if (f != NULL)
@@ -87,8 +92,13 @@ void ParticleClassesLoadJSON(CArray *classes, json_t *root)
 		CArrayPushBack(classes, &c);
 	}
 }
+static const char *ParticleClassName(const void *c)
+{
+	return ((const ParticleClass *)c)->Name;
+}
 void ParticleClassesTerminate(ParticleClasses *classes)
 {
+	AssetRegistryTerminate(&classes->registry);
 	ParticleClassesClear(&classes->Classes);
 	CArrayTerminate(&classes->Classes);
 	ParticleClassesClear(&classes->CustomClasses);
@@ -154,205 +164,298 @@ const ParticleClass *StrParticleClass(
 	{
 		return NULL;
 	}
-	CA_FOREACH(const ParticleClass, c, classes->CustomClasses)
-		if (strcmp(c->Name, name) == 0)
-		{
-			return c;
-		}
-	CA_FOREACH_END()
-	CA_FOREACH(const ParticleClass, c, classes->Classes)
-		if (strcmp(c->Name, name) == 0)
-		{
-			return c;
-		}
-	CA_FOREACH_END()
-	CASSERT(false, "Cannot find particle class");
-	return NULL;
+	const ParticleClass *c = AssetRegistryGet(
+		&classes->registry, AssetRegistryFind(&classes->registry, name));
+	CASSERT(c != NULL, "Cannot find particle class");
+	return c;
 }
 
-void ParticlesInit(CArray *particles)
+static void ParticlesGrow(Particles *particles, const int capacity);
+void ParticlesInit(Particles *particles)
 {
-	CArrayInit(particles, sizeof(Particle));
-	CArrayReserve(particles, 256);
+	memset(particles, 0, sizeof *particles);
+	ParticlesGrow(particles, 256);
 }
-void ParticlesTerminate(CArray *particles)
+static void ParticlesGrow(Particles *particles, const int capacity)
 {
-	for (int i = 0; i < (int)particles->size; i++)
+	const int oldCapacity = particles->capacity;
+	particles->capacity = capacity;
+	CREALLOC(particles->Id, capacity * sizeof *particles->Id);
+	CREALLOC(particles->Class, capacity * sizeof *particles->Class);
+	CREALLOC(particles->X, capacity * sizeof *particles->X);
+	CREALLOC(particles->Y, capacity * sizeof *particles->Y);
+	CREALLOC(particles->VelX, capacity * sizeof *particles->VelX);
+	CREALLOC(particles->VelY, capacity * sizeof *particles->VelY);
+	CREALLOC(particles->Z, capacity * sizeof *particles->Z);
+	CREALLOC(particles->DZ, capacity * sizeof *particles->DZ);
+	CREALLOC(particles->Gravity, capacity * sizeof *particles->Gravity);
+	CREALLOC(particles->Bounces, capacity * sizeof *particles->Bounces);
+	CREALLOC(particles->Count, capacity * sizeof *particles->Count);
+	CREALLOC(particles->Range, capacity * sizeof *particles->Range);
+	CREALLOC(particles->Angle, capacity * sizeof *particles->Angle);
+	CREALLOC(particles->Spin, capacity * sizeof *particles->Spin);
+	CREALLOC(particles->idIndex, capacity * sizeof *particles->idIndex);
+	CREALLOC(particles->tileItems, capacity * sizeof *particles->tileItems);
+	CREALLOC(particles->freeIds, capacity * sizeof *particles->freeIds);
+	CREALLOC(particles->startPos, capacity * sizeof *particles->startPos);
+	// Push the new ids so that the lowest is used first
+	for (int id = capacity - 1; id >= oldCapacity; id--)
 	{
-		Particle *p = CArrayGet(particles, i);
-		if (p->isInUse)
-		{
-			ParticleDestroy(particles, i);
-		}
+		particles->idIndex[id] = -1;
+		particles->freeIds[particles->freeCount] = id;
+		particles->freeCount++;
+	}
+}
+void ParticlesTerminate(Particles *particles)
+{
+	while (particles->size > 0)
+	{
+		ParticleDestroy(particles, particles->Id[particles->size - 1]);
 	}
-	CArrayTerminate(particles);
+	CFREE(particles->Id);
+	CFREE(particles->Class);
+	CFREE(particles->X);
+	CFREE(particles->Y);
+	CFREE(particles->VelX);
+	CFREE(particles->VelY);
+	CFREE(particles->Z);
+	CFREE(particles->DZ);
+	CFREE(particles->Gravity);
+	CFREE(particles->Bounces);
+	CFREE(particles->Count);
+	CFREE(particles->Range);
+	CFREE(particles->Angle);
+	CFREE(particles->Spin);
+	CFREE(particles->idIndex);
+	CFREE(particles->tileItems);
+	CFREE(particles->freeIds);
+	CFREE(particles->startPos);
+	memset(particles, 0, sizeof *particles);
 }
 
-static bool ParticleUpdate(Particle *p, const int ticks);
-void ParticlesUpdate(CArray *particles, const int ticks)
+static void ParticlesMove(Particles *particles, const int ticks);
+static bool ParticleUpdate(Particles *particles, const int i);
+void ParticlesUpdate(Particles *particles, const int ticks)
 {
-	for (int i = 0; i < (int)particles->size; i++)
+	ParticlesMove(particles, ticks);
+	for (int i = 0; i < particles->size; i++)
 	{
-		Particle *p = CArrayGet(particles, i);
-		if (!p->isInUse)
-		{
-			continue;
-		}
-		if (!ParticleUpdate(p, ticks))
+		if (!ParticleUpdate(particles, i))
 		{
 			GameEvent e = GameEventNew(GAME_EVENT_PARTICLE_REMOVE);
-			e.u.ParticleRemoveId = i;
+			e.u.ParticleRemoveId = particles->Id[i];
 			GameEventsEnqueue(&gGameEvents, e);
 		}
 	}
 }
-
-
-static bool ParticleUpdate(Particle *p, const int ticks)
+static bool ParticleIsAtRest(const int gravity, const int z, const int dz)
 {
-	p->Count += ticks;
-	const Vec2i startPos = p->Pos;
-	for (int i = 0; i < ticks; i++)
+	return gravity != 0 && z == 0 && dz == 0;
+}
+// Move all the particles and apply gravity
+// This only touches the arrays, without branching on the particle class, so
+// that the compiler can vectorise the loops
+static void ParticlesMove(Particles *particles, const int ticks)
+{
+	const int n = particles->size;
+	int *x = particles->X;
+	int *y = particles->Y;
+	int *velX = particles->VelX;
+	int *velY = particles->VelY;
+	int *z = particles->Z;
+	int *dz = particles->DZ;
+	const int *gravity = particles->Gravity;
+	const bool *bounces = particles->Bounces;
+	for (int i = 0; i < n; i++)
+	{
+		particles->startPos[i] = Vec2iNew(x[i], y[i]);
+		particles->Count[i] += ticks;
+	}
+	for (int t = 0; t < ticks; t++)
 	{
-		p->Pos = Vec2iAdd(p->Pos, p->Vel);
-		p->Z += p->DZ;
-		if (p->Class->GravityFactor != 0)
+		for (int i = 0; i < n; i++)
 		{
-			if (p->Z <= 0)
-			{
-				p->Z = 0;
-				if (p->Class->Bounces)
-				{
-					p->DZ = -p->DZ / 2;
-				}
-				else
-				{
-					p->DZ = 0;
-				}
-			}
-			else
-			{
-				p->DZ -= p->Class->GravityFactor;
-			}
-			if (p->DZ == 0 && p->Z == 0)
-			{
-				p->Vel = Vec2iZero();
-				p->Spin = 0;
-				// Set as wreck so that it gets drawn last
-				p->tileItem.flags |= TILEITEM_IS_WRECK;
-			}
+			x[i] += velX[i];
+			y[i] += velY[i];
+			z[i] += dz[i];
+			// Falling particles bounce or stop when they hit the ground
+			const bool hitGround = gravity[i] != 0 && z[i] <= 0;
+			const int bounceDZ = bounces[i] ? -dz[i] / 2 : 0;
+			z[i] = hitGround ? 0 : z[i];
+			dz[i] = hitGround ? bounceDZ : dz[i] - gravity[i];
+			// Particles at rest on the ground stop sliding
+			const bool atRest = ParticleIsAtRest(gravity[i], z[i], dz[i]);
+			velX[i] = atRest ? 0 : velX[i];
+			velY[i] = atRest ? 0 : velY[i];
 		}
 	}
-	if (p->Class->HitsWalls)
+}
+static bool ParticleUpdate(Particles *particles, const int i)
+{
+	const ParticleClass *c = particles->Class[i];
+	Vec2i pos = Vec2iNew(particles->X[i], particles->Y[i]);
+	if (c->HitsWalls)
 	{
-		const Vec2i realPos = Vec2iFull2Real(p->Pos);
+		const Vec2i realPos = Vec2iFull2Real(pos);
 		const bool hitWall =
 			MapIsRealPosIn(&gMap, realPos) && ShootWall(realPos.x, realPos.y);
 		if (hitWall)
 		{
-			if (p->Class->WallBounces)
+			Vec2i vel = Vec2iNew(particles->VelX[i], particles->VelY[i]);
+			if (c->WallBounces)
 			{
-				p->Pos = GetWallBounceFullPos(startPos, p->Pos, &p->Vel);
+				pos = GetWallBounceFullPos(particles->startPos[i], pos, &vel);
 			}
 			else
 			{
-				p->Vel = Vec2iZero();
+				vel = Vec2iZero();
 			}
+			particles->X[i] = pos.x;
+			particles->Y[i] = pos.y;
+			particles->VelX[i] = vel.x;
+			particles->VelY[i] = vel.y;
 		}
 	}
-	const Vec2i realPos = Vec2iFull2Real(p->Pos);
-	if (!MapTryMoveTileItem(&gMap, &p->tileItem, realPos))
+	if (!MapIsRealPosIn(&gMap, Vec2iFull2Real(pos)))
 	{
 		// Out of map; destroy
 		return false;
 	}
 
 	// Spin
-	p->Angle += p->Spin;
-	if (p->Angle > 2 * PI)
+	double *angle = &particles->Angle[i];
+	if (ParticleIsAtRest(
+		particles->Gravity[i], particles->Z[i], particles->DZ[i]))
+	{
+		particles->Spin[i] = 0;
+	}
+	*angle += particles->Spin[i];
+	if (*angle > 2 * PI)
 	{
-		p->Angle -= PI * 2;
+		*angle -= PI * 2;
 	}
-	if (p->Angle < 0)
+	if (*angle < 0)
 	{
-		p->Angle += PI * 2;
+		*angle += PI * 2;
 	}
 
-	return p->Count <= p->Range;
+	return particles->Count[i] <= particles->Range[i];
 }
 
-static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data);
-int ParticleAdd(CArray *particles, const AddParticle add)
+void ParticlesPlaceOnMap(Particles *particles)
 {
-	// Find an empty slot in list
-	Particle *p = NULL;
-	int i;
-	for (i = 0; i < (int)particles->size; i++)
+	for (int i = 0; i < particles->size; i++)
 	{
-		Particle *pSlot = CArrayGet(particles, i);
-		if (!pSlot->isInUse)
+		TTileItem *ti = &particles->tileItems[particles->Id[i]];
+		// Set as wreck so that it gets drawn last
+		if (ParticleIsAtRest(
+			particles->Gravity[i], particles->Z[i], particles->DZ[i]))
 		{
-			p = pSlot;
-			break;
+			ti->flags |= TILEITEM_IS_WRECK;
 		}
+		MapTryMoveTileItem(
+			&gMap, ti,
+			Vec2iFull2Real(Vec2iNew(particles->X[i], particles->Y[i])));
 	}
-	// If no empty slots, add a new one
-	if (p == NULL)
+}
+
+static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data);
+int ParticleAdd(Particles *particles, const AddParticle add)
+{
+	if (particles->freeCount == 0)
+	{
+		ParticlesGrow(particles, particles->capacity * 2);
+	}
+	particles->freeCount--;
+	const int id = particles->freeIds[particles->freeCount];
+	const int i = particles->size;
+	particles->size++;
+	particles->idIndex[id] = i;
+
+	particles->Id[i] = id;
+	particles->Class[i] = add.Class;
+	particles->X[i] = add.FullPos.x;
+	particles->Y[i] = add.FullPos.y;
+	particles->VelX[i] = add.Vel.x;
+	particles->VelY[i] = add.Vel.y;
+	particles->Z[i] = add.Z;
+	particles->DZ[i] = add.DZ;
+	particles->Gravity[i] = add.Class->GravityFactor;
+	particles->Bounces[i] = add.Class->Bounces;
+	particles->Count[i] = 0;
+	particles->Range[i] = RAND_INT(add.Class->RangeLow, add.Class->RangeHigh);
+	particles->Angle[i] = add.Angle;
+	particles->Spin[i] = add.Spin;
+
+	TTileItem *ti = &particles->tileItems[id];
+	memset(ti, 0, sizeof *ti);
+	ti->x = ti->y = -1;
+	ti->kind = KIND_PARTICLE;
+	ti->id = id;
+	ti->drawFunc = DrawParticle;
+	ti->drawData.MobObjId = id;
+	return id;
+}
+void ParticleDestroy(Particles *particles, const int id)
+{
+	const int i = particles->idIndex[id];
+	CASSERT(i >= 0, "Destroying not-in-use particle");
+	MapRemoveTileItem(&gMap, &particles->tileItems[id]);
+	// Move the last particle into the hole to keep the live ones packed
+	const int last = particles->size - 1;
+	if (i != last)
 	{
-		Particle pNew;
-		memset(&pNew, 0, sizeof pNew);
-		CArrayPushBack(particles, &pNew);
-		i = (int)particles->size - 1;
-		p = CArrayGet(particles, i);
+		particles->Id[i] = particles->Id[last];
+		particles->Class[i] = particles->Class[last];
+		particles->X[i] = particles->X[last];
+		particles->Y[i] = particles->Y[last];
+		particles->VelX[i] = particles->VelX[last];
+		particles->VelY[i] = particles->VelY[last];
+		particles->Z[i] = particles->Z[last];
+		particles->DZ[i] = particles->DZ[last];
+		particles->Gravity[i] = particles->Gravity[last];
+		particles->Bounces[i] = particles->Bounces[last];
+		particles->Count[i] = particles->Count[last];
+		particles->Range[i] = particles->Range[last];
+		particles->Angle[i] = particles->Angle[last];
+		particles->Spin[i] = particles->Spin[last];
+		particles->idIndex[particles->Id[i]] = i;
 	}
-	memset(p, 0, sizeof *p);
-	p->Class = add.Class;
-	p->Pos = add.FullPos;
-	p->Z = add.Z;
-	p->Angle = add.Angle;
-	p->Vel = add.Vel;
-	p->DZ = add.DZ;
-	p->Spin = add.Spin;
-	p->Range = RAND_INT(add.Class->RangeLow, add.Class->RangeHigh);
-	p->isInUse = true;
-	p->tileItem.x = p->tileItem.y = -1;
-	p->tileItem.kind = KIND_PARTICLE;
-	p->tileItem.id = i;
-	p->tileItem.drawFunc = DrawParticle;
-	p->tileItem.drawData.MobObjId = i;
-	MapTryMoveTileItem(&gMap, &p->tileItem, Vec2iFull2Real(add.FullPos));
-	return i;
+	particles->size--;
+	particles->idIndex[id] = -1;
+	particles->freeIds[particles->freeCount] = id;
+	particles->freeCount++;
 }
-void ParticleDestroy(CArray *particles, const int id)
+
+TTileItem *ParticleGetTileItem(Particles *particles, const int id)
 {
-	Particle *p = CArrayGet(particles, id);
-	CASSERT(p->isInUse, "Destroying not-in-use particle");
-	MapRemoveTileItem(&gMap, &p->tileItem);
-	p->isInUse = false;
+	CASSERT(particles->idIndex[id] >= 0, "Cannot get non-existent particle");
+	return &particles->tileItems[id];
 }
 
 static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data)
 {
-	const Particle *p = CArrayGet(&gParticles, data->MobObjId);
-	CASSERT(p->isInUse, "Cannot draw non-existent particle");
+	const int i = gParticles.idIndex[data->MobObjId];
+	CASSERT(i >= 0, "Cannot draw non-existent particle");
+	const ParticleClass *c = gParticles.Class[i];
 	const Pic *pic;
-	if (p->Class->Sprites)
+	if (c->Sprites)
 	{
-		int frame = (int)RadiansToDirection(p->Angle);
-		if (p->Class->TicksPerFrame > 0)
+		int frame = (int)RadiansToDirection(gParticles.Angle[i]);
+		if (c->TicksPerFrame > 0)
 		{
 			frame = MIN(
-				p->Count / p->Class->TicksPerFrame,
-				(int)p->Class->Sprites->pics.size - 1);
+				gParticles.Count[i] / c->TicksPerFrame,
+				(int)c->Sprites->pics.size - 1);
 		}
-		pic = CArrayGet(&p->Class->Sprites->pics, frame);
+		pic = CArrayGet(&c->Sprites->pics, frame);
 	}
 	else
 	{
-		pic = p->Class->Pic;
+		pic = c->Pic;
 	}
 	CASSERT(pic != NULL, "particle picture not found");
 	Vec2i picPos = Vec2iMinus(pos, Vec2iScaleDiv(pic->size, 2));
-	picPos.y -= p->Z / Z_FACTOR;
-	BlitMasked(&gGraphicsDevice, pic, picPos, p->Class->Mask, true);
+	picPos.y -= gParticles.Z[i] / Z_FACTOR;
+	BlitMasked(&gGraphicsDevice, pic, picPos, c->Mask, true);
 }
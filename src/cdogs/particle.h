@@ -29,6 +29,7 @@
 
 #include <json/json.h>
 
+#include "asset_registry.h"
 #include "pic.h"
 #include "tile.h"
 
@@ -51,25 +52,43 @@ typedef struct
 {
 	CArray Classes;	// of ParticleClass
 	CArray CustomClasses;	// of ParticleClass
+	AssetRegistry registry;	// of Classes and CustomClasses
 } ParticleClasses;
 extern ParticleClasses gParticleClasses;
 
+// Particles are stored as parallel arrays, one per field, with the live
+// particles packed at the front so that updates only touch live data.
+// Particles are referred to by id, which stays the same for the life of the
+// particle; free ids are kept on a stack for reuse.
 typedef struct
 {
-	const ParticleClass *Class;
+	int size;
+	int capacity;
+	// Per live particle, from 0 to size - 1
+	int *Id;
+	const ParticleClass **Class;
 	// Coordinates are in full
-	Vec2i Pos;
-	int Z;
-	double Angle;
-	Vec2i Vel;
-	int DZ;
-	double Spin;
-	int Count;
-	int Range;
-	TTileItem tileItem;
-	bool isInUse;
-} Particle;
-extern CArray gParticles;	// of Particle
+	int *X;
+	int *Y;
+	int *VelX;
+	int *VelY;
+	int *Z;
+	int *DZ;
+	int *Gravity;
+	bool *Bounces;
+	int *Count;
+	int *Range;
+	double *Angle;
+	double *Spin;
+	// Per id, from 0 to capacity - 1
+	int *idIndex;	// index of the particle with this id; -1 if free
+	TTileItem *tileItems;
+	int *freeIds;
+	int freeCount;
+	// Scratch for the update
+	Vec2i *startPos;
+} Particles;
+extern Particles gParticles;
 
 typedef struct
 {
@@ -89,9 +108,13 @@ void ParticleClassesClear(CArray *classes);
 const ParticleClass *StrParticleClass(
 	const ParticleClasses *classes, const char *name);
 
-void ParticlesInit(CArray *particles);
-void ParticlesTerminate(CArray *particles);
-void ParticlesUpdate(CArray *particles, const int ticks);
+void ParticlesInit(Particles *particles);
+void ParticlesTerminate(Particles *particles);
+void ParticlesUpdate(Particles *particles, const int ticks);
+// Move the particles to the map tiles they are on, so they can be drawn
+// Particles are not on the map otherwise, since they are never collided
+void ParticlesPlaceOnMap(Particles *particles);
 
-int ParticleAdd(CArray *particles, const AddParticle add);
-void ParticleDestroy(CArray *particles, const int id);
+int ParticleAdd(Particles *particles, const AddParticle add);
+void ParticleDestroy(Particles *particles, const int id);
+TTileItem *ParticleGetTileItem(Particles *particles, const int id);
@@ -31,10 +31,25 @@
 
 #include "ai_utils.h"
 
-#define PATH_CACHE_MAX 128
+// Padding around changed map areas, in tiles, when invalidating paths
+// This catches paths that route around the changed area
+#define PATH_CACHE_INVALIDATE_PAD 1
 
 PathCache gPathCache;
 
+typedef struct
+{
+	CachedPath c;	// c.refs is NULL if entry is unused
+	bool ignoreObjects;
+	// Bounding box of path tiles
+	Vec2i min;
+	Vec2i max;
+	// Next entry in hash bucket or free list
+	int next;
+	int lruPrev;
+	int lruNext;
+} PathCacheEntry;
+
 
 static CachedPath CachedPathCopy(CachedPath *c)
 {
@@ -58,38 +73,219 @@ void CachedPathDestroy(CachedPath *c)
 	}
 }
 
-static bool CachedPathMatches(
-	const CachedPath *c, const Vec2i from, const Vec2i to)
+static int HashKey(const Vec2i from, const Vec2i to, const bool ignoreObjects)
+{
+	unsigned h = (unsigned)from.x * 73856093u;
+	h ^= (unsigned)from.y * 19349663u;
+	h ^= (unsigned)to.x * 83492791u;
+	h ^= (unsigned)to.y * 2654435761u;
+	h ^= ignoreObjects ? 0x9e3779b9u : 0;
+	h ^= h >> 16;
+	return (int)(h & (PATH_CACHE_BUCKETS - 1));
+}
+static PathCacheEntry *GetEntry(const PathCache *pc, const int idx)
+{
+	return CArrayGet(&pc->entries, idx);
+}
+
+static void LRUUnlink(PathCache *pc, const int idx)
+{
+	PathCacheEntry *e = GetEntry(pc, idx);
+	if (e->lruPrev >= 0)
+	{
+		GetEntry(pc, e->lruPrev)->lruNext = e->lruNext;
+	}
+	else
+	{
+		pc->lruHead = e->lruNext;
+	}
+	if (e->lruNext >= 0)
+	{
+		GetEntry(pc, e->lruNext)->lruPrev = e->lruPrev;
+	}
+	else
+	{
+		pc->lruTail = e->lruPrev;
+	}
+	e->lruPrev = e->lruNext = -1;
+}
+static void LRUPushFront(PathCache *pc, const int idx)
+{
+	PathCacheEntry *e = GetEntry(pc, idx);
+	e->lruPrev = -1;
+	e->lruNext = pc->lruHead;
+	if (pc->lruHead >= 0)
+	{
+		GetEntry(pc, pc->lruHead)->lruPrev = idx;
+	}
+	pc->lruHead = idx;
+	if (pc->lruTail < 0)
+	{
+		pc->lruTail = idx;
+	}
+}
+
+static int FindEntry(
+	const PathCache *pc,
+	const Vec2i from, const Vec2i to, const bool ignoreObjects)
+{
+	for (int idx = pc->buckets[HashKey(from, to, ignoreObjects)];
+		idx >= 0;
+		idx = GetEntry(pc, idx)->next)
+	{
+		const PathCacheEntry *e = GetEntry(pc, idx);
+		if (Vec2iEqual(e->c.from, from) && Vec2iEqual(e->c.to, to) &&
+			e->ignoreObjects == ignoreObjects)
+		{
+			return idx;
+		}
+	}
+	return -1;
+}
+
+static void RemoveEntry(PathCache *pc, const int idx)
 {
-	return Vec2iEqual(c->from, from) && Vec2iEqual(c->to, to);
+	PathCacheEntry *e = GetEntry(pc, idx);
+	// Unlink from hash bucket
+	int *link = &pc->buckets[HashKey(e->c.from, e->c.to, e->ignoreObjects)];
+	while (*link != idx)
+	{
+		CASSERT(*link >= 0, "path cache entry not in bucket");
+		link = &GetEntry(pc, *link)->next;
+	}
+	*link = e->next;
+	LRUUnlink(pc, idx);
+	CachedPathDestroy(&e->c);
+	e->c.Path = NULL;
+	e->c.refs = NULL;
+	// Add to free list
+	e->next = pc->freeHead;
+	pc->freeHead = idx;
+}
+
+static int AllocEntry(PathCache *pc)
+{
+	if (pc->freeHead < 0)
+	{
+		// Full; evict the least recently used path
+		RemoveEntry(pc, pc->lruTail);
+		pc->Stats.Evictions++;
+	}
+	const int idx = pc->freeHead;
+	pc->freeHead = GetEntry(pc, idx)->next;
+	return idx;
 }
 
 
 void PathCacheInit(PathCache *pc, Map *m)
 {
-	CArrayInit(&pc->paths, sizeof(CachedPath));
-	pc->head = 0;
+	CArrayInit(&pc->entries, sizeof(PathCacheEntry));
+	CArrayResize(&pc->entries, PATH_CACHE_MAX, NULL);
+	CArrayFillZero(&pc->entries);
+	for (int i = 0; i < PATH_CACHE_MAX; i++)
+	{
+		PathCacheEntry *e = GetEntry(pc, i);
+		e->next = i + 1 < PATH_CACHE_MAX ? i + 1 : -1;
+		e->lruPrev = e->lruNext = -1;
+	}
+	pc->freeHead = 0;
+	for (int i = 0; i < PATH_CACHE_BUCKETS; i++)
+	{
+		pc->buckets[i] = -1;
+	}
+	pc->lruHead = pc->lruTail = -1;
+	memset(&pc->Stats, 0, sizeof pc->Stats);
 	pc->map = m;
+	HPAGraphInit(&pc->hpa, m);
 }
 void PathCacheTerminate(PathCache *pc)
 {
+	if (pc->entries.elemSize == 0)
+	{
+		return;
+	}
 	PathCacheClear(pc);
-	CArrayTerminate(&pc->paths);
+	CArrayTerminate(&pc->entries);
+	HPAGraphTerminate(&pc->hpa);
 }
 
 void PathCacheClear(PathCache *pc)
 {
-	CA_FOREACH(CachedPath, c, pc->paths)
-		CachedPathDestroy(c);
-	CA_FOREACH_END()
-	CArrayClear(&pc->paths);
-	pc->head = 0;
+	while (pc->lruHead >= 0)
+	{
+		RemoveEntry(pc, pc->lruHead);
+	}
+}
+
+void PathCacheInvalidate(PathCache *pc, const Vec2i min, const Vec2i max)
+{
+	const Vec2i pad =
+		Vec2iNew(PATH_CACHE_INVALIDATE_PAD, PATH_CACHE_INVALIDATE_PAD);
+	const Vec2i padMin = Vec2iMinus(min, pad);
+	const Vec2i padMax = Vec2iAdd(max, pad);
+	for (int i = 0; i < PATH_CACHE_MAX; i++)
+	{
+		const PathCacheEntry *e = GetEntry(pc, i);
+		if (e->c.refs == NULL)
+		{
+			continue;
+		}
+		const bool failed = ASPathGetCount(e->c.Path) == 0;
+		const bool overlaps =
+			e->min.x <= padMax.x && e->max.x >= padMin.x &&
+			e->min.y <= padMax.y && e->max.y >= padMin.y;
+		if (failed || overlaps)
+		{
+			RemoveEntry(pc, i);
+			pc->Stats.Invalidations++;
+		}
+	}
+}
+
+void PathCacheUpdateTile(PathCache *pc, const Vec2i tile)
+{
+	if (HPAGraphUpdateTile(&pc->hpa, tile))
+	{
+		PathCacheInvalidate(pc, tile, tile);
+	}
+}
+void PathCacheUpdateDoors(PathCache *pc, const int keyFlags)
+{
+	Vec2i v;
+	for (v.y = 0; v.y < pc->map->Size.y; v.y++)
+	{
+		for (v.x = 0; v.x < pc->map->Size.x; v.x++)
+		{
+			const Tile *t = MapGetTile(pc->map, v);
+			if (!(t->flags & MAPTILE_OFFSET_PIC))
+			{
+				continue;
+			}
+			if (MapGetDoorKeycardFlag(pc->map, v) & keyFlags)
+			{
+				PathCacheUpdateTile(pc, v);
+			}
+		}
+	}
+}
+
+void PathCacheStatsPrint(const PathCache *pc, FILE *f)
+{
+	const PathCacheStats *s = &pc->Stats;
+	const int lookups = s->Hits + s->Misses;
+	fprintf(f, "Path cache: %d hits, %d misses (%.1f%% hit rate), "
+		"%d evictions, %d invalidations\n",
+		s->Hits, s->Misses, lookups > 0 ? 100.0 * s->Hits / lookups : 0.0,
+		s->Evictions, s->Invalidations);
 }
 
 typedef struct
 {
 	Map *Map;
 	TileSelectFunc IsTileOk;
+	// Search bounds, inclusive
+	Vec2i Min;
+	Vec2i Max;
 } AStarContext;
 static void AddTileNeighbors(
 	ASNeighborList neighbors, void *node, void *context);
@@ -98,6 +294,17 @@ static ASPathNodeSource cPathNodeSource =
 {
 	sizeof(Vec2i), AddTileNeighbors, AStarHeuristic, NULL, NULL
 };
+ASPath TilePathCreate(
+	Map *map, Vec2i from, Vec2i to, TileSelectFunc isTileOk,
+	const Vec2i min, const Vec2i max)
+{
+	AStarContext ac;
+	ac.Map = map;
+	ac.IsTileOk = isTileOk;
+	ac.Min = Vec2iMax(min, Vec2iZero());
+	ac.Max = Vec2iMin(max, Vec2iMinus(map->Size, Vec2iNew(1, 1)));
+	return ASPathCreate(&cPathNodeSource, &ac, &from, &to);
+}
 CachedPath PathCacheCreate(
 	PathCache *pc, Vec2i from, Vec2i to,
 	const bool ignoreObjects, const bool cache)
@@ -106,22 +313,31 @@ CachedPath PathCacheCreate(
 		from.x, from.y, to.x, to.y);
 
 	// Search through existing cache for path
-	CA_FOREACH(CachedPath, c, pc->paths)
-		if (CachedPathMatches(c, from, to))
-		{
-			debug(D_NORMAL, "returning cached path\n");
-			return CachedPathCopy(c);
-		}
-	CA_FOREACH_END()
+	const int found = FindEntry(pc, from, to, ignoreObjects);
+	if (found >= 0)
+	{
+		debug(D_NORMAL, "returning cached path\n");
+		pc->Stats.Hits++;
+		// Mark as most recently used
+		LRUUnlink(pc, found);
+		LRUPushFront(pc, found);
+		return CachedPathCopy(&GetEntry(pc, found)->c);
+	}
+	pc->Stats.Misses++;
 
 	debug(D_NORMAL, "pathfinding\n");
 
 	// Cached path not found; find the path now
+	// Try the hierarchical search first, as it is much faster for long
+	// paths, falling back to a full search
 	CachedPath cp;
-	AStarContext ac;
-	ac.Map = pc->map;
-	ac.IsTileOk = ignoreObjects ? IsTileWalkable : IsTileWalkableAroundObjects;
-	cp.Path = ASPathCreate(&cPathNodeSource, &ac, &from, &to);
+	const TileSelectFunc isTileOk =
+		ignoreObjects ? IsTileWalkable : IsTileWalkableAroundObjects;
+	if (!HPAGraphFindPath(&pc->hpa, from, to, isTileOk, &cp.Path))
+	{
+		cp.Path = TilePathCreate(
+			pc->map, from, to, isTileOk, Vec2iZero(), pc->map->Size);
+	}
 	CMALLOC(cp.refs, sizeof *cp.refs);
 	(*cp.refs) = 1;
 	cp.from = from;
@@ -130,25 +346,22 @@ CachedPath PathCacheCreate(
 	if (cache)
 	{
 		(*cp.refs)++;
-		// Add to the cache if we are under the max size
-		if ((int)pc->paths.size < PATH_CACHE_MAX)
-		{
-			CArrayPushBack(&pc->paths, &cp);
-		}
-		else
+		const int idx = AllocEntry(pc);
+		PathCacheEntry *e = GetEntry(pc, idx);
+		e->c = cp;
+		e->ignoreObjects = ignoreObjects;
+		e->min = e->max = from;
+		for (size_t i = 0; i < ASPathGetCount(cp.Path); i++)
 		{
-			// Replace the oldest cached path with this one
-			CachedPath *oldest = CArrayGet(&pc->paths, pc->head);
-			CachedPathDestroy(oldest);
-			memcpy(oldest, &cp, sizeof cp);
-			// Move the head
-			pc->head++;
-			if (pc->head == pc->paths.size)
-			{
-				pc->head = 0;
-			}
+			const Vec2i *v = ASPathGetNode(cp.Path, i);
+			e->min = Vec2iMin(e->min, *v);
+			e->max = Vec2iMax(e->max, *v);
 		}
-		debug(D_NORMAL, "Cached pathfind (%d paths)\n", (int)pc->paths.size);
+		const int bucket = HashKey(from, to, ignoreObjects);
+		e->next = pc->buckets[bucket];
+		pc->buckets[bucket] = idx;
+		LRUPushFront(pc, idx);
+		debug(D_NORMAL, "Cached pathfind\n");
 	}
 	return cp;
 }
@@ -162,17 +375,16 @@ static void AddTileNeighbors(
 	for (y = v->y - 1; y <= v->y + 1; y++)
 	{
 		int x;
-		if (y < 0 || y >= c->Map->Size.y)
+		if (y < c->Min.y || y > c->Max.y)
 		{
 			continue;
 		}
 		for (x = v->x - 1; x <= v->x + 1; x++)
 		{
-			float cost;
 			Vec2i neighbor;
 			neighbor.x = x;
 			neighbor.y = y;
-			if (x < 0 || x >= c->Map->Size.x)
+			if (x < c->Min.x || x > c->Max.x)
 			{
 				continue;
 			}
@@ -188,23 +400,7 @@ static void AddTileNeighbors(
 			{
 				continue;
 			}
-			// Calculate cost of direction
-			// Note that there are different horizontal and vertical costs,
-			// due to the tiles being non-square
-			// Slightly prefer axes instead of diagonals
-			if (x != v->x && y != v->y)
-			{
-				cost = TILE_WIDTH * 1.1f;
-			}
-			else if (x != v->x)
-			{
-				cost = TILE_WIDTH;
-			}
-			else
-			{
-				cost = TILE_HEIGHT;
-			}
-			ASNeighborListAdd(neighbors, &neighbor, cost);
+			ASNeighborListAdd(neighbors, &neighbor, PathStepCost(*v, neighbor));
 		}
 	}
 }
@@ -217,3 +413,20 @@ static float AStarHeuristic(void *fromNode, void *toNode, void *context)
 	return (float)sqrt(DistanceSquared(
 		Vec2iCenterOfTile(*v1), Vec2iCenterOfTile(*v2)));
 }
+
+float PathStepCost(const Vec2i from, const Vec2i to)
+{
+	// Calculate cost of direction
+	// Note that there are different horizontal and vertical costs,
+	// due to the tiles being non-square
+	// Slightly prefer axes instead of diagonals
+	if (from.x != to.x && from.y != to.y)
+	{
+		return TILE_WIDTH * 1.1f;
+	}
+	else if (from.x != to.x)
+	{
+		return TILE_WIDTH;
+	}
+	return TILE_HEIGHT;
+}
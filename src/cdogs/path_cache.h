@@ -27,9 +27,12 @@
 */
 #pragma once
 
+#include <stdio.h>
+
 #include "AStar.h"
 #include "c_array.h"
 #include "map.h"
+#include "path_hpa.h"
 #include "vector.h"
 
 // Ref-counted path reference
@@ -42,11 +45,29 @@ typedef struct
 	Vec2i to;
 } CachedPath;
 
+#define PATH_CACHE_MAX 128
+// Number of hash buckets; must be a power of 2
+#define PATH_CACHE_BUCKETS 256
+
 typedef struct
 {
-	CArray paths;	// of CachedPath
-	size_t head;
+	int Hits;
+	int Misses;
+	int Evictions;
+	int Invalidations;
+} PathCacheStats;
+
+typedef struct
+{
+	CArray entries;	// of PathCacheEntry; fixed size PATH_CACHE_MAX
+	int buckets[PATH_CACHE_BUCKETS];	// index of first entry in bucket
+	// Doubly-linked list of used entries, most recently used first
+	int lruHead;
+	int lruTail;
+	int freeHead;
 	Map *map;
+	HPAGraph hpa;
+	PathCacheStats Stats;
 } PathCache;
 
 // Cache of A* paths so similar paths don't need to be recalculated
@@ -60,10 +81,27 @@ void PathCacheInit(PathCache *pc, Map *m);
 void PathCacheTerminate(PathCache *pc);
 
 // Clear all entries in cache
-// This is done when the underlying map changes, changing paths
-// e.g. keys
 void PathCacheClear(PathCache *pc);
+// Remove cached paths that may be affected by a change to the map in the
+// tile area min-max (inclusive), e.g. doors opened by keys
+// This removes paths that pass near the area, as well as failed paths, which
+// may now succeed.
+void PathCacheInvalidate(PathCache *pc, const Vec2i min, const Vec2i max);
+// Update after a map tile has changed, e.g. doors, invalidating paths if
+// the tile's walkability has changed
+void PathCacheUpdateTile(PathCache *pc, const Vec2i tile);
+// Update doors that can be opened by keys
+void PathCacheUpdateDoors(PathCache *pc, const int keyFlags);
 
 CachedPath PathCacheCreate(
 	PathCache *pc, Vec2i from, Vec2i to,
-	const bool ignoreObjects, const bool cache);
\ No newline at end of file
+	const bool ignoreObjects, const bool cache);
+
+void PathCacheStatsPrint(const PathCache *pc, FILE *f);
+
+// Find a tile path using A*, within an area (inclusive)
+ASPath TilePathCreate(
+	Map *map, Vec2i from, Vec2i to, TileSelectFunc isTileOk,
+	const Vec2i min, const Vec2i max);
+// Cost of moving between adjacent tiles
+float PathStepCost(const Vec2i from, const Vec2i to);
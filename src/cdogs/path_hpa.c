@@ -0,0 +1,707 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "path_hpa.h"
+
+#include <math.h>
+
+#include "ai_utils.h"
+#include "path_cache.h"
+
+// Maximum spacing between entrances along a border stretch
+// Short stretches get a single entrance in the middle
+#define HPA_ENTRANCE_SPACING 5
+#define HPA_CLUSTER_TILES (HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE)
+
+// Special cluster indices for the start and goal of a search
+#define HPA_START -1
+#define HPA_GOAL -2
+
+
+static HPACluster *GetCluster(const HPAGraph *g, const int idx)
+{
+	return CArrayGet(&g->clusters, idx);
+}
+static int ClusterIndexOfTile(const HPAGraph *g, const Vec2i v)
+{
+	return (v.y / HPA_CLUSTER_SIZE) * g->NumClusters.x + v.x / HPA_CLUSTER_SIZE;
+}
+static bool IsWalkable(const HPAGraph *g, const Vec2i v)
+{
+	if (!MapIsTileIn(g->map, v))
+	{
+		return false;
+	}
+	return *(bool *)CArrayGet(&g->walkable, v.y * g->map->Size.x + v.x);
+}
+static bool IsInCluster(const HPACluster *c, const Vec2i v)
+{
+	return v.x >= c->Pos.x && v.x < c->Pos.x + c->Size.x &&
+		v.y >= c->Pos.y && v.y < c->Pos.y + c->Size.y;
+}
+
+static void ClusterClearGraph(HPACluster *c)
+{
+	const int n = (int)c->Nodes.size;
+	if (c->paths != NULL)
+	{
+		for (int i = 0; i < n * n; i++)
+		{
+			ASPathDestroy(c->paths[i]);
+		}
+	}
+	CFREE(c->paths);
+	c->paths = NULL;
+	CFREE(c->costs);
+	c->costs = NULL;
+	CArrayClear(&c->Nodes);
+}
+
+
+void HPAGraphInit(HPAGraph *g, Map *map)
+{
+	memset(g, 0, sizeof *g);
+	g->map = map;
+	g->NumClusters = Vec2iNew(
+		(map->Size.x + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE,
+		(map->Size.y + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE);
+}
+void HPAGraphTerminate(HPAGraph *g)
+{
+	if (g->isBuilt)
+	{
+		CA_FOREACH(HPACluster, c, g->clusters)
+			ClusterClearGraph(c);
+			CArrayTerminate(&c->Nodes);
+		CA_FOREACH_END()
+		CArrayTerminate(&g->clusters);
+	}
+	if (g->walkable.elemSize > 0)
+	{
+		CArrayTerminate(&g->walkable);
+	}
+	memset(g, 0, sizeof *g);
+}
+
+// Take a snapshot of static walkability on first use, since the map tiles
+// are not set up when the graph is initialised
+static void EnsureWalkable(HPAGraph *g)
+{
+	if (g->walkable.elemSize > 0)
+	{
+		return;
+	}
+	CArrayInit(&g->walkable, sizeof(bool));
+	Vec2i v;
+	for (v.y = 0; v.y < g->map->Size.y; v.y++)
+	{
+		for (v.x = 0; v.x < g->map->Size.x; v.x++)
+		{
+			const bool w = IsTileWalkableOrOpenable(g->map, v);
+			CArrayPushBack(&g->walkable, &w);
+		}
+	}
+}
+
+static void MarkDirty(HPAGraph *g, const Vec2i cluster)
+{
+	if (cluster.x < 0 || cluster.x >= g->NumClusters.x ||
+		cluster.y < 0 || cluster.y >= g->NumClusters.y)
+	{
+		return;
+	}
+	GetCluster(g, cluster.y * g->NumClusters.x + cluster.x)->isDirty = true;
+}
+bool HPAGraphUpdateTile(HPAGraph *g, const Vec2i tile)
+{
+	if (!MapIsTileIn(g->map, tile))
+	{
+		return false;
+	}
+	EnsureWalkable(g);
+	bool *w = CArrayGet(&g->walkable, tile.y * g->map->Size.x + tile.x);
+	const bool walkable = IsTileWalkableOrOpenable(g->map, tile);
+	if (*w == walkable)
+	{
+		return false;
+	}
+	*w = walkable;
+	if (g->isBuilt)
+	{
+		// Rebuild the tile's cluster, as well as neighbours sharing a border
+		// with the tile, since their entrances may change
+		const Vec2i c = Vec2iScaleDiv(tile, HPA_CLUSTER_SIZE);
+		const Vec2i local = Vec2iMinus(tile, Vec2iScale(c, HPA_CLUSTER_SIZE));
+		MarkDirty(g, c);
+		if (local.x == 0) MarkDirty(g, Vec2iNew(c.x - 1, c.y));
+		if (local.x == HPA_CLUSTER_SIZE - 1) MarkDirty(g, Vec2iNew(c.x + 1, c.y));
+		if (local.y == 0) MarkDirty(g, Vec2iNew(c.x, c.y - 1));
+		if (local.y == HPA_CLUSTER_SIZE - 1) MarkDirty(g, Vec2iNew(c.x, c.y + 1));
+	}
+	return true;
+}
+
+static bool StepIsOk(
+	Map *map, TileSelectFunc isTileOk, const Vec2i from, const Vec2i to)
+{
+	// Same rules as tile A*: if moving diagonally, the axis-aligned
+	// neighbours also need to be clear
+	return isTileOk(map, to) &&
+		isTileOk(map, Vec2iNew(from.x, to.y)) &&
+		isTileOk(map, Vec2iNew(to.x, from.y));
+}
+static bool StaticStepIsOk(const HPAGraph *g, const Vec2i from, const Vec2i to)
+{
+	return IsWalkable(g, to) &&
+		IsWalkable(g, Vec2iNew(from.x, to.y)) &&
+		IsWalkable(g, Vec2iNew(to.x, from.y));
+}
+
+typedef struct
+{
+	float Dist;
+	int Idx;
+} HeapItem;
+static void HeapPush(HeapItem *heap, int *size, const HeapItem item)
+{
+	int i = (*size)++;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (heap[parent].Dist <= item.Dist) break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = item;
+}
+static HeapItem HeapPop(HeapItem *heap, int *size)
+{
+	const HeapItem top = heap[0];
+	const HeapItem last = heap[--(*size)];
+	int i = 0;
+	for (;;)
+	{
+		int child = 2 * i + 1;
+		if (child >= *size) break;
+		if (child + 1 < *size && heap[child + 1].Dist < heap[child].Dist)
+		{
+			child++;
+		}
+		if (last.Dist <= heap[child].Dist) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return top;
+}
+// Calculate the cost from a tile to all other tiles in a cluster, using
+// static walkability; unreachable tiles are set to a negative cost
+static void ClusterDijkstra(
+	const HPAGraph *g, const HPACluster *c, const Vec2i source,
+	float *dist)
+{
+	HeapItem heap[HPA_CLUSTER_TILES * 8 + 1];
+	int heapSize = 0;
+	for (int i = 0; i < c->Size.x * c->Size.y; i++)
+	{
+		dist[i] = -1;
+	}
+	const Vec2i srcLocal = Vec2iMinus(source, c->Pos);
+	const int src = srcLocal.y * c->Size.x + srcLocal.x;
+	dist[src] = 0;
+	HeapItem start = { 0, src };
+	HeapPush(heap, &heapSize, start);
+	while (heapSize > 0)
+	{
+		const HeapItem item = HeapPop(heap, &heapSize);
+		if (item.Dist > dist[item.Idx])
+		{
+			continue;
+		}
+		const Vec2i v = Vec2iAdd(
+			c->Pos, Vec2iNew(item.Idx % c->Size.x, item.Idx / c->Size.x));
+		Vec2i w;
+		for (w.y = v.y - 1; w.y <= v.y + 1; w.y++)
+		{
+			for (w.x = v.x - 1; w.x <= v.x + 1; w.x++)
+			{
+				if (Vec2iEqual(v, w) || !IsInCluster(c, w) ||
+					!StaticStepIsOk(g, v, w))
+				{
+					continue;
+				}
+				const Vec2i wLocal = Vec2iMinus(w, c->Pos);
+				const int wIdx = wLocal.y * c->Size.x + wLocal.x;
+				const float d = item.Dist + PathStepCost(v, w);
+				if (dist[wIdx] < 0 || d < dist[wIdx])
+				{
+					dist[wIdx] = d;
+					HeapItem next = { d, wIdx };
+					HeapPush(heap, &heapSize, next);
+				}
+			}
+		}
+	}
+}
+static float ClusterDist(
+	const HPACluster *c, const float *dist, const Vec2i v)
+{
+	const Vec2i local = Vec2iMinus(v, c->Pos);
+	return dist[local.y * c->Size.x + local.x];
+}
+
+static void AddBorderNodes(
+	HPAGraph *g, HPACluster *c, const Vec2i start, const Vec2i step,
+	const Vec2i across, const int length);
+static void ClusterRebuild(HPAGraph *g, HPACluster *c)
+{
+	ClusterClearGraph(c);
+
+	// Find entrances along each border
+	const Vec2i right = Vec2iNew(1, 0);
+	const Vec2i down = Vec2iNew(0, 1);
+	AddBorderNodes(
+		g, c, c->Pos, down, Vec2iNew(-1, 0), c->Size.y);
+	AddBorderNodes(
+		g, c, Vec2iNew(c->Pos.x + c->Size.x - 1, c->Pos.y), down,
+		Vec2iNew(1, 0), c->Size.y);
+	AddBorderNodes(
+		g, c, c->Pos, right, Vec2iNew(0, -1), c->Size.x);
+	AddBorderNodes(
+		g, c, Vec2iNew(c->Pos.x, c->Pos.y + c->Size.y - 1), right,
+		Vec2iNew(0, 1), c->Size.x);
+
+	// Precompute costs between entrances
+	const int n = (int)c->Nodes.size;
+	if (n > 0)
+	{
+		CMALLOC(c->costs, n * n * sizeof *c->costs);
+		CCALLOC(c->paths, n * n * sizeof *c->paths);
+	}
+	float dist[HPA_CLUSTER_TILES];
+	for (int i = 0; i < n; i++)
+	{
+		const HPANode *from = CArrayGet(&c->Nodes, i);
+		ClusterDijkstra(g, c, from->Tile, dist);
+		for (int j = 0; j < n; j++)
+		{
+			const HPANode *to = CArrayGet(&c->Nodes, j);
+			c->costs[i * n + j] = ClusterDist(c, dist, to->Tile);
+		}
+	}
+	c->isDirty = false;
+}
+static void AddBorderNode(
+	HPAGraph *g, HPACluster *c, const Vec2i v, const Vec2i across);
+static void AddBorderNodes(
+	HPAGraph *g, HPACluster *c, const Vec2i start, const Vec2i step,
+	const Vec2i across, const int length)
+{
+	// Check that there's a cluster across this border
+	if (!MapIsTileIn(g->map, Vec2iAdd(start, across)))
+	{
+		return;
+	}
+	// Find stretches where both sides of the border are walkable,
+	// and place entrances on them
+	int runStart = -1;
+	for (int i = 0; i <= length; i++)
+	{
+		const Vec2i v = Vec2iAdd(start, Vec2iScale(step, i));
+		const bool open = i < length &&
+			IsWalkable(g, v) && IsWalkable(g, Vec2iAdd(v, across));
+		if (open)
+		{
+			if (runStart < 0) runStart = i;
+			continue;
+		}
+		if (runStart < 0)
+		{
+			continue;
+		}
+		// Spread entrances evenly along the stretch
+		const int runLength = i - runStart;
+		const int count = (runLength - 1) / HPA_ENTRANCE_SPACING + 1;
+		for (int j = 0; j < count; j++)
+		{
+			const int offset = count == 1 ?
+				runLength / 2 : j * (runLength - 1) / (count - 1);
+			AddBorderNode(
+				g, c, Vec2iAdd(start, Vec2iScale(step, runStart + offset)),
+				across);
+		}
+		runStart = -1;
+	}
+}
+static void AddBorderNode(
+	HPAGraph *g, HPACluster *c, const Vec2i v, const Vec2i across)
+{
+	HPANode n;
+	n.Tile = v;
+	n.Partner = Vec2iAdd(v, across);
+	n.PartnerCluster = ClusterIndexOfTile(g, n.Partner);
+	CArrayPushBack(&c->Nodes, &n);
+}
+
+static void Build(HPAGraph *g)
+{
+	CArrayInit(&g->clusters, sizeof(HPACluster));
+	Vec2i v;
+	for (v.y = 0; v.y < g->NumClusters.y; v.y++)
+	{
+		for (v.x = 0; v.x < g->NumClusters.x; v.x++)
+		{
+			HPACluster c;
+			memset(&c, 0, sizeof c);
+			c.Pos = Vec2iScale(v, HPA_CLUSTER_SIZE);
+			c.Size = Vec2iMin(
+				Vec2iNew(HPA_CLUSTER_SIZE, HPA_CLUSTER_SIZE),
+				Vec2iMinus(g->map->Size, c.Pos));
+			CArrayInit(&c.Nodes, sizeof(HPANode));
+			c.isDirty = true;
+			CArrayPushBack(&g->clusters, &c);
+		}
+	}
+	g->isBuilt = true;
+}
+static void Update(HPAGraph *g)
+{
+	if (!g->isBuilt)
+	{
+		Build(g);
+	}
+	CA_FOREACH(HPACluster, c, g->clusters)
+		if (c->isDirty)
+		{
+			ClusterRebuild(g, c);
+		}
+	CA_FOREACH_END()
+}
+
+
+// Abstract graph search
+typedef struct
+{
+	int Cluster;
+	int Index;
+} HPAKey;
+typedef struct
+{
+	HPAGraph *g;
+	Vec2i From;
+	Vec2i To;
+	int FromCluster;
+	int ToCluster;
+	// Costs from start / to goal for entrances in their clusters
+	float *FromCosts;
+	float *ToCosts;
+	// Cost from start to goal within the same cluster
+	float DirectCost;
+} HPASearch;
+static Vec2i KeyTile(const HPASearch *s, const HPAKey *k)
+{
+	switch (k->Cluster)
+	{
+	case HPA_START:
+		return s->From;
+	case HPA_GOAL:
+		return s->To;
+	default:
+		{
+			const HPACluster *c = GetCluster(s->g, k->Cluster);
+			return ((const HPANode *)CArrayGet(&c->Nodes, k->Index))->Tile;
+		}
+	}
+}
+static void AddNeighbor(
+	ASNeighborList neighbors, const int cluster, const int idx,
+	const float cost)
+{
+	HPAKey k;
+	k.Cluster = cluster;
+	k.Index = idx;
+	ASNeighborListAdd(neighbors, &k, cost);
+}
+static void AddAbstractNeighbors(
+	ASNeighborList neighbors, void *node, void *context)
+{
+	const HPAKey *k = node;
+	const HPASearch *s = context;
+	if (k->Cluster == HPA_START)
+	{
+		const HPACluster *c = GetCluster(s->g, s->FromCluster);
+		for (int j = 0; j < (int)c->Nodes.size; j++)
+		{
+			if (s->FromCosts[j] >= 0)
+			{
+				AddNeighbor(neighbors, s->FromCluster, j, s->FromCosts[j]);
+			}
+		}
+		if (s->DirectCost >= 0)
+		{
+			AddNeighbor(neighbors, HPA_GOAL, 0, s->DirectCost);
+		}
+		return;
+	}
+	if (k->Cluster == HPA_GOAL)
+	{
+		return;
+	}
+	const HPACluster *c = GetCluster(s->g, k->Cluster);
+	const int n = (int)c->Nodes.size;
+	const HPANode *hn = CArrayGet(&c->Nodes, k->Index);
+	// Intra-cluster edges
+	for (int j = 0; j < n; j++)
+	{
+		const float cost = c->costs[k->Index * n + j];
+		if (j != k->Index && cost >= 0)
+		{
+			AddNeighbor(neighbors, k->Cluster, j, cost);
+		}
+	}
+	// Inter-cluster edge to the partner entrance
+	const HPACluster *pc = GetCluster(s->g, hn->PartnerCluster);
+	CA_FOREACH(const HPANode, pn, pc->Nodes)
+		if (Vec2iEqual(pn->Tile, hn->Partner) &&
+			Vec2iEqual(pn->Partner, hn->Tile))
+		{
+			AddNeighbor(
+				neighbors, hn->PartnerCluster, _ca_index,
+				PathStepCost(hn->Tile, hn->Partner));
+			break;
+		}
+	CA_FOREACH_END()
+	if (k->Cluster == s->ToCluster && s->ToCosts[k->Index] >= 0)
+	{
+		AddNeighbor(neighbors, HPA_GOAL, 0, s->ToCosts[k->Index]);
+	}
+}
+static float AbstractHeuristic(void *fromNode, void *toNode, void *context)
+{
+	const HPASearch *s = context;
+	return (float)sqrt(DistanceSquared(
+		Vec2iCenterOfTile(KeyTile(s, fromNode)),
+		Vec2iCenterOfTile(KeyTile(s, toNode))));
+}
+static ASPathNodeSource cAbstractNodeSource =
+{
+	sizeof(HPAKey), AddAbstractNeighbors, AbstractHeuristic, NULL, NULL
+};
+
+static float *ClusterCostsFrom(
+	const HPAGraph *g, const HPACluster *c, const Vec2i v, float *direct,
+	const Vec2i other)
+{
+	float dist[HPA_CLUSTER_TILES];
+	ClusterDijkstra(g, c, v, dist);
+	float *costs = NULL;
+	const int n = (int)c->Nodes.size;
+	if (n > 0)
+	{
+		CMALLOC(costs, n * sizeof *costs);
+	}
+	for (int i = 0; i < n; i++)
+	{
+		const HPANode *hn = CArrayGet(&c->Nodes, i);
+		costs[i] = ClusterDist(c, dist, hn->Tile);
+	}
+	if (direct != NULL)
+	{
+		*direct = IsInCluster(c, other) ? ClusterDist(c, dist, other) : -1;
+	}
+	return costs;
+}
+
+static bool AppendTilePath(
+	CArray *tiles, float *cost, ASPath p, Map *map, TileSelectFunc isTileOk);
+static ASPath GetIntraPath(
+	HPAGraph *g, HPACluster *c, const int i, const int j);
+static bool RefinePath(
+	HPAGraph *g, const HPASearch *s, ASPath abstract,
+	TileSelectFunc isTileOk, ASPath *path);
+bool HPAGraphFindPath(
+	HPAGraph *g, const Vec2i from, const Vec2i to, TileSelectFunc isTileOk,
+	ASPath *path)
+{
+	if (!MapIsTileIn(g->map, from) || !MapIsTileIn(g->map, to))
+	{
+		return false;
+	}
+	EnsureWalkable(g);
+	// Only use for paths spanning several clusters; for shorter paths
+	// a full search is fast enough and gives optimal results
+	const Vec2i fromC = Vec2iScaleDiv(from, HPA_CLUSTER_SIZE);
+	const Vec2i toC = Vec2iScaleDiv(to, HPA_CLUSTER_SIZE);
+	if (abs(fromC.x - toC.x) <= 1 && abs(fromC.y - toC.y) <= 1)
+	{
+		return false;
+	}
+	// The goal needs to be walkable, like in a full search
+	if (!isTileOk(g->map, to))
+	{
+		*path = NULL;
+		return true;
+	}
+	Update(g);
+
+	HPASearch s;
+	s.g = g;
+	s.From = from;
+	s.To = to;
+	s.FromCluster = ClusterIndexOfTile(g, from);
+	s.ToCluster = ClusterIndexOfTile(g, to);
+	s.FromCosts = ClusterCostsFrom(
+		g, GetCluster(g, s.FromCluster), from, &s.DirectCost, to);
+	s.ToCosts = ClusterCostsFrom(g, GetCluster(g, s.ToCluster), to, NULL, to);
+
+	HPAKey startKey = { HPA_START, 0 };
+	HPAKey goalKey = { HPA_GOAL, 0 };
+	ASPath abstract =
+		ASPathCreate(&cAbstractNodeSource, &s, &startKey, &goalKey);
+	bool ok = true;
+	if (ASPathGetCount(abstract) == 0)
+	{
+		// No path even ignoring objects; a full search would also fail
+		*path = NULL;
+	}
+	else
+	{
+		ok = RefinePath(g, &s, abstract, isTileOk, path);
+	}
+	ASPathDestroy(abstract);
+	CFREE(s.FromCosts);
+	CFREE(s.ToCosts);
+	return ok;
+}
+static bool RefinePath(
+	HPAGraph *g, const HPASearch *s, ASPath abstract,
+	TileSelectFunc isTileOk, ASPath *path)
+{
+	CArray tiles;
+	CArrayInit(&tiles, sizeof(Vec2i));
+	CArrayPushBack(&tiles, &s->From);
+	float cost = 0;
+	bool ok = true;
+	for (size_t i = 0; ok && i + 1 < ASPathGetCount(abstract); i++)
+	{
+		const HPAKey *a = ASPathGetNode(abstract, i);
+		const HPAKey *b = ASPathGetNode(abstract, i + 1);
+		const Vec2i aTile = KeyTile(s, a);
+		const Vec2i bTile = KeyTile(s, b);
+		if (Vec2iEqual(aTile, bTile))
+		{
+			continue;
+		}
+		if (a->Cluster >= 0 && a->Cluster == b->Cluster)
+		{
+			// Between entrances; try the cached path first
+			HPACluster *c = GetCluster(g, a->Cluster);
+			ASPath p = GetIntraPath(g, c, a->Index, b->Index);
+			if (!AppendTilePath(&tiles, &cost, p, g->map, isTileOk))
+			{
+				// Blocked by objects; search again within the cluster
+				p = TilePathCreate(
+					g->map, aTile, bTile, isTileOk, c->Pos,
+					Vec2iAdd(c->Pos, Vec2iMinus(c->Size, Vec2iNew(1, 1))));
+				ok = AppendTilePath(&tiles, &cost, p, g->map, isTileOk);
+				ASPathDestroy(p);
+			}
+		}
+		else if (a->Cluster >= 0 && b->Cluster >= 0)
+		{
+			// Crossing a border
+			ok = StepIsOk(g->map, isTileOk, aTile, bTile);
+			if (ok)
+			{
+				CArrayPushBack(&tiles, &bTile);
+				cost += PathStepCost(aTile, bTile);
+			}
+		}
+		else
+		{
+			// From the start or to the goal; search within the cluster
+			const HPACluster *c = GetCluster(
+				g, a->Cluster == HPA_START ? s->FromCluster : s->ToCluster);
+			ASPath p = TilePathCreate(
+				g->map, aTile, bTile, isTileOk, c->Pos,
+				Vec2iAdd(c->Pos, Vec2iMinus(c->Size, Vec2iNew(1, 1))));
+			ok = AppendTilePath(&tiles, &cost, p, g->map, isTileOk);
+			ASPathDestroy(p);
+		}
+	}
+	if (ok)
+	{
+		*path = ASPathCreateFromNodes(
+			sizeof(Vec2i), tiles.data, tiles.size, cost);
+	}
+	CArrayTerminate(&tiles);
+	return ok;
+}
+// Append a tile path, excluding its first tile which should be the last
+// tile so far; fails if any step is blocked
+static bool AppendTilePath(
+	CArray *tiles, float *cost, ASPath p, Map *map, TileSelectFunc isTileOk)
+{
+	const size_t count = ASPathGetCount(p);
+	if (count == 0)
+	{
+		return false;
+	}
+	const size_t origSize = tiles->size;
+	const float origCost = *cost;
+	for (size_t i = 1; i < count; i++)
+	{
+		const Vec2i *prev = ASPathGetNode(p, i - 1);
+		const Vec2i *v = ASPathGetNode(p, i);
+		if (!StepIsOk(map, isTileOk, *prev, *v))
+		{
+			tiles->size = origSize;
+			*cost = origCost;
+			return false;
+		}
+		CArrayPushBack(tiles, v);
+		*cost += PathStepCost(*prev, *v);
+	}
+	return true;
+}
+static ASPath GetIntraPath(
+	HPAGraph *g, HPACluster *c, const int i, const int j)
+{
+	const int n = (int)c->Nodes.size;
+	ASPath *p = &c->paths[i * n + j];
+	if (*p == NULL)
+	{
+		// Lazily find the path between entrances, ignoring objects
+		const HPANode *a = CArrayGet(&c->Nodes, i);
+		const HPANode *b = CArrayGet(&c->Nodes, j);
+		*p = TilePathCreate(
+			g->map, a->Tile, b->Tile, IsTileWalkableOrOpenable, c->Pos,
+			Vec2iAdd(c->Pos, Vec2iMinus(c->Size, Vec2iNew(1, 1))));
+	}
+	return *p;
+}
@@ -0,0 +1,92 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include "AStar.h"
+#include "c_array.h"
+#include "map.h"
+#include "vector.h"
+
+// Hierarchical pathfinding (HPA*)
+// The map is split into square clusters of tiles; entrances are placed on
+// walkable stretches of cluster borders, and the costs between entrances
+// within each cluster are precomputed. Long paths are found by searching
+// this much smaller graph first, then refining each step to tiles.
+//
+// The graph only considers static walkability (walls, doors and keys); the
+// refined path is checked against objects, and callers should fall back to
+// a full search if that fails.
+
+#define HPA_CLUSTER_SIZE 16
+
+typedef struct
+{
+	Vec2i Tile;
+	// The entrance tile on the other side of the border
+	Vec2i Partner;
+	int PartnerCluster;
+} HPANode;
+
+typedef struct
+{
+	Vec2i Pos;	// origin tile
+	Vec2i Size;
+	CArray Nodes;	// of HPANode
+	// Costs between each pair of nodes; negative if unreachable
+	float *costs;
+	// Tile paths between each pair of nodes, computed on first use
+	ASPath *paths;
+	bool isDirty;
+} HPACluster;
+
+typedef struct
+{
+	Map *map;
+	Vec2i NumClusters;
+	CArray clusters;	// of HPACluster
+	CArray walkable;	// of bool; static walkability as of the last update
+	bool isBuilt;
+} HPAGraph;
+
+void HPAGraphInit(HPAGraph *g, Map *map);
+void HPAGraphTerminate(HPAGraph *g);
+
+// Update the static walkability of a tile, e.g. after tile changes or keys
+// Affected clusters are rebuilt on the next search
+// Returns whether the walkability changed
+bool HPAGraphUpdateTile(HPAGraph *g, const Vec2i tile);
+
+// Find a path using the hierarchical graph
+// Returns false if the hierarchical search is not suitable or the refined
+// path is blocked, in which case a full search should be used instead
+bool HPAGraphFindPath(
+	HPAGraph *g, const Vec2i from, const Vec2i to, TileSelectFunc isTileOk,
+	ASPath *path);
@@ -32,7 +32,7 @@
 #include "grafx.h"
 #include "utils.h"
 
-Pic picNone = { { 0, 0 }, { 0, 0 }, NULL };
+Pic picNone = { { 0, 0 }, { 0, 0 }, NULL, false };
 
 
 color_t PixelToColor(
@@ -53,36 +53,76 @@ Uint32 ColorToPixel(
 }
 
 
+static Uint32 SurfacePixel(const SDL_Surface *image, const int i);
 void PicLoad(
 	Pic *p, const Vec2i size, const Vec2i offset, const SDL_Surface *image)
 {
 	p->size = size;
 	p->offset = Vec2iZero();
+	p->packed = false;
 	CMALLOC(p->Data, size.x * size.y * sizeof *((Pic *)0)->Data);
 	// Manually copy the pixels and replace the alpha component,
 	// since our gfx device format has no alpha
 	int srcI = offset.y*image->w + offset.x;
 	for (int i = 0; i < size.x * size.y; i++, srcI++)
 	{
-		const Uint32 pixel = ((Uint32 *)image->pixels)[srcI];
-		color_t c;
-		SDL_GetRGBA(pixel, image->format, &c.r, &c.g, &c.b, &c.a);
-		// If completely transparent, replace rgb with black (0) too
-		// This is because transparency blitting checks entire pixel
-		if (c.a == 0)
-		{
-			p->Data[i] = 0;
-		}
-		else
-		{
-			p->Data[i] = COLOR2PIXEL(c);
-		}
+		p->Data[i] = SurfacePixel(image, srcI);
 		if ((i + 1) % size.x == 0)
 		{
 			srcI += image->w - size.x;
 		}
 	}
 }
+static Uint32 SurfacePixel(const SDL_Surface *image, const int i)
+{
+	const Uint32 pixel = ((Uint32 *)image->pixels)[i];
+	color_t c;
+	SDL_GetRGBA(pixel, image->format, &c.r, &c.g, &c.b, &c.a);
+	// If completely transparent, replace rgb with black (0) too
+	// This is because transparency blitting checks entire pixel
+	if (c.a == 0)
+	{
+		return 0;
+	}
+	return COLOR2PIXEL(c);
+}
+
+PicImage *PicImageNew(SDL_Surface *image)
+{
+	PicImage *pi;
+	const int count = image->w * image->h;
+	CMALLOC(pi, sizeof *pi + count * sizeof *pi->Pixels);
+	pi->Size = Vec2iNew(image->w, image->h);
+	SDL_LockSurface(image);
+	for (int i = 0; i < count; i++)
+	{
+		pi->Pixels[i] = SurfacePixel(image, i);
+	}
+	SDL_UnlockSurface(image);
+	return pi;
+}
+size_t PicImageSize(const PicImage *image)
+{
+	return sizeof *image + image->Size.x * image->Size.y * sizeof *image->Pixels;
+}
+void PicLoadImage(
+	Pic *p, const Vec2i size, const Vec2i offset, const PicImage *image)
+{
+	p->size = size;
+	p->offset = Vec2iZero();
+	p->packed = false;
+	CMALLOC(p->Data, size.x * size.y * sizeof *p->Data);
+	// Copy whole rows; pixels outside the image are left transparent
+	memset(p->Data, 0, size.x * size.y * sizeof *p->Data);
+	const int w = MIN(size.x, image->Size.x - offset.x);
+	for (int y = 0; y < size.y && offset.y + y < image->Size.y; y++)
+	{
+		memcpy(
+			p->Data + y * size.x,
+			image->Pixels + (offset.y + y) * image->Size.x + offset.x,
+			w * sizeof *p->Data);
+	}
+}
 
 Pic PicCopy(const Pic *src)
 {
@@ -90,12 +130,16 @@ Pic PicCopy(const Pic *src)
 	const size_t size = p.size.x * p.size.y * sizeof *p.Data;
 	CMALLOC(p.Data, size);
 	memcpy(p.Data, src->Data, size);
+	p.packed = false;
 	return p;
 }
 
 void PicFree(Pic *pic)
 {
-	CFREE(pic->Data);
+	if (!pic->packed)
+	{
+		CFREE(pic->Data);
+	}
 }
 
 bool PicIsNone(const Pic *pic)
@@ -152,8 +196,9 @@ void PicTrim(Pic *pic, const bool xTrim, const bool yTrim)
 		}
 	}
 	// Replace the old data
-	CFREE(pic->Data);
+	PicFree(pic);
 	pic->Data = newData;
+	pic->packed = false;
 	pic->size = newSize;
 	pic->offset = Vec2iZero();
 }
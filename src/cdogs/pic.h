@@ -25,6 +25,8 @@
 */
 #pragma once
 
+#include <stdbool.h>
+
 #include <SDL_surface.h>
 
 #include "vector.h"
@@ -34,10 +36,19 @@ typedef struct
 	Vec2i size;
 	Vec2i offset;
 	Uint32 *Data;
+	bool packed;	// Data is borrowed, e.g. from an atlas page, and not freed
 } Pic;
 
 extern Pic picNone;
 
+// Whole image in the graphics device's pixel format, to be cut into pics
+// Plain data in a single allocation, so that it can be cached as-is
+typedef struct
+{
+	Vec2i Size;
+	Uint32 Pixels[];
+} PicImage;
+
 color_t PixelToColor(
 	const SDL_PixelFormat *f, const Uint8 aShift, const Uint32 pixel);
 Uint32 ColorToPixel(
@@ -49,6 +60,10 @@ Uint32 ColorToPixel(
 
 void PicLoad(
 	Pic *p, const Vec2i size, const Vec2i offset, const SDL_Surface *image);
+PicImage *PicImageNew(SDL_Surface *image);
+size_t PicImageSize(const PicImage *image);
+void PicLoadImage(
+	Pic *p, const Vec2i size, const Vec2i offset, const PicImage *image);
 Pic PicCopy(const Pic *src);
 void PicFree(Pic *pic);
 bool PicIsNone(const Pic *pic);
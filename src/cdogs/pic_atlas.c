@@ -0,0 +1,124 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "pic_atlas.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+// Start each pic on a 16-byte boundary, as malloc would, so that vector
+// loads of its rows line up the same way
+#define PIC_ATLAS_ALIGN 4
+
+
+void PicAtlasInit(PicAtlas *a)
+{
+	memset(a, 0, sizeof *a);
+	CArrayInit(&a->pages, sizeof(PicAtlasPage));
+}
+void PicAtlasTerminate(PicAtlas *a)
+{
+	CA_FOREACH(PicAtlasPage, page, a->pages)
+		CFREE(page->Data);
+	CA_FOREACH_END()
+	CArrayTerminate(&a->pages);
+}
+
+static PicAtlasPage *LastPage(PicAtlas *a);
+static PicAtlasPage *AddPage(PicAtlas *a, const int pixels);
+void PicAtlasReserve(PicAtlas *a, const int pixels)
+{
+	const PicAtlasPage *page = LastPage(a);
+	if (pixels > 0 && (page == NULL || page->Size - page->Used < pixels))
+	{
+		AddPage(a, pixels);
+	}
+}
+
+Uint32 *PicAtlasAlloc(PicAtlas *a, const Vec2i size)
+{
+	const int pixels = PicAtlasPixels(size);
+	PicAtlasPage *page = LastPage(a);
+	if (page == NULL || page->Size - page->Used < pixels)
+	{
+		// Oversized pics get a page of their own
+		page = AddPage(a, MAX(pixels, PIC_ATLAS_PAGE_PIXELS));
+	}
+	Uint32 *data = page->Data + page->Used;
+	page->Used += pixels;
+	a->NumPics++;
+	return data;
+}
+static PicAtlasPage *LastPage(PicAtlas *a)
+{
+	if (a->pages.size == 0)
+	{
+		return NULL;
+	}
+	return CArrayGet(&a->pages, a->pages.size - 1);
+}
+static PicAtlasPage *AddPage(PicAtlas *a, const int pixels)
+{
+	PicAtlasPage p;
+	p.Size = pixels;
+	p.Used = 0;
+	CMALLOC(p.Data, p.Size * sizeof *p.Data);
+	CArrayPushBack(&a->pages, &p);
+	return LastPage(a);
+}
+
+int PicAtlasPixels(const Vec2i size)
+{
+	const int count = size.x * size.y;
+	return (count + PIC_ATLAS_ALIGN - 1) / PIC_ATLAS_ALIGN * PIC_ATLAS_ALIGN;
+}
+
+void PicAtlasPack(PicAtlas *a, Pic *p)
+{
+	if (p->packed || p->Data == NULL)
+	{
+		return;
+	}
+	Uint32 *data = PicAtlasAlloc(a, p->size);
+	memcpy(data, p->Data, p->size.x * p->size.y * sizeof *data);
+	CFREE(p->Data);
+	p->Data = data;
+	p->packed = true;
+}
+
+size_t PicAtlasSize(const PicAtlas *a, size_t *used)
+{
+	size_t size = 0;
+	*used = 0;
+	CA_FOREACH(const PicAtlasPage, page, a->pages)
+		size += page->Size * sizeof *page->Data;
+		*used += page->Used * sizeof *page->Data;
+	CA_FOREACH_END()
+	return size;
+}
@@ -0,0 +1,70 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stddef.h>
+
+#include "c_array.h"
+#include "pic.h"
+
+// Pixels per page for pics allocated one at a time; 256KB
+#define PIC_ATLAS_PAGE_PIXELS (64 * 1024)
+
+typedef struct
+{
+	Uint32 *Data;
+	int Size;	// in pixels
+	int Used;
+} PicAtlasPage;
+
+// Large pages that pic pixels are packed into, one after the other in the
+// order they are added, so that pics drawn together sit together in memory
+// and don't each need a heap allocation
+// Pics keep their own size and row stride, so a packed pic is drawn the
+// same way as any other
+// Pages are only freed all at once, with the pics that use them
+typedef struct
+{
+	CArray pages;	// of PicAtlasPage
+	int NumPics;
+} PicAtlas;
+
+void PicAtlasInit(PicAtlas *a);
+void PicAtlasTerminate(PicAtlas *a);
+// Make room for pics of this many pixels in total, so that packing a
+// known set of pics takes a single page with no slack
+void PicAtlasReserve(PicAtlas *a, const int pixels);
+// Reserve pixels for a pic of this size
+Uint32 *PicAtlasAlloc(PicAtlas *a, const Vec2i size);
+// Pixels taken by a pic of this size, including alignment
+int PicAtlasPixels(const Vec2i size);
+// Move the pic's pixels into the atlas, unless they are already packed
+void PicAtlasPack(PicAtlas *a, Pic *p);
+// Bytes of page memory, and bytes used by pixels
+size_t PicAtlasSize(const PicAtlas *a, size_t *used);
@@ -29,8 +29,7 @@
 
 #include <SDL_image.h>
 
-#include <tinydir/tinydir.h>
-
+#include "asset_loader.h"
 #include "files.h"
 #include "log.h"
 
@@ -271,6 +270,8 @@ bool PicManagerTryInit(
 	pm->sprites = hashmap_new();
 	pm->customPics = hashmap_new();
 	pm->customSprites = hashmap_new();
+	PicAtlasInit(&pm->atlas);
+	PicAtlasInit(&pm->customAtlas);
 	CArrayInit(&pm->drainPics, sizeof(NamedPic *));
 	CArrayInit(&pm->doorStyleNames, sizeof(char *));
 
@@ -324,7 +325,6 @@ static void SetPaletteRange(
 
 static NamedPic *AddNamedPic(map_t pics, const char *name, const Pic *p);
 static NamedSprites *AddNamedSprites(map_t sprites, const char *name);
-static void AfterAdd(PicManager *pm);
 void PicManagerAdd(
 	map_t pics, map_t sprites, const char *name, SDL_Surface *image)
 {
@@ -335,6 +335,15 @@ void PicManagerAdd(
 		SDL_FreeSurface(image);
 		return;
 	}
+	PicImage *pi = PicImageNew(image);
+	SDL_FreeSurface(image);
+	PicManagerAddImage(pics, sprites, name, pi);
+	CFREE(pi);
+}
+static void AfterAdd(PicManager *pm);
+void PicManagerAddImage(
+	map_t pics, map_t sprites, const char *name, const PicImage *image)
+{
 	char buf[CDOGS_FILENAME_MAX];
 	const char *dot = strrchr(name, '.');
 	if (dot)
@@ -351,7 +360,7 @@ void PicManagerAdd(
 	// Special case: if the file name is in the form foobar_WxH.ext,
 	// this is a spritesheet where each sprite is W wide by H high
 	// Load multiple images from this single sheet
-	Vec2i size = Vec2iNew(image->w, image->h);
+	Vec2i size = image->Size;
 	bool isSpritesheet = false;
 	char *underscore = strrchr(buf, '_');
 	const char *x = strrchr(buf, 'x');
@@ -360,7 +369,7 @@ void PicManagerAdd(
 	{
 		if (sscanf(underscore, "_%dx%d", &size.x, &size.y) != 2)
 		{
-			size = Vec2iNew(image->w, image->h);
+			size = image->Size;
 		}
 		else
 		{
@@ -378,11 +387,10 @@ void PicManagerAdd(
 	{
 		np = AddNamedPic(pics, buf, NULL);
 	}
-	SDL_LockSurface(image);
 	Vec2i offset;
-	for (offset.y = 0; offset.y < image->h; offset.y += size.y)
+	for (offset.y = 0; offset.y < image->Size.y; offset.y += size.y)
 	{
-		for (offset.x = 0; offset.x < image->w; offset.x += size.x)
+		for (offset.x = 0; offset.x < image->Size.x; offset.x += size.x)
 		{
 			Pic *pic;
 			if (isSpritesheet)
@@ -395,80 +403,59 @@ void PicManagerAdd(
 			{
 				pic = &np->pic;
 			}
-			PicLoad(pic, size, offset, image);
+			PicLoadImage(pic, size, offset, image);
 		}
 	}
-	SDL_UnlockSurface(image);
-	SDL_FreeSurface(image);
 
 	AfterAdd(&gPicManager);
 }
 
-static void PicManagerLoadDirImpl(
-	PicManager *pm, const char *path, const char *prefix)
+static void *DecodePic(const char *path, size_t *len)
 {
-	tinydir_dir dir;
-	if (tinydir_open(&dir, path) == -1)
+	SDL_RWops *rwops = SDL_RWFromFile(path, "rb");
+	if (rwops == NULL)
 	{
-		perror("Cannot open image dir");
-		goto bail;
+		return NULL;
 	}
-
-	for (; dir.has_next; tinydir_next(&dir))
+	PicImage *data = NULL;
+	if (IMG_isPNG(rwops))
 	{
-		tinydir_file file;
-		if (tinydir_readfile(&dir, &file) == -1)
+		SDL_Surface *image = IMG_Load_RW(rwops, 0);
+		if (!image)
 		{
-			perror("Cannot read image file");
-			goto bail;
+			LOG(LM_MAIN, LL_ERROR, "Cannot load image");
+			LOG(LM_MAIN, LL_ERROR, "IMG_Load: %s", IMG_GetError());
 		}
-		if (file.is_reg)
+		else if (image->format->BytesPerPixel != 4)
 		{
-			SDL_RWops *rwops = SDL_RWFromFile(file.path, "rb");
-			const bool isPng = IMG_isPNG(rwops);
-			if (isPng)
-			{
-				SDL_Surface *data = IMG_Load_RW(rwops, 0);
-				if (!data)
-				{
-					LOG(LM_MAIN, LL_ERROR, "Cannot load image");
-					LOG(LM_MAIN, LL_ERROR, "IMG_Load: %s", IMG_GetError());
-				}
-				else
-				{
-					char buf[CDOGS_PATH_MAX];
-					if (prefix)
-					{
-						char buf1[CDOGS_PATH_MAX];
-						sprintf(buf1, "%s/%s", prefix, file.name);
-						PathGetWithoutExtension(buf, buf1);
-					}
-					else
-					{
-						PathGetBasenameWithoutExtension(buf, file.name);
-					}
-					PicManagerAdd(pm->pics, pm->sprites, buf, data);
-				}
-			}
-			rwops->close(rwops);
+			LOG(LM_MAIN, LL_ERROR,
+				"Only 32-bit depth images supported (%s)", path);
 		}
-		else if (file.is_dir && file.name[0] != '.')
+		else
 		{
-			if (prefix)
-			{
-				char buf[CDOGS_PATH_MAX];
-				sprintf(buf, "%s/%s", prefix, file.name);
-				PicManagerLoadDirImpl(pm, file.path, buf);
-			}
-			else
-			{
-				PicManagerLoadDirImpl(pm, file.path, file.name);
-			}
+			data = PicImageNew(image);
+			*len = PicImageSize(data);
 		}
+		SDL_FreeSurface(image);
 	}
-
-bail:
-	tinydir_close(&dir);
+	rwops->close(rwops);
+	return data;
+}
+// Guard against truncated or corrupt cache entries
+static bool CheckPic(const void *data, const size_t len)
+{
+	const PicImage *image = data;
+	if (len < sizeof *image || image->Size.x < 0 || image->Size.y < 0)
+	{
+		return false;
+	}
+	// Check the pixel count fits before multiplying it out
+	const size_t pixels = (len - sizeof *image) / sizeof *image->Pixels;
+	if (image->Size.x > 0 && (size_t)image->Size.y > pixels / image->Size.x)
+	{
+		return false;
+	}
+	return PicImageSize(image) == len;
 }
 static void GenerateOldPics(PicManager *pm);
 static void LoadOldSprites(
@@ -476,7 +463,8 @@ static void LoadOldSprites(
 static void LoadOldFacePics(
 	PicManager *pm, const char *spritesName, int facePics[][DIRECTION_COUNT],
 	Vec2i offsets[FACE_COUNT][DIRECTION_COUNT]);
-void PicManagerLoadDir(PicManager *pm, const char *path)
+void PicManagerLoadDir(
+	PicManager *pm, const char *path, const char *cachePath)
 {
 	if (!IMG_Init(IMG_INIT_PNG))
 	{
@@ -485,7 +473,31 @@ void PicManagerLoadDir(PicManager *pm, const char *path)
 	}
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
-	PicManagerLoadDirImpl(pm, buf, NULL);
+	// Decode the images in parallel, then add them in directory order
+	AssetLoad l;
+	AssetLoadInit(&l, "graphics");
+	AssetLoadScan(&l, buf);
+	if (cachePath != NULL)
+	{
+		// Cached images are only valid for the same pixel format
+		AssetLoadUseCache(
+			&l, cachePath,
+			gGraphicsDevice.Format->format ^
+			((Uint32)gGraphicsDevice.Ashift << 24),
+			CheckPic);
+	}
+	AssetLoadDecode(&l, DecodePic);
+	CA_FOREACH(const AssetFile, f, l.Files)
+		if (f->Data == NULL) continue;
+		PathGetWithoutExtension(buf, f->Name);
+		PicManagerAddImage(pm->pics, pm->sprites, buf, f->Data);
+	CA_FOREACH_END()
+	AssetLoadLogTimes(&l);
+	AssetLoadSaveCache(&l);
+	CA_FOREACH(const AssetFile, f, l.Files)
+		if (!f->Cached) CFREE(f->Data);
+	CA_FOREACH_END()
+	AssetLoadTerminate(&l);
 	GenerateOldPics(pm);
 
 	// Load old pics and sprites
@@ -502,6 +514,8 @@ void PicManagerLoadDir(PicManager *pm, const char *path)
 	// Faces
 	LoadOldFacePics(pm, "idle", facePicsIdle, faceOffsets);
 	LoadOldFacePics(pm, "firing", facePicsFiring, faceOffsetsFiring);
+
+	PicManagerPack(pm);
 }
 static void LoadOldSprites(
 	PicManager *pm, const char *name, const TOffsetPic *pics, const int count)
@@ -771,12 +785,95 @@ static int MaybeAddDoorPicName(any_t data, any_t item)
 // Need to free the pics and the memory since hashmap stores on heap
 static void NamedPicDestroy(any_t data);
 static void NamedSpritesDestroy(any_t data);
+typedef struct
+{
+	const char *Name;
+	Pic *Pic;
+} PackItem;
+static int AddPackPic(any_t data, any_t item);
+static int AddPackSprites(any_t data, any_t item);
+static int ComparePackItems(const void *v1, const void *v2);
+static void PackMaps(
+	PicAtlas *a, Pic *picsFromOld, map_t pics, map_t sprites);
+void PicManagerPack(PicManager *pm)
+{
+	PackMaps(&pm->atlas, pm->picsFromOld, pm->oldSprites, NULL);
+	PackMaps(&pm->atlas, NULL, pm->pics, pm->sprites);
+	PackMaps(&pm->customAtlas, NULL, pm->customPics, pm->customSprites);
+}
+static void PackMaps(
+	PicAtlas *a, Pic *picsFromOld, map_t pics, map_t sprites)
+{
+	// Pack in name order, so that pics from the same dir are together,
+	// and each sprite sheet's frames are in a row
+	CArray items;
+	CArrayInit(&items, sizeof(PackItem));
+	for (int i = 0; picsFromOld != NULL && i < PIC_MAX; i++)
+	{
+		if (picsFromOld[i].packed || picsFromOld[i].Data == NULL) continue;
+		const PackItem p = { "", &picsFromOld[i] };
+		CArrayPushBack(&items, &p);
+	}
+	if (pics != NULL)
+	{
+		hashmap_iterate(pics, AddPackPic, &items);
+	}
+	if (sprites != NULL)
+	{
+		hashmap_iterate(sprites, AddPackSprites, &items);
+	}
+	qsort(items.data, items.size, items.elemSize, ComparePackItems);
+	int pixels = 0;
+	CA_FOREACH(const PackItem, item, items)
+		pixels += PicAtlasPixels(item->Pic->size);
+	CA_FOREACH_END()
+	PicAtlasReserve(a, pixels);
+	CA_FOREACH(const PackItem, item, items)
+		PicAtlasPack(a, item->Pic);
+	CA_FOREACH_END()
+	CArrayTerminate(&items);
+}
+static int AddPackPic(any_t data, any_t item)
+{
+	NamedPic *n = item;
+	if (!n->pic.packed && n->pic.Data != NULL)
+	{
+		const PackItem p = { n->name, &n->pic };
+		CArrayPushBack(data, &p);
+	}
+	return MAP_OK;
+}
+static int AddPackSprites(any_t data, any_t item)
+{
+	NamedSprites *n = item;
+	CA_FOREACH(Pic, pic, n->pics)
+		if (pic->packed || pic->Data == NULL) continue;
+		const PackItem p = { n->name, pic };
+		CArrayPushBack(data, &p);
+	CA_FOREACH_END()
+	return MAP_OK;
+}
+static int ComparePackItems(const void *v1, const void *v2)
+{
+	const PackItem *p1 = v1;
+	const PackItem *p2 = v2;
+	const int c = strcmp(p1->Name, p2->Name);
+	if (c != 0)
+	{
+		return c;
+	}
+	// Keep sprite frames in order
+	return p1->Pic < p2->Pic ? -1 : p1->Pic > p2->Pic;
+}
+
 void PicManagerClearCustom(PicManager *pm)
 {
 	hashmap_destroy(pm->customPics, NamedPicDestroy);
 	hashmap_destroy(pm->customSprites, NamedSpritesDestroy);
 	pm->customPics = hashmap_new();
 	pm->customSprites = hashmap_new();
+	PicAtlasTerminate(&pm->customAtlas);
+	PicAtlasInit(&pm->customAtlas);
 	AfterAdd(pm);
 }
 void PicManagerTerminate(PicManager *pm)
@@ -794,6 +891,8 @@ void PicManagerTerminate(PicManager *pm)
 	hashmap_destroy(pm->sprites, NamedSpritesDestroy);
 	hashmap_destroy(pm->customPics, NamedPicDestroy);
 	hashmap_destroy(pm->customSprites, NamedSpritesDestroy);
+	PicAtlasTerminate(&pm->atlas);
+	PicAtlasTerminate(&pm->customAtlas);
 	CArrayTerminate(&pm->drainPics);
 	CA_FOREACH(char *, doorStyleName, pm->doorStyleNames)
 		CFREE(*doorStyleName);
@@ -932,7 +1031,9 @@ void PicManagerGenerateMaskedPic(
 	CASSERT(original != NULL, "Cannot find original pic for masking\n");
 
 	// Create the new pic by masking the original pic
-	Pic p = PicCopy(original);
+	Pic p = *original;
+	p.Data = PicAtlasAlloc(&pm->customAtlas, p.size);
+	p.packed = true;
 	debug(D_VERBOSE, "Creating new masked pic %s (%d x %d)\n",
 		maskedName, p.size.x, p.size.y);
 	for (int i = 0; i < p.size.x * p.size.y; i++)
@@ -1065,5 +1166,6 @@ Pic PicFromTOffsetPic(PicManager *pm, TOffsetPic op)
 	pic.size = opPic->size;
 	pic.offset = Vec2iNew(op.dx, op.dy);
 	pic.Data = opPic->Data;
+	pic.packed = true;	// a view that must not be freed
 	return pic;
 }
@@ -29,6 +29,7 @@
 
 #include "c_hashmap/hashmap.h"
 #include "cpic.h"
+#include "pic_atlas.h"
 #include "pics.h"
 
 typedef struct
@@ -41,6 +42,8 @@ typedef struct
 	map_t sprites;	// of NamedSprites
 	map_t customPics;	// of NamedPic
 	map_t customSprites;	// of NamedSprites
+	PicAtlas atlas;	// pixels of the pics and sprites above
+	PicAtlas customAtlas;	// pixels of the custom pics and sprites
 
 	CArray drainPics;	// of NamedPic *
 
@@ -51,11 +54,20 @@ extern PicManager gPicManager;
 
 #define NECK_OFFSET (-14)
 
+#define GRAPHICS_CACHE_FILE "graphics.cache"
+
 bool PicManagerTryInit(
 	PicManager *pm, const char *oldGfxFile1, const char *oldGfxFile2);
-void PicManagerLoadDir(PicManager *pm, const char *path);
+// Load the images under path; decoded images are cached at cachePath if
+// it isn't NULL
+void PicManagerLoadDir(
+	PicManager *pm, const char *path, const char *cachePath);
 void PicManagerAdd(
 	map_t pics, map_t sprites, const char *name, SDL_Surface *image);
+void PicManagerAddImage(
+	map_t pics, map_t sprites, const char *name, const PicImage *image);
+// Pack the pixels of any newly added pics into the atlases
+void PicManagerPack(PicManager *pm);
 void PicManagerClearCustom(PicManager *pm);
 void PicManagerTerminate(PicManager *pm);
 
@@ -205,7 +205,7 @@ void PickupPickup(TActor *a, Pickup *p, const bool pickupAll)
 			e.u.ActorReplaceGun.GunIdx =
 				(int)a->guns.size == MAX_WEAPONS ?
 				a->gunIndex : (int)a->guns.size;
-			strcpy(e.u.ActorReplaceGun.Gun, gun->name);
+			e.u.ActorReplaceGun.GunId = p->class->u.GunId;
 			GameEventsEnqueue(&gGameEvents, e);
 
 			// If the player has less ammo than the default amount,
@@ -243,7 +243,7 @@ void PickupPickup(TActor *a, Pickup *p, const bool pickupAll)
 		if (sound != NULL)
 		{
 			GameEvent es = GameEventNew(GAME_EVENT_SOUND_AT);
-			strcpy(es.u.SoundAt.Sound, sound);
+			es.u.SoundAt.SoundId = StrSoundId(sound);
 			es.u.SoundAt.Pos = Vec2i2Net(actorPos);
 			es.u.SoundAt.IsHit = false;
 			GameEventsEnqueue(&gGameEvents, es);
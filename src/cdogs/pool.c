@@ -0,0 +1,158 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "pool.h"
+
+#include "utils.h"
+
+#define POOL_BUCKETS_MIN 64
+
+typedef struct
+{
+	int UID;
+	int next;	// next slot in the same UID bucket, or -1
+	bool isInUse;
+} PoolSlot;
+
+
+void PoolInit(Pool *p)
+{
+	CArrayInit(&p->slots, sizeof(PoolSlot));
+	CArrayInit(&p->freeSlots, sizeof(int));
+	CArrayInit(&p->buckets, sizeof(int));
+	const int empty = -1;
+	CArrayResize(&p->buckets, POOL_BUCKETS_MIN, &empty);
+}
+void PoolTerminate(Pool *p)
+{
+	CArrayTerminate(&p->slots);
+	CArrayTerminate(&p->freeSlots);
+	CArrayTerminate(&p->buckets);
+}
+
+// UIDs are handed out in sequence, so the low bits spread them evenly
+static int *GetBucket(const Pool *p, const int uid)
+{
+	return CArrayGet(&p->buckets, (int)((unsigned)uid & (p->buckets.size - 1)));
+}
+static void LinkUID(Pool *p, const int index)
+{
+	PoolSlot *s = CArrayGet(&p->slots, index);
+	int *bucket = GetBucket(p, s->UID);
+	s->next = *bucket;
+	*bucket = index;
+}
+static void UnlinkUID(Pool *p, const int index)
+{
+	const PoolSlot *s = CArrayGet(&p->slots, index);
+	for (int *link = GetBucket(p, s->UID); *link >= 0;)
+	{
+		PoolSlot *ls = CArrayGet(&p->slots, *link);
+		if (*link == index)
+		{
+			*link = ls->next;
+			return;
+		}
+		link = &ls->next;
+	}
+	CASSERT(false, "cannot find pool UID to unlink");
+}
+// Keep the buckets at least as many as the slots, so chains stay short
+static void GrowBuckets(Pool *p)
+{
+	if (p->slots.size <= p->buckets.size)
+	{
+		return;
+	}
+	const int empty = -1;
+	CArrayResize(&p->buckets, p->buckets.size * 2, &empty);
+	CArrayFill(&p->buckets, &empty);
+	for (int i = 0; i < (int)p->slots.size; i++)
+	{
+		LinkUID(p, i);
+	}
+}
+
+int PoolAdd(Pool *p, const int uid)
+{
+	int index;
+	PoolSlot *s;
+	if (p->freeSlots.size > 0)
+	{
+		index = *(int *)CArrayGet(&p->freeSlots, (int)p->freeSlots.size - 1);
+		CArrayDelete(&p->freeSlots, (int)p->freeSlots.size - 1);
+		UnlinkUID(p, index);
+		s = CArrayGet(&p->slots, index);
+	}
+	else
+	{
+		PoolSlot sNew;
+		memset(&sNew, 0, sizeof sNew);
+		CArrayPushBack(&p->slots, &sNew);
+		index = (int)p->slots.size - 1;
+		s = CArrayGet(&p->slots, index);
+	}
+	CASSERT(!s->isInUse, "adding to in-use pool slot");
+	s->UID = uid;
+	s->isInUse = true;
+	LinkUID(p, index);
+	GrowBuckets(p);
+	return index;
+}
+void PoolRemove(Pool *p, const int index)
+{
+	PoolSlot *s = CArrayGet(&p->slots, index);
+	CASSERT(s->isInUse, "removing not-in-use pool slot");
+	s->isInUse = false;
+	// Note: the UID stays linked until the slot is reused, so that
+	// it can still be found
+	CArrayPushBack(&p->freeSlots, &index);
+}
+bool PoolIsInUse(const Pool *p, const int index)
+{
+	if (index < 0 || index >= (int)p->slots.size)
+	{
+		return false;
+	}
+	const PoolSlot *s = CArrayGet(&p->slots, index);
+	return s->isInUse;
+}
+
+int PoolFindUID(const Pool *p, const int uid)
+{
+	for (int i = *GetBucket(p, uid); i >= 0;)
+	{
+		const PoolSlot *s = CArrayGet(&p->slots, i);
+		if (s->UID == uid)
+		{
+			return i;
+		}
+		i = s->next;
+	}
+	return -1;
+}
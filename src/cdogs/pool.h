@@ -0,0 +1,58 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include "c_array.h"
+
+// Slot bookkeeping for arrays of game objects, such as actors and bullets.
+// The objects themselves stay in their CArray, indexed by slot; the pool
+// keeps a free list of slots and the slot that each UID is in.
+
+typedef struct
+{
+	CArray slots;	// of PoolSlot
+	CArray freeSlots;	// of int, used as a stack
+	CArray buckets;	// of int; first slot in each UID hash bucket, or -1
+} Pool;
+
+void PoolInit(Pool *p);
+void PoolTerminate(Pool *p);
+
+// Take a slot for a new object with a UID, and return its index
+// Free slots are reused first; if the index is past the end of the object
+// array, the caller needs to add an object
+int PoolAdd(Pool *p, const int uid);
+void PoolRemove(Pool *p, const int index);
+bool PoolIsInUse(const Pool *p, const int index);
+
+// Index of the slot last used by the UID, or -1 if none
+// The object in the slot may since have been destroyed
+int PoolFindUID(const Pool *p, const int uid);
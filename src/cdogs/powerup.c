@@ -35,6 +35,9 @@
 #include "net_util.h"
 #include "pickup.h"
 
+static ConfigHandle configAmmo = CONFIG_HANDLE("Game.Ammo");
+static ConfigHandle configHealthPickups = CONFIG_HANDLE("Game.HealthPickups");
+
 
 #define TIME_DECAY_EXPONENT 1.04
 #define HEALTH_W 6
@@ -140,7 +143,7 @@ void HealthSpawnerInit(PowerupSpawner *p, Map *map)
 	PowerupSpawnerInit(p, map);
 	p->Enabled =
 		AreHealthPickupsAllowed(gCampaign.Entry.Mode) &&
-		ConfigGetBool(&gConfig, "Game.HealthPickups") &&
+		ConfigHandleGetBool(&configHealthPickups) &&
 		!gCampaign.IsClient;
 	p->SpawnTime = HEALTH_SPAWN_TIME;
 	p->RateScaleFunc = HealthScale;
@@ -190,7 +193,7 @@ void AmmoSpawnerInit(PowerupSpawner *p, Map *map, const int ammoId)
 	PowerupSpawnerInit(p, map);
 	// TODO: disable ammo spawners unless classic mode
 	p->Enabled =
-		ConfigGetBool(&gConfig, "Game.Ammo") &&
+		ConfigHandleGetBool(&configAmmo) &&
 		!gCampaign.IsClient;
 	p->SpawnTime = AMMO_SPAWN_TIME;
 	p->RateScaleFunc = AmmoScale;
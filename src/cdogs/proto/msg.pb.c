@@ -7,6 +7,7 @@
 #error Regenerate this file with the current version of nanopb generator.
 #endif
 
+const int32_t NSound_SoundId_default = -1;
 const int32_t NActorAdd_Direction_default = 4;
 const int32_t NActorAdd_PlayerUID_default = -1;
 const int32_t NActorHeal_PlayerUID_default = -1;
@@ -137,8 +138,8 @@ const pb_field_t NScore_fields[3] = {
 };
 
 const pb_field_t NSound_fields[4] = {
-    PB_FIELD(  1, STRING  , REQUIRED, STATIC  , FIRST, NSound, Sound, Sound, 0),
-    PB_FIELD(  2, MESSAGE , REQUIRED, STATIC  , OTHER, NSound, Pos, Sound, &NVec2i_fields),
+    PB_FIELD(  1, INT32   , REQUIRED, STATIC  , FIRST, NSound, SoundId, SoundId, &NSound_SoundId_default),
+    PB_FIELD(  2, MESSAGE , REQUIRED, STATIC  , OTHER, NSound, Pos, SoundId, &NVec2i_fields),
     PB_FIELD(  3, BOOL    , REQUIRED, STATIC  , OTHER, NSound, IsHit, Pos, 0),
     PB_LAST_FIELD
 };
@@ -207,7 +208,7 @@ const pb_field_t NActorPickupAll_fields[3] = {
 const pb_field_t NActorReplaceGun_fields[4] = {
     PB_FIELD(  1, UINT32  , REQUIRED, STATIC  , FIRST, NActorReplaceGun, UID, UID, 0),
     PB_FIELD(  2, UINT32  , REQUIRED, STATIC  , OTHER, NActorReplaceGun, GunIdx, UID, 0),
-    PB_FIELD(  3, STRING  , REQUIRED, STATIC  , OTHER, NActorReplaceGun, Gun, GunIdx, 0),
+    PB_FIELD(  3, INT32   , REQUIRED, STATIC  , OTHER, NActorReplaceGun, GunId, GunIdx, 0),
     PB_LAST_FIELD
 };
 
@@ -253,8 +254,8 @@ const pb_field_t NActorDie_fields[2] = {
 
 const pb_field_t NActorMelee_fields[6] = {
     PB_FIELD(  1, UINT32  , REQUIRED, STATIC  , FIRST, NActorMelee, UID, UID, 0),
-    PB_FIELD(  2, STRING  , REQUIRED, STATIC  , OTHER, NActorMelee, BulletClass, UID, 0),
-    PB_FIELD(  3, INT32   , REQUIRED, STATIC  , OTHER, NActorMelee, HitType, BulletClass, 0),
+    PB_FIELD(  2, INT32   , REQUIRED, STATIC  , OTHER, NActorMelee, BulletClassId, UID, 0),
+    PB_FIELD(  3, INT32   , REQUIRED, STATIC  , OTHER, NActorMelee, HitType, BulletClassId, 0),
     PB_FIELD(  4, INT32   , REQUIRED, STATIC  , OTHER, NActorMelee, TargetKind, HitType, 0),
     PB_FIELD(  5, UINT32  , REQUIRED, STATIC  , OTHER, NActorMelee, TargetUID, TargetKind, 0),
     PB_LAST_FIELD
@@ -292,8 +293,8 @@ const pb_field_t NRemoveBullet_fields[2] = {
 
 const pb_field_t NGunReload_fields[5] = {
     PB_FIELD(  1, INT32   , REQUIRED, STATIC  , FIRST, NGunReload, PlayerUID, PlayerUID, &NGunReload_PlayerUID_default),
-    PB_FIELD(  2, STRING  , REQUIRED, STATIC  , OTHER, NGunReload, Gun, PlayerUID, 0),
-    PB_FIELD(  3, MESSAGE , REQUIRED, STATIC  , OTHER, NGunReload, FullPos, Gun, &NVec2i_fields),
+    PB_FIELD(  2, INT32   , REQUIRED, STATIC  , OTHER, NGunReload, GunId, PlayerUID, 0),
+    PB_FIELD(  3, MESSAGE , REQUIRED, STATIC  , OTHER, NGunReload, FullPos, GunId, &NVec2i_fields),
     PB_FIELD(  4, INT32   , REQUIRED, STATIC  , OTHER, NGunReload, Direction, FullPos, 0),
     PB_LAST_FIELD
 };
@@ -301,8 +302,8 @@ const pb_field_t NGunReload_fields[5] = {
 const pb_field_t NGunFire_fields[10] = {
     PB_FIELD(  1, INT32   , REQUIRED, STATIC  , FIRST, NGunFire, UID, UID, &NGunFire_UID_default),
     PB_FIELD(  2, INT32   , REQUIRED, STATIC  , OTHER, NGunFire, PlayerUID, UID, &NGunFire_PlayerUID_default),
-    PB_FIELD(  3, STRING  , REQUIRED, STATIC  , OTHER, NGunFire, Gun, PlayerUID, 0),
-    PB_FIELD(  4, MESSAGE , REQUIRED, STATIC  , OTHER, NGunFire, MuzzleFullPos, Gun, &NVec2i_fields),
+    PB_FIELD(  3, INT32   , REQUIRED, STATIC  , OTHER, NGunFire, GunId, PlayerUID, 0),
+    PB_FIELD(  4, MESSAGE , REQUIRED, STATIC  , OTHER, NGunFire, MuzzleFullPos, GunId, &NVec2i_fields),
     PB_FIELD(  5, INT32   , REQUIRED, STATIC  , OTHER, NGunFire, Z, MuzzleFullPos, 0),
     PB_FIELD(  6, FLOAT   , REQUIRED, STATIC  , OTHER, NGunFire, Angle, Z, 0),
     PB_FIELD(  7, BOOL    , REQUIRED, STATIC  , OTHER, NGunFire, Sound, Angle, 0),
@@ -319,8 +320,8 @@ const pb_field_t NGunState_fields[3] = {
 
 const pb_field_t NAddBullet_fields[10] = {
     PB_FIELD(  1, UINT32  , REQUIRED, STATIC  , FIRST, NAddBullet, UID, UID, 0),
-    PB_FIELD(  2, STRING  , REQUIRED, STATIC  , OTHER, NAddBullet, BulletClass, UID, 0),
-    PB_FIELD(  3, MESSAGE , REQUIRED, STATIC  , OTHER, NAddBullet, MuzzlePos, BulletClass, &NVec2i_fields),
+    PB_FIELD(  2, INT32   , REQUIRED, STATIC  , OTHER, NAddBullet, BulletClassId, UID, 0),
+    PB_FIELD(  3, MESSAGE , REQUIRED, STATIC  , OTHER, NAddBullet, MuzzlePos, BulletClassId, &NVec2i_fields),
     PB_FIELD(  4, INT32   , REQUIRED, STATIC  , OTHER, NAddBullet, MuzzleHeight, MuzzlePos, 0),
     PB_FIELD(  5, FLOAT   , REQUIRED, STATIC  , OTHER, NAddBullet, Angle, MuzzleHeight, 0),
     PB_FIELD(  6, INT32   , REQUIRED, STATIC  , OTHER, NAddBullet, Elevation, Angle, 0),
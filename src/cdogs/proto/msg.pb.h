@@ -41,7 +41,7 @@ typedef struct _NActorHeal {
 
 typedef struct _NActorMelee {
     uint32_t UID;
-    char BulletClass[128];
+    int32_t BulletClassId;
     int32_t HitType;
     int32_t TargetKind;
     uint32_t TargetUID;
@@ -55,7 +55,7 @@ typedef struct _NActorPickupAll {
 typedef struct _NActorReplaceGun {
     uint32_t UID;
     uint32_t GunIdx;
-    char Gun[128];
+    int32_t GunId;
 } NActorReplaceGun;
 
 typedef struct _NActorState {
@@ -209,7 +209,7 @@ typedef struct _NActorSlide {
 
 typedef struct _NAddBullet {
     uint32_t UID;
-    char BulletClass[128];
+    int32_t BulletClassId;
     NVec2i MuzzlePos;
     int32_t MuzzleHeight;
     float Angle;
@@ -257,7 +257,7 @@ typedef struct _NExploreTiles_Run {
 typedef struct _NGunFire {
     int32_t UID;
     int32_t PlayerUID;
-    char Gun[128];
+    int32_t GunId;
     NVec2i MuzzleFullPos;
     int32_t Z;
     float Angle;
@@ -268,7 +268,7 @@ typedef struct _NGunFire {
 
 typedef struct _NGunReload {
     int32_t PlayerUID;
-    char Gun[128];
+    int32_t GunId;
     NVec2i FullPos;
     int32_t Direction;
 } NGunReload;
@@ -288,7 +288,7 @@ typedef struct _NMissionComplete {
 } NMissionComplete;
 
 typedef struct _NSound {
-    char Sound[128];
+    int32_t SoundId;
     NVec2i Pos;
     bool IsHit;
 } NSound;
@@ -326,6 +326,7 @@ typedef struct _NPlayerData {
 } NPlayerData;
 
 /* Default values for struct fields */
+extern const int32_t NSound_SoundId_default;
 extern const int32_t NActorAdd_Direction_default;
 extern const int32_t NActorAdd_PlayerUID_default;
 extern const int32_t NActorHeal_PlayerUID_default;
@@ -356,7 +357,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NMapObjectDamage_init_default            {0, 0, 0, 0, 0}
 #define NMapObjectRemove_init_default            {0, 0, 0, 0}
 #define NScore_init_default                      {0, 0}
-#define NSound_init_default                      {"", NVec2i_init_default, 0}
+#define NSound_init_default                      {-1, NVec2i_init_default, 0}
 #define NVec2i_init_default                      {0, 0}
 #define NActorAdd_init_default                   {0, 0, 4, 0, -1, 0, NVec2i_init_default}
 #define NActorMove_init_default                  {0, NVec2i_init_default, NVec2i_init_default}
@@ -366,21 +367,21 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorImpulse_init_default               {0, NVec2i_init_default, NVec2i_init_default}
 #define NActorSwitchGun_init_default             {0, 0}
 #define NActorPickupAll_init_default             {0, 0}
-#define NActorReplaceGun_init_default            {0, 0, ""}
+#define NActorReplaceGun_init_default            {0, 0, 0}
 #define NActorHeal_init_default                  {0, -1, 0, 0}
 #define NActorHit_init_default                   {0, -1, -1, 0, 0, NVec2i_init_default}
 #define NActorAddAmmo_init_default               {0, -1, 0, 0, 0}
 #define NActorUseAmmo_init_default               {0, -1, 0, 0}
 #define NActorDie_init_default                   {0}
-#define NActorMelee_init_default                 {0, "", 0, 0, 0}
+#define NActorMelee_init_default                 {0, 0, 0, 0, 0}
 #define NAddPickup_init_default                  {0, "", 0, -1, 0, NVec2i_init_default}
 #define NRemovePickup_init_default               {0, -1}
 #define NBulletBounce_init_default               {0, 0, 0, NVec2i_init_default, NVec2i_init_default}
 #define NRemoveBullet_init_default               {0}
-#define NGunReload_init_default                  {-1, "", NVec2i_init_default, 0}
-#define NGunFire_init_default                    {-1, -1, "", NVec2i_init_default, 0, 0, 0, 0, 0}
+#define NGunReload_init_default                  {-1, 0, NVec2i_init_default, 0}
+#define NGunFire_init_default                    {-1, -1, 0, NVec2i_init_default, 0, 0, 0, 0, 0}
 #define NGunState_init_default                   {0, 0}
-#define NAddBullet_init_default                  {0, "", NVec2i_init_default, 0, 0, 0, 0, -1, -1}
+#define NAddBullet_init_default                  {0, 0, NVec2i_init_default, 0, 0, 0, 0, -1, -1}
 #define NTrigger_init_default                    {0, NVec2i_init_default}
 #define NExploreTiles_init_default               {0, {NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default, NExploreTiles_Run_init_default}}
 #define NExploreTiles_Run_init_default           {NVec2i_init_default, 0}
@@ -403,7 +404,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NMapObjectDamage_init_zero               {0, 0, 0, 0, 0}
 #define NMapObjectRemove_init_zero               {0, 0, 0, 0}
 #define NScore_init_zero                         {0, 0}
-#define NSound_init_zero                         {"", NVec2i_init_zero, 0}
+#define NSound_init_zero                         {0, NVec2i_init_zero, 0}
 #define NVec2i_init_zero                         {0, 0}
 #define NActorAdd_init_zero                      {0, 0, 0, 0, 0, 0, NVec2i_init_zero}
 #define NActorMove_init_zero                     {0, NVec2i_init_zero, NVec2i_init_zero}
@@ -413,21 +414,21 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorImpulse_init_zero                  {0, NVec2i_init_zero, NVec2i_init_zero}
 #define NActorSwitchGun_init_zero                {0, 0}
 #define NActorPickupAll_init_zero                {0, 0}
-#define NActorReplaceGun_init_zero               {0, 0, ""}
+#define NActorReplaceGun_init_zero               {0, 0, 0}
 #define NActorHeal_init_zero                     {0, 0, 0, 0}
 #define NActorHit_init_zero                      {0, 0, 0, 0, 0, NVec2i_init_zero}
 #define NActorAddAmmo_init_zero                  {0, 0, 0, 0, 0}
 #define NActorUseAmmo_init_zero                  {0, 0, 0, 0}
 #define NActorDie_init_zero                      {0}
-#define NActorMelee_init_zero                    {0, "", 0, 0, 0}
+#define NActorMelee_init_zero                    {0, 0, 0, 0, 0}
 #define NAddPickup_init_zero                     {0, "", 0, 0, 0, NVec2i_init_zero}
 #define NRemovePickup_init_zero                  {0, 0}
 #define NBulletBounce_init_zero                  {0, 0, 0, NVec2i_init_zero, NVec2i_init_zero}
 #define NRemoveBullet_init_zero                  {0}
-#define NGunReload_init_zero                     {0, "", NVec2i_init_zero, 0}
-#define NGunFire_init_zero                       {0, 0, "", NVec2i_init_zero, 0, 0, 0, 0, 0}
+#define NGunReload_init_zero                     {0, 0, NVec2i_init_zero, 0}
+#define NGunFire_init_zero                       {0, 0, 0, NVec2i_init_zero, 0, 0, 0, 0, 0}
 #define NGunState_init_zero                      {0, 0}
-#define NAddBullet_init_zero                     {0, "", NVec2i_init_zero, 0, 0, 0, 0, 0, 0}
+#define NAddBullet_init_zero                     {0, 0, NVec2i_init_zero, 0, 0, 0, 0, 0, 0}
 #define NTrigger_init_zero                       {0, NVec2i_init_zero}
 #define NExploreTiles_init_zero                  {0, {NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero, NExploreTiles_Run_init_zero}}
 #define NExploreTiles_Run_init_zero              {NVec2i_init_zero, 0}
@@ -451,7 +452,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorHeal_Amount_tag                    3
 #define NActorHeal_IsRandomSpawned_tag           4
 #define NActorMelee_UID_tag                      1
-#define NActorMelee_BulletClass_tag              2
+#define NActorMelee_BulletClassId_tag            2
 #define NActorMelee_HitType_tag                  3
 #define NActorMelee_TargetKind_tag               4
 #define NActorMelee_TargetUID_tag                5
@@ -459,7 +460,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorPickupAll_PickupAll_tag            2
 #define NActorReplaceGun_UID_tag                 1
 #define NActorReplaceGun_GunIdx_tag              2
-#define NActorReplaceGun_Gun_tag                 3
+#define NActorReplaceGun_GunId_tag               3
 #define NActorState_UID_tag                      1
 #define NActorState_State_tag                    2
 #define NActorSwitchGun_UID_tag                  1
@@ -535,7 +536,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NActorSlide_UID_tag                      1
 #define NActorSlide_Vel_tag                      2
 #define NAddBullet_UID_tag                       1
-#define NAddBullet_BulletClass_tag               2
+#define NAddBullet_BulletClassId_tag             2
 #define NAddBullet_MuzzlePos_tag                 3
 #define NAddBullet_MuzzleHeight_tag              4
 #define NAddBullet_Angle_tag                     5
@@ -565,7 +566,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NExploreTiles_Run_Run_tag                2
 #define NGunFire_UID_tag                         1
 #define NGunFire_PlayerUID_tag                   2
-#define NGunFire_Gun_tag                         3
+#define NGunFire_GunId_tag                       3
 #define NGunFire_MuzzleFullPos_tag               4
 #define NGunFire_Z_tag                           5
 #define NGunFire_Angle_tag                       6
@@ -573,7 +574,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NGunFire_Flags_tag                       8
 #define NGunFire_IsGun_tag                       9
 #define NGunReload_PlayerUID_tag                 1
-#define NGunReload_Gun_tag                       2
+#define NGunReload_GunId_tag                     2
 #define NGunReload_FullPos_tag                   3
 #define NGunReload_Direction_tag                 4
 #define NMapObjectAdd_UID_tag                    1
@@ -584,7 +585,7 @@ extern const int32_t NAddBullet_ActorUID_default;
 #define NMissionComplete_ShowMsg_tag             1
 #define NMissionComplete_ExitStart_tag           2
 #define NMissionComplete_ExitEnd_tag             3
-#define NSound_Sound_tag                         1
+#define NSound_SoundId_tag                       1
 #define NSound_Pos_tag                           2
 #define NSound_IsHit_tag                         3
 #define NTileSet_Pos_tag                         1
@@ -670,7 +671,7 @@ extern const pb_field_t NMissionEnd_fields[4];
 #define NMapObjectDamage_size                    45
 #define NMapObjectRemove_size                    34
 #define NScore_size                              17
-#define NSound_size                              157
+#define NSound_size                              37
 #define NVec2i_size                              22
 #define NActorAdd_size                           75
 #define NActorMove_size                          54
@@ -680,21 +681,21 @@ extern const pb_field_t NMissionEnd_fields[4];
 #define NActorImpulse_size                       54
 #define NActorSwitchGun_size                     12
 #define NActorPickupAll_size                     8
-#define NActorReplaceGun_size                    143
+#define NActorReplaceGun_size                    23
 #define NActorHeal_size                          30
 #define NActorHit_size                           74
 #define NActorAddAmmo_size                       31
 #define NActorUseAmmo_size                       29
 #define NActorDie_size                           6
-#define NActorMelee_size                         165
+#define NActorMelee_size                         45
 #define NAddPickup_size                          180
 #define NRemovePickup_size                       17
 #define NBulletBounce_size                       67
 #define NRemoveBullet_size                       6
-#define NGunReload_size                          177
-#define NGunFire_size                            203
+#define NGunReload_size                          57
+#define NGunFire_size                            83
 #define NGunState_size                           17
-#define NAddBullet_size                          216
+#define NAddBullet_size                          96
 #define NTrigger_size                            30
 #define NExploreTiles_size                       592
 #define NExploreTiles_Run_size                   35
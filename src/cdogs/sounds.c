@@ -56,15 +56,17 @@
 
 #include <SDL.h>
 
-#include <tinydir/tinydir.h>
-
 #include "algorithms.h"
+#include "asset_loader.h"
 #include "files.h"
 #include "log.h"
 #include "map.h"
 #include "music.h"
 #include "vector.h"
 
+static ConfigHandle configMusicVolume = CONFIG_HANDLE("Sound.MusicVolume");
+static ConfigHandle configSoundVolume = CONFIG_HANDLE("Sound.SoundVolume");
+
 SoundDevice gSoundDevice;
 
 
@@ -92,16 +94,11 @@ int OpenAudio(int frequency, Uint16 format, int channels, int chunkSize)
 	return 0;
 }
 
-static void LoadSound(SoundDevice *device, const char *name, const char *path)
+static void *DecodeSound(const char *path, size_t *len)
 {
-	Mix_Chunk *data = Mix_LoadWAV(path);
-	if (data == NULL)
-	{
-		return;
-	}
-	char buf[CDOGS_FILENAME_MAX];
-	PathGetWithoutExtension(buf, name);
-	SoundAdd(&device->sounds, buf, data);
+	// Chunks hold pointers, so sounds aren't cached
+	(void)len;
+	return Mix_LoadWAV(path);
 }
 void SoundAdd(CArray *sounds, const char *name, Mix_Chunk *data)
 {
@@ -111,11 +108,14 @@ void SoundAdd(CArray *sounds, const char *name, Mix_Chunk *data)
 	CArrayPushBack(sounds, &sound);
 }
 
-static void SoundLoadDirImpl(
-	SoundDevice *s, const char *path, const char *prefix);
+static const char *SoundDataName(const void *data);
+static void SoundLoadDir(SoundDevice *s, const char *path);
 void SoundInitialize(SoundDevice *device, const char *path)
 {
 	memset(device, 0, sizeof *device);
+	AssetRegistryInit(
+		&device->registry, &device->sounds, &device->customSounds,
+		SoundDataName);
 	if (OpenAudio(44100, AUDIO_S16, 2, 1024) != 0)
 	{
 		return;
@@ -128,7 +128,8 @@ void SoundInitialize(SoundDevice *device, const char *path)
 	CArrayInit(&device->customSounds, sizeof(SoundData));
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
-	SoundLoadDirImpl(device, buf, NULL);
+	SoundLoadDir(device, buf);
+	AssetRegistryIndex(&device->registry);
 
 	// Look for commonly used sounds to set our pointers
 	CArrayInit(&device->footstepSounds, sizeof(Mix_Chunk *));
@@ -156,44 +157,26 @@ void SoundInitialize(SoundDevice *device, const char *path)
 		CArrayPushBack(&device->screamSounds, &scream);
 	}
 }
-static void SoundLoadDirImpl(
-	SoundDevice *s, const char *path, const char *prefix)
+static const char *SoundDataName(const void *data)
 {
-	tinydir_dir dir;
-	if (tinydir_open(&dir, path) == -1)
-	{
-		LOG(LM_MAIN, LL_ERROR, "Cannot open sound dir '%s'", path);
-		goto bail;
-	}
-	for (; dir.has_next; tinydir_next(&dir))
-	{
-		tinydir_file file;
-		if (tinydir_readfile(&dir, &file) == -1)
-		{
-			LOG(LM_MAIN, LL_ERROR, "Cannot read sound file '%s'", file.path);
-			continue;
-		}
-		char buf[CDOGS_PATH_MAX];
-		if (prefix != NULL)
-		{
-			sprintf(buf, "%s/%s", prefix, file.name);
-		}
-		else
-		{
-			strcpy(buf, file.name);
-		}
-		if (file.is_reg)
-		{
-			LoadSound(s, buf, file.path);
-		}
-		else if (file.is_dir && file.name[0] != '.')
-		{
-			SoundLoadDirImpl(s, file.path, buf);
-		}
-	}
-
-bail:
-	tinydir_close(&dir);
+	const SoundData *sound = data;
+	return sound->Name;
+}
+static void SoundLoadDir(SoundDevice *s, const char *path)
+{
+	// Decode the sounds in parallel, then add them in directory order
+	AssetLoad l;
+	AssetLoadInit(&l, "sound");
+	AssetLoadScan(&l, path);
+	AssetLoadDecode(&l, DecodeSound);
+	CA_FOREACH(const AssetFile, f, l.Files)
+		if (f->Data == NULL) continue;
+		char buf[CDOGS_FILENAME_MAX];
+		PathGetWithoutExtension(buf, f->Name);
+		SoundAdd(&s->sounds, buf, f->Data);
+	CA_FOREACH_END()
+	AssetLoadLogTimes(&l);
+	AssetLoadTerminate(&l);
 }
 
 void SoundReconfigure(SoundDevice *s)
@@ -206,9 +189,9 @@ void SoundReconfigure(SoundDevice *s)
 		return;
 	}
 
-	Mix_Volume(-1, ConfigGetInt(&gConfig, "Sound.SoundVolume"));
-	Mix_VolumeMusic(ConfigGetInt(&gConfig, "Sound.MusicVolume"));
-	if (ConfigGetInt(&gConfig, "Sound.MusicVolume") > 0)
+	Mix_Volume(-1, ConfigHandleGetInt(&configSoundVolume));
+	Mix_VolumeMusic(ConfigHandleGetInt(&configMusicVolume));
+	if (ConfigHandleGetInt(&configMusicVolume) > 0)
 	{
 		MusicResume(s);
 	}
@@ -231,6 +214,7 @@ void SoundClear(CArray *sounds)
 }
 void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete)
 {
+	AssetRegistryTerminate(&device->registry);
 	if (!device->isInitialised)
 	{
 		return;
@@ -316,7 +300,7 @@ static void SoundPlayAtPosition(
 			return;
 		}
 		// When allocating new channels, need to reset their volume
-		Mix_Volume(-1, ConfigGetInt(&gConfig, "Sound.SoundVolume"));
+		Mix_Volume(-1, ConfigHandleGetInt(&configSoundVolume));
 	}
 	Mix_SetPosition(channel, (Sint16)bearing, (Uint8)distance);
 	if (isMuffled)
@@ -436,27 +420,25 @@ void SoundPlayAtPlusDistance(
 
 Mix_Chunk *StrSound(const char *s)
 {
-	if (s == NULL || strlen(s) == 0)
-	{
-		return NULL;
-	}
-	CA_FOREACH(SoundData, sound, gSoundDevice.customSounds)
-		if (strcmp(sound->Name, s) == 0)
-		{
-			return sound->data;
-		}
-	CA_FOREACH_END()
-	CA_FOREACH(SoundData, sound, gSoundDevice.sounds)
-		if (strcmp(sound->Name, s) == 0)
-		{
-			return sound->data;
-		}
-	CA_FOREACH_END()
-	return NULL;
+	return IdSound(StrSoundId(s));
+}
+int StrSoundId(const char *s)
+{
+	return AssetRegistryFind(&gSoundDevice.registry, s);
+}
+Mix_Chunk *IdSound(const int id)
+{
+	const SoundData *sound = AssetRegistryGet(&gSoundDevice.registry, id);
+	return sound != NULL ? sound->data : NULL;
 }
 
 Mix_Chunk *SoundGetRandomFootstep(SoundDevice *device)
 {
+	// No sounds loaded if there is no sound device
+	if (device->footstepSounds.size == 0)
+	{
+		return NULL;
+	}
 	Mix_Chunk **sound = CArrayGet(
 		&device->footstepSounds, rand() % device->footstepSounds.size);
 	return *sound;
@@ -464,6 +446,10 @@ Mix_Chunk *SoundGetRandomFootstep(SoundDevice *device)
 
 Mix_Chunk *SoundGetRandomScream(SoundDevice *device)
 {
+	if (device->screamSounds.size == 0)
+	{
+		return NULL;
+	}
 	// Don't get the last scream used
 	int idx = device->lastScream;
 	while ((int)device->screamSounds.size > 1 && idx == device->lastScream)
@@ -52,6 +52,7 @@
 
 #include <SDL_mixer.h>
 
+#include "asset_registry.h"
 #include "c_array.h"
 #include "defs.h"
 #include "sys_config.h"
@@ -88,6 +89,7 @@ typedef struct
 
 	CArray sounds;	// of SoundData
 	CArray customSounds;	// of SoundData
+	AssetRegistry registry;	// of sounds and customSounds
 
 	// Some commonly-used sounds, store them here for quick access
 	CArray footstepSounds;	// of Mix_Chunk *
@@ -138,5 +140,9 @@ void SoundPlayAtPlusDistance(
 	const Vec2i pos, const int plusDistance);
 
 Mix_Chunk *StrSound(const char *s);
+// Sound IDs are interned at load time, for sending sounds in events;
+// -1 is no sound
+int StrSoundId(const char *s);
+Mix_Chunk *IdSound(const int id);
 Mix_Chunk *SoundGetRandomFootstep(SoundDevice *device);
 Mix_Chunk *SoundGetRandomScream(SoundDevice *device);
@@ -76,3 +76,10 @@
 #ifndef __func__
 #define __func__ __FUNCTION__
 #endif
+
+// Variables with one instance per thread
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
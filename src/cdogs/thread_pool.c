@@ -0,0 +1,132 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "thread_pool.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "utils.h"
+
+
+static int WorkerMain(void *data);
+void ThreadPoolInit(ThreadPool *p, const int numWorkers)
+{
+	memset(p, 0, sizeof *p);
+	CArrayInit(&p->workers, sizeof(SDL_Thread *));
+	p->lock = SDL_CreateMutex();
+	p->start = SDL_CreateCond();
+	p->done = SDL_CreateCond();
+	for (int i = 0; i < numWorkers; i++)
+	{
+		SDL_Thread *t = SDL_CreateThread(WorkerMain, "ThreadPool", p);
+		if (t == NULL)
+		{
+			// Fewer workers only means less parallelism
+			LOG(LM_MAIN, LL_WARN, "cannot create worker thread: %s",
+				SDL_GetError());
+			break;
+		}
+		CArrayPushBack(&p->workers, &t);
+	}
+}
+void ThreadPoolTerminate(ThreadPool *p)
+{
+	SDL_LockMutex(p->lock);
+	p->quit = true;
+	SDL_CondBroadcast(p->start);
+	SDL_UnlockMutex(p->lock);
+	CA_FOREACH(SDL_Thread *, t, p->workers)
+		SDL_WaitThread(*t, NULL);
+	CA_FOREACH_END()
+	CArrayTerminate(&p->workers);
+	SDL_DestroyCond(p->done);
+	SDL_DestroyCond(p->start);
+	SDL_DestroyMutex(p->lock);
+}
+
+// Claim and process items of the current run until there are none left
+// Must be called with the lock held, and returns with it held
+static void WorkOnRun(ThreadPool *p)
+{
+	while (p->next < p->count)
+	{
+		void *item = p->items + p->next * p->itemSize;
+		p->next++;
+		SDL_UnlockMutex(p->lock);
+		p->func(item);
+		SDL_LockMutex(p->lock);
+		p->remaining--;
+		if (p->remaining == 0)
+		{
+			SDL_CondBroadcast(p->done);
+		}
+	}
+}
+static int WorkerMain(void *data)
+{
+	ThreadPool *p = data;
+	SDL_LockMutex(p->lock);
+	int lastRun = p->run;
+	for (;;)
+	{
+		while (!p->quit && p->run == lastRun)
+		{
+			SDL_CondWait(p->start, p->lock);
+		}
+		if (p->quit)
+		{
+			break;
+		}
+		lastRun = p->run;
+		WorkOnRun(p);
+	}
+	SDL_UnlockMutex(p->lock);
+	return 0;
+}
+
+void ThreadPoolRun(
+	ThreadPool *p, ThreadPoolFunc func, void *items, const size_t itemSize,
+	const int count)
+{
+	SDL_LockMutex(p->lock);
+	p->func = func;
+	p->items = items;
+	p->itemSize = itemSize;
+	p->count = count;
+	p->next = 0;
+	p->remaining = count;
+	p->run++;
+	SDL_CondBroadcast(p->start);
+	WorkOnRun(p);
+	while (p->remaining > 0)
+	{
+		SDL_CondWait(p->done, p->lock);
+	}
+	SDL_UnlockMutex(p->lock);
+}
@@ -0,0 +1,69 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#include "c_array.h"
+
+typedef void (*ThreadPoolFunc)(void *item);
+
+// Worker threads that run a function over an array of items in parallel.
+// The thread that starts a run works on the items too, so a pool with no
+// workers simply runs everything on the calling thread.
+typedef struct
+{
+	CArray workers;	// of SDL_Thread *
+	SDL_mutex *lock;
+	SDL_cond *start;	// signalled when a run starts or the pool quits
+	SDL_cond *done;	// signalled when the last item of a run is done
+	int run;	// incremented for every run
+	bool quit;
+
+	// Current run
+	ThreadPoolFunc func;
+	char *items;
+	size_t itemSize;
+	int count;
+	int next;	// next item to claim
+	int remaining;	// items claimed but not done, plus unclaimed
+} ThreadPool;
+
+void ThreadPoolInit(ThreadPool *p, const int numWorkers);
+void ThreadPoolTerminate(ThreadPool *p);
+
+// Call func on each of the count items, itemSize bytes apart, and return
+// once all the calls have finished
+void ThreadPoolRun(
+	ThreadPool *p, ThreadPoolFunc func, void *items, const size_t itemSize,
+	const int count);
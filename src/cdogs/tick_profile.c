@@ -0,0 +1,154 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "tick_profile.h"
+
+#include <SDL_timer.h>
+
+#include "utils.h"
+
+
+TickProfile gTickProfile;
+
+
+const char *TickSectionStr(const TickSection s)
+{
+	switch (s)
+	{
+		T2S(TICK_SECTION_LOS, "LOS");
+		T2S(TICK_SECTION_PLAYERS, "Players");
+		T2S(TICK_SECTION_AI, "AI");
+		T2S(TICK_SECTION_ACTORS, "Actors");
+		T2S(TICK_SECTION_OBJECTS, "Objects");
+		T2S(TICK_SECTION_MOBILE_OBJECTS, "Mobile objects");
+		T2S(TICK_SECTION_PARTICLES, "Particles");
+		T2S(TICK_SECTION_WATCHES, "Watches");
+		T2S(TICK_SECTION_GAME_EVENTS, "Game events");
+		T2S(TICK_SECTION_RENDER, "Render");
+	default:
+		return "";
+	}
+}
+
+void TickProfileInit(TickProfile *p)
+{
+	memset(p, 0, sizeof *p);
+	CArrayInit(&p->TickTimes, sizeof(Uint64));
+}
+void TickProfileTerminate(TickProfile *p)
+{
+	CArrayTerminate(&p->TickTimes);
+}
+void TickProfileReset(TickProfile *p)
+{
+	memset(p->SectionTotals, 0, sizeof p->SectionTotals);
+	CArrayClear(&p->TickTimes);
+}
+
+void TickProfileTickBegin(TickProfile *p)
+{
+	if (!p->Enabled) return;
+	p->tickStart = SDL_GetPerformanceCounter();
+}
+void TickProfileTickEnd(TickProfile *p)
+{
+	if (!p->Enabled) return;
+	const Uint64 elapsed = SDL_GetPerformanceCounter() - p->tickStart;
+	CArrayPushBack(&p->TickTimes, &elapsed);
+}
+void TickProfileSectionBegin(TickProfile *p)
+{
+	if (!p->Enabled) return;
+	p->sectionStart = SDL_GetPerformanceCounter();
+}
+void TickProfileSectionEnd(TickProfile *p, const TickSection s)
+{
+	if (!p->Enabled) return;
+	p->SectionTotals[s] += SDL_GetPerformanceCounter() - p->sectionStart;
+}
+
+double TickProfileGetTotalSeconds(const TickProfile *p)
+{
+	Uint64 total = 0;
+	CA_FOREACH(const Uint64, t, p->TickTimes)
+		total += *t;
+	CA_FOREACH_END()
+	return (double)total / SDL_GetPerformanceFrequency();
+}
+static int CompareUint64(const void *v1, const void *v2);
+double TickProfileGetPercentileMs(const TickProfile *p, const double pct)
+{
+	if (p->TickTimes.size == 0)
+	{
+		return 0;
+	}
+	CArray sorted;
+	CArrayInit(&sorted, sizeof(Uint64));
+	CArrayCopy(&sorted, &p->TickTimes);
+	qsort(sorted.data, sorted.size, sorted.elemSize, CompareUint64);
+	// Nearest-rank percentile
+	int idx = (int)(pct / 100.0 * sorted.size + 0.5) - 1;
+	idx = CLAMP(idx, 0, (int)sorted.size - 1);
+	const Uint64 t = *(const Uint64 *)CArrayGet(&sorted, idx);
+	CArrayTerminate(&sorted);
+	return t * 1000.0 / SDL_GetPerformanceFrequency();
+}
+static int CompareUint64(const void *v1, const void *v2)
+{
+	const Uint64 a = *(const Uint64 *)v1;
+	const Uint64 b = *(const Uint64 *)v2;
+	if (a < b) return -1;
+	if (a > b) return 1;
+	return 0;
+}
+double TickProfileGetSectionMs(const TickProfile *p, const TickSection s)
+{
+	return p->SectionTotals[s] * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void TickProfilePrint(const TickProfile *p, FILE *f)
+{
+	const int ticks = (int)p->TickTimes.size;
+	const double totalSeconds = TickProfileGetTotalSeconds(p);
+	fprintf(f, "Ticks:      %d\n", ticks);
+	fprintf(f, "Total:      %.3f s\n", totalSeconds);
+	fprintf(f, "Ticks/sec:  %.1f\n",
+		totalSeconds > 0 ? ticks / totalSeconds : 0.0);
+	fprintf(f, "Tick p50:   %.4f ms\n", TickProfileGetPercentileMs(p, 50));
+	fprintf(f, "Tick p99:   %.4f ms\n", TickProfileGetPercentileMs(p, 99));
+	fprintf(f, "Tick max:   %.4f ms\n", TickProfileGetPercentileMs(p, 100));
+	fprintf(f, "%-16s %12s %12s %7s\n", "Subsystem", "total ms", "ms/tick", "%");
+	for (int i = 0; i < (int)TICK_SECTION_COUNT; i++)
+	{
+		const double ms = TickProfileGetSectionMs(p, (TickSection)i);
+		fprintf(f, "%-16s %12.3f %12.4f %6.1f%%\n",
+			TickSectionStr((TickSection)i), ms,
+			ticks > 0 ? ms / ticks : 0.0,
+			totalSeconds > 0 ? ms / 10.0 / totalSeconds : 0.0);
+	}
+}
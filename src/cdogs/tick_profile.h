@@ -0,0 +1,81 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <SDL_stdinc.h>
+
+#include "c_array.h"
+
+// Subsystems of the game update that are timed separately
+typedef enum
+{
+	TICK_SECTION_LOS,
+	TICK_SECTION_PLAYERS,
+	TICK_SECTION_AI,
+	TICK_SECTION_ACTORS,
+	TICK_SECTION_OBJECTS,
+	TICK_SECTION_MOBILE_OBJECTS,
+	TICK_SECTION_PARTICLES,
+	TICK_SECTION_WATCHES,
+	TICK_SECTION_GAME_EVENTS,
+	TICK_SECTION_RENDER,
+	TICK_SECTION_COUNT
+} TickSection;
+const char *TickSectionStr(const TickSection s);
+
+// Per-tick and per-subsystem timings of the game update.
+// Disabled by default; when disabled all the timing calls are no-ops.
+typedef struct
+{
+	bool Enabled;
+	Uint64 tickStart;
+	Uint64 sectionStart;
+	Uint64 SectionTotals[TICK_SECTION_COUNT];
+	CArray TickTimes;	// of Uint64, in performance counter units
+} TickProfile;
+extern TickProfile gTickProfile;
+
+void TickProfileInit(TickProfile *p);
+void TickProfileTerminate(TickProfile *p);
+void TickProfileReset(TickProfile *p);
+
+void TickProfileTickBegin(TickProfile *p);
+void TickProfileTickEnd(TickProfile *p);
+void TickProfileSectionBegin(TickProfile *p);
+void TickProfileSectionEnd(TickProfile *p, const TickSection s);
+
+// Total time of all ticks, in seconds
+double TickProfileGetTotalSeconds(const TickProfile *p);
+// Time of the tick at the given percentile (0-100), in milliseconds
+double TickProfileGetPercentileMs(const TickProfile *p, const double pct);
+double TickProfileGetSectionMs(const TickProfile *p, const TickSection s);
+void TickProfilePrint(const TickProfile *p, FILE *f);
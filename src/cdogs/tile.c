@@ -147,7 +147,7 @@ TTileItem *ThingIdGetTileItem(ThingId *tid)
 		ti = &((TActor *)CArrayGet(&gActors, tid->Id))->tileItem;
 		break;
 	case KIND_PARTICLE:
-		ti = &((Particle *)CArrayGet(&gParticles, tid->Id))->tileItem;
+		ti = ParticleGetTileItem(&gParticles, tid->Id);
 		break;
 	case KIND_MOBILEOBJECT:
 		ti = &((TMobileObject *)CArrayGet(
@@ -79,7 +79,8 @@ typedef enum
 	MAPTILE_OFFSET_PIC		= 0x0080,
 // These constants are used internally in draw, it is never set in the map
 	MAPTILE_DELAY_DRAW		= 0x0100,
-	MAPTILE_OUT_OF_SIGHT	= 0x0200
+	MAPTILE_OUT_OF_SIGHT	= 0x0200,
+	MAPTILE_HIDE_PIC		= 0x0400
 } MapTileFlags;
 
 typedef enum
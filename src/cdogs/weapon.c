@@ -62,6 +62,8 @@
 #include "objs.h"
 #include "sounds.h"
 
+static ConfigHandle configReloads = CONFIG_HANDLE("Sound.Reloads");
+
 GunClasses gGunDescriptions;
 
 const TOffsetPic cGunPics[GUNPIC_COUNT][DIRECTION_COUNT][GUNSTATE_COUNT] = {
@@ -102,11 +104,18 @@ const OffsetTable cMuzzleOffset[GUNPIC_COUNT] = {
 
 // Initialise all the static weapon data
 #define VERSION 1
+static const char *GunDescriptionName(const void *g);
 void WeaponInitialize(GunClasses *g)
 {
 	memset(g, 0, sizeof *g);
 	CArrayInit(&g->Guns, sizeof(GunDescription));
 	CArrayInit(&g->CustomGuns, sizeof(GunDescription));
+	AssetRegistryInit(
+		&g->registry, &g->Guns, &g->CustomGuns, GunDescriptionName);
+}
+static const char *GunDescriptionName(const void *g)
+{
+	return ((const GunDescription *)g)->name;
 }
 static void LoadGunDescription(
 	GunDescription *g, json_t *node, const GunDescription *defaultGun);
@@ -185,6 +194,7 @@ void WeaponLoadJSON(GunClasses *g, CArray *classes, json_t *root)
 			CArrayPushBack(classes, &gd);
 		}
 	}
+	AssetRegistryIndex(&g->registry);
 }
 static void LoadGunDescription(
 	GunDescription *g, json_t *node, const GunDescription *defaultGun)
@@ -339,6 +349,7 @@ static void LoadGunDescription(
 }
 void WeaponTerminate(GunClasses *g)
 {
+	AssetRegistryTerminate(&g->registry);
 	WeaponClassesClear(&g->Guns);
 	CArrayTerminate(&g->Guns);
 	WeaponClassesClear(&g->CustomGuns);
@@ -371,59 +382,27 @@ Weapon WeaponCreate(const GunDescription *gun)
 	return w;
 }
 
-// TODO: use map structure?
 const GunDescription *StrGunDescription(const char *s)
 {
-	CA_FOREACH(const GunDescription, gd, gGunDescriptions.CustomGuns)
-		if (strcmp(s, gd->name) == 0)
-		{
-			return gd;
-		}
-	CA_FOREACH_END()
-	CA_FOREACH(const GunDescription, gd, gGunDescriptions.Guns)
-		if (strcmp(s, gd->name) == 0)
-		{
-			return gd;
-		}
-	CA_FOREACH_END()
-	fprintf(stderr, "Cannot parse gun name: %s\n", s);
-	return NULL;
+	const int id = AssetRegistryFind(&gGunDescriptions.registry, s);
+	if (id < 0)
+	{
+		fprintf(stderr, "Cannot parse gun name: %s\n", s);
+		return NULL;
+	}
+	return IdGunDescription(id);
 }
 GunDescription *IdGunDescription(const int i)
 {
-	CASSERT(
-		i >= 0 &&
-		i < (int)gGunDescriptions.Guns.size +
-		(int)gGunDescriptions.CustomGuns.size,
-		"Gun index out of bounds");
-	if (i < (int)gGunDescriptions.Guns.size)
-	{
-		return CArrayGet(&gGunDescriptions.Guns, i);
-	}
-	return CArrayGet(
-		&gGunDescriptions.CustomGuns, i - gGunDescriptions.Guns.size);
+	GunDescription *g = AssetRegistryGet(&gGunDescriptions.registry, i);
+	CASSERT(g != NULL, "Gun index out of bounds");
+	return g;
 }
 int GunDescriptionId(const GunDescription *g)
 {
-	int idx = 0;
-	for (int i = 0; i < (int)gGunDescriptions.Guns.size; i++, idx++)
-	{
-		const GunDescription *c = CArrayGet(&gGunDescriptions.Guns, i);
-		if (c == g)
-		{
-			return idx;
-		}
-	}
-	for (int i = 0; i < (int)gGunDescriptions.CustomGuns.size; i++, idx++)
-	{
-		const GunDescription *c = CArrayGet(&gGunDescriptions.CustomGuns, i);
-		if (c == g)
-		{
-			return idx;
-		}
-	}
-	CASSERT(false, "cannot find gun");
-	return -1;
+	const int id = AssetRegistryId(&gGunDescriptions.registry, g);
+	CASSERT(id >= 0, "cannot find gun");
+	return id;
 }
 
 void WeaponUpdate(
@@ -431,7 +410,7 @@ void WeaponUpdate(
 	const int playerUID)
 {
 	// Reload sound
-	if (ConfigGetBool(&gConfig, "Sound.Reloads") &&
+	if (ConfigHandleGetBool(&configReloads) &&
 		w->lock > w->Gun->ReloadLead &&
 		w->lock - ticks <= w->Gun->ReloadLead &&
 		w->lock > 0 &&
@@ -439,7 +418,7 @@ void WeaponUpdate(
 	{
 		GameEvent e = GameEventNew(GAME_EVENT_GUN_RELOAD);
 		e.u.GunReload.PlayerUID = playerUID;
-		strcpy(e.u.GunReload.Gun, w->Gun->name);
+		e.u.GunReload.GunId = GunDescriptionId(w->Gun);
 		e.u.GunReload.FullPos = Vec2i2Net(fullPos);
 		e.u.GunReload.Direction = (int)d;
 		GameEventsEnqueue(&gGameEvents, e);
@@ -514,7 +493,7 @@ void GunFire(
 	GameEvent e = GameEventNew(GAME_EVENT_GUN_FIRE);
 	e.u.GunFire.UID = uid;
 	e.u.GunFire.PlayerUID = playerUID;
-	strcpy(e.u.GunFire.Gun, g->name);
+	e.u.GunFire.GunId = GunDescriptionId(g);
 	e.u.GunFire.MuzzleFullPos = Vec2i2Net(fullPos);
 	e.u.GunFire.Z = z;
 	e.u.GunFire.Angle = (float)radians;
@@ -133,6 +133,7 @@ typedef struct
 	CArray Guns;	// of GunDescription
 	GunDescription Default;
 	CArray CustomGuns;	// of GunDescription
+	AssetRegistry registry;	// of Guns and CustomGuns
 } GunClasses;
 
 typedef struct
@@ -1326,7 +1326,8 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 	FontLoadFromJSON(&gFont, "graphics/font.png", "graphics/font.json");
-	PicManagerLoadDir(&gPicManager, "graphics");
+	PicManagerLoadDir(
+		&gPicManager, "graphics", GetConfigFilePath(GRAPHICS_CACHE_FILE));
 
 	ParticleClassesInit(&gParticleClasses, "data/particles.json");
 	AmmoInitialize(&gAmmo, "data/ammo.json");
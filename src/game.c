@@ -80,14 +80,21 @@
 #include <cdogs/pic_manager.h>
 #include <cdogs/pics.h>
 #include <cdogs/powerup.h>
+#include <cdogs/tick_profile.h>
 #include <cdogs/triggers.h>
 
+static ConfigHandle configFPS = CONFIG_HANDLE("Game.FPS");
+static ConfigHandle configMapKey = CONFIG_HANDLE("Input.PlayerCodes0.map");
+static ConfigHandle configSplitscreen = CONFIG_HANDLE("Interface.Splitscreen");
+static ConfigHandle configStartServer = CONFIG_HANDLE("StartServer");
+static ConfigHandle configSwitchMoveStyle = CONFIG_HANDLE("Game.SwitchMoveStyle");
+
 
 static void PlayerSpecialCommands(TActor *actor, const int cmd)
 {
 	if ((cmd & CMD_BUTTON2) && CMD_HAS_DIRECTION(cmd))
 	{
-		if (ConfigGetEnum(&gConfig, "Game.SwitchMoveStyle") == SWITCHMOVE_SLIDE)
+		if (ConfigHandleGetEnum(&configSwitchMoveStyle) == SWITCHMOVE_SLIDE)
 		{
 			SlideActor(actor, cmd);
 		}
@@ -97,7 +104,7 @@ static void PlayerSpecialCommands(TActor *actor, const int cmd)
 		!(cmd & CMD_BUTTON2) &&
 		!actor->specialCmdDir &&
 		!actor->CanPickupSpecial &&
-		!(ConfigGetEnum(&gConfig, "Game.SwitchMoveStyle") == SWITCHMOVE_SLIDE && CMD_HAS_DIRECTION(cmd)) &&
+		!(ConfigHandleGetEnum(&configSwitchMoveStyle) == SWITCHMOVE_SLIDE && CMD_HAS_DIRECTION(cmd)) &&
 		ActorCanSwitchGun(actor))
 	{
 		GameEvent e = GameEventNew(GAME_EVENT_ACTOR_SWITCH_GUN);
@@ -173,13 +180,48 @@ typedef struct
 static void RunGameInput(void *data);
 static GameLoopResult RunGameUpdate(void *data);
 static void RunGameDraw(void *data);
+static bool RunGameImpl(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const bool headless, GameLoopData *headlessLoop);
 bool RunGame(const CampaignOptions *co, struct MissionOptions *m, Map *map)
+{
+	return RunGameImpl(co, m, map, false, NULL);
+}
+bool RunGameHeadless(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const int maxFrames, const bool draw, Uint32 *frameHash)
+{
+	GameLoopData loop;
+	memset(&loop, 0, sizeof loop);
+	loop.HeadlessDraw = draw;
+	loop.FrameHash = frameHash;
+	loop.MaxFrames = maxFrames;
+	return RunGameImpl(co, m, map, true, &loop);
+}
+int RunGameDedicated(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const int maxFrames, volatile sig_atomic_t *quit)
+{
+	GameLoopData loop;
+	memset(&loop, 0, sizeof loop);
+	loop.MaxFrames = maxFrames;
+	loop.HeadlessRealtime = true;
+	loop.HeadlessQuit = quit;
+	RunGameImpl(co, m, map, true, &loop);
+	return loop.Frames;
+}
+// headlessLoop has the headless options of the game loop, and gets the
+// loop's state after the game finishes
+static bool RunGameImpl(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const bool headless, GameLoopData *headlessLoop)
 {
 	MapLoad(map, m, co);
 
 	// Seed random if PVP mode (otherwise players will always spawn in same
 	// position)
-	if (IsPVP(co->Entry.Mode))
+	// Headless games keep the campaign seed so that they are deterministic
+	if (IsPVP(co->Entry.Mode) && !headless)
 	{
 		srand((unsigned int)time(NULL));
 	}
@@ -246,12 +288,15 @@ bool RunGame(const CampaignOptions *co, struct MissionOptions *m, Map *map)
 	m->state = MISSION_STATE_WAITING;
 	m->isDone = false;
 	m->DoneCounter = 0;
-	Pic *crosshair = PicManagerGetPic(&gPicManager, "crosshair");
-	crosshair->offset.x = -crosshair->size.x / 2;
-	crosshair->offset.y = -crosshair->size.y / 2;
-	EventReset(
-		&gEventHandlers, crosshair,
-		PicManagerGetPic(&gPicManager, "crosshair_trail"));
+	if (!headless)
+	{
+		Pic *crosshair = PicManagerGetPic(&gPicManager, "crosshair");
+		crosshair->offset.x = -crosshair->size.x / 2;
+		crosshair->offset.y = -crosshair->size.y / 2;
+		EventReset(
+			&gEventHandlers, crosshair,
+			PicManagerGetPic(&gPicManager, "crosshair_trail"));
+	}
 
 	NetServerSendGameStartMessages(&gNetServer, NET_SERVER_BCAST);
 	GameEvent start = GameEventNew(GAME_EVENT_GAME_START);
@@ -261,9 +306,22 @@ bool RunGame(const CampaignOptions *co, struct MissionOptions *m, Map *map)
 		&data, RunGameUpdate, &data, RunGameDraw);
 	data.loop.InputData = &data;
 	data.loop.InputFunc = RunGameInput;
-	data.loop.FPS = ConfigGetInt(&gConfig, "Game.FPS");
+	data.loop.FPS = ConfigHandleGetInt(&configFPS);
 	data.loop.InputEverySecondFrame = true;
+	data.loop.Headless = headless;
+	if (headless)
+	{
+		data.loop.HeadlessDraw = headlessLoop->HeadlessDraw;
+		data.loop.FrameHash = headlessLoop->FrameHash;
+		data.loop.MaxFrames = headlessLoop->MaxFrames;
+		data.loop.HeadlessRealtime = headlessLoop->HeadlessRealtime;
+		data.loop.HeadlessQuit = headlessLoop->HeadlessQuit;
+	}
 	GameLoop(&data.loop);
+	if (headless)
+	{
+		*headlessLoop = data.loop;
+	}
 	LOG(LM_MAIN, LL_INFO, "Game finished");
 
 	// Flush events
@@ -355,7 +413,7 @@ static void RunGameInput(void *data)
 	// Check if automap key is pressed by any player
 	// Toggle
 	if (IsAutoMapEnabled(gCampaign.Entry.Mode) &&
-		(KeyIsPressed(&gEventHandlers.keyboard, ConfigGetInt(&gConfig, "Input.PlayerCodes0.map")) ||
+		(KeyIsPressed(&gEventHandlers.keyboard, ConfigHandleGetInt(&configMapKey)) ||
 		((cmdAll & CMD_MAP) && !(lastCmdAll & CMD_MAP))))
 	{
 		rData->isMap = !rData->isMap;
@@ -434,7 +492,7 @@ static GameLoopResult RunGameUpdate(void *data)
 		rData->controllerUnplugged ||
 		rData->isMap;
 	if (!gCampaign.IsClient &&
-		!ConfigGetBool(&gConfig, "StartServer") &&
+		!ConfigHandleGetBool(&configStartServer) &&
 		paused &&
 		!gEventHandlers.HasQuit)
 	{
@@ -454,10 +512,12 @@ static GameLoopResult RunGameUpdate(void *data)
 			TActor *player = ActorGetByUID(p->ActorUID);
 			if (player->dead > DEATH_MAX) continue;
 			// Calculate LOS for all players alive or dying
+			TickProfileSectionBegin(&gTickProfile);
 			LOSCalcFrom(
 				&gMap,
 				Vec2iToTile(Vec2iNew(player->tileItem.x, player->tileItem.y)),
 				!gCampaign.IsClient);
+			TickProfileSectionEnd(&gTickProfile, TICK_SECTION_LOS);
 
 			if (player->dead) continue;
 
@@ -467,23 +527,27 @@ static GameLoopResult RunGameUpdate(void *data)
 				idx--;
 				continue;
 			}
+			TickProfileSectionBegin(&gTickProfile);
 			if (p->inputDevice == INPUT_DEVICE_AI)
 			{
 				rData->cmds[idx] = AICoopGetCmd(player, ticksPerFrame);
 			}
 			PlayerSpecialCommands(player, rData->cmds[idx]);
 			CommandActor(player, rData->cmds[idx], ticksPerFrame);
+			TickProfileSectionEnd(&gTickProfile, TICK_SECTION_PLAYERS);
 		}
 	}
 
 	if (!gCampaign.IsClient)
 	{
+		TickProfileSectionBegin(&gTickProfile);
 		CommandBadGuys(ticksPerFrame);
+		TickProfileSectionEnd(&gTickProfile, TICK_SECTION_AI);
 	}
 
 	// If split screen never and players are too close to the
 	// edge of the screen, forcefully pull them towards the center
-	if (ConfigGetEnum(&gConfig, "Interface.Splitscreen") == SPLITSCREEN_NEVER &&
+	if (ConfigHandleGetEnum(&configSplitscreen) == SPLITSCREEN_NEVER &&
 		GetNumPlayers(true, true, true) > 1 &&
 		!IsPVP(gCampaign.Entry.Mode))
 	{
@@ -530,12 +594,22 @@ static GameLoopResult RunGameUpdate(void *data)
 		CA_FOREACH_END()
 	}
 
+	TickProfileSectionBegin(&gTickProfile);
 	UpdateAllActors(ticksPerFrame);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_ACTORS);
+	TickProfileSectionBegin(&gTickProfile);
 	UpdateObjects(ticksPerFrame);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_OBJECTS);
+	TickProfileSectionBegin(&gTickProfile);
 	UpdateMobileObjects(ticksPerFrame);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_MOBILE_OBJECTS);
+	TickProfileSectionBegin(&gTickProfile);
 	ParticlesUpdate(&gParticles, ticksPerFrame);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_PARTICLES);
 
+	TickProfileSectionBegin(&gTickProfile);
 	UpdateWatches(&rData->map->triggers, ticksPerFrame);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_WATCHES);
 
 	PowerupSpawnerUpdate(&rData->healthSpawner, ticksPerFrame);
 	CA_FOREACH(PowerupSpawner, a, rData->ammoSpawners)
@@ -553,9 +627,21 @@ static GameLoopResult RunGameUpdate(void *data)
 		MissionDone(&gMission, me);
 	}
 
+	if (gCampaign.IsClient)
+	{
+		NetClientApplySnapshot(&gNetClient);
+	}
+
+	TickProfileSectionBegin(&gTickProfile);
 	HandleGameEvents(
 		&gGameEvents, &rData->Camera,
 		&rData->healthSpawner, &rData->ammoSpawners);
+	TickProfileSectionEnd(&gTickProfile, TICK_SECTION_GAME_EVENTS);
+
+	if (!gCampaign.IsClient)
+	{
+		NetServerSendSnapshot(&gNetServer);
+	}
 
 	rData->m->time += ticksPerFrame;
 
@@ -48,9 +48,25 @@
 */
 #pragma once
 
+#include <signal.h>
 #include <stdbool.h>
 
 #include <cdogs/map.h>
 #include <cdogs/mission.h>
 
 bool RunGame(const CampaignOptions *co, struct MissionOptions *m, Map *map);
+// Run the game without drawing, input or frame rate control,
+// for simulations and benchmarks. Only AI players are supported.
+// The game exits after maxFrames frames, if non-zero.
+// If draw is set, every frame is also drawn into the graphics buffer, and
+// hashed into frameHash if that is non-NULL.
+bool RunGameHeadless(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const int maxFrames, const bool draw, Uint32 *frameHash);
+// Run the game for a dedicated server: headless, but at the game's frame
+// rate, with no local players, until the mission ends, maxFrames frames
+// if non-zero, or quit becomes non-zero.
+// Returns the number of frames run.
+int RunGameDedicated(
+	const CampaignOptions *co, struct MissionOptions *m, Map *map,
+	const int maxFrames, volatile sig_atomic_t *quit);
@@ -429,35 +429,31 @@ void MenuAddConfigOptionsItem(menu_t *menu, Config *c)
 	char nameBuf[256];
 	CASSERT(strlen(c->Name) < sizeof nameBuf, "buffer too small");
 	CamelToTitle(nameBuf, c->Name);
+	menu_t *option = NULL;
 	switch (c->Type)
 	{
 	case CONFIG_TYPE_STRING:
 		CASSERT(false, "Unimplemented");
 		break;
 	case CONFIG_TYPE_INT:
-		MenuAddSubmenu(
-			menu,
-			MenuCreateOptionRange(
+		option = MenuCreateOptionRange(
 			nameBuf, (int *)&c->u.Int.Value,
 			c->u.Int.Min, c->u.Int.Max, c->u.Int.Increment,
 			MENU_OPTION_DISPLAY_STYLE_INT_TO_STR_FUNC,
-			(void (*)(void))c->u.Int.IntToStr));
+			(void (*)(void))c->u.Int.IntToStr);
 		break;
 	case CONFIG_TYPE_FLOAT:
 		CASSERT(false, "Unimplemented");
 		break;
 	case CONFIG_TYPE_BOOL:
-		MenuAddSubmenu(
-			menu, MenuCreateOptionToggle(nameBuf, &c->u.Bool.Value));
+		option = MenuCreateOptionToggle(nameBuf, &c->u.Bool.Value);
 		break;
 	case CONFIG_TYPE_ENUM:
-		MenuAddSubmenu(
-			menu,
-			MenuCreateOptionRange(
+		option = MenuCreateOptionRange(
 			nameBuf, (int *)&c->u.Enum.Value,
 			c->u.Enum.Min, c->u.Enum.Max, 1,
 			MENU_OPTION_DISPLAY_STYLE_INT_TO_STR_FUNC,
-			(void(*)(void))c->u.Enum.EnumToStr));
+			(void(*)(void))c->u.Enum.EnumToStr);
 		break;
 	case CONFIG_TYPE_GROUP:
 		// Do nothing
@@ -466,6 +462,11 @@ void MenuAddConfigOptionsItem(menu_t *menu, Config *c)
 		CASSERT(false, "Unknown config type");
 		break;
 	}
+	if (option != NULL)
+	{
+		option->u.option.config = c;
+		MenuAddSubmenu(menu, option);
+	}
 }
 
 menu_t *MenuCreateOptionToggle(const char *name, bool *config)
@@ -1195,6 +1196,14 @@ void MenuChangeIndex(menu_t *menu, int cmd)
 }
 
 
+// Let listeners, such as the brightness preview, see options as they change
+static void NotifyConfigChanged(menu_t *menu)
+{
+	if (menu->u.option.config != NULL)
+	{
+		ConfigNotifyChanged(menu->u.option.config);
+	}
+}
 void MenuActivate(MenuSystem *ms, menu_t *menu, int cmd)
 {
 	UNUSED(ms);
@@ -1206,6 +1215,7 @@ void MenuActivate(MenuSystem *ms, menu_t *menu, int cmd)
 		return;
 	case MENU_TYPE_SET_OPTION_TOGGLE:
 		*menu->u.option.uHook.optionToggle = !*menu->u.option.uHook.optionToggle;
+		NotifyConfigChanged(menu);
 		break;
 	case MENU_TYPE_SET_OPTION_RANGE:
 		{
@@ -1244,6 +1254,7 @@ void MenuActivate(MenuSystem *ms, menu_t *menu, int cmd)
 				}
 			}
 			*menu->u.option.uHook.optionRange.option = option;
+			NotifyConfigChanged(menu);
 		}
 		break;
 	case MENU_TYPE_SET_OPTION_SEED:
@@ -200,6 +200,8 @@ struct menu
 				char *(*str)(void);
 				const char *(*intToStr)(int);
 			} uFunc;
+			// Config edited by this option, if any; notified on change
+			Config *config;
 		} option;
 		// change key
 		struct
@@ -0,0 +1,352 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL.h>
+
+#include <cdogs/ammo.h>
+#include <cdogs/character_class.h>
+#include <cdogs/collision.h>
+#include <cdogs/files.h>
+#include <cdogs/gamedata.h>
+#include <cdogs/grafx.h>
+#include <cdogs/log.h>
+#include <cdogs/map_object.h>
+#include <cdogs/mission.h>
+#include <cdogs/net_client.h>
+#include <cdogs/net_server.h>
+#include <cdogs/particle.h>
+#include <cdogs/pic_manager.h>
+#include <cdogs/pickup.h>
+#include <cdogs/player.h>
+#include <cdogs/player_template.h>
+
+#include "game.h"
+#include "XGetopt.h"
+
+// Dedicated server.
+// Runs a campaign's missions with no local players, video, sound or input,
+// at the game's frame rate, and serves them to clients over the network.
+// Completed missions advance to the next one; failed ones are replayed.
+// Memory and CPU use are reported on startup and exit, to help size how
+// many servers a machine can host.
+
+
+static void PrintHelp(void)
+{
+	printf("%s\n",
+		"Usage: cdogs-sdl-server [options] campaign\n"
+		"    campaign         Campaign file relative to the data dir\n"
+		"    --mission=n      Mission index to start at, from 0 (default 0)\n"
+		"    --fps=n          Game ticks per second (default "
+		TOSTRING(FPS_FRAMELIMIT) ")\n"
+		"    --ticks=n        Exit after running n ticks (default 0, run\n"
+		"                       until interrupted)\n"
+		"    --log=L          Enable logging for all modules at level L\n"
+	);
+}
+
+static volatile sig_atomic_t quit = 0;
+static void OnSignal(int sig)
+{
+	UNUSED(sig);
+	quit = 1;
+}
+
+// Value of a "Name: value kB" line from /proc/self/status; -1 if unknown
+static long ReadProcStatusKB(const char *name)
+{
+	long kb = -1;
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/status", "r");
+	if (f == NULL)
+	{
+		return -1;
+	}
+	char line[256];
+	while (fgets(line, sizeof line, f) != NULL)
+	{
+		if (strncmp(line, name, strlen(name)) == 0 &&
+			line[strlen(name)] == ':')
+		{
+			sscanf(line + strlen(name) + 1, "%ld", &kb);
+			break;
+		}
+	}
+	fclose(f);
+#else
+	UNUSED(name);
+#endif
+	return kb;
+}
+static void PrintUsage(
+	const char *when, const Uint32 startTicks, const int ticksRun)
+{
+	const double cpuSeconds = (double)clock() / CLOCKS_PER_SEC;
+	const double wallSeconds = (SDL_GetTicks() - startTicks) / 1000.0;
+	printf("Usage %s:\n", when);
+	const long rss = ReadProcStatusKB("VmRSS");
+	const long peak = ReadProcStatusKB("VmHWM");
+	if (rss >= 0)
+	{
+		printf("  Memory:     %.1f MB (peak %.1f MB)\n",
+			rss / 1024.0, peak / 1024.0);
+	}
+	else
+	{
+		printf("  Memory:     unknown\n");
+	}
+	printf("  CPU time:   %.2f s\n", cpuSeconds);
+	printf("  Wall time:  %.2f s\n", wallSeconds);
+	if (ticksRun > 0)
+	{
+		printf("  Ticks run:  %d\n", ticksRun);
+		printf("  CPU:        %.1f%% of a core, %.3f ms per tick\n",
+			wallSeconds > 0 ? cpuSeconds * 100 / wallSeconds : 0.0,
+			cpuSeconds * 1000 / ticksRun);
+	}
+	fflush(stdout);
+}
+
+static void RunMissions(const int maxTicks, int *ticksRun);
+int main(int argc, char *argv[])
+{
+	int err = EXIT_SUCCESS;
+	const char *campaignPath = NULL;
+	int missionIndex = 0;
+	int fps = FPS_FRAMELIMIT;
+	int maxTicks = 0;
+	int ticksRun = 0;
+
+	LogInit();
+	for (int i = 0; i < (int)LM_COUNT; i++)
+	{
+		LogModuleSetLevel((LogModule)i, LL_WARN);
+	}
+	// Connections are worth logging on a server
+	LogModuleSetLevel(LM_NET, LL_INFO);
+	{
+		struct option longopts[] =
+		{
+			{"mission",	required_argument,	NULL,	'm'},
+			{"fps",		required_argument,	NULL,	'f'},
+			{"ticks",	required_argument,	NULL,	't'},
+			{"log",		required_argument,	NULL,	1000},
+			{"help",	no_argument,		NULL,	'h'},
+			{0,			0,					NULL,	0}
+		};
+		int opt = 0;
+		int idx = 0;
+		while ((opt = getopt_long(argc, argv, "m:f:t:\0h", longopts, &idx)) != -1)
+		{
+			switch (opt)
+			{
+			case 'm':
+				missionIndex = MAX(atoi(optarg), 0);
+				break;
+			case 'f':
+				fps = CLAMP(atoi(optarg), 10, 120);
+				break;
+			case 't':
+				maxTicks = MAX(atoi(optarg), 0);
+				break;
+			case 1000:
+				{
+					const LogLevel ll = StrLogLevel(optarg);
+					for (int i = 0; i < (int)LM_COUNT; i++)
+					{
+						LogModuleSetLevel((LogModule)i, ll);
+					}
+				}
+				break;
+			case 'h':
+				PrintHelp();
+				return EXIT_SUCCESS;
+			default:
+				PrintHelp();
+				return EXIT_FAILURE;
+			}
+		}
+		if (optind < argc)
+		{
+			campaignPath = argv[optind];
+		}
+	}
+	if (campaignPath == NULL)
+	{
+		PrintHelp();
+		return EXIT_FAILURE;
+	}
+
+	gConfig = ConfigDefault();
+	ConfigGet(&gConfig, "Game.FPS")->u.Int.Value = fps;
+	ConfigGet(&gConfig, "Sound.SoundVolume")->u.Int.Value = 0;
+	ConfigGet(&gConfig, "Sound.MusicVolume")->u.Int.Value = 0;
+
+	// Only the timer; no video, audio or input
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Could not initialise SDL: %s", SDL_GetError());
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	const Uint32 startTicks = SDL_GetTicks();
+	if (enet_initialize() != 0)
+	{
+		LOG(LM_MAIN, LL_ERROR, "An error occurred while initializing ENet.");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	NetClientInit(&gNetClient);
+	NetServerInit(&gNetServer);
+
+	// Graphics are only initialised for the sprites that game data refers to
+	GraphicsInit(&gGraphicsDevice, &gConfig);
+	GraphicsInitializeHeadless(&gGraphicsDevice);
+	if (!PicManagerTryInit(
+		&gPicManager, "graphics/cdogs.px", "graphics/cdogs2.px"))
+	{
+		LOG(LM_MAIN, LL_ERROR, "Failed to initialize graphics");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	PicManagerLoadDir(&gPicManager, "graphics", NULL);
+
+	ParticleClassesInit(&gParticleClasses, "data/particles.json");
+	AmmoInitialize(&gAmmo, "data/ammo.json");
+	BulletAndWeaponInitialize(
+		&gBulletClasses, &gGunDescriptions,
+		"data/bullets.json", "data/guns.json");
+	CharacterClassesInitialize(&gCharacterClasses, "data/character_classes.json");
+	PickupClassesInit(
+		&gPickupClasses, "data/pickups.json", &gAmmo, &gGunDescriptions);
+	MapObjectsInit(
+		&gMapObjects, "data/map_objects.json", &gAmmo, &gGunDescriptions);
+	CollisionSystemInit(&gCollisionSystem);
+	CampaignInit(&gCampaign);
+	PlayerDataInit(&gPlayerDatas);
+	CArrayInit(&gPlayerTemplates, sizeof(PlayerTemplate));
+
+	char buf[CDOGS_PATH_MAX];
+	GetDataFilePath(buf, campaignPath);
+	CampaignEntry entry;
+	if (!CampaignEntryTryLoad(&entry, buf, GAME_MODE_NORMAL) ||
+		!CampaignLoad(&gCampaign, &entry))
+	{
+		LOG(LM_MAIN, LL_ERROR, "Failed to load campaign %s", campaignPath);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	if (missionIndex >= (int)gCampaign.Setting.Missions.size)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Campaign %s has only %d missions",
+			campaignPath, (int)gCampaign.Setting.Missions.size);
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	gCampaign.MissionIndex = missionIndex;
+	gCampaign.OptionsSet = true;
+
+	NetServerOpen(&gNetServer);
+	if (gNetServer.server == NULL)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Failed to start server");
+		err = EXIT_FAILURE;
+		goto bail;
+	}
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+
+	printf("Campaign:   %s\n", campaignPath);
+	printf("Port:       %u\n", gNetServer.server->address.port);
+	printf("Tick rate:  %d/s\n", fps);
+	PrintUsage("on startup", startTicks, 0);
+
+	GameEventsInit(&gGameEvents);
+	RunMissions(maxTicks, &ticksRun);
+	GameEventsTerminate(&gGameEvents);
+	CampaignUnload(&gCampaign);
+
+	PrintUsage("on exit", startTicks, ticksRun);
+
+bail:
+	MapTerminate(&gMap);
+	PlayerDataTerminate(&gPlayerDatas);
+	CArrayTerminate(&gPlayerTemplates);
+	MapObjectsTerminate(&gMapObjects);
+	PickupClassesTerminate(&gPickupClasses);
+	ParticleClassesTerminate(&gParticleClasses);
+	AmmoTerminate(&gAmmo);
+	WeaponTerminate(&gGunDescriptions);
+	BulletTerminate(&gBulletClasses);
+	CharacterClassesTerminate(&gCharacterClasses);
+	NetServerTerminate(&gNetServer);
+	NetClientTerminate(&gNetClient);
+	enet_deinitialize();
+	CampaignTerminate(&gCampaign);
+	GraphicsTerminate(&gGraphicsDevice);
+	PicManagerTerminate(&gPicManager);
+	ConfigDestroy(&gConfig);
+	SDL_Quit();
+
+	return err;
+}
+
+static void RunMissions(const int maxTicks, int *ticksRun)
+{
+	while (!quit && (maxTicks == 0 || *ticksRun < maxTicks))
+	{
+		CampaignAndMissionSetup(&gCampaign, &gMission);
+		LOG(LM_MAIN, LL_INFO, "starting mission %d (%s)",
+			gCampaign.MissionIndex, gMission.missionData->Title);
+		*ticksRun += RunGameDedicated(
+			&gCampaign, &gMission, &gMap,
+			maxTicks == 0 ? 0 : maxTicks - *ticksRun, &quit);
+
+		// Unready all the players, for them to rejoin the next mission
+		CA_FOREACH(PlayerData, p, gPlayerDatas)
+			p->Ready = false;
+		CA_FOREACH_END()
+
+		const bool completed =
+			GetNumPlayers(PLAYER_ALIVE, false, false) > 0 &&
+			MissionAllObjectivesComplete(&gMission);
+		if (completed)
+		{
+			gCampaign.MissionIndex =
+				(gCampaign.MissionIndex + 1) %
+				(int)gCampaign.Setting.Missions.size;
+		}
+		MissionOptionsTerminate(&gMission);
+	}
+}
@@ -0,0 +1,183 @@
+#include <cbehave/cbehave.h>
+
+#include <asset_loader.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sys_specifics.h>
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+#define TEST_DIR "asset_loader_test_dir"
+#define TEST_CACHE "asset_loader_test.cache"
+static void WriteFile(const char *path, const char *contents)
+{
+	FILE *f = fopen(path, "w");
+	fputs(contents, f);
+	fclose(f);
+}
+static void MakeTestDir(void)
+{
+	mkdir(TEST_DIR, MKDIR_MODE);
+	mkdir(TEST_DIR "/sub", MKDIR_MODE);
+	mkdir(TEST_DIR "/.hidden", MKDIR_MODE);
+	WriteFile(TEST_DIR "/a.txt", "a");
+	WriteFile(TEST_DIR "/bad.txt", "");
+	WriteFile(TEST_DIR "/sub/b.txt", "b");
+	WriteFile(TEST_DIR "/.hidden/c.txt", "c");
+}
+static void RemoveTestDir(void)
+{
+	remove(TEST_DIR "/.hidden/c.txt");
+	remove(TEST_DIR "/sub/b.txt");
+	remove(TEST_DIR "/bad.txt");
+	remove(TEST_DIR "/a.txt");
+	remove(TEST_DIR "/.hidden");
+	remove(TEST_DIR "/sub");
+	remove(TEST_DIR);
+}
+// Decode to the first character of the file, or fail for empty files
+static void *DecodeChar(const char *path, size_t *len)
+{
+	FILE *f = fopen(path, "r");
+	const int c = fgetc(f);
+	fclose(f);
+	if (c == EOF)
+	{
+		return NULL;
+	}
+	char *data;
+	CMALLOC(data, 2);
+	data[0] = (char)c;
+	data[1] = '\0';
+	*len = 2;
+	return data;
+}
+static bool CheckChar(const void *data, const size_t len)
+{
+	return len == 2 && ((const char *)data)[1] == '\0';
+}
+static const AssetFile *FindFile(const AssetLoad *l, const char *name)
+{
+	CA_FOREACH(const AssetFile, f, l->Files)
+		if (strcmp(f->Name, name) == 0) return f;
+	CA_FOREACH_END()
+	return NULL;
+}
+static void LoadCached(AssetLoad *l)
+{
+	AssetLoadInit(l, "test");
+	AssetLoadScan(l, TEST_DIR);
+	AssetLoadUseCache(l, TEST_CACHE, 1, CheckChar);
+	AssetLoadDecode(l, DecodeChar);
+	AssetLoadSaveCache(l);
+}
+static void FreeLoad(AssetLoad *l)
+{
+	CA_FOREACH(AssetFile, f, l->Files)
+		if (!f->Cached) CFREE(f->Data);
+	CA_FOREACH_END()
+	AssetLoadTerminate(l);
+}
+
+FEATURE(1, "Load asset dirs")
+	SCENARIO("Scan and decode a dir")
+		AssetLoad l;
+		GIVEN("a dir with files, a subdir and a hidden dir")
+			MakeTestDir();
+			AssetLoadInit(&l, "test");
+		WHEN("I scan and decode it")
+			AssetLoadScan(&l, TEST_DIR);
+			AssetLoadDecode(&l, DecodeChar);
+		THEN("files in the dir and subdir should be found")
+			SHOULD_INT_EQUAL((int)l.Files.size, 3);
+			const AssetFile *a = FindFile(&l, "a.txt");
+			const AssetFile *b = FindFile(&l, "sub/b.txt");
+			SHOULD_BE_TRUE(a != NULL);
+			SHOULD_BE_TRUE(b != NULL);
+		AND("they should be decoded")
+			SHOULD_STR_EQUAL(a->Data, "a");
+			SHOULD_STR_EQUAL(b->Data, "b");
+		AND("files that fail to decode should have no data")
+			SHOULD_BE_TRUE(FindFile(&l, "bad.txt")->Data == NULL);
+		CA_FOREACH(AssetFile, f, l.Files)
+			CFREE(f->Data);
+		CA_FOREACH_END()
+		AssetLoadTerminate(&l);
+		RemoveTestDir();
+	SCENARIO_END
+
+	SCENARIO("Load a dir through the cache")
+		AssetLoad l;
+		GIVEN("a dir that has been loaded once with a cache")
+			MakeTestDir();
+			remove(TEST_CACHE);
+			LoadCached(&l);
+			SHOULD_INT_EQUAL(l.cacheHits, 0);
+			FreeLoad(&l);
+		WHEN("I load it again")
+			LoadCached(&l);
+		THEN("the decoded files should come from the cache")
+			SHOULD_INT_EQUAL(l.cacheHits, 2);
+			const AssetFile *a = FindFile(&l, "a.txt");
+			SHOULD_BE_TRUE(a->Cached);
+			SHOULD_STR_EQUAL(a->Data, "a");
+			SHOULD_STR_EQUAL(FindFile(&l, "sub/b.txt")->Data, "b");
+			FreeLoad(&l);
+		AND("changed files should be decoded again")
+			WriteFile(TEST_DIR "/a.txt", "aa");
+			LoadCached(&l);
+			SHOULD_INT_EQUAL(l.cacheHits, 1);
+			SHOULD_BE_FALSE(FindFile(&l, "a.txt")->Cached);
+			FreeLoad(&l);
+		AND("cached data that fails the check should be decoded again")
+			LoadCached(&l);
+			CArray items;
+			CArrayInit(&items, sizeof(AssetCacheItem));
+			CA_FOREACH(const AssetFile, f, l.Files)
+				if (f->Data == NULL) continue;
+				AssetCacheItem item;
+				item.Name = f->Name;
+				item.MTime = f->MTime;
+				item.Size = f->Size;
+				item.Data = f->Data;
+				// Truncate a.txt's entry
+				item.DataLen = strcmp(f->Name, "a.txt") == 0 ? 1 : f->DataLen;
+				CArrayPushBack(&items, &item);
+			CA_FOREACH_END()
+			SHOULD_BE_TRUE(AssetCacheWrite(TEST_CACHE, 1, &items));
+			CArrayTerminate(&items);
+			FreeLoad(&l);
+			LoadCached(&l);
+			SHOULD_INT_EQUAL(l.cacheHits, 1);
+			SHOULD_BE_FALSE(FindFile(&l, "a.txt")->Cached);
+			SHOULD_STR_EQUAL(FindFile(&l, "a.txt")->Data, "a");
+			FreeLoad(&l);
+		AND("a cache with a different tag should be discarded")
+			AssetCache c;
+			AssetCacheOpen(&c, TEST_CACHE, 2);
+			SHOULD_INT_EQUAL(hashmap_length(c.entries), 0);
+			AssetCacheClose(&c);
+		THEN_END
+		remove(TEST_CACHE);
+		RemoveTestDir();
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Asset loader features are:", features);
+}
@@ -0,0 +1,122 @@
+#include <cbehave/cbehave.h>
+
+#include <asset_registry.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+typedef struct
+{
+	const char *Name;
+	int Value;
+} Asset;
+static const char *AssetName(const void *a)
+{
+	return ((const Asset *)a)->Name;
+}
+static void AddAsset(CArray *assets, const char *name, const int value)
+{
+	Asset a;
+	a.Name = name;
+	a.Value = value;
+	CArrayPushBack(assets, &a);
+}
+
+FEATURE(1, "Find assets")
+	SCENARIO("Find built-in and custom assets")
+		CArray builtin, custom;
+		AssetRegistry r;
+		GIVEN("a registry of built-in and custom assets")
+			CArrayInit(&builtin, sizeof(Asset));
+			CArrayInit(&custom, sizeof(Asset));
+			AddAsset(&builtin, "pistol", 1);
+			AddAsset(&builtin, "shotgun", 2);
+			AddAsset(&custom, "laser", 3);
+			AssetRegistryInit(&r, &builtin, &custom, AssetName);
+			AssetRegistryIndex(&r);
+		WHEN("I find them by name")
+			const int pistol = AssetRegistryFind(&r, "pistol");
+			const int laser = AssetRegistryFind(&r, "laser");
+		THEN("built-in assets should have their index as ID")
+			SHOULD_INT_EQUAL(pistol, 0);
+		AND("custom assets should follow the built-in ones")
+			SHOULD_INT_EQUAL(laser, 2);
+		AND("the IDs should get the assets back")
+			const Asset *a = AssetRegistryGet(&r, laser);
+			SHOULD_INT_EQUAL(a->Value, 3);
+			SHOULD_INT_EQUAL(AssetRegistryId(&r, a), laser);
+		AND("unknown names and IDs should not be found")
+			SHOULD_INT_EQUAL(AssetRegistryFind(&r, "bfg"), -1);
+			SHOULD_INT_EQUAL(AssetRegistryFind(&r, ""), -1);
+			SHOULD_BE_TRUE(AssetRegistryGet(&r, 3) == NULL);
+			SHOULD_BE_TRUE(AssetRegistryGet(&r, -1) == NULL);
+		AssetRegistryTerminate(&r);
+		CArrayTerminate(&builtin);
+		CArrayTerminate(&custom);
+	SCENARIO_END
+
+	SCENARIO("Custom assets shadow built-in ones")
+		CArray builtin, custom;
+		AssetRegistry r;
+		GIVEN("a custom asset with a built-in asset's name")
+			CArrayInit(&builtin, sizeof(Asset));
+			CArrayInit(&custom, sizeof(Asset));
+			AddAsset(&builtin, "pistol", 1);
+			AddAsset(&custom, "pistol", 2);
+			AssetRegistryInit(&r, &builtin, &custom, AssetName);
+			AssetRegistryIndex(&r);
+		WHEN("I find the name")
+			const int id = AssetRegistryFind(&r, "pistol");
+		THEN("the custom asset should be found")
+			const Asset *a = AssetRegistryGet(&r, id);
+			SHOULD_INT_EQUAL(a->Value, 2);
+		AssetRegistryTerminate(&r);
+		CArrayTerminate(&builtin);
+		CArrayTerminate(&custom);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(2, "Reindex assets")
+	SCENARIO("Clear custom assets")
+		CArray builtin, custom;
+		AssetRegistry r;
+		GIVEN("a registry with custom assets")
+			CArrayInit(&builtin, sizeof(Asset));
+			CArrayInit(&custom, sizeof(Asset));
+			AddAsset(&builtin, "pistol", 1);
+			AddAsset(&custom, "pistol", 2);
+			AddAsset(&custom, "laser", 3);
+			AssetRegistryInit(&r, &builtin, &custom, AssetName);
+			AssetRegistryIndex(&r);
+		WHEN("I clear the custom assets and reindex")
+			CArrayClear(&custom);
+			AssetRegistryIndex(&r);
+		THEN("the built-in asset should be found again")
+			const Asset *a = AssetRegistryGet(
+				&r, AssetRegistryFind(&r, "pistol"));
+			SHOULD_INT_EQUAL(a->Value, 1);
+		AND("the cleared asset should not be found")
+			SHOULD_INT_EQUAL(AssetRegistryFind(&r, "laser"), -1);
+		AssetRegistryTerminate(&r);
+		CArrayTerminate(&builtin);
+		CArrayTerminate(&custom);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)},
+		{feature_idx(2)}
+	};
+
+	return cbehave_runner("Asset registry features are:", features);
+}
@@ -0,0 +1,147 @@
+#include <cbehave/cbehave.h>
+
+#include <blit_kernels.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <blit.h>
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+#define ROW_MAX 67
+#define AMASK 0xFF000000
+
+static Uint32 RandPixel(void)
+{
+	// Make a good number of them transparent
+	if (rand() % 4 == 0)
+	{
+		return 0;
+	}
+	return
+		(Uint32)(rand() & 0xFF) | ((Uint32)(rand() & 0xFF) << 8) |
+		((Uint32)(rand() & 0xFF) << 16) | ((Uint32)(rand() & 0xFF) << 24);
+}
+static void RandRow(Uint32 *row)
+{
+	for (int i = 0; i < ROW_MAX; i++)
+	{
+		row[i] = RandPixel();
+	}
+}
+
+// Compare the kernels against the scalar ones, for every row length so
+// that the SIMD row tails are covered
+static bool KernelsMatchScalar(const BlitKernels *k)
+{
+	const BlitKernels *s = &gBlitKernelsScalar;
+	Uint32 src[ROW_MAX];
+	Uint32 dst[ROW_MAX];
+	Uint32 expected[ROW_MAX];
+	Uint32 actual[ROW_MAX];
+	BlitBrightness b;
+	bool match = true;
+	for (int n = 0; n <= ROW_MAX; n++)
+	{
+		RandRow(src);
+		RandRow(dst);
+		const Uint32 m = RandPixel() | AMASK;
+		const Uint8 alpha = (Uint8)(rand() & 0xFF);
+
+		memcpy(expected, dst, sizeof dst);
+		memcpy(actual, dst, sizeof dst);
+		s->CopyKeyed(expected, src, n, AMASK);
+		k->CopyKeyed(actual, src, n, AMASK);
+		match = match && memcmp(expected, actual, sizeof dst) == 0;
+
+		for (int t = 0; t < 2; t++)
+		{
+			memcpy(expected, dst, sizeof dst);
+			memcpy(actual, dst, sizeof dst);
+			s->Mult(expected, src, n, m, t);
+			k->Mult(actual, src, n, m, t);
+			match = match && memcmp(expected, actual, sizeof dst) == 0;
+		}
+
+		memcpy(expected, dst, sizeof dst);
+		memcpy(actual, dst, sizeof dst);
+		s->Blend(expected, src, n, m, alpha, AMASK);
+		k->Blend(actual, src, n, m, alpha, AMASK);
+		match = match && memcmp(expected, actual, sizeof dst) == 0;
+
+		BlitBrightnessInit(
+			&b,
+			BLIT_BRIGHTNESS_MIN +
+			n % (BLIT_BRIGHTNESS_MAX - BLIT_BRIGHTNESS_MIN + 1));
+		memcpy(expected, src, sizeof src);
+		memcpy(actual, src, sizeof src);
+		s->Brightness(expected, n, &b);
+		k->Brightness(actual, n, &b);
+		match = match && memcmp(expected, actual, sizeof src) == 0;
+	}
+	return match;
+}
+
+FEATURE(1, "Blit arithmetic")
+	SCENARIO("Divide by 255")
+		GIVEN("every product of two channels")
+		THEN("DIV255 should match integer division")
+			bool match = true;
+			for (int x = 0; x <= 0xFF * 0xFF; x++)
+			{
+				match = match && DIV255(x) == x / 0xFF;
+			}
+			SHOULD_BE_TRUE(match);
+	SCENARIO_END
+	SCENARIO("Brightness lookup")
+		GIVEN("the brightest setting")
+			BlitBrightness b;
+			BlitBrightnessInit(&b, BLIT_BRIGHTNESS_MAX);
+		THEN("channels should double and saturate")
+			SHOULD_INT_EQUAL(b.LUT[0], 0);
+			SHOULD_INT_EQUAL(b.LUT[100], 200);
+			SHOULD_INT_EQUAL(b.LUT[200], 0xFF);
+		GIVEN("the default setting")
+			BlitBrightnessInit(&b, 0);
+		THEN("channels should be unchanged")
+			SHOULD_INT_EQUAL(b.LUT[0], 0);
+			SHOULD_INT_EQUAL(b.LUT[123], 123);
+			SHOULD_INT_EQUAL(b.LUT[0xFF], 0xFF);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(2, "SIMD blit kernels")
+	SCENARIO("Match the scalar kernels")
+		GIVEN("random rows of pixels")
+			srand(42);
+		THEN("every kernel type the CPU supports should match scalar")
+			for (int t = 0; t < BLIT_KERNELS_COUNT; t++)
+			{
+				const BlitKernels *k = BlitKernelsGet((BlitKernelsType)t);
+				if (k == NULL)
+				{
+					continue;
+				}
+				SHOULD_BE_TRUE(KernelsMatchScalar(k));
+			}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)},
+		{feature_idx(2)}
+	};
+
+	return cbehave_runner("Blit kernels features are:", features);
+}
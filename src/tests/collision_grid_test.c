@@ -0,0 +1,91 @@
+#include <cbehave/cbehave.h>
+
+#include <collision_grid.h>
+
+#include <string.h>
+
+#include <SDL_joystick.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+static TTileItem MakeItem(const int id, const int x, const int y)
+{
+	TTileItem t;
+	memset(&t, 0, sizeof t);
+	t.id = id;
+	t.kind = KIND_MOBILEOBJECT;
+	t.x = x;
+	t.y = y;
+	t.size = Vec2iNew(4, 4);
+	return t;
+}
+
+FEATURE(1, "Collision grid")
+	SCENARIO("Add items to cells")
+		GIVEN("an empty grid")
+			CollisionGrid g;
+			CollisionGridInit(&g, Vec2iNew(4, 4));
+		WHEN("I add two items to a cell")
+			const TTileItem t1 = MakeItem(1, 20, 15);
+			const TTileItem t2 = MakeItem(2, 21, 16);
+			CollisionGridAdd(&g, Vec2iNew(1, 1), &t1);
+			CollisionGridAdd(&g, Vec2iNew(1, 1), &t2);
+		THEN("the cell should contain both items in insertion order")
+			const CArray *c = CollisionGridGetCell(&g, Vec2iNew(1, 1));
+			SHOULD_INT_EQUAL((int)c->size, 2);
+			const CollisionGridItem *gi = CArrayGet(c, 0);
+			SHOULD_INT_EQUAL(gi->id.Id, 1);
+			SHOULD_INT_EQUAL(gi->x, 20);
+			SHOULD_INT_EQUAL(gi->size.x, 4);
+			gi = CArrayGet(c, 1);
+			SHOULD_INT_EQUAL(gi->id.Id, 2);
+		AND("other cells should be empty")
+			SHOULD_BE_TRUE(CollisionGridGetCell(&g, Vec2iNew(0, 0)) == NULL);
+			SHOULD_BE_TRUE(CollisionGridGetCell(&g, Vec2iNew(-1, 0)) == NULL);
+			SHOULD_BE_TRUE(CollisionGridGetCell(&g, Vec2iNew(4, 0)) == NULL);
+		CollisionGridTerminate(&g);
+	SCENARIO_END
+	SCENARIO("Update and remove items")
+		GIVEN("a grid with two items in a cell")
+			CollisionGrid g;
+			CollisionGridInit(&g, Vec2iNew(4, 4));
+			TTileItem t1 = MakeItem(1, 20, 15);
+			const TTileItem t2 = MakeItem(2, 21, 16);
+			CollisionGridAdd(&g, Vec2iNew(1, 1), &t1);
+			CollisionGridAdd(&g, Vec2iNew(1, 1), &t2);
+		WHEN("I move the first item within the cell and change its flags")
+			t1.x = 25;
+			t1.flags = TILEITEM_IMPASSABLE;
+			CollisionGridUpdate(&g, Vec2iNew(1, 1), &t1);
+		THEN("the cached item should be updated")
+			const CArray *c = CollisionGridGetCell(&g, Vec2iNew(1, 1));
+			const CollisionGridItem *gi = CArrayGet(c, 0);
+			SHOULD_INT_EQUAL(gi->x, 25);
+			SHOULD_INT_EQUAL(gi->flags, TILEITEM_IMPASSABLE);
+		WHEN("I remove the first item")
+			CollisionGridRemove(&g, Vec2iNew(1, 1), &t1);
+		THEN("only the second item should remain")
+			SHOULD_INT_EQUAL((int)c->size, 1);
+			gi = CArrayGet(c, 0);
+			SHOULD_INT_EQUAL(gi->id.Id, 2);
+		CollisionGridTerminate(&g);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Collision grid features are:", features);
+}
@@ -129,6 +129,76 @@ FEATURE(4, "Save config as latest format by default")
 	SCENARIO_END
 FEATURE_END
 
+static void CountChanges(Config *c, void *data)
+{
+	UNUSED(c);
+	int *count = data;
+	(*count)++;
+}
+FEATURE(5, "Config handles and listeners")
+	SCENARIO("Look up a value through a handle")
+	{
+		ConfigHandle h = CONFIG_HANDLE("Graphics.Brightness");
+		int changes = 0;
+		GIVEN("the default config, with a listener on a value")
+			gConfig = ConfigLoad(NULL);
+			ConfigAddListener(
+				ConfigGet(&gConfig, "Graphics.Brightness"),
+				CountChanges, &changes);
+
+		WHEN("I set the value")
+			ConfigSetInt(&gConfig, "Graphics.Brightness", 5);
+
+		THEN("the handle should return the new value")
+			SHOULD_INT_EQUAL(ConfigHandleGetInt(&h), 5);
+		AND("the listener should have been called once")
+			SHOULD_INT_EQUAL(changes, 1);
+
+		WHEN("I reload the config")
+			ConfigDestroy(&gConfig);
+			gConfig = ConfigLoad(NULL);
+
+		THEN("the handle should return the value from the new config")
+			SHOULD_INT_EQUAL(ConfigHandleGetInt(&h), 0);
+			SHOULD_BE_TRUE(
+				ConfigHandleGet(&h) ==
+				ConfigGet(&gConfig, "Graphics.Brightness"));
+		ConfigDestroy(&gConfig);
+	}
+	SCENARIO_END
+
+	SCENARIO("Reset changed values")
+	{
+		int changes = 0;
+		int otherChanges = 0;
+		GIVEN("a config with a changed value, and listeners")
+			gConfig = ConfigLoad(NULL);
+			ConfigAddListener(
+				ConfigGet(&gConfig, "Graphics.Brightness"),
+				CountChanges, &changes);
+			ConfigAddListener(
+				ConfigGet(&gConfig, "Game.Difficulty"),
+				CountChanges, &otherChanges);
+			ConfigSetInt(&gConfig, "Graphics.Brightness", 5);
+
+		WHEN("I reset the changes")
+			changes = 0;
+			ConfigResetChanged(&gConfig);
+
+		THEN("the value should be reverted")
+			SHOULD_INT_EQUAL(ConfigGetInt(&gConfig, "Graphics.Brightness"), 0);
+		AND("its listener should have been called")
+			SHOULD_INT_EQUAL(changes, 1);
+		AND("listeners of unchanged values should not be called")
+			SHOULD_INT_EQUAL(otherChanges, 0);
+		AND("resetting again should not call the listener")
+			ConfigResetChanged(&gConfig);
+			SHOULD_INT_EQUAL(changes, 1);
+		ConfigDestroy(&gConfig);
+	}
+	SCENARIO_END
+FEATURE_END
+
 int main(void)
 {
 	cbehave_feature features[] =
@@ -136,7 +206,8 @@ int main(void)
 		{feature_idx(1)},
 		{feature_idx(2)},
 		{feature_idx(3)},
-		{feature_idx(4)}
+		{feature_idx(4)},
+		{feature_idx(5)}
 	};
 
 	return cbehave_runner("Config features are:", features);
@@ -0,0 +1,98 @@
+#include <cbehave/cbehave.h>
+
+#include <file_map.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+#define TEST_PATH "file_map_test.tmp"
+static void WriteTestFile(const size_t len)
+{
+	FILE *f = fopen(TEST_PATH, "wb");
+	for (size_t i = 0; i < len; i++)
+	{
+		fputc('a' + (int)(i % 26), f);
+	}
+	fclose(f);
+}
+static bool FileMapMatches(const FileMap *m, const size_t len)
+{
+	if (m->Len != len || m->Data[len] != '\0') return false;
+	for (size_t i = 0; i < len; i++)
+	{
+		if (m->Data[i] != 'a' + (int)(i % 26)) return false;
+	}
+	return true;
+}
+
+FEATURE(1, "Open files")
+	SCENARIO("Open a small file")
+		FileMap m;
+		GIVEN("a file")
+			WriteTestFile(100);
+		WHEN("I open it")
+			const bool res = FileMapOpen(&m, TEST_PATH);
+		THEN("its contents should be readable and NUL-terminated")
+			SHOULD_BE_TRUE(res);
+			SHOULD_BE_TRUE(FileMapMatches(&m, 100));
+		FileMapClose(&m);
+		remove(TEST_PATH);
+	SCENARIO_END
+
+	SCENARIO("Open a file that fills whole pages")
+		FileMap m;
+		GIVEN("a file whose size is a multiple of any page size")
+			WriteTestFile(65536);
+		WHEN("I open it")
+			const bool res = FileMapOpen(&m, TEST_PATH);
+		THEN("its contents should still be NUL-terminated")
+			SHOULD_BE_TRUE(res);
+			SHOULD_BE_TRUE(FileMapMatches(&m, 65536));
+		FileMapClose(&m);
+		remove(TEST_PATH);
+	SCENARIO_END
+
+	SCENARIO("Open an empty file")
+		FileMap m;
+		GIVEN("an empty file")
+			WriteTestFile(0);
+		WHEN("I open it")
+			const bool res = FileMapOpen(&m, TEST_PATH);
+		THEN("it should be an empty string")
+			SHOULD_BE_TRUE(res);
+			SHOULD_BE_TRUE(FileMapMatches(&m, 0));
+		FileMapClose(&m);
+		remove(TEST_PATH);
+	SCENARIO_END
+
+	SCENARIO("Open a missing file")
+		FileMap m;
+		GIVEN("a file that doesn't exist")
+			remove(TEST_PATH);
+		WHEN("I open it")
+			const bool res = FileMapOpen(&m, TEST_PATH);
+		THEN("it should fail")
+			SHOULD_BE_FALSE(res);
+		FileMapClose(&m);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("File map features are:", features);
+}
@@ -0,0 +1,151 @@
+#include <cbehave/cbehave.h>
+
+#include <flow_field.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <actors.h>
+#include <collision.h>
+#include <map_object.h>
+#include <net_util.h>
+#include <objs.h>
+#include <path_cache.h>
+
+#include "test_map.h"
+
+
+static const char *rows[] =
+{
+	"#######",
+	"#..#..#",
+	"#..#..#",
+	"#.....#",
+	"#######",
+	NULL
+};
+static TActor MakeTarget(const Vec2i tile)
+{
+	TActor a;
+	memset(&a, 0, sizeof a);
+	a.uid = 42;
+	a.Pos = Vec2iReal2Full(Vec2iCenterOfTile(tile));
+	return a;
+}
+
+// Add a dangerous object class, one that fires a gun when destroyed
+static void AddDangerousObjectClass(MapObject *mo)
+{
+	memset(mo, 0, sizeof *mo);
+	mo->Name = "barrel";
+	mo->Size = Vec2iNew(8, 8);
+	CArrayInit(&mo->DestroyGuns, sizeof(const GunDescription *));
+	const GunDescription *g = NULL;
+	CArrayPushBack(&mo->DestroyGuns, &g);
+	CArrayInit(&gMapObjects.Classes, sizeof(MapObject));
+	CArrayInit(&gMapObjects.CustomClasses, sizeof(MapObject));
+	CArrayPushBack(&gMapObjects.Classes, mo);
+}
+static void AddObject(const int uid, const Vec2i tile)
+{
+	NMapObjectAdd amo = NMapObjectAdd_init_default;
+	amo.UID = uid;
+	strcpy(amo.MapObjectClass, "barrel");
+	amo.Pos = Vec2i2Net(Vec2iCenterOfTile(tile));
+	amo.Health = 1;
+	ObjAdd(amo);
+}
+
+FEATURE(1, "Flow fields")
+	SCENARIO("Update a field when the map changes")
+		Map map;
+		TActor target;
+		const float step = PathStepCost(Vec2iZero(), Vec2iNew(1, 0));
+		const Vec2i far = Vec2iNew(4, 1);
+		GIVEN("a field towards a target behind a wall")
+			TestMapInit(&map, rows);
+			FlowFieldsInit(&gFlowFields, &map);
+			target = MakeTarget(Vec2iNew(1, 1));
+		WHEN("I get the field")
+			const FlowField *ff = FlowFieldsGet(&gFlowFields, &target);
+		THEN("the way to the other side should go around the wall")
+			SHOULD_BE_TRUE(FlowFieldGetDistance(ff, &map, far) > 3 * step);
+		AND("walls should be unreachable")
+			SHOULD_BE_TRUE(
+				FlowFieldGetDistance(ff, &map, Vec2iNew(3, 1)) < 0);
+		AND("blocking the way around should make the other side unreachable")
+			TestMapSetTile(&map, Vec2iNew(3, 3), '#');
+			FlowFieldsUpdateTile(&gFlowFields, Vec2iNew(3, 3));
+			ff = FlowFieldsGet(&gFlowFields, &target);
+			SHOULD_BE_TRUE(FlowFieldGetDistance(ff, &map, far) < 0);
+		AND("opening the wall should make the way straight")
+			TestMapSetTile(&map, Vec2iNew(3, 1), '.');
+			FlowFieldsUpdateTile(&gFlowFields, Vec2iNew(3, 1));
+			ff = FlowFieldsGet(&gFlowFields, &target);
+			SHOULD_BE_TRUE(
+				fabsf(FlowFieldGetDistance(ff, &map, far) - 3 * step) < 0.01f);
+		FlowFieldsTerminate(&gFlowFields);
+		TestMapTerminate(&map);
+	SCENARIO_END
+
+	SCENARIO("Update a field when dangerous objects come and go")
+		MapObject mo;
+		TActor target;
+		const Vec2i far = Vec2iNew(4, 1);
+		GIVEN("a field towards a target behind a wall")
+			TestMapInit(&gMap, rows);
+			CollisionGridInit(&gMap.Collision, gMap.Size);
+			ObjsInit();
+			AddDangerousObjectClass(&mo);
+			FlowFieldsInit(&gFlowFields, &gMap);
+			target = MakeTarget(Vec2iNew(1, 1));
+			const FlowField *ff = FlowFieldsGet(&gFlowFields, &target);
+			SHOULD_BE_TRUE(FlowFieldGetDistance(ff, &gMap, far) > 0);
+		WHEN("a dangerous object is added in the way around")
+			AddObject(1, Vec2iNew(3, 3));
+			ff = FlowFieldsGet(&gFlowFields, &target);
+		THEN("the other side should be unreachable")
+			SHOULD_BE_TRUE(FlowFieldGetDistance(ff, &gMap, far) < 0);
+		WHEN("the object is destroyed")
+			ObjDestroy(ObjGetByUID(1));
+			ff = FlowFieldsGet(&gFlowFields, &target);
+		THEN("the other side should be reachable again")
+			SHOULD_BE_TRUE(FlowFieldGetDistance(ff, &gMap, far) > 0);
+		FlowFieldsTerminate(&gFlowFields);
+		ObjsTerminate();
+		CArrayTerminate(&gMapObjects.Classes);
+		CArrayTerminate(&gMapObjects.CustomClasses);
+		CArrayTerminate(&mo.DestroyGuns);
+		CollisionGridTerminate(&gMap.Collision);
+		TestMapTerminate(&gMap);
+	SCENARIO_END
+
+	SCENARIO("Drop fields of actors that are gone")
+		Map map;
+		TActor target;
+		GIVEN("a field towards an actor that isn't in the game")
+			TestMapInit(&map, rows);
+			ActorsInit();
+			FlowFieldsInit(&gFlowFields, &map);
+			target = MakeTarget(Vec2iNew(1, 1));
+			FlowFieldsGet(&gFlowFields, &target);
+			SHOULD_INT_EQUAL((int)gFlowFields.fields.size, 1);
+		WHEN("the fields are updated")
+			FlowFieldsUpdate(&gFlowFields, 1);
+		THEN("the field should be dropped")
+			SHOULD_INT_EQUAL((int)gFlowFields.fields.size, 0);
+		FlowFieldsTerminate(&gFlowFields);
+		ActorsTerminate();
+		TestMapTerminate(&map);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Flow field features are:", features);
+}
@@ -0,0 +1,328 @@
+#include <cbehave/cbehave.h>
+
+#include <los.h>
+
+#include <string.h>
+
+#include <algorithms.h>
+#include <config.h>
+
+#include "test_map.h"
+
+
+#define SIGHT_RANGE 8
+
+static const char *openRows[] =
+{
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	".................",
+	NULL
+};
+static const char *cornerRows[] =
+{
+	"###########",
+	"#.........#",
+	"#.........#",
+	"#...#######",
+	"#...#.....#",
+	"#...#.....#",
+	"###########",
+	NULL
+};
+static const char *wallRows[] =
+{
+	"#######",
+	"#..#..#",
+	"#..#..#",
+	"#######",
+	NULL
+};
+static const char *roomRows[] =
+{
+	"#########################",
+	"#.......#.......#.......#",
+	"#..#....#...#...#..##...#",
+	"#.......#.......#.......#",
+	"#....#......#.......#...#",
+	"#.......#.......#.......#",
+	"###.#####...#######.#####",
+	"#.......#...............#",
+	"#..#.#..#..###...#..#...#",
+	"#.......#..#.#..........#",
+	"#...#......###...#..#...#",
+	"#.......#...............#",
+	"#########################",
+	NULL
+};
+static void InitMap(Map *map, const char **rows)
+{
+	gConfig = ConfigDefault();
+	ConfigSetInt(&gConfig, "Game.SightRange", SIGHT_RANGE);
+	TestMapInit(map, rows);
+}
+static void TerminateMap(Map *map)
+{
+	TestMapTerminate(map);
+	ConfigDestroy(&gConfig);
+}
+static void CalcFrom(Map *map, const Vec2i pos)
+{
+	LOSReset(&map->LOS);
+	LOSCalcFrom(map, pos, false);
+}
+
+// Reference: the ray casting LOSCalcFrom used before views were cached,
+// for a single viewer, into an array of bools per tile
+typedef struct
+{
+	Map *Map;
+	Vec2i Center;
+	bool *Visible;
+} RayCast;
+static void RayCastSetVisible(RayCast *r, const Vec2i pos)
+{
+	if (MapGetTile(r->Map, pos) == NULL) return;
+	r->Visible[pos.y * r->Map->Size.x + pos.x] = true;
+}
+static bool RayCastIsBlocked(void *data, Vec2i pos)
+{
+	RayCast *r = data;
+	if (DistanceSquared(r->Center, pos) >= SIGHT_RANGE * SIGHT_RANGE)
+	{
+		return true;
+	}
+	const Tile *t = MapGetTile(r->Map, pos);
+	if (t == NULL) return true;
+	RayCastSetVisible(r, pos);
+	return t->flags & MAPTILE_NO_SEE;
+}
+static bool RayCastIsVisibleFloor(const RayCast *r, const Vec2i pos)
+{
+	const Tile *t = MapGetTile(r->Map, pos);
+	return t != NULL && !(t->flags & MAPTILE_NO_SEE) &&
+		r->Visible[pos.y * r->Map->Size.x + pos.x];
+}
+static void RayCastFrom(Map *map, const Vec2i pos, bool *visible)
+{
+	RayCast r;
+	r.Map = map;
+	r.Center = pos;
+	r.Visible = visible;
+	Vec2i v;
+	for (v.y = pos.y - 1; v.y <= pos.y + 1; v.y++)
+	{
+		for (v.x = pos.x - 1; v.x <= pos.x + 1; v.x++)
+		{
+			RayCastSetVisible(&r, v);
+		}
+	}
+	// Rays to every tile on the perimeter, clockwise from the top-left
+	const Vec2i origin = Vec2iNew(pos.x - SIGHT_RANGE, pos.y - SIGHT_RANGE);
+	const int size = 2 * SIGHT_RANGE;
+	HasClearLineData lineData;
+	lineData.IsBlocked = RayCastIsBlocked;
+	lineData.data = &r;
+	v = origin;
+	for (; v.x < origin.x + size; v.x++)
+	{
+		HasClearLineXiaolinWu(pos, v, &lineData);
+	}
+	for (; v.y < origin.y + size; v.y++)
+	{
+		HasClearLineXiaolinWu(pos, v, &lineData);
+	}
+	for (; v.x > origin.x; v.x--)
+	{
+		HasClearLineXiaolinWu(pos, v, &lineData);
+	}
+	for (; v.y > origin.y; v.y--)
+	{
+		HasClearLineXiaolinWu(pos, v, &lineData);
+	}
+	// Walls next to visible floor
+	for (v.y = origin.y; v.y < origin.y + size; v.y++)
+	{
+		for (v.x = origin.x; v.x < origin.x + size; v.x++)
+		{
+			const Tile *t = MapGetTile(map, v);
+			if (t == NULL || !(t->flags & MAPTILE_NO_SEE) ||
+				DistanceSquared(pos, v) >= SIGHT_RANGE * SIGHT_RANGE)
+			{
+				continue;
+			}
+			Vec2i d;
+			for (d.y = -1; d.y < 2; d.y++)
+			{
+				for (d.x = -1; d.x < 2; d.x++)
+				{
+					if (RayCastIsVisibleFloor(&r, Vec2iAdd(v, d)))
+					{
+						RayCastSetVisible(&r, v);
+					}
+				}
+			}
+		}
+	}
+}
+// Look from every floor tile, and count the tiles whose visibility differs
+// from the ray casting
+static int CountRayCastMismatches(Map *map)
+{
+	int mismatches = 0;
+	const int numTiles = map->Size.x * map->Size.y;
+	bool *visible;
+	CMALLOC(visible, numTiles * sizeof *visible);
+	Vec2i pos;
+	for (pos.y = 0; pos.y < map->Size.y; pos.y++)
+	{
+		for (pos.x = 0; pos.x < map->Size.x; pos.x++)
+		{
+			if (MapGetTile(map, pos)->flags & MAPTILE_NO_SEE) continue;
+			memset(visible, 0, numTiles * sizeof *visible);
+			RayCastFrom(map, pos, visible);
+			CalcFrom(map, pos);
+			for (int i = 0; i < numTiles; i++)
+			{
+				const Vec2i tile = Vec2iNew(i % map->Size.x, i / map->Size.x);
+				if (visible[i] != LOSTileIsVisible(map, tile))
+				{
+					mismatches++;
+				}
+			}
+		}
+	}
+	CFREE(visible);
+	return mismatches;
+}
+
+FEATURE(1, "Line of sight")
+	SCENARIO("See a circle in the open")
+		Map map;
+		const Vec2i center = Vec2iNew(8, 8);
+		GIVEN("an open map")
+			InitMap(&map, openRows);
+		WHEN("I look from the center")
+			CalcFrom(&map, center);
+		THEN("tiles inside the sight range should be visible")
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(15, 8)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(8, 1)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(13, 13)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(14, 13)));
+		AND("tiles outside it should not")
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(16, 8)));
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(8, 0)));
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(14, 14)));
+		TerminateMap(&map);
+	SCENARIO_END
+
+	SCENARIO("Don't see around corners")
+		Map map;
+		GIVEN("a room with a corner")
+			InitMap(&map, cornerRows);
+		WHEN("I look from one end")
+			CalcFrom(&map, Vec2iNew(1, 1));
+		THEN("the floor in line should be visible")
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(8, 1)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(3, 5)));
+		AND("the floor around the corner should not")
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(6, 5)));
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(8, 4)));
+		AND("walls next to visible floor should be visible")
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(4, 3)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(7, 3)));
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(4, 5)));
+		AND("walls hidden behind others should not")
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, Vec2iNew(10, 5)));
+		TerminateMap(&map);
+	SCENARIO_END
+
+	SCENARIO("See through a wall that has been removed")
+		Map map;
+		const Vec2i viewer = Vec2iNew(1, 1);
+		const Vec2i behind = Vec2iNew(5, 1);
+		GIVEN("a wall between me and a tile")
+			InitMap(&map, wallRows);
+			CalcFrom(&map, viewer);
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, behind));
+		WHEN("the wall is removed")
+			TestMapSetTile(&map, Vec2iNew(3, 1), '.');
+			LOSUpdateTile(&map.LOS, Vec2iNew(3, 1));
+			CalcFrom(&map, viewer);
+		THEN("the tile should be visible")
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, behind));
+		AND("putting the wall back should hide it again")
+			TestMapSetTile(&map, Vec2iNew(3, 1), '#');
+			LOSUpdateTile(&map.LOS, Vec2iNew(3, 1));
+			CalcFrom(&map, viewer);
+			SHOULD_BE_FALSE(LOSTileIsVisible(&map, behind));
+		TerminateMap(&map);
+	SCENARIO_END
+
+	SCENARIO("See the same as ray casting")
+		Map map;
+		GIVEN("a map of rooms with pillars")
+			InitMap(&map, roomRows);
+		WHEN("I look from every floor tile")
+		THEN("the same tiles should be visible as with ray casting")
+			SHOULD_INT_EQUAL(CountRayCastMismatches(&map), 0);
+		WHEN("a wall is removed")
+			TestMapSetTile(&map, Vec2iNew(8, 3), '.');
+			LOSUpdateTile(&map.LOS, Vec2iNew(8, 3));
+		THEN("the cached views should still match ray casting")
+			SHOULD_INT_EQUAL(CountRayCastMismatches(&map), 0);
+		TerminateMap(&map);
+	SCENARIO_END
+
+	SCENARIO("Combine views regardless of viewer order")
+		Map map;
+		const Vec2i near = Vec2iNew(3, 1);
+		const Vec2i far = Vec2iNew(7, 1);
+		// In range of the near viewer only, and next to floor that only the
+		// far viewer sees
+		const Vec2i wall = Vec2iNew(0, 5);
+		bool nearFirst, farFirst;
+		GIVEN("two viewers in a room")
+			InitMap(&map, roomRows);
+		WHEN("I look from the near viewer first")
+			LOSReset(&map.LOS);
+			LOSCalcFrom(&map, near, false);
+			LOSCalcFrom(&map, far, false);
+			nearFirst = LOSTileIsVisible(&map, wall);
+		AND("I look from the far viewer first")
+			LOSReset(&map.LOS);
+			LOSCalcFrom(&map, far, false);
+			LOSCalcFrom(&map, near, false);
+			farFirst = LOSTileIsVisible(&map, wall);
+		THEN("the floor next to the wall should be visible")
+			SHOULD_BE_TRUE(LOSTileIsVisible(&map, Vec2iNew(1, 5)));
+		AND("the wall should not be, whichever viewer went first")
+			SHOULD_BE_FALSE(nearFirst);
+			SHOULD_BE_FALSE(farFirst);
+		TerminateMap(&map);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Line of sight features are:", features);
+}
@@ -0,0 +1,418 @@
+#include <cbehave/cbehave.h>
+
+#include <net_batch.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+// A server and client connected over the loopback interface
+typedef struct
+{
+	ENetHost *server;
+	ENetHost *client;
+	ENetPeer *serverPeer;	// the client, as seen by the server
+	ENetPeer *clientPeer;	// the server, as seen by the client
+	CArray received;	// of RecvMsg
+	int receivedPackets;
+} Loopback;
+typedef struct
+{
+	GameEventType Type;
+	size_t Len;
+	uint8_t Data[32];
+} RecvMsg;
+
+static void LoopbackService(Loopback *lb, const enet_uint32 timeoutMs)
+{
+	ENetEvent event;
+	while (enet_host_service(lb->client, &event, 0) > 0)
+	{
+		if (event.type == ENET_EVENT_TYPE_CONNECT)
+		{
+			lb->clientPeer = event.peer;
+		}
+	}
+	// Only wait for the first event
+	enet_uint32 wait = timeoutMs;
+	while (enet_host_service(lb->server, &event, wait) > 0)
+	{
+		switch (event.type)
+		{
+		case ENET_EVENT_TYPE_CONNECT:
+			lb->serverPeer = event.peer;
+			break;
+		case ENET_EVENT_TYPE_RECEIVE:
+			{
+				lb->receivedPackets++;
+				size_t offset = 0;
+				NetMsg msg;
+				while (NetBatchRead(event.packet, &offset, &msg))
+				{
+					RecvMsg m;
+					m.Type = msg.Type;
+					m.Len = msg.Len;
+					memcpy(m.Data, msg.Data, MIN(msg.Len, sizeof m.Data));
+					CArrayPushBack(&lb->received, &m);
+				}
+				enet_packet_destroy(event.packet);
+			}
+			break;
+		default:
+			break;
+		}
+		wait = 0;
+	}
+}
+static bool LoopbackOpen(Loopback *lb)
+{
+	memset(lb, 0, sizeof *lb);
+	CArrayInit(&lb->received, sizeof(RecvMsg));
+	ENetAddress addr;
+	enet_address_set_host(&addr, "127.0.0.1");
+	addr.port = ENET_PORT_ANY;
+	lb->server = enet_host_create(&addr, 1, 1, 0, 0);
+	lb->client = enet_host_create(NULL, 1, 1, 0, 0);
+	if (lb->server == NULL || lb->client == NULL)
+	{
+		return false;
+	}
+	enet_host_connect(lb->client, &lb->server->address, 1, 0);
+	for (int i = 0; i < 1000; i++)
+	{
+		LoopbackService(lb, 1);
+		if (lb->clientPeer != NULL && lb->serverPeer != NULL)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+static void LoopbackClose(Loopback *lb)
+{
+	if (lb->client) enet_host_destroy(lb->client);
+	if (lb->server) enet_host_destroy(lb->server);
+	CArrayTerminate(&lb->received);
+}
+// Flush the client and wait until the server has all of its packets
+static void LoopbackDeliver(Loopback *lb, const int packets)
+{
+	enet_host_flush(lb->client);
+	const int target = lb->receivedPackets + packets;
+	for (int i = 0; i < 1000 && lb->receivedPackets < target; i++)
+	{
+		LoopbackService(lb, 1);
+	}
+	// Let the client process the acks
+	LoopbackService(lb, 0);
+}
+// Queue a message in the batch, or if there is no batch, send it in its own
+// packet as the game did before batching; returns the packets sent
+static int Send(
+	Loopback *lb, NetBatch *b, const GameEventType e, const int uid,
+	const void *data, const size_t len)
+{
+	if (b != NULL)
+	{
+		NetBatchAdd(b, e, uid, data, len);
+		return 0;
+	}
+	ENetPacket *packet = enet_packet_create(
+		NULL, NET_BATCH_MSG_HEADER_SIZE + len, ENET_PACKET_FLAG_RELIABLE);
+	uint8_t *dst = packet->data;
+	dst[0] = (uint8_t)e;
+	dst[1] = 0;
+	dst[2] = (uint8_t)len;
+	dst[3] = 0;
+	memcpy(dst + NET_BATCH_MSG_HEADER_SIZE, data, len);
+	enet_peer_send(lb->clientPeer, 0, packet);
+	return 1;
+}
+
+// One tick of messages, with counts and sizes like those of a four-player
+// game: each actor moves, changes state (some twice), and some turn or get
+// pushed back
+#define TICK_ACTORS 30
+// One second at the default frame rate
+#define TICKS 70
+static int SendTick(Loopback *lb, NetBatch *b, const int tick)
+{
+	int packets = 0;
+	uint8_t data[16];
+	for (int uid = 0; uid < TICK_ACTORS; uid++)
+	{
+		memset(data, tick + uid, sizeof data);
+		packets += Send(lb, b, GAME_EVENT_ACTOR_STATE, uid, data, 5);
+		packets += Send(lb, b, GAME_EVENT_ACTOR_MOVE, uid, data, 14);
+		if (uid % 8 == 0)
+		{
+			data[0]++;
+			packets += Send(lb, b, GAME_EVENT_ACTOR_STATE, uid, data, 5);
+		}
+		if (uid % 3 == 0)
+		{
+			packets += Send(lb, b, GAME_EVENT_ACTOR_DIR, uid, data, 4);
+		}
+		else if (uid % 3 == 1)
+		{
+			packets += Send(lb, b, GAME_EVENT_ACTOR_IMPULSE, -1, data, 16);
+		}
+	}
+	if (b != NULL)
+	{
+		packets = NetBatchSend(b, lb->clientPeer, 0);
+	}
+	return packets;
+}
+typedef struct
+{
+	int Packets;
+	enet_uint32 Datagrams;
+	enet_uint32 Bytes;
+	int Msgs;
+} LoopbackStats;
+static LoopbackStats RunTicks(const bool batched)
+{
+	LoopbackStats s;
+	memset(&s, 0, sizeof s);
+	Loopback lb;
+	if (!LoopbackOpen(&lb))
+	{
+		printf("Cannot open loopback hosts\n");
+		LoopbackClose(&lb);
+		s.Packets = -1;
+		return s;
+	}
+	lb.client->totalSentData = lb.client->totalSentPackets = 0;
+	lb.server->totalSentData = lb.server->totalSentPackets = 0;
+	NetBatch b;
+	NetBatchInit(&b);
+	for (int tick = 0; tick < TICKS; tick++)
+	{
+		const int packets = SendTick(&lb, batched ? &b : NULL, tick);
+		s.Packets += packets;
+		LoopbackDeliver(&lb, packets);
+	}
+	NetBatchTerminate(&b);
+	// Count both directions, since every reliable packet is acknowledged
+	s.Datagrams = lb.client->totalSentPackets + lb.server->totalSentPackets;
+	s.Bytes = lb.client->totalSentData + lb.server->totalSentData;
+	s.Msgs = (int)lb.received.size;
+	LoopbackClose(&lb);
+	printf("%s: %d packets/s, %u datagrams/s, %u bytes/s, %d messages\n",
+		batched ? "batched" : "unbatched",
+		s.Packets, s.Datagrams, s.Bytes, s.Msgs);
+	return s;
+}
+
+
+FEATURE(1, "Batch packets")
+	SCENARIO("Superseded messages")
+		GIVEN("a loopback connection")
+			Loopback lb;
+			const bool open = LoopbackOpen(&lb);
+			SHOULD_BE_TRUE(open);
+		AND("a batch where an actor moves twice")
+			NetBatch b;
+			NetBatchInit(&b);
+			const uint8_t move1[] = { 1, 1 };
+			const uint8_t dir[] = { 2 };
+			const uint8_t moveOther[] = { 3, 3 };
+			const uint8_t move2[] = { 4, 4 };
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_MOVE, 1, move1, sizeof move1);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_DIR, 1, dir, sizeof dir);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_MOVE, 2, moveOther, sizeof moveOther);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_IMPULSE, -1, dir, sizeof dir);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_IMPULSE, -1, dir, sizeof dir);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_MOVE, 1, move2, sizeof move2);
+			NetBatchAdd(&b, GAME_EVENT_GAME_BEGIN, -1, NULL, 0);
+		WHEN("I send the batch")
+			const int packets = NetBatchSend(&b, lb.clientPeer, 0);
+			LoopbackDeliver(&lb, packets);
+		THEN("it should arrive in one packet")
+			SHOULD_INT_EQUAL(packets, 1);
+			SHOULD_INT_EQUAL(lb.receivedPackets, 1);
+		AND("only the last move of the actor should be received, in order")
+			SHOULD_INT_EQUAL((int)lb.received.size, 6);
+			const GameEventType types[] =
+			{
+				GAME_EVENT_ACTOR_DIR, GAME_EVENT_ACTOR_MOVE,
+				GAME_EVENT_ACTOR_IMPULSE, GAME_EVENT_ACTOR_IMPULSE,
+				GAME_EVENT_ACTOR_MOVE, GAME_EVENT_GAME_BEGIN
+			};
+			bool typesMatch = lb.received.size == 6;
+			for (int i = 0; typesMatch && i < 6; i++)
+			{
+				const RecvMsg *m = CArrayGet(&lb.received, i);
+				typesMatch = m->Type == types[i];
+			}
+			SHOULD_BE_TRUE(typesMatch);
+			const RecvMsg *last = CArrayGet(&lb.received, 4);
+			SHOULD_INT_EQUAL((int)last->Len, 2);
+			SHOULD_INT_EQUAL(last->Data[0], 4);
+			const RecvMsg *begin = CArrayGet(&lb.received, 5);
+			SHOULD_INT_EQUAL((int)begin->Len, 0);
+		AND("the batch should be empty")
+			SHOULD_INT_EQUAL(NetBatchSend(&b, lb.clientPeer, 0), 0);
+		NetBatchTerminate(&b);
+		LoopbackClose(&lb);
+	SCENARIO_END
+	SCENARIO("Big batches")
+		GIVEN("a loopback connection")
+			Loopback lb;
+			const bool open = LoopbackOpen(&lb);
+			SHOULD_BE_TRUE(open);
+		AND("a batch bigger than one packet")
+			NetBatch b;
+			NetBatchInit(&b);
+			uint8_t data[20];
+			for (int i = 0; i < 200; i++)
+			{
+				memset(data, i, sizeof data);
+				NetBatchAdd(&b, GAME_EVENT_TILE_SET, -1, data, sizeof data);
+			}
+		WHEN("I send the batch")
+			const int packets = NetBatchSend(&b, lb.clientPeer, 0);
+			LoopbackDeliver(&lb, packets);
+		THEN("it should be split into packets that fit a datagram")
+			const int msgsPerPacket =
+				NET_BATCH_PACKET_SIZE / (NET_BATCH_MSG_HEADER_SIZE + 20);
+			SHOULD_INT_EQUAL(
+				packets, (200 + msgsPerPacket - 1) / msgsPerPacket);
+		AND("every message should arrive in order")
+			SHOULD_INT_EQUAL((int)lb.received.size, 200);
+			bool inOrder = lb.received.size == 200;
+			for (int i = 0; inOrder && i < 200; i++)
+			{
+				const RecvMsg *m = CArrayGet(&lb.received, i);
+				inOrder = m->Len == 20 && m->Data[19] == (uint8_t)i;
+			}
+			SHOULD_BE_TRUE(inOrder);
+		NetBatchTerminate(&b);
+		LoopbackClose(&lb);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(2, "Loopback traffic")
+	SCENARIO("A second of game ticks")
+		GIVEN("a second of ticks sent one message per packet")
+			const LoopbackStats unbatched = RunTicks(false);
+		WHEN("the same ticks are sent in batches")
+			const LoopbackStats batched = RunTicks(true);
+		THEN("every message should be received")
+			SHOULD_INT_EQUAL(unbatched.Msgs, unbatched.Packets);
+		AND("superseded states should be dropped")
+			SHOULD_INT_EQUAL(
+				batched.Msgs,
+				unbatched.Msgs - TICKS * ((TICK_ACTORS + 7) / 8));
+		AND("there should be one packet per tick")
+			SHOULD_INT_EQUAL(batched.Packets, TICKS);
+		AND("fewer datagrams and bytes should be sent")
+			SHOULD_BE_TRUE(batched.Datagrams < unbatched.Datagrams);
+			SHOULD_BE_TRUE(batched.Bytes < unbatched.Bytes);
+	SCENARIO_END
+FEATURE_END
+
+static void ReadFile(FILE *f, char *buf, const size_t size)
+{
+	rewind(f);
+	const size_t len = fread(buf, 1, size - 1, f);
+	buf[len] = '\0';
+}
+
+FEATURE(3, "Traffic stats")
+	SCENARIO("Counting batches")
+		GIVEN("a batch where an actor moves twice")
+			NetBatch b;
+			NetBatchInit(&b);
+			const uint8_t move[] = { 1, 1, 1 };
+			const uint8_t dir[] = { 2 };
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_MOVE, 1, move, sizeof move);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_DIR, 1, dir, sizeof dir);
+			NetBatchAdd(&b, GAME_EVENT_ACTOR_MOVE, 1, move, sizeof move);
+		AND("some stats")
+			NetStats stats;
+			NetStatsInit(&stats);
+			NetTraffic peer;
+			memset(&peer, 0, sizeof peer);
+		WHEN("I count the batch")
+			NetBatchCount(&b, &stats, &peer);
+		THEN("only the messages that will be sent should be counted")
+			SHOULD_INT_EQUAL(stats.Total.Sent.Msgs, 2);
+			SHOULD_INT_EQUAL(stats.Total.Sent.Bytes, 4);
+			SHOULD_INT_EQUAL(stats.Types[GAME_EVENT_ACTOR_MOVE].Sent.Msgs, 1);
+			SHOULD_INT_EQUAL(stats.Types[GAME_EVENT_ACTOR_DIR].Sent.Bytes, 1);
+		AND("the peer's traffic should match")
+			SHOULD_INT_EQUAL(peer.Sent.Msgs, 2);
+			SHOULD_INT_EQUAL(peer.Sent.Bytes, 4);
+		NetStatsTerminate(&stats);
+		NetBatchTerminate(&b);
+	SCENARIO_END
+	SCENARIO("Rates and dumps")
+		GIVEN("stats that have been updated once")
+			NetStats stats;
+			NetStatsInit(&stats);
+			NetStatsUpdate(&stats, "test", 100, NET_STATS_LOG_OFF);
+		WHEN("messages are sent and received over a second")
+			NetStatsSent(&stats, GAME_EVENT_ACTOR_MOVE, 10);
+			NetStatsSent(&stats, GAME_EVENT_ACTOR_MOVE, 10);
+			NetStatsRecv(&stats, NET_STATS_SNAPSHOT, 50);
+			NetStatsRecv(&stats, 60000, 5);
+			NetStatsUpdate(&stats, "test", 1100, NET_STATS_LOG_OFF);
+		THEN("the rates should be for that second")
+			SHOULD_INT_EQUAL(stats.TotalRate.Sent.Bytes, 20);
+			SHOULD_INT_EQUAL(stats.TotalRate.Recv.Bytes, 55);
+			SHOULD_INT_EQUAL(
+				stats.TypesRate[GAME_EVENT_ACTOR_MOVE].Sent.Msgs, 2);
+			SHOULD_INT_EQUAL(
+				stats.TypesRate[NET_STATS_SNAPSHOT].Recv.Bytes, 50);
+		AND("the next second should only count new messages")
+			NetStatsSent(&stats, GAME_EVENT_ACTOR_MOVE, 10);
+			NetStatsUpdate(&stats, "test", 2100, NET_STATS_LOG_OFF);
+			SHOULD_INT_EQUAL(stats.TotalRate.Sent.Bytes, 10);
+			SHOULD_INT_EQUAL(stats.TotalRate.Recv.Bytes, 0);
+		AND("the CSV dump should have a row per type used")
+			char buf[1024];
+			FILE *f = tmpfile();
+			NetStatsPrint(&stats, NET_STATS_LOG_CSV, f);
+			ReadFile(f, buf, sizeof buf);
+			fclose(f);
+			SHOULD_BE_TRUE(
+				strstr(buf, "\ntype,actor_move,3,30,0,0,,,\n") != NULL);
+			SHOULD_BE_TRUE(strstr(buf, "\ntype,snapshot,0,0,1,50,,,\n") != NULL);
+			SHOULD_BE_TRUE(strstr(buf, "\ntotal,,3,30,2,55,,,\n") != NULL);
+		AND("the JSON dump should have the same counts")
+			f = tmpfile();
+			NetStatsPrint(&stats, NET_STATS_LOG_JSON, f);
+			ReadFile(f, buf, sizeof buf);
+			fclose(f);
+			SHOULD_BE_TRUE(strstr(buf,
+				"{\"type\":\"snapshot\",\"sent_msgs\":0,\"sent_bytes\":0,"
+				"\"recv_msgs\":1,\"recv_bytes\":50}") != NULL);
+			SHOULD_BE_TRUE(strstr(buf, "\"peers\":[]}") != NULL);
+		NetStatsTerminate(&stats);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)},
+		{feature_idx(2)},
+		{feature_idx(3)}
+	};
+	enet_initialize();
+	const int res = cbehave_runner("Net batch features are:", features);
+	enet_deinitialize();
+	return res;
+}
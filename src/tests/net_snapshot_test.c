@@ -0,0 +1,411 @@
+#include <cbehave/cbehave.h>
+
+#include <net_snapshot.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <enet/enet.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+static void AddActor(
+	NetSnapshot *s, const int uid, const int x, const int y, const int dir)
+{
+	NetActorSnapshot a;
+	memset(&a, 0, sizeof a);
+	a.UID = uid;
+	a.Pos = Vec2iNew(x, y);
+	a.MoveVel = Vec2iNew(x % 7 - 3, 0);
+	a.Dir = dir;
+	a.State = uid % 2;
+	a.GunState = 1;
+	CArrayPushBack(&s->Actors, &a);
+}
+static bool ActorsEqual(const NetSnapshot *s1, const NetSnapshot *s2)
+{
+	if (s1->Actors.size != s2->Actors.size) return false;
+	for (int i = 0; i < (int)s1->Actors.size; i++)
+	{
+		const NetActorSnapshot *a1 = CArrayGet(&s1->Actors, i);
+		const NetActorSnapshot *a2 = CArrayGet(&s2->Actors, i);
+		if (a1->UID != a2->UID ||
+			!Vec2iEqual(a1->Pos, a2->Pos) ||
+			!Vec2iEqual(a1->MoveVel, a2->MoveVel) ||
+			a1->Dir != a2->Dir || a1->State != a2->State ||
+			a1->GunState != a2->GunState)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// A server and client connected over the loopback interface, where the
+// client drops some of the datagrams it receives
+typedef struct
+{
+	ENetHost *server;
+	ENetHost *client;
+	ENetPeer *serverPeer;	// the client, as seen by the server
+	ENetPeer *clientPeer;	// the server, as seen by the client
+} Loopback;
+static int sDropEvery = 0;
+static int sDatagrams = 0;
+static int ENET_CALLBACK DropDatagrams(ENetHost *host, ENetEvent *event)
+{
+	UNUSED(host);
+	UNUSED(event);
+	if (sDropEvery == 0) return 0;
+	sDatagrams++;
+	return sDatagrams % sDropEvery == 0 ? 1 : 0;
+}
+static bool LoopbackOpen(Loopback *lb)
+{
+	memset(lb, 0, sizeof *lb);
+	sDropEvery = 0;
+	ENetAddress addr;
+	enet_address_set_host(&addr, "127.0.0.1");
+	addr.port = ENET_PORT_ANY;
+	// Same host settings as the game's client and server
+	lb->server = enet_host_create(
+		&addr, 1, NET_HOST_CHANNELS,
+		NET_HOST_BANDWIDTH_IN, NET_HOST_BANDWIDTH_OUT);
+	lb->client = enet_host_create(
+		NULL, 1, NET_HOST_CHANNELS,
+		NET_HOST_BANDWIDTH_IN, NET_HOST_BANDWIDTH_OUT);
+	if (lb->server == NULL || lb->client == NULL)
+	{
+		return false;
+	}
+	lb->client->intercept = DropDatagrams;
+	enet_host_connect(lb->client, &lb->server->address, NET_HOST_CHANNELS, 0);
+	for (int i = 0; i < 1000; i++)
+	{
+		ENetEvent event;
+		if (enet_host_service(lb->server, &event, 1) > 0 &&
+			event.type == ENET_EVENT_TYPE_CONNECT)
+		{
+			lb->serverPeer = event.peer;
+		}
+		if (enet_host_service(lb->client, &event, 0) > 0 &&
+			event.type == ENET_EVENT_TYPE_CONNECT)
+		{
+			lb->clientPeer = event.peer;
+		}
+		if (lb->clientPeer != NULL && lb->serverPeer != NULL)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+static void LoopbackClose(Loopback *lb)
+{
+	if (lb->client) enet_host_destroy(lb->client);
+	if (lb->server) enet_host_destroy(lb->server);
+}
+
+// Replay ticks in real time, moving actors every tick, and measure how
+// many ticks old the client's view of the actors is at the end of each tick
+#define TICK_MS 14
+#define TICKS 70
+#define LOSS_ACTORS 20
+typedef struct
+{
+	double MeanTicks;
+	int MaxTicks;
+	int DecodeErrors;
+	int Bytes;
+} LatencyStats;
+static LatencyStats RunTicks(const bool snapshots, const int dropEvery)
+{
+	LatencyStats stats;
+	memset(&stats, 0, sizeof stats);
+	Loopback lb;
+	if (!LoopbackOpen(&lb))
+	{
+		printf("Cannot open loopback hosts\n");
+		LoopbackClose(&lb);
+		stats.MaxTicks = -1;
+		return stats;
+	}
+	sDropEvery = dropEvery;
+	sDatagrams = 0;
+
+	NetSnapshotHistory serverHistory;
+	NetSnapshotHistoryInit(&serverHistory);
+	NetSnapshotHistory clientHistory;
+	NetSnapshotHistoryInit(&clientHistory);
+	CArray buf;
+	CArrayInit(&buf, sizeof(uint8_t));
+	uint32_t ack = 0;
+	int latestTick = -1;
+	int totalTicks = 0;
+
+	const enet_uint32 start = enet_time_get();
+	for (int tick = 0; tick < TICKS; tick++)
+	{
+		// Each tick, actors move one pixel per tick, so the client can tell
+		// which tick its positions are from
+		if (snapshots)
+		{
+			NetSnapshot *s = NetSnapshotHistoryAdd(&serverHistory, tick + 1);
+			for (int uid = 0; uid < LOSS_ACTORS; uid++)
+			{
+				AddActor(s, uid, (tick + uid) * 256, uid * 256, tick % 8);
+			}
+			NetSnapshotEncode(
+				&buf, s, NetSnapshotHistoryGet(&serverHistory, ack));
+			enet_peer_send(
+				lb.serverPeer, NET_SNAPSHOT_CHANNEL,
+				enet_packet_create(buf.data, buf.size, 0));
+		}
+		else
+		{
+			// Previously, each actor's move was a reliable message
+			for (int uid = 0; uid < LOSS_ACTORS; uid++)
+			{
+				int pos[2] = { (tick + uid) * 256, uid * 256 };
+				enet_peer_send(
+					lb.serverPeer, 0,
+					enet_packet_create(pos, sizeof pos,
+						ENET_PACKET_FLAG_RELIABLE));
+			}
+		}
+		enet_host_flush(lb.server);
+
+		// Service both hosts until the next tick
+		const enet_uint32 deadline = start + (tick + 1) * TICK_MS;
+		while ((int)(enet_time_get() - deadline) < 0)
+		{
+			ENetEvent event;
+			while (enet_host_service(lb.client, &event, 1) > 0)
+			{
+				if (event.type != ENET_EVENT_TYPE_RECEIVE) continue;
+				if (snapshots)
+				{
+					const NetSnapshot *s = NetSnapshotDecode(
+						&clientHistory,
+						event.packet->data, event.packet->dataLength);
+					if (s == NULL)
+					{
+						stats.DecodeErrors++;
+					}
+					else
+					{
+						const NetActorSnapshot *a =
+							NetSnapshotFindActor(s, 0);
+						latestTick = MAX(latestTick, a->Pos.x / 256);
+						NetSnapshotEncodeAck(&buf, s->Seq);
+						enet_peer_send(
+							lb.clientPeer, NET_SNAPSHOT_CHANNEL,
+							enet_packet_create(buf.data, buf.size, 0));
+					}
+				}
+				else
+				{
+					const int *pos = (const int *)event.packet->data;
+					if (pos[1] == 0)
+					{
+						latestTick = MAX(latestTick, pos[0] / 256);
+					}
+				}
+				enet_packet_destroy(event.packet);
+			}
+			enet_host_flush(lb.client);
+			while (enet_host_service(lb.server, &event, 0) > 0)
+			{
+				if (event.type != ENET_EVENT_TYPE_RECEIVE) continue;
+				uint32_t seq;
+				if (NetSnapshotDecodeAck(
+					event.packet->data, event.packet->dataLength, &seq))
+				{
+					ack = MAX(ack, seq);
+				}
+				enet_packet_destroy(event.packet);
+			}
+		}
+
+		const int age = latestTick < 0 ? tick + 1 : tick - latestTick;
+		totalTicks += age;
+		stats.MaxTicks = MAX(stats.MaxTicks, age);
+	}
+	stats.MeanTicks = (double)totalTicks / TICKS;
+	stats.Bytes = (int)lb.server->totalSentData;
+
+	CArrayTerminate(&buf);
+	NetSnapshotHistoryTerminate(&serverHistory);
+	NetSnapshotHistoryTerminate(&clientHistory);
+	sDropEvery = 0;
+	LoopbackClose(&lb);
+	printf("%s, 1 in %d dropped: mean %.1fms, max %dms, %d bytes/s\n",
+		snapshots ? "snapshots" : "reliable moves", dropEvery,
+		stats.MeanTicks * TICK_MS, stats.MaxTicks * TICK_MS,
+		stats.Bytes * 1000 / (TICKS * TICK_MS));
+	return stats;
+}
+
+
+FEATURE(1, "Snapshot encoding")
+	SCENARIO("Whole snapshots")
+		GIVEN("a snapshot of some actors")
+			NetSnapshot s;
+			NetSnapshotInit(&s);
+			s.Seq = 1;
+			AddActor(&s, 7, 1000, 2000, 3);
+			AddActor(&s, 2, 256 * 10, 256 * 3, 0);
+			AddActor(&s, 40, 0, 16, 5);
+			NetSnapshotSort(&s);
+		WHEN("I encode it without a baseline")
+			CArray buf;
+			CArrayInit(&buf, sizeof(uint8_t));
+			NetSnapshotEncode(&buf, &s, NULL);
+		AND("decode it")
+			NetSnapshotHistory h;
+			NetSnapshotHistoryInit(&h);
+			const NetSnapshot *d = NetSnapshotDecode(&h, buf.data, buf.size);
+		THEN("it should be decoded, sorted by UID")
+			SHOULD_BE_TRUE(d != NULL);
+			SHOULD_INT_EQUAL((int)d->Seq, 1);
+			SHOULD_INT_EQUAL((int)d->Actors.size, 3);
+			const NetActorSnapshot *first = CArrayGet(&d->Actors, 0);
+			SHOULD_INT_EQUAL(first->UID, 2);
+		AND("positions should be rounded to 1/16 of a pixel")
+			const NetActorSnapshot *a = NetSnapshotFindActor(d, 7);
+			SHOULD_INT_EQUAL(a->Pos.x, 1008);
+			SHOULD_INT_EQUAL(a->Pos.y, 2000);
+			SHOULD_INT_EQUAL(a->Dir, 3);
+			SHOULD_INT_EQUAL(a->MoveVel.x, 1000 % 7 - 3);
+		NetSnapshotHistoryTerminate(&h);
+		CArrayTerminate(&buf);
+		NetSnapshotTerminate(&s);
+	SCENARIO_END
+	SCENARIO("Deltas")
+		GIVEN("a server with two snapshots")
+			NetSnapshotHistory server;
+			NetSnapshotHistoryInit(&server);
+			NetSnapshot *s1 = NetSnapshotHistoryAdd(&server, 1);
+			for (int uid = 0; uid < 10; uid++)
+			{
+				AddActor(s1, uid, uid * 256, 512, 0);
+			}
+			NetSnapshot *s2 = NetSnapshotHistoryAdd(&server, 2);
+			for (int uid = 1; uid < 12; uid++)
+			{
+				// Actor 0 is gone, 1 moved, 10 and 11 are new
+				AddActor(s2, uid, uid * 256 + (uid == 1 ? 64 : 0), 512, 0);
+			}
+		AND("a client with the first one")
+			NetSnapshotHistory client;
+			NetSnapshotHistoryInit(&client);
+			CArray buf;
+			CArrayInit(&buf, sizeof(uint8_t));
+			NetSnapshotEncode(&buf, s1, NULL);
+			const size_t fullSize = buf.size;
+			NetSnapshotDecode(&client, buf.data, buf.size);
+		WHEN("I encode the second against the first")
+			NetSnapshotEncode(&buf, s2, s1);
+		THEN("it should be smaller than a whole snapshot")
+			SHOULD_BE_TRUE(buf.size * 2 < fullSize);
+		AND("the client should decode the same actors")
+			const NetSnapshot *d = NetSnapshotDecode(&client, buf.data, buf.size);
+			SHOULD_BE_TRUE(d != NULL);
+			SHOULD_BE_TRUE(d != NULL && ActorsEqual(d, s2));
+		AND("the delta cannot be decoded without the baseline")
+			NetSnapshotHistory empty;
+			NetSnapshotHistoryInit(&empty);
+			SHOULD_BE_TRUE(
+				NetSnapshotDecode(&empty, buf.data, buf.size) == NULL);
+			NetSnapshotHistoryTerminate(&empty);
+		AND("truncated snapshots should not be decoded")
+			SHOULD_BE_TRUE(
+				NetSnapshotDecode(&client, buf.data, buf.size - 1) == NULL);
+		CArrayTerminate(&buf);
+		NetSnapshotHistoryTerminate(&client);
+		NetSnapshotHistoryTerminate(&server);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(2, "Loopback under loss")
+	SCENARIO("Actors moving every tick")
+		GIVEN("a second of moves sent reliably, with 1 in 5 datagrams lost")
+			const LatencyStats reliable = RunTicks(false, 5);
+		WHEN("the same moves are sent as snapshots")
+			const LatencyStats snapshots = RunTicks(true, 5);
+		THEN("every snapshot received should be decoded")
+			SHOULD_INT_EQUAL(snapshots.DecodeErrors, 0);
+		AND("a lost snapshot should only delay the client until the next")
+			SHOULD_BE_TRUE(snapshots.MaxTicks >= 0);
+			SHOULD_BE_TRUE(snapshots.MaxTicks <= 3);
+		AND("fewer bytes should be sent than with reliable moves")
+			SHOULD_BE_TRUE(snapshots.Bytes < reliable.Bytes);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(3, "Jitter buffer")
+	SCENARIO("Pacing snapshots")
+		GIVEN("no snapshots shown yet")
+		THEN("nothing should be shown until there are enough snapshots")
+			SHOULD_INT_EQUAL((int)NetSnapshotNextShown(0, NET_SNAPSHOT_DELAY), 0);
+			SHOULD_INT_EQUAL(
+				(int)NetSnapshotNextShown(0, NET_SNAPSHOT_DELAY + 1), 1);
+		AND("snapshots should be shown one per tick behind the latest")
+			SHOULD_INT_EQUAL((int)NetSnapshotNextShown(5, 7), 6);
+			SHOULD_INT_EQUAL((int)NetSnapshotNextShown(5, 9), 6);
+		AND("the client should skip ahead if it falls too far behind")
+			SHOULD_INT_EQUAL(
+				(int)NetSnapshotNextShown(5, 20), 20 - NET_SNAPSHOT_DELAY);
+		AND("the client should hold if no snapshots arrive")
+			SHOULD_INT_EQUAL((int)NetSnapshotNextShown(9, 9), 0);
+	SCENARIO_END
+	SCENARIO("Interpolating a lost snapshot")
+		GIVEN("snapshots either side of a lost one")
+			NetSnapshot a, b, out;
+			NetSnapshotInit(&a);
+			NetSnapshotInit(&b);
+			NetSnapshotInit(&out);
+			a.Seq = 3;
+			AddActor(&a, 1, 0, 512, 0);
+			AddActor(&a, 2, 256, 256, 0);
+			b.Seq = 7;
+			AddActor(&b, 1, 1024, 0, 0);
+		WHEN("I interpolate the one in between")
+			NetSnapshotInterpolate(&out, &a, &b, 4);
+		THEN("positions should be partway between the two")
+			SHOULD_INT_EQUAL((int)out.Seq, 4);
+			const NetActorSnapshot *as = NetSnapshotFindActor(&out, 1);
+			SHOULD_INT_EQUAL(as->Pos.x, 256);
+			SHOULD_INT_EQUAL(as->Pos.y, 384);
+		AND("actors missing from the later snapshot should keep still")
+			as = NetSnapshotFindActor(&out, 2);
+			SHOULD_INT_EQUAL(as->Pos.x, 256);
+			SHOULD_INT_EQUAL(as->Pos.y, 256);
+		NetSnapshotTerminate(&out);
+		NetSnapshotTerminate(&b);
+		NetSnapshotTerminate(&a);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)},
+		{feature_idx(2)},
+		{feature_idx(3)}
+	};
+	enet_initialize();
+	const int res = cbehave_runner("Net snapshot features are:", features);
+	enet_deinitialize();
+	return res;
+}
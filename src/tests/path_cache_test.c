@@ -0,0 +1,145 @@
+#include <cbehave/cbehave.h>
+
+#include <path_cache.h>
+
+#include "test_map.h"
+
+
+static const char *rows[] =
+{
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	"....................",
+	NULL
+};
+static const Vec2i goal = { 18, 8 };
+// A different start tile for each i
+static Vec2i StartTile(const int i)
+{
+	return Vec2iNew(i % 18, i / 18);
+}
+// Look up a path and release it, returning whether it was cached
+static bool Lookup(
+	PathCache *pc, const Vec2i from, const Vec2i to, const bool ignoreObjects)
+{
+	const int hits = pc->Stats.Hits;
+	CachedPath c = PathCacheCreate(pc, from, to, ignoreObjects, true);
+	CachedPathDestroy(&c);
+	return pc->Stats.Hits > hits;
+}
+
+FEATURE(1, "Path cache")
+	SCENARIO("Look up cached paths")
+		Map map;
+		int hits = 0;
+		GIVEN("a full path cache")
+			TestMapInit(&map, rows);
+			PathCacheInit(&gPathCache, &map);
+			for (int i = 0; i < PATH_CACHE_MAX; i++)
+			{
+				Lookup(&gPathCache, StartTile(i), goal, true);
+			}
+		WHEN("I look up the same paths again")
+			for (int i = 0; i < PATH_CACHE_MAX; i++)
+			{
+				if (Lookup(&gPathCache, StartTile(i), goal, true)) hits++;
+			}
+		THEN("they should all be found")
+			SHOULD_INT_EQUAL(hits, PATH_CACHE_MAX);
+			SHOULD_INT_EQUAL(gPathCache.Stats.Evictions, 0);
+		AND("the same path should be the same object")
+			CachedPath a =
+				PathCacheCreate(&gPathCache, StartTile(0), goal, true, true);
+			CachedPath b =
+				PathCacheCreate(&gPathCache, StartTile(0), goal, true, true);
+			SHOULD_BE_TRUE(a.Path == b.Path);
+			CachedPathDestroy(&a);
+			CachedPathDestroy(&b);
+		AND("paths with different options should be looked up separately")
+			SHOULD_BE_FALSE(Lookup(&gPathCache, StartTile(0), goal, false));
+			SHOULD_BE_FALSE(Lookup(&gPathCache, goal, StartTile(0), true));
+		PathCacheTerminate(&gPathCache);
+		TestMapTerminate(&map);
+	SCENARIO_END
+
+	SCENARIO("Evict the least recently used path")
+		Map map;
+		GIVEN("a full path cache")
+			TestMapInit(&map, rows);
+			PathCacheInit(&gPathCache, &map);
+			for (int i = 0; i < PATH_CACHE_MAX; i++)
+			{
+				Lookup(&gPathCache, StartTile(i), goal, true);
+			}
+		AND("I have used the oldest path again")
+			SHOULD_BE_TRUE(Lookup(&gPathCache, StartTile(0), goal, true));
+		WHEN("I add a new path")
+			SHOULD_BE_FALSE(
+				Lookup(&gPathCache, StartTile(PATH_CACHE_MAX), goal, true));
+		THEN("one path should be evicted")
+			SHOULD_INT_EQUAL(gPathCache.Stats.Evictions, 1);
+		AND("it should be the least recently used one")
+			SHOULD_BE_TRUE(Lookup(&gPathCache, StartTile(0), goal, true));
+			SHOULD_BE_TRUE(
+				Lookup(&gPathCache, StartTile(PATH_CACHE_MAX), goal, true));
+			SHOULD_BE_TRUE(Lookup(&gPathCache, StartTile(2), goal, true));
+			SHOULD_BE_FALSE(Lookup(&gPathCache, StartTile(1), goal, true));
+		PathCacheTerminate(&gPathCache);
+		TestMapTerminate(&map);
+	SCENARIO_END
+
+	SCENARIO("Invalidate paths near changed tiles")
+		Map map;
+		const Vec2i nearFrom = Vec2iNew(1, 1);
+		const Vec2i nearTo = Vec2iNew(8, 1);
+		const Vec2i farFrom = Vec2iNew(1, 8);
+		const Vec2i farTo = Vec2iNew(8, 8);
+		GIVEN("paths near and far from a tile")
+			TestMapInit(&map, rows);
+			PathCacheInit(&gPathCache, &map);
+			Lookup(&gPathCache, nearFrom, nearTo, true);
+			Lookup(&gPathCache, farFrom, farTo, true);
+		WHEN("the tile is updated without changing")
+			PathCacheUpdateTile(&gPathCache, Vec2iNew(5, 1));
+		THEN("no paths should be invalidated")
+			SHOULD_INT_EQUAL(gPathCache.Stats.Invalidations, 0);
+		WHEN("the tile becomes a wall")
+			TestMapSetTile(&map, Vec2iNew(5, 1), '#');
+			PathCacheUpdateTile(&gPathCache, Vec2iNew(5, 1));
+		THEN("only the path near it should be invalidated")
+			SHOULD_INT_EQUAL(gPathCache.Stats.Invalidations, 1);
+			SHOULD_BE_TRUE(Lookup(&gPathCache, farFrom, farTo, true));
+			SHOULD_BE_FALSE(Lookup(&gPathCache, nearFrom, nearTo, true));
+		AND("the new path should go around the wall")
+			CachedPath c =
+				PathCacheCreate(&gPathCache, nearFrom, nearTo, true, true);
+			bool throughWall = false;
+			for (size_t i = 0; i < ASPathGetCount(c.Path); i++)
+			{
+				const Vec2i *v = ASPathGetNode(c.Path, i);
+				if (Vec2iEqual(*v, Vec2iNew(5, 1))) throughWall = true;
+			}
+			SHOULD_INT_GT((int)ASPathGetCount(c.Path), 0);
+			SHOULD_BE_FALSE(throughWall);
+			CachedPathDestroy(&c);
+		PathCacheTerminate(&gPathCache);
+		TestMapTerminate(&map);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Path cache features are:", features);
+}
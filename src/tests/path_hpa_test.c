@@ -0,0 +1,192 @@
+#include <cbehave/cbehave.h>
+
+#include <path_hpa.h>
+
+#include <stdlib.h>
+
+#include <ai_utils.h>
+#include <path_cache.h>
+
+#include "test_map.h"
+
+
+// Refined paths may be longer than optimal, since they pass through
+// entrances rather than anywhere along cluster borders; allow this much
+#define HPA_MAX_SUBOPTIMALITY 1.15f
+
+// Three clusters in a row, joined by narrow gaps in the walls between them
+static const char *gapRows[] =
+{
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................................#...............",
+	"................................#...............",
+	"................................#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............................",
+	"................#...............#...............",
+	"................#...............#...............",
+	"................#...............#...............",
+	NULL
+};
+#define MAZE_WIDTH 64
+#define MAZE_HEIGHT 48
+static char mazeBuf[MAZE_HEIGHT][MAZE_WIDTH + 1];
+static const char *mazeRows[MAZE_HEIGHT + 1];
+// Rooms separated by walls with doorways, spanning several clusters
+static void MakeMaze(void)
+{
+	for (int y = 0; y < MAZE_HEIGHT; y++)
+	{
+		for (int x = 0; x < MAZE_WIDTH; x++)
+		{
+			const bool hWall = y % 12 == 6 && (x + y) % 20 >= 3;
+			const bool vWall = x % 16 == 10 && y % 16 >= 3 && y % 16 < 14;
+			mazeBuf[y][x] = hWall || vWall ? '#' : '.';
+		}
+		mazeBuf[y][MAZE_WIDTH] = '\0';
+		mazeRows[y] = mazeBuf[y];
+	}
+	mazeRows[MAZE_HEIGHT] = NULL;
+}
+
+// Length of a tile path, or -1 if it is not a series of walkable steps
+// between the expected ends
+static float PathLength(
+	Map *map, ASPath path, const Vec2i from, const Vec2i to)
+{
+	const size_t count = ASPathGetCount(path);
+	if (count == 0 ||
+		!Vec2iEqual(*(const Vec2i *)ASPathGetNode(path, 0), from) ||
+		!Vec2iEqual(*(const Vec2i *)ASPathGetNode(path, count - 1), to))
+	{
+		return -1;
+	}
+	float length = 0;
+	for (size_t i = 1; i < count; i++)
+	{
+		const Vec2i a = *(const Vec2i *)ASPathGetNode(path, i - 1);
+		const Vec2i b = *(const Vec2i *)ASPathGetNode(path, i);
+		if (abs(a.x - b.x) > 1 || abs(a.y - b.y) > 1 ||
+			!IsTileWalkable(map, b))
+		{
+			return -1;
+		}
+		length += PathStepCost(a, b);
+	}
+	return length;
+}
+static bool PathHasTile(ASPath path, const Vec2i tile)
+{
+	for (size_t i = 0; i < ASPathGetCount(path); i++)
+	{
+		if (Vec2iEqual(*(const Vec2i *)ASPathGetNode(path, i), tile))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+static float FullPathLength(Map *map, const Vec2i from, const Vec2i to)
+{
+	ASPath path = TilePathCreate(
+		map, from, to, IsTileWalkable, Vec2iZero(), map->Size);
+	const float length = PathLength(map, path, from, to);
+	ASPathDestroy(path);
+	return length;
+}
+
+FEATURE(1, "Hierarchical pathfinding")
+	SCENARIO("Build clusters with entrances")
+		Map map;
+		HPAGraph g;
+		ASPath path = NULL;
+		bool found;
+		const Vec2i from = Vec2iNew(1, 1);
+		const Vec2i to = Vec2iNew(46, 1);
+		GIVEN("three clusters joined by gaps")
+			TestMapInit(&map, gapRows);
+			HPAGraphInit(&g, &map);
+		WHEN("I find a path across them")
+			found = HPAGraphFindPath(&g, from, to, IsTileWalkable, &path);
+		THEN("the hierarchical search should be used")
+			SHOULD_BE_TRUE(found);
+			SHOULD_INT_EQUAL(g.NumClusters.x, 3);
+			SHOULD_INT_EQUAL(g.NumClusters.y, 1);
+		AND("each gap should have an entrance in its middle")
+			const HPACluster *c0 = CArrayGet(&g.clusters, 0);
+			const HPACluster *c1 = CArrayGet(&g.clusters, 1);
+			SHOULD_INT_EQUAL((int)c0->Nodes.size, 1);
+			SHOULD_INT_EQUAL((int)c1->Nodes.size, 2);
+			const HPANode *n = CArrayGet(&c0->Nodes, 0);
+			SHOULD_BE_TRUE(Vec2iEqual(n->Tile, Vec2iNew(15, 7)));
+			SHOULD_BE_TRUE(Vec2iEqual(n->Partner, Vec2iNew(16, 7)));
+			SHOULD_INT_EQUAL(n->PartnerCluster, 1);
+		AND("the refined path should go through the gaps")
+			SHOULD_BE_TRUE(PathLength(&map, path, from, to) > 0);
+			SHOULD_BE_TRUE(PathHasTile(path, Vec2iNew(16, 7)));
+			SHOULD_BE_TRUE(PathHasTile(path, Vec2iNew(32, 12)));
+		ASPathDestroy(path);
+		HPAGraphTerminate(&g);
+		TestMapTerminate(&map);
+	SCENARIO_END
+
+	SCENARIO("Find paths close to optimal")
+		Map map;
+		HPAGraph g;
+		const Vec2i ends[] =
+		{
+			{ 1, 1 }, { 62, 46 }, { 40, 2 }, { 5, 44 }, { 33, 24 }, { 60, 20 }
+		};
+		const int numEnds = sizeof ends / sizeof ends[0];
+		int compared = 0;
+		int mismatched = 0;
+		GIVEN("a map of rooms spanning several clusters")
+			MakeMaze();
+			TestMapInit(&map, mazeRows);
+			HPAGraphInit(&g, &map);
+		WHEN("I find paths between rooms far apart")
+			for (int i = 0; i < numEnds; i++)
+			{
+				for (int j = 0; j < numEnds; j++)
+				{
+					ASPath path = NULL;
+					if (!HPAGraphFindPath(
+						&g, ends[i], ends[j], IsTileWalkable, &path))
+					{
+						continue;
+					}
+					const float hpa = PathLength(&map, path, ends[i], ends[j]);
+					const float full = FullPathLength(&map, ends[i], ends[j]);
+					ASPathDestroy(path);
+					compared++;
+					if (hpa < 0 || full < 0 ||
+						hpa > full * HPA_MAX_SUBOPTIMALITY)
+					{
+						mismatched++;
+					}
+				}
+			}
+		THEN("they should be within bounds of the full search")
+			SHOULD_INT_GT(compared, 0);
+			SHOULD_INT_EQUAL(mismatched, 0);
+		HPAGraphTerminate(&g);
+		TestMapTerminate(&map);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Hierarchical pathfinding features are:", features);
+}
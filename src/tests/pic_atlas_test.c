@@ -0,0 +1,93 @@
+#include <cbehave/cbehave.h>
+
+#include <pic_atlas.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+static Pic MakePic(const Vec2i size, const Uint32 fill)
+{
+	Pic p;
+	p.size = size;
+	p.offset = Vec2iZero();
+	p.packed = false;
+	CMALLOC(p.Data, size.x * size.y * sizeof *p.Data);
+	for (int i = 0; i < size.x * size.y; i++)
+	{
+		p.Data[i] = fill;
+	}
+	return p;
+}
+
+FEATURE(1, "Pack pics")
+	SCENARIO("Pack pics into a page")
+		PicAtlas a;
+		Pic p1, p2;
+		GIVEN("two separately allocated pics")
+			PicAtlasInit(&a);
+			p1 = MakePic(Vec2iNew(3, 3), 1);
+			p2 = MakePic(Vec2iNew(2, 5), 2);
+		WHEN("I reserve room for them and pack them")
+			PicAtlasReserve(
+				&a, PicAtlasPixels(p1.size) + PicAtlasPixels(p2.size));
+			PicAtlasPack(&a, &p1);
+			PicAtlasPack(&a, &p2);
+		THEN("they should share a single page with no slack")
+			SHOULD_INT_EQUAL((int)a.pages.size, 1);
+			size_t used;
+			SHOULD_INT_EQUAL(
+				(int)PicAtlasSize(&a, &used), 24 * (int)sizeof(Uint32));
+			SHOULD_INT_EQUAL((int)used, 24 * (int)sizeof(Uint32));
+		AND("each pic should start on a 16-byte boundary")
+			SHOULD_INT_EQUAL((int)(p2.Data - p1.Data), 12);
+			SHOULD_INT_EQUAL((int)((uintptr_t)p2.Data % 16), 0);
+		AND("their pixels should be kept")
+			SHOULD_BE_TRUE(p1.packed && p2.packed);
+			SHOULD_INT_EQUAL((int)p1.Data[8], 1);
+			SHOULD_INT_EQUAL((int)p2.Data[9], 2);
+		AND("packing them again should do nothing")
+			Uint32 *data = p1.Data;
+			PicAtlasPack(&a, &p1);
+			SHOULD_BE_TRUE(p1.Data == data);
+			SHOULD_INT_EQUAL(a.NumPics, 2);
+		PicAtlasTerminate(&a);
+	SCENARIO_END
+
+	SCENARIO("Allocate pics one at a time")
+		PicAtlas a;
+		GIVEN("an empty atlas")
+			PicAtlasInit(&a);
+		WHEN("I allocate a small pic and then an oversized one")
+			PicAtlasAlloc(&a, Vec2iNew(8, 8));
+			PicAtlasAlloc(&a, Vec2iNew(1024, 1024));
+		THEN("the small pic should get a default page")
+			const PicAtlasPage *page = CArrayGet(&a.pages, 0);
+			SHOULD_INT_EQUAL(page->Size, PIC_ATLAS_PAGE_PIXELS);
+			SHOULD_INT_EQUAL(page->Used, 64);
+		AND("the oversized pic should get a page of its own")
+			SHOULD_INT_EQUAL((int)a.pages.size, 2);
+			page = CArrayGet(&a.pages, 1);
+			SHOULD_INT_EQUAL(page->Size, 1024 * 1024);
+		PicAtlasTerminate(&a);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Pic atlas features are:", features);
+}
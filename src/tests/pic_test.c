@@ -32,6 +32,9 @@ void BlitMasked(
 	UNUSED(mask);
 	UNUSED(isTransparent);
 }
+void BlitKernelsInit(void)
+{
+}
 const char *JoyName(const int deviceIndex)
 {
 	UNUSED(deviceIndex);
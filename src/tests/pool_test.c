@@ -0,0 +1,76 @@
+#include <cbehave/cbehave.h>
+
+#include <pool.h>
+
+#include <SDL_joystick.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+
+FEATURE(1, "Pool slots")
+	SCENARIO("Reuse free slots")
+		GIVEN("a pool with two objects")
+			Pool p;
+			PoolInit(&p);
+			const int i1 = PoolAdd(&p, 10);
+			const int i2 = PoolAdd(&p, 11);
+		WHEN("I remove the first and add another")
+			PoolRemove(&p, i1);
+			const int i3 = PoolAdd(&p, 12);
+		THEN("the new object should take the free slot")
+			SHOULD_INT_EQUAL(i1, 0);
+			SHOULD_INT_EQUAL(i2, 1);
+			SHOULD_INT_EQUAL(i3, i1);
+			SHOULD_BE_TRUE(PoolIsInUse(&p, i3));
+		AND("a new object should go at the end")
+			SHOULD_INT_EQUAL(PoolAdd(&p, 13), 2);
+		PoolTerminate(&p);
+	SCENARIO_END
+	SCENARIO("Find by UID")
+		GIVEN("a pool with many objects")
+			Pool p;
+			PoolInit(&p);
+			for (int i = 0; i < 1000; i++)
+			{
+				PoolAdd(&p, i * 3);
+			}
+		THEN("every UID should be found in its slot")
+			bool found = true;
+			for (int i = 0; i < 1000; i++)
+			{
+				found = found && PoolFindUID(&p, i * 3) == i;
+			}
+			SHOULD_BE_TRUE(found);
+		AND("missing UIDs should not be found")
+			SHOULD_INT_EQUAL(PoolFindUID(&p, 1), -1);
+			SHOULD_INT_EQUAL(PoolFindUID(&p, 3000), -1);
+		WHEN("I remove an object")
+			PoolRemove(&p, 5);
+		THEN("its UID should still be found until the slot is reused")
+			SHOULD_INT_EQUAL(PoolFindUID(&p, 15), 5);
+			SHOULD_BE_FALSE(PoolIsInUse(&p, 5));
+		WHEN("I reuse the slot")
+			PoolAdd(&p, 5000);
+		THEN("only the new UID should be found")
+			SHOULD_INT_EQUAL(PoolFindUID(&p, 15), -1);
+			SHOULD_INT_EQUAL(PoolFindUID(&p, 5000), 5);
+		PoolTerminate(&p);
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Pool features are:", features);
+}
@@ -0,0 +1,36 @@
+# Draws the same headless game with the split screen views drawn one after
+# another, then on worker threads, and checks that every frame is the same.
+# Run with -DBENCHMARK=<path to cdogs-sdl-benchmark>, from the src dir so
+# that the game data can be found.
+
+foreach(players 2 4)
+	set(hashes)
+	foreach(threads OFF ON)
+		set(args
+			missions/doom.cdogscpn --mission=5 --players=${players}
+			--ticks=150 --render=640x480 --frame-hash)
+		if(threads)
+			list(APPEND args --render-threads)
+		endif()
+		execute_process(
+			COMMAND ${BENCHMARK} ${args}
+			OUTPUT_VARIABLE output
+			RESULT_VARIABLE result)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "Benchmark failed (${result}):\n${output}")
+		endif()
+		string(REGEX MATCH "Frame hash: ([0-9a-f]+)" match "${output}")
+		if(NOT match)
+			message(FATAL_ERROR "No frame hash in output:\n${output}")
+		endif()
+		list(APPEND hashes ${CMAKE_MATCH_1})
+	endforeach()
+	list(GET hashes 0 serial)
+	list(GET hashes 1 threaded)
+	if(NOT serial STREQUAL threaded)
+		message(FATAL_ERROR
+			"${players} players: threaded frames ${threaded} "
+			"differ from serial frames ${serial}")
+	endif()
+	message("${players} players: frame hash ${serial}")
+endforeach()
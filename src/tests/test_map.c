@@ -0,0 +1,42 @@
+#include "test_map.h"
+
+#include <string.h>
+
+#include <los.h>
+
+
+void TestMapInit(Map *map, const char **rows)
+{
+	memset(map, 0, sizeof *map);
+	int height = 0;
+	while (rows[height] != NULL) height++;
+	map->Size = Vec2iNew((int)strlen(rows[0]), height);
+	CArrayInit(&map->Tiles, sizeof(Tile));
+	Vec2i v;
+	for (v.y = 0; v.y < map->Size.y; v.y++)
+	{
+		for (v.x = 0; v.x < map->Size.x; v.x++)
+		{
+			Tile t;
+			TileInit(&t);
+			CArrayPushBack(&map->Tiles, &t);
+			TestMapSetTile(map, v, rows[v.y][v.x]);
+		}
+	}
+	LOSInit(map, map->Size);
+}
+void TestMapSetTile(Map *map, const Vec2i pos, const char c)
+{
+	Tile *t = MapGetTile(map, pos);
+	t->flags = c == '#' ?
+		MAPTILE_NO_WALK | MAPTILE_NO_SEE | MAPTILE_NO_SHOOT | MAPTILE_IS_WALL :
+		MAPTILE_IS_NORMAL_FLOOR;
+}
+void TestMapTerminate(Map *map)
+{
+	CA_FOREACH(Tile, t, map->Tiles)
+		TileDestroy(t);
+	CA_FOREACH_END()
+	CArrayTerminate(&map->Tiles);
+	LOSTerminate(&map->LOS);
+}
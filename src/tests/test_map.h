@@ -0,0 +1,9 @@
+#pragma once
+
+#include <map.h>
+
+// Build a map from rows of text, all the same width:
+// '#' is a wall, '.' is floor
+void TestMapInit(Map *map, const char **rows);
+void TestMapSetTile(Map *map, const Vec2i pos, const char c);
+void TestMapTerminate(Map *map);